@@ -0,0 +1,381 @@
+#include "AllocationTracker.h"
+
+#include <cocos/base/ccMacros.h>
+
+#if ALLOCATION_TRACKING
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <vector>
+
+#if defined( _MSC_VER )
+#include <windows.h>
+#else
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <unwind.h>
+#endif
+
+// Frames of a call stack kept per call site
+static const int k_iStackDepth = 16;
+
+// Frames of the tracker itself at the top of every captured stack in a debug build: the capture, the recording, the
+// allocation and operator new
+static const int k_iSkippedFrames = 4;
+
+// Call sites stored, a power of two
+static const int k_iMaxCallSites = 1024;
+
+// Call stack allocating outside the allowed scopes
+struct SCallSite
+{
+	void*		apFrames[ k_iStackDepth ];
+	int			iDepth;
+	uint32_t	uiHash;
+	int			iAllocations;
+	size_t		uiBytes;
+	int			iFirstFrame;
+};
+
+// Call sites hashed by their stack, a free entry has no allocation
+static SCallSite s_asCallSites[ k_iMaxCallSites ];
+static int s_iCallSites = 0;
+
+static AllocationTracker::SReport s_sReport = {};
+static int s_iFrameAllocations = 0;
+
+// Guards the counts and the call sites, a spin lock as the tracker must not allocate itself
+static std::atomic_flag s_bIsLocked = ATOMIC_FLAG_INIT;
+
+// State of the calling thread, the recording flag stops the tracker counting its own allocations
+static thread_local bool s_bIsTracked = false;
+static thread_local int s_iAllowDepth = 0;
+static thread_local bool s_bIsRecording = false;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CLock
+// Purpose				: To hold the tracker's spin lock for a scope
+//-----------------------------------------------------------------------------------------------------------------------------
+class CLock
+{
+
+public:
+
+	CLock()
+	{
+		while( s_bIsLocked.test_and_set( std::memory_order_acquire ) )
+		{
+		}
+	}
+
+	~CLock()
+	{
+		s_bIsLocked.clear( std::memory_order_release );
+	}
+};
+
+#if !defined( _MSC_VER )
+// Frames gathered by the unwinder
+struct SUnwindState
+{
+	void**	ppFrames;
+	int		iFrames;
+	int		iSkip;
+};
+
+static _Unwind_Reason_Code UnwindCallback( _Unwind_Context* pContext, void* pArgument )
+{
+	SUnwindState* psState = static_cast<SUnwindState*>( pArgument );
+	const uintptr_t uiAddress = _Unwind_GetIP( pContext );
+
+	if( 0 == uiAddress )
+	{
+		return _URC_END_OF_STACK;
+	}
+
+	if( psState->iSkip > 0 )
+	{
+		psState->iSkip--;
+		return _URC_NO_REASON;
+	}
+
+	psState->ppFrames[ psState->iFrames++ ] = reinterpret_cast<void*>( uiAddress );
+
+	return ( psState->iFrames < k_iStackDepth ) ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+#endif
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: CaptureStack()
+// Parameters		: ppFrames			- Filled with the return addresses, the caller of operator new first
+// Returns			: The amount of frames captured
+//-----------------------------------------------------------------------------------------------------------------------------
+static int CaptureStack( void** ppFrames )
+{
+#if defined( _MSC_VER )
+	return CaptureStackBackTrace( k_iSkippedFrames, k_iStackDepth, ppFrames, nullptr );
+#else
+	SUnwindState sState = { ppFrames, 0, k_iSkippedFrames };
+	_Unwind_Backtrace( UnwindCallback, &sState );
+	return sState.iFrames;
+#endif
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: RecordAllocation()
+// Parameters		: uiSize			- Size of the allocation
+// Purpose			: Count the allocation of a tracked thread and attribute it to its call stack
+//-----------------------------------------------------------------------------------------------------------------------------
+static void RecordAllocation( const size_t uiSize )
+{
+	if( !s_bIsTracked || s_bIsRecording )
+	{
+		return;
+	}
+
+	if( s_iAllowDepth > 0 )
+	{
+		CLock cLock;
+		s_sReport.iAllowedAllocations++;
+		return;
+	}
+
+	s_bIsRecording = true;
+
+	void* apFrames[ k_iStackDepth ];
+	const int iDepth = CaptureStack( apFrames );
+
+	// FNV-1a over the return addresses
+	uint32_t uiHash = 2166136261u;
+
+	for( int i = 0; i < iDepth; i++ )
+	{
+		uiHash = ( uiHash ^ static_cast<uint32_t>( reinterpret_cast<uintptr_t>( apFrames[ i ] ) ) ) * 16777619u;
+	}
+
+	{
+		CLock cLock;
+
+		s_sReport.iAllocations++;
+		s_sReport.uiBytes += uiSize;
+		s_iFrameAllocations++;
+
+		// Open addressing, the table is never emptied but by Reset()
+		int iSlot = static_cast<int>( uiHash & ( k_iMaxCallSites - 1 ) );
+		SCallSite* psCallSite = nullptr;
+
+		for( int iProbe = 0; iProbe < k_iMaxCallSites; iProbe++ )
+		{
+			SCallSite& rsSlot = s_asCallSites[ iSlot ];
+
+			if( 0 == rsSlot.iAllocations )
+			{
+				// A table filled up to three quarters would mostly be probed, leave the rest unattributed
+				if( s_iCallSites < k_iMaxCallSites * 3 / 4 )
+				{
+					std::copy( apFrames, apFrames + iDepth, rsSlot.apFrames );
+					rsSlot.iDepth = iDepth;
+					rsSlot.uiHash = uiHash;
+					rsSlot.iFirstFrame = s_sReport.iFrames;
+					psCallSite = &rsSlot;
+					s_iCallSites++;
+				}
+				break;
+			}
+
+			if( rsSlot.uiHash == uiHash && rsSlot.iDepth == iDepth && std::equal( apFrames, apFrames + iDepth, rsSlot.apFrames ) )
+			{
+				psCallSite = &rsSlot;
+				break;
+			}
+
+			iSlot = ( iSlot + 1 ) & ( k_iMaxCallSites - 1 );
+		}
+
+		if( nullptr != psCallSite )
+		{
+			psCallSite->iAllocations++;
+			psCallSite->uiBytes += uiSize;
+		}
+		else
+		{
+			s_sReport.iUnattributedAllocations++;
+		}
+	}
+
+	s_bIsRecording = false;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: Allocate()
+// Parameters		: uiSize			- Size of the allocation
+// Returns			: The allocated memory, nullptr if the heap is exhausted
+//-----------------------------------------------------------------------------------------------------------------------------
+static void* Allocate( const size_t uiSize )
+{
+	RecordAllocation( uiSize );
+	return malloc( std::max<size_t>( uiSize, 1 ) );
+}
+
+void* operator new( std::size_t uiSize )
+{
+	void* pMemory = Allocate( uiSize );
+
+	if( nullptr == pMemory )
+	{
+		throw std::bad_alloc();
+	}
+
+	return pMemory;
+}
+
+void* operator new[]( std::size_t uiSize )
+{
+	return operator new( uiSize );
+}
+
+void* operator new( std::size_t uiSize, const std::nothrow_t& ) noexcept			{ return Allocate( uiSize ); }
+
+void* operator new[]( std::size_t uiSize, const std::nothrow_t& ) noexcept		{ return Allocate( uiSize ); }
+
+void operator delete( void* pMemory ) noexcept									{ free( pMemory ); }
+
+void operator delete[]( void* pMemory ) noexcept								{ free( pMemory ); }
+
+void operator delete( void* pMemory, const std::nothrow_t& ) noexcept			{ free( pMemory ); }
+
+void operator delete[]( void* pMemory, const std::nothrow_t& ) noexcept		{ free( pMemory ); }
+
+namespace AllocationTracker
+{
+	CAllowScope::CAllowScope()		{ s_iAllowDepth++; }
+
+	CAllowScope::~CAllowScope()		{ s_iAllowDepth--; }
+
+	bool IsEnabled()				{ return true; }
+
+	void TrackThisThread( const bool bTrack )
+	{
+		s_bIsTracked = bTrack;
+	}
+
+	int EndFrame()
+	{
+		CLock cLock;
+
+		const int iAllocations = s_iFrameAllocations;
+
+		s_sReport.iFrames++;
+		s_sReport.iFramesWithAllocations += ( iAllocations > 0 ) ? 1 : 0;
+		s_iFrameAllocations = 0;
+
+		return iAllocations;
+	}
+
+	void GetReport( SReport& rsReport )
+	{
+		CLock cLock;
+		rsReport = s_sReport;
+	}
+
+	void LogCallSites( const int iMaxCallSites )
+	{
+		// Logging allocates, which is neither counted nor attributed
+		s_bIsRecording = true;
+
+		std::vector<SCallSite> asCallSites;
+		int iUnattributedAllocations = 0;
+
+		{
+			CLock cLock;
+
+			iUnattributedAllocations = s_sReport.iUnattributedAllocations;
+
+			for( const SCallSite& rsCallSite : s_asCallSites )
+			{
+				if( rsCallSite.iAllocations > 0 )
+				{
+					asCallSites.push_back( rsCallSite );
+				}
+			}
+		}
+
+		std::sort( asCallSites.begin(), asCallSites.end(),
+			[]( const SCallSite& rsFirst, const SCallSite& rsSecond ) { return rsFirst.iAllocations > rsSecond.iAllocations; } );
+
+		const int iLogged = std::min( iMaxCallSites, static_cast<int>( asCallSites.size() ) );
+
+		CCLOG( "Allocations: %d call sites, %d allocations unattributed, logging %d", static_cast<int>( asCallSites.size() ),
+			iUnattributedAllocations, iLogged );
+
+		for( int i = 0; i < iLogged; i++ )
+		{
+			const SCallSite& rsCallSite = asCallSites[ i ];
+
+			CCLOG( "Allocations: %d allocations of %d bytes in total, first in frame %d", rsCallSite.iAllocations,
+				static_cast<int>( rsCallSite.uiBytes ), rsCallSite.iFirstFrame );
+
+			for( int j = 0; j < rsCallSite.iDepth; j++ )
+			{
+#if defined( _MSC_VER )
+				CCLOG( "    #%d %p", j, rsCallSite.apFrames[ j ] );
+#else
+				// Symbols of the exported functions only, the others show their module
+				Dl_info sInfo = {};
+
+				if( 0 != dladdr( rsCallSite.apFrames[ j ], &sInfo ) && nullptr != sInfo.dli_sname )
+				{
+					int iStatus = 0;
+					char* pszDemangled = abi::__cxa_demangle( sInfo.dli_sname, nullptr, nullptr, &iStatus );
+
+					CCLOG( "    #%d %p %s", j, rsCallSite.apFrames[ j ], ( 0 == iStatus ) ? pszDemangled : sInfo.dli_sname );
+					free( pszDemangled );
+				}
+				else
+				{
+					CCLOG( "    #%d %p %s", j, rsCallSite.apFrames[ j ], ( nullptr != sInfo.dli_fname ) ? sInfo.dli_fname : "?" );
+				}
+#endif
+			}
+		}
+
+		s_bIsRecording = false;
+	}
+
+	void Reset()
+	{
+		CLock cLock;
+
+		std::fill( std::begin( s_asCallSites ), std::end( s_asCallSites ), SCallSite() );
+		s_iCallSites = 0;
+		s_sReport = SReport();
+		s_iFrameAllocations = 0;
+	}
+}
+
+#else
+
+namespace AllocationTracker
+{
+	CAllowScope::CAllowScope()					{}
+
+	CAllowScope::~CAllowScope()					{}
+
+	bool IsEnabled()							{ return false; }
+
+	void TrackThisThread( const bool )			{}
+
+	int EndFrame()								{ return 0; }
+
+	void GetReport( SReport& rsReport )			{ rsReport = SReport(); }
+
+	void LogCallSites( const int )				{}
+
+	void Reset()								{}
+}
+
+#endif // ALLOCATION_TRACKING
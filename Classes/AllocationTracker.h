@@ -0,0 +1,96 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <cstddef>
+
+// Replace the global allocation functions to count the allocations of the tracked threads, on in debug builds by default.
+// Without it the functions below do nothing and every count stays 0
+#ifndef ALLOCATION_TRACKING
+#define ALLOCATION_TRACKING ( COCOS2D_DEBUG > 0 )
+#endif
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Namespace Name		: AllocationTracker
+// Purpose				: To check that gameplay frames do not touch the heap. Once a thread is tracked, every operator new it
+//						: calls outside an allowed scope is counted against the current frame and attributed to its call
+//						: stack, so the report points at the code allocating rather than at the standard library
+// Notes				: Stage transitions and initialisation may allocate, they open a CAllowScope. Worker threads are not
+//						: tracked unless they call TrackThisThread() themselves. Call sites are stored in a fixed table and
+//						: never allocate, the ones past its size are only counted
+// Example				: AllocationTracker::TrackThisThread( true ); ... cLevelManager.Update( fDeltaTime );
+//						: if( AllocationTracker::EndFrame() > 0 ) { AllocationTracker::LogCallSites( 10 ); }
+//-----------------------------------------------------------------------------------------------------------------------------
+namespace AllocationTracker
+{
+	// Allocations counted since the last Reset()
+	struct SReport
+	{
+		// Frames ended and frames with at least one allocation
+		int		iFrames;
+		int		iFramesWithAllocations;
+		// Allocations outside the allowed scopes and their size
+		int		iAllocations;
+		size_t	uiBytes;
+		// Allocations inside the allowed scopes
+		int		iAllowedAllocations;
+		// Allocations whose call site did not fit in the table
+		int		iUnattributedAllocations;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Class Name			: CAllowScope
+	// Purpose				: To let the calling thread allocate until the scope ends, e.g. during a stage transition
+	// Notes				: Scopes can be nested
+	//-----------------------------------------------------------------------------------------------------------------------------
+	class CAllowScope
+	{
+
+	public:
+
+		CAllowScope();
+		~CAllowScope();
+
+		CAllowScope( const CAllowScope& ) = delete;
+		CAllowScope& operator=( const CAllowScope& ) = delete;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: IsEnabled()
+	// Returns			: True if the allocation functions are replaced by this build
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsEnabled();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: TrackThisThread()
+	// Parameters		: bTrack			- True to count the allocations of the calling thread
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void TrackThisThread( const bool bTrack );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: EndFrame()
+	// Purpose			: Close the current frame and start counting the next one
+	// Returns			: The allocations of the frame outside the allowed scopes
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int EndFrame();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetReport()
+	// Parameters		: rsReport			- Filled with the counts since the last Reset()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GetReport( SReport& rsReport );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: LogCallSites()
+	// Parameters		: iMaxCallSites		- Most call sites logged, the ones allocating most often first
+	// Purpose			: Log the call stacks allocating outside the allowed scopes, with the first frame each one was seen
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void LogCallSites( const int iMaxCallSites );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Reset()
+	// Purpose			: Drop the counts and the call sites, the tracked threads stay tracked
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Reset();
+}
+
+#endif // !ALLOCATIONTRACKER_H
@@ -0,0 +1,329 @@
+#include "BackgroundCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+#include <cocos/2d/CCRenderTexture.h>
+#include <cocos/2d/CCSprite.h>
+#include <cocos/2d/CCTMXXMLParser.h>
+#include <cocos/renderer/CCTextureCache.h>
+
+#include "LevelContext.h"
+
+using cocos2d::Rect;
+using cocos2d::Size;
+using cocos2d::Sprite;
+using cocos2d::Vec2;
+
+const int CBackgroundCache::k_iMaxChunkSize;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: SetupTile()
+// Parameters		: pcTile			- Sprite of the tile
+//					: rcPosition		- Bottom left corner of the tile in the chunk
+//					: eFlags			- Flip flags of the tile in the map
+// Purpose			: Flip, rotate and position the sprite like FastTMXLayer draws the tile, whatever tile it drew before
+//-----------------------------------------------------------------------------------------------------------------------------
+static void SetupTile( Sprite* pcTile, const Vec2& rcPosition, const cocos2d::TMXTileFlags eFlags )
+{
+	// The sprite may have drawn a flipped or rotated tile before
+	pcTile->setRotation( 0.0f );
+	pcTile->setFlippedX( false );
+	pcTile->setFlippedY( false );
+
+	if( eFlags & cocos2d::kTMXTileDiagonalFlag )
+	{
+		// Rotated around the middle of the tile
+		const Size& rcSize = pcTile->getContentSize();
+		pcTile->setAnchorPoint( Vec2( 0.5f, 0.5f ) );
+		pcTile->setPosition( rcPosition.x + rcSize.height * 0.5f, rcPosition.y + rcSize.width * 0.5f );
+
+		const unsigned int uiFlip = eFlags & ( cocos2d::kTMXTileHorizontalFlag | cocos2d::kTMXTileVerticalFlag );
+
+		if( cocos2d::kTMXTileHorizontalFlag == uiFlip )
+		{
+			pcTile->setRotation( 90.0f );
+		}
+		else if( cocos2d::kTMXTileVerticalFlag == uiFlip )
+		{
+			pcTile->setRotation( 270.0f );
+		}
+		else if( ( cocos2d::kTMXTileHorizontalFlag | cocos2d::kTMXTileVerticalFlag ) == uiFlip )
+		{
+			pcTile->setRotation( 90.0f );
+			pcTile->setFlippedX( true );
+		}
+		else
+		{
+			pcTile->setRotation( 270.0f );
+			pcTile->setFlippedX( true );
+		}
+	}
+	else
+	{
+		pcTile->setAnchorPoint( Vec2::ZERO );
+		pcTile->setPosition( rcPosition );
+		pcTile->setFlippedX( 0 != ( eFlags & cocos2d::kTMXTileHorizontalFlag ) );
+		pcTile->setFlippedY( 0 != ( eFlags & cocos2d::kTMXTileVerticalFlag ) );
+	}
+}
+
+CBackgroundCache::CBackgroundCache()
+	: m_pcLayer( nullptr )
+	, m_pcContext( nullptr )
+	, m_uiLastBakedFrame( 0 )
+	, m_bIsLayerVisible( true )
+	, m_bIsValid( false )
+{}
+
+CBackgroundCache* CBackgroundCache::create( cocos2d::FastTMXLayer* pcLayer, const CLevelContext* pcContext )
+{
+	CBackgroundCache* pcCache = new ( std::nothrow ) CBackgroundCache();
+
+	if( nullptr != pcCache && pcCache->init( pcLayer, pcContext ) )
+	{
+		pcCache->autorelease();
+		return pcCache;
+	}
+
+	CC_SAFE_DELETE( pcCache );
+	return nullptr;
+}
+
+bool CBackgroundCache::init( cocos2d::FastTMXLayer* pcLayer, const CLevelContext* pcContext )
+{
+	if( !Node::init() )
+	{
+		return false;
+	}
+
+	CCASSERT( nullptr != pcLayer, "Cached layer is null" );
+	CCASSERT( nullptr != pcContext && nullptr != pcContext->GetTextureCache(), "Context does not render" );
+
+	m_pcLayer = pcLayer;
+	m_pcContext = pcContext;
+	m_bIsLayerVisible = pcLayer->isVisible();
+
+	// Nothing is cached until the first stage is loaded
+	setVisible( false );
+
+	return true;
+}
+
+void CBackgroundCache::visit( cocos2d::Renderer* pcRenderer, const cocos2d::Mat4& rcParentTransform, uint32_t uiParentFlags )
+{
+	const unsigned int uiFrame = m_pcContext->GetFrame();
+
+	// The render commands of the last chunk's sprites ran at the end of the frame it was baked in
+	if( m_asPendingChunks.empty() && !m_cTileSprites.empty() && uiFrame != m_uiLastBakedFrame )
+	{
+		m_cTileSprites.clear();
+	}
+
+	// One chunk per frame, so that the tile sprites of a single chunk are ever needed
+	if( !m_asPendingChunks.empty() && uiFrame != m_uiLastBakedFrame )
+	{
+		m_uiLastBakedFrame = uiFrame;
+
+		BakeChunk( m_asPendingChunks.back() );
+		m_asPendingChunks.pop_back();
+
+		if( m_asPendingChunks.empty() )
+		{
+			// The chunks replace the layer all at once, they are drawn after their render textures in the render queue
+			for( Node* pcChunk : getChildren() )
+			{
+				pcChunk->setVisible( true );
+			}
+
+			m_pcLayer->setVisible( false );
+			m_bIsValid = true;
+		}
+	}
+
+	Node::visit( pcRenderer, rcParentTransform, uiParentFlags );
+}
+
+void CBackgroundCache::Rebuild( const Rect& rcRegion )
+{
+	m_cRegion = rcRegion;
+
+	Invalidate();
+
+	// A hidden layer is baked when it is shown again, the cache is only visited to bake its chunks until they are all done
+	setVisible( m_bIsLayerVisible && CreateChunks() );
+}
+
+void CBackgroundCache::Invalidate()
+{
+	removeAllChildrenWithCleanup( true );
+	m_asPendingChunks.clear();
+	m_cTileSprites.clear();
+	m_bIsValid = false;
+
+	m_pcLayer->setVisible( m_bIsLayerVisible );
+	setVisible( false );
+}
+
+void CBackgroundCache::SetLayerVisible( const bool bIsVisible )
+{
+	if( bIsVisible == m_bIsLayerVisible )
+	{
+		return;
+	}
+
+	m_bIsLayerVisible = bIsVisible;
+
+	// The chunks of a hidden layer are only memory, they are baked again when the layer is shown
+	if( m_bIsLayerVisible )
+	{
+		Rebuild( m_cRegion );
+	}
+	else
+	{
+		Invalidate();
+	}
+}
+
+bool CBackgroundCache::CreateChunks()
+{
+	if( m_cRegion.size.width <= 0.0f || m_cRegion.size.height <= 0.0f )
+	{
+		return false;
+	}
+
+	const Size cTileSize = CC_SIZE_PIXELS_TO_POINTS( m_pcLayer->getMapTileSize() );
+	const int iLayerColumns = static_cast<int>( m_pcLayer->getLayerSize().width );
+	const int iLayerRows = static_cast<int>( m_pcLayer->getLayerSize().height );
+
+	// Tiles covered by the region, rows are counted from the top of the map like in Tiled
+	const Vec2& rcLayerPosition = m_pcLayer->getPosition();
+	const float fMinX = m_cRegion.getMinX() - rcLayerPosition.x;
+	const float fMaxX = m_cRegion.getMaxX() - rcLayerPosition.x;
+	const float fMinY = m_cRegion.getMinY() - rcLayerPosition.y;
+	const float fMaxY = m_cRegion.getMaxY() - rcLayerPosition.y;
+
+	const int iFirstColumn = std::max( 0, static_cast<int>( floorf( fMinX / cTileSize.width ) ) );
+	const int iLastColumn = std::min( iLayerColumns - 1, static_cast<int>( ceilf( fMaxX / cTileSize.width ) ) - 1 );
+	const int iFirstRow = std::max( 0, iLayerRows - static_cast<int>( ceilf( fMaxY / cTileSize.height ) ) );
+	const int iLastRow = std::min( iLayerRows - 1, iLayerRows - 1 - static_cast<int>( floorf( fMinY / cTileSize.height ) ) );
+
+	if( iFirstColumn > iLastColumn || iFirstRow > iLastRow )
+	{
+		return false;
+	}
+
+	// Chunks are kept within the texture size every GL implementation supports, including the software ones
+	const int iMaxChunkSize = std::min( k_iMaxChunkSize, m_pcContext->GetMaxTextureSize() );
+	const int iChunkColumns = std::max( 1, iMaxChunkSize / static_cast<int>( m_pcLayer->getMapTileSize().width ) );
+	const int iChunkRows = std::max( 1, iMaxChunkSize / static_cast<int>( m_pcLayer->getMapTileSize().height ) );
+
+	const int iColumns = iLastColumn - iFirstColumn + 1;
+	const int iRows = iLastRow - iFirstRow + 1;
+	const int iChunks = ( ( iColumns + iChunkColumns - 1 ) / iChunkColumns ) * ( ( iRows + iChunkRows - 1 ) / iChunkRows );
+
+	if( iChunks > k_iMaxChunks )
+	{
+		CCLOG( "Background cache: %d chunks needed for %s, drawing its tiles", iChunks, m_pcLayer->getLayerName().c_str() );
+		return false;
+	}
+
+	m_asPendingChunks.reserve( iChunks );
+
+	for( int iRow = iFirstRow; iRow <= iLastRow; iRow += iChunkRows )
+	{
+		for( int iColumn = iFirstColumn; iColumn <= iLastColumn; iColumn += iChunkColumns )
+		{
+			SChunk sChunk;
+			sChunk.iFirstColumn = iColumn;
+			sChunk.iFirstRow = iRow;
+			sChunk.iColumns = std::min( iChunkColumns, iLastColumn - iColumn + 1 );
+			sChunk.iRows = std::min( iChunkRows, iLastRow - iRow + 1 );
+
+			const Size cChunkSize( sChunk.iColumns * cTileSize.width, sChunk.iRows * cTileSize.height );
+
+			sChunk.pcTexture = cocos2d::RenderTexture::create( static_cast<int>( ceilf( cChunkSize.width ) ),
+				static_cast<int>( ceilf( cChunkSize.height ) ), cocos2d::Texture2D::PixelFormat::RGBA8888 );
+
+			if( nullptr == sChunk.pcTexture )
+			{
+				removeAllChildrenWithCleanup( true );
+				m_asPendingChunks.clear();
+				return false;
+			}
+
+			// Bottom left corner of the chunk in the layer, the position of its bottom left tile
+			const Vec2 cOrigin = m_pcLayer->getPositionAt( Vec2( static_cast<float>( sChunk.iFirstColumn ),
+				static_cast<float>( sChunk.iFirstRow + sChunk.iRows - 1 ) ) );
+
+			// The render texture draws its sprite centred on its position, hidden until every chunk is baked
+			sChunk.pcTexture->setPosition( rcLayerPosition + cOrigin + Vec2( cChunkSize.width * 0.5f, cChunkSize.height * 0.5f ) );
+			sChunk.pcTexture->setVisible( false );
+			addChild( sChunk.pcTexture );
+
+			m_asPendingChunks.push_back( sChunk );
+		}
+	}
+
+	return true;
+}
+
+void CBackgroundCache::BakeChunk( const SChunk& rsChunk )
+{
+	cocos2d::Texture2D* pcTileset = m_pcContext->GetTextureCache()->addImage( m_pcLayer->getTileSet()->_sourceImage );
+	const cocos2d::TMXTilesetInfo* pcTilesetInfo = m_pcLayer->getTileSet();
+
+	// Bottom left corner of the chunk in the layer, the position of its bottom left tile
+	const Vec2 cOrigin = m_pcLayer->getPositionAt( Vec2( static_cast<float>( rsChunk.iFirstColumn ),
+		static_cast<float>( rsChunk.iFirstRow + rsChunk.iRows - 1 ) ) );
+
+	// Every tile needs its own sprite as the queued commands are only executed when the frame is rendered
+	size_t uiTile = 0;
+
+	rsChunk.pcTexture->beginWithClear( 0.0f, 0.0f, 0.0f, 0.0f );
+
+	for( int iRow = rsChunk.iFirstRow; iRow < rsChunk.iFirstRow + rsChunk.iRows; iRow++ )
+	{
+		for( int iColumn = rsChunk.iFirstColumn; iColumn < rsChunk.iFirstColumn + rsChunk.iColumns; iColumn++ )
+		{
+			const Vec2 cTile( static_cast<float>( iColumn ), static_cast<float>( iRow ) );
+
+			cocos2d::TMXTileFlags eFlags = static_cast<cocos2d::TMXTileFlags>( 0 );
+			const uint32_t uiGID = m_pcLayer->getTileGIDAt( cTile, &eFlags );
+
+			// Empty tile
+			if( 0 == uiGID || nullptr == pcTileset )
+			{
+				continue;
+			}
+
+			const Rect cTileRect = CC_RECT_PIXELS_TO_POINTS( pcTilesetInfo->getRectForGID( uiGID ) );
+			Sprite* pcTile = nullptr;
+
+			if( uiTile < m_cTileSprites.size() )
+			{
+				pcTile = m_cTileSprites.at( uiTile );
+				pcTile->setTextureRect( cTileRect );
+			}
+			else
+			{
+				pcTile = Sprite::createWithTexture( pcTileset, cTileRect );
+				m_cTileSprites.pushBack( pcTile );
+			}
+
+			uiTile++;
+
+			SetupTile( pcTile, m_pcLayer->getPositionAt( cTile ) - cOrigin, eFlags );
+			pcTile->visit();
+		}
+	}
+
+	rsChunk.pcTexture->end();
+}
+
+bool CBackgroundCache::IsLayerVisible() const				{ return m_bIsLayerVisible; }
+
+bool CBackgroundCache::IsValid() const						{ return m_bIsValid; }
+
+cocos2d::FastTMXLayer* CBackgroundCache::GetLayer() const	{ return m_pcLayer; }
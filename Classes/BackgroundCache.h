@@ -0,0 +1,151 @@
+#ifndef BACKGROUNDCACHE_H
+#define BACKGROUNDCACHE_H
+
+#include <vector>
+
+#include <cocos/2d/CCFastTMXLayer.h>
+#include <cocos/2d/CCNode.h>
+#include <cocos/2d/CCSprite.h>
+#include <cocos/base/CCVector.h>
+
+namespace cocos2d
+{
+	class RenderTexture;
+	class Texture2D;
+}
+
+class CLevelContext;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CBackgroundCache
+// Classes Inherited	: Node
+// Purpose				: To draw a static tile layer of the map, e.g. a background, from textures rendered once per stage
+//						: instead of tile by tile every frame. Rebuild() splits the part of the layer covering the stage in
+//						: chunks, which are baked one per frame while the cache is visited, with the frame's own render
+//						: queue. Once every chunk is baked the layer is hidden and each chunk is drawn as a single quad
+// Notes				: The cache has to be added to the map with the layer's z order right after the map is created, so that
+//						: it is drawn where the layer was. The chunks are small enough for software GL implementations; when
+//						: the region needs too many of them the layer is drawn from its tiles instead. The tiles of a chunk
+//						: are drawn with sprites reused from one chunk to the next, released in the frame after the last chunk is baked
+//-----------------------------------------------------------------------------------------------------------------------------
+class CBackgroundCache : public cocos2d::Node
+{
+
+private:
+
+	// Render texture of a chunk and the tiles it holds, rows are counted from the top of the map like in Tiled
+	struct SChunk
+	{
+		cocos2d::RenderTexture*	pcTexture;
+		int						iFirstColumn;
+		int						iFirstRow;
+		int						iColumns;
+		int						iRows;
+	};
+
+	// Tile layer drawn by the cache, hidden while the chunks are valid
+	cocos2d::FastTMXLayer* m_pcLayer;
+
+	// Context of the level, holding the texture cache of the layer's tileset
+	const CLevelContext* m_pcContext;
+
+	// Part of the map covered by the chunks, in the map's coordinates
+	cocos2d::Rect m_cRegion;
+
+	// Chunks created for the region and not baked yet
+	std::vector<SChunk> m_asPendingChunks;
+
+	// Sprites drawing the tiles of the chunk being baked, kept until the last chunk's frame is rendered
+	cocos2d::Vector<cocos2d::Sprite*> m_cTileSprites;
+
+	// Frame the last chunk was baked in, a frame visiting the cache with several cameras bakes a single chunk
+	unsigned int m_uiLastBakedFrame;
+
+	// True if the layer is shown, from the chunks or from its tiles
+	bool m_bIsLayerVisible;
+
+	// True if the chunks hold the layer's current region
+	bool m_bIsValid;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreateChunks()
+	// Purpose			: Split the region in chunks, create their render textures and queue them to be baked
+	// Returns			: False if the region could not be cached, the layer is then drawn from its tiles
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool CreateChunks();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: BakeChunk()
+	// Parameters		: rsChunk			- Chunk to bake
+	// Purpose			: Queue the drawing of the chunk's tiles into its render texture in the current frame's render queue
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BakeChunk( const SChunk& rsChunk );
+
+public:
+
+	// Largest side of a chunk in pixels, lowered to the maximum texture size of the GL implementation
+	static const int k_iMaxChunkSize = 1024;
+
+	// Most chunks a stage can use, bounding the memory of the cache
+	static const int k_iMaxChunks = 16;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: create()
+	// Parameters		: pcLayer			- Static tile layer to cache
+	//					: pcContext			- Context of the level, which has to render
+	// Purpose			: Create an empty cache, the layer is drawn from its tiles until Rebuild() is called
+	// Returns			: An autoreleased cache, nullptr on failure
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CBackgroundCache* create( cocos2d::FastTMXLayer* pcLayer, const CLevelContext* pcContext );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: init()
+	// Parameters		: pcLayer			- Static tile layer to cache
+	//					: pcContext			- Context of the level, which has to render
+	// Returns			: False if the node could not be initialised
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool init( cocos2d::FastTMXLayer* pcLayer, const CLevelContext* pcContext );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: visit()
+	// Parameters		: pcRenderer		- Renderer of the frame
+	//					: rcParentTransform	- Model view transform of the parent
+	//					: uiParentFlags		- Transform flags of the parent
+	// Purpose			: Bake the next pending chunk, then draw the chunks once they are all baked
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void visit( cocos2d::Renderer* pcRenderer, const cocos2d::Mat4& rcParentTransform, uint32_t uiParentFlags ) override;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Rebuild()
+	// Parameters		: rcRegion			- Part of the map seen during the stage, in the map's coordinates
+	// Purpose			: Drop the chunks of the previous stage and queue the region's chunks, called when a new stage is
+	//					: loaded. The layer is drawn from its tiles until the chunks are baked
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Rebuild( const cocos2d::Rect& rcRegion );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Invalidate()
+	// Purpose			: Drop the chunks and draw the layer from its tiles again
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Invalidate();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetLayerVisible()
+	// Parameters		: bIsVisible		- True to show the layer
+	// Purpose			: Show or hide the layer. Hiding it releases the chunks, showing it bakes the region again
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetLayerVisible( const bool bIsVisible );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Getters
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsLayerVisible() const;
+	bool IsValid() const;
+	cocos2d::FastTMXLayer* GetLayer() const;
+
+protected:
+
+	CBackgroundCache();
+};
+
+#endif // !BACKGROUNDCACHE_H
@@ -0,0 +1,851 @@
+#include "ChunkedMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <cocos/2d/CCFastTMXLayer.h>
+#include <cocos/2d/CCNode.h>
+#include <cocos/base/ccMacros.h>
+
+using cocos2d::Rect;
+using cocos2d::Size;
+using cocos2d::Value;
+using cocos2d::ValueMap;
+using cocos2d::Vec2;
+
+// Magic number at the start of every chunk file
+static const uint8_t k_auiMagic[] = { 'I', 'R', 'C', 'M' };
+
+// Bytes before the header's content: magic, version, padding and the size of the header
+static const size_t k_uiPreambleSize = 4 + 2 + 2 + 4;
+
+// Tiles added around the objects of a stage when choosing its chunks, about half a screen
+static const int k_iStageMarginTiles = 16;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Little endian writers appending to a buffer
+//-----------------------------------------------------------------------------------------------------------------------------
+static void PutUInt8( std::vector<uint8_t>& rauiData, const uint8_t uiValue )
+{
+	rauiData.push_back( uiValue );
+}
+
+static void PutUInt16( std::vector<uint8_t>& rauiData, const uint16_t uiValue )
+{
+	rauiData.push_back( static_cast<uint8_t>( uiValue ) );
+	rauiData.push_back( static_cast<uint8_t>( uiValue >> 8 ) );
+}
+
+static void PutUInt32( std::vector<uint8_t>& rauiData, const uint32_t uiValue )
+{
+	for( int iShift = 0; iShift < 32; iShift += 8 )
+	{
+		rauiData.push_back( static_cast<uint8_t>( uiValue >> iShift ) );
+	}
+}
+
+static void PutFloat( std::vector<uint8_t>& rauiData, const float fValue )
+{
+	uint32_t uiBits;
+	memcpy( &uiBits, &fValue, sizeof( uiBits ) );
+	PutUInt32( rauiData, uiBits );
+}
+
+static void PutString( std::vector<uint8_t>& rauiData, const std::string& rsValue )
+{
+	// Longer strings are cut, no value of a map comes close
+	const size_t uiSize = std::min<size_t>( rsValue.size(), 0xFFFF );
+	PutUInt16( rauiData, static_cast<uint16_t>( uiSize ) );
+	rauiData.insert( rauiData.end(), rsValue.begin(), rsValue.begin() + uiSize );
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Struct Name			: SReader
+// Purpose				: To read the little endian values written above from a buffer. Reading past the end returns zeros and
+//						: clears bIsValid, so a truncated file is detected once after reading it
+//-----------------------------------------------------------------------------------------------------------------------------
+struct SReader
+{
+	const std::vector<uint8_t>& rauiData;
+	size_t uiPosition;
+	bool bIsValid;
+
+	explicit SReader( const std::vector<uint8_t>& rauiBuffer )
+		: rauiData( rauiBuffer )
+		, uiPosition( 0 )
+		, bIsValid( true )
+	{}
+
+	bool Has( const size_t uiSize )
+	{
+		bIsValid = bIsValid && uiPosition + uiSize <= rauiData.size();
+		return bIsValid;
+	}
+
+	uint8_t GetUInt8()
+	{
+		return Has( 1 ) ? rauiData[ uiPosition++ ] : 0;
+	}
+
+	uint16_t GetUInt16()
+	{
+		if( !Has( 2 ) )
+		{
+			return 0;
+		}
+
+		const uint16_t uiValue = static_cast<uint16_t>( rauiData[ uiPosition ] | ( rauiData[ uiPosition + 1 ] << 8 ) );
+		uiPosition += 2;
+		return uiValue;
+	}
+
+	uint32_t GetUInt32()
+	{
+		if( !Has( 4 ) )
+		{
+			return 0;
+		}
+
+		uint32_t uiValue = 0;
+
+		for( int i = 0; i < 4; i++ )
+		{
+			uiValue |= static_cast<uint32_t>( rauiData[ uiPosition + i ] ) << ( i * 8 );
+		}
+
+		uiPosition += 4;
+		return uiValue;
+	}
+
+	float GetFloat()
+	{
+		const uint32_t uiBits = GetUInt32();
+		float fValue;
+		memcpy( &fValue, &uiBits, sizeof( fValue ) );
+		return fValue;
+	}
+
+	std::string GetString()
+	{
+		const uint16_t uiSize = GetUInt16();
+
+		if( !Has( uiSize ) )
+		{
+			return std::string();
+		}
+
+		std::string sValue( reinterpret_cast<const char*>( &rauiData[ uiPosition ] ), uiSize );
+		uiPosition += uiSize;
+		return sValue;
+	}
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: GetStageID()
+// Parameters		: rsName			- Name of an object group or of an object
+//					: rsPrefix			- Name expected before the stage's ID, e.g. "ExitDoor "
+// Returns			: The stage's ID at the end of the name, -1 if the name is not the prefix followed by a number
+//-----------------------------------------------------------------------------------------------------------------------------
+static int GetStageID( const std::string& rsName, const std::string& rsPrefix )
+{
+	if( rsName.size() <= rsPrefix.size() || 0 != rsName.compare( 0, rsPrefix.size(), rsPrefix ) )
+	{
+		return -1;
+	}
+
+	const std::string sID = rsName.substr( rsPrefix.size() );
+
+	if( !std::all_of( sID.begin(), sID.end(), []( const char cDigit ) { return cDigit >= '0' && cDigit <= '9'; } ) )
+	{
+		return -1;
+	}
+
+	return atoi( sID.c_str() );
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: GetObjectBounds()
+// Parameters		: rcObject			- Values of a Tiled object
+// Returns			: The object's bounds in the map's coordinates
+//-----------------------------------------------------------------------------------------------------------------------------
+static Rect GetObjectBounds( const ValueMap& rcObject )
+{
+	const auto GetValue = [&rcObject]( const char* pszKey )
+	{
+		const auto cIter = rcObject.find( pszKey );
+		return cIter == rcObject.end() ? 0.0f : cIter->second.asFloat();
+	};
+
+	return Rect( GetValue( "x" ), GetValue( "y" ), GetValue( "width" ), GetValue( "height" ) );
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: MergeStageBounds()
+// Parameters		: rasStages			- Stages found so far
+//					: iStage			- Stage the object belongs to, ignored if negative
+//					: rcBounds			- Bounds of the object
+// Purpose			: Grow the stage's bounds to contain the object, adding the stage if needed
+//-----------------------------------------------------------------------------------------------------------------------------
+static void MergeStageBounds( std::vector<CChunkedMap::SStage>& rasStages, const int iStage, const Rect& rcBounds )
+{
+	if( iStage < 0 )
+	{
+		return;
+	}
+
+	for( CChunkedMap::SStage& rsStage : rasStages )
+	{
+		if( rsStage.iStage == iStage )
+		{
+			rsStage.cBounds = rsStage.cBounds.unionWithRect( rcBounds );
+			return;
+		}
+	}
+
+	rasStages.push_back( { iStage, rcBounds } );
+}
+
+CChunkedMap::CChunkedMap()
+	: m_pFile( nullptr )
+	, m_pcParent( nullptr )
+	, m_pcMapInfo( nullptr )
+	, m_iMapColumns( 0 )
+	, m_iMapRows( 0 )
+	, m_iChunkSize( 0 )
+	, m_iChunkColumns( 0 )
+	, m_iChunkRows( 0 )
+	, m_iResidentChunks( 0 )
+	, m_uiResidentBytes( 0 )
+{}
+
+CChunkedMap::~CChunkedMap()
+{
+	Close();
+}
+
+bool CChunkedMap::Bake( const std::string& rsMapFile, const std::string& rsChunkFile, const int iChunkSize )
+{
+	// Only the map's XML is parsed, no texture or node is created
+	cocos2d::TMXMapInfo* pcMapInfo = cocos2d::TMXMapInfo::create( rsMapFile );
+
+	if( nullptr == pcMapInfo || iChunkSize <= 0 )
+	{
+		return false;
+	}
+
+	const int iMapColumns = static_cast<int>( pcMapInfo->getMapSize().width );
+	const int iMapRows = static_cast<int>( pcMapInfo->getMapSize().height );
+	const Size& rcTileSize = pcMapInfo->getTileSize();
+	const int iChunkColumns = ( iMapColumns + iChunkSize - 1 ) / iChunkSize;
+	const int iChunkRows = ( iMapRows + iChunkSize - 1 ) / iChunkSize;
+	const int iChunks = iChunkColumns * iChunkRows;
+
+	// Sort the objects into the chunks containing their origin and collect the bounds of the stages
+	std::vector<std::vector<std::pair<std::string, const ValueMap*>>> aacObjects( iChunks );
+	std::vector<SStage> asStages;
+
+	for( cocos2d::TMXObjectGroup* pcGroup : pcMapInfo->getObjectGroups() )
+	{
+		const std::string& rsGroupName = pcGroup->getGroupName();
+
+		// Stage groups are named after their stage, e.g. "Platforms 2"
+		const size_t uiSpace = rsGroupName.rfind( ' ' );
+		const int iGroupStage = ( std::string::npos == uiSpace ) ? -1 : GetStageID( rsGroupName, rsGroupName.substr( 0, uiSpace + 1 ) );
+
+		for( const Value& rcObject : pcGroup->getObjects() )
+		{
+			const ValueMap& rcValues = rcObject.asValueMap();
+			const Rect cBounds = GetObjectBounds( rcValues );
+
+			const int iColumn = static_cast<int>( cocos2d::clampf( floorf( cBounds.getMinX() / rcTileSize.width ), 0.0f, iMapColumns - 1.0f ) );
+			const int iRow = iMapRows - 1 - static_cast<int>( cocos2d::clampf( floorf( cBounds.getMinY() / rcTileSize.height ), 0.0f, iMapRows - 1.0f ) );
+			aacObjects[ ( iRow / iChunkSize ) * iChunkColumns + iColumn / iChunkSize ].emplace_back( rsGroupName, &rcValues );
+
+			// Exit doors share one group and are named after their stage
+			const auto cName = rcValues.find( "name" );
+			const int iObjectStage = ( iGroupStage < 0 && cName != rcValues.end() ) ? GetStageID( cName->second.asString(), "ExitDoor " ) : iGroupStage;
+
+			MergeStageBounds( asStages, iObjectStage, cBounds );
+		}
+	}
+
+	// Header: map, tilesets, layers and stages
+	std::vector<uint8_t> auiHeader;
+	PutUInt32( auiHeader, static_cast<uint32_t>( iMapColumns ) );
+	PutUInt32( auiHeader, static_cast<uint32_t>( iMapRows ) );
+	PutFloat( auiHeader, rcTileSize.width );
+	PutFloat( auiHeader, rcTileSize.height );
+	PutUInt32( auiHeader, static_cast<uint32_t>( pcMapInfo->getOrientation() ) );
+	PutUInt32( auiHeader, static_cast<uint32_t>( iChunkSize ) );
+
+	PutUInt32( auiHeader, static_cast<uint32_t>( pcMapInfo->getTilesets().size() ) );
+
+	for( const cocos2d::TMXTilesetInfo* pcTileset : pcMapInfo->getTilesets() )
+	{
+		PutString( auiHeader, pcTileset->_name );
+		PutUInt32( auiHeader, static_cast<uint32_t>( pcTileset->_firstGid ) );
+		PutFloat( auiHeader, pcTileset->_tileSize.width );
+		PutFloat( auiHeader, pcTileset->_tileSize.height );
+		PutUInt32( auiHeader, static_cast<uint32_t>( pcTileset->_spacing ) );
+		PutUInt32( auiHeader, static_cast<uint32_t>( pcTileset->_margin ) );
+		PutString( auiHeader, pcTileset->_sourceImage );
+		PutFloat( auiHeader, pcTileset->_imageSize.width );
+		PutFloat( auiHeader, pcTileset->_imageSize.height );
+	}
+
+	PutUInt32( auiHeader, static_cast<uint32_t>( pcMapInfo->getLayers().size() ) );
+
+	for( const cocos2d::TMXLayerInfo* pcLayer : pcMapInfo->getLayers() )
+	{
+		CCASSERT( static_cast<int>( pcLayer->_layerSize.width ) == iMapColumns, "Layers must have the size of the map" );
+
+		PutString( auiHeader, pcLayer->_name );
+		PutUInt8( auiHeader, pcLayer->_visible ? 1 : 0 );
+		PutUInt8( auiHeader, pcLayer->_opacity );
+	}
+
+	PutUInt32( auiHeader, static_cast<uint32_t>( asStages.size() ) );
+
+	for( const SStage& rsStage : asStages )
+	{
+		PutUInt32( auiHeader, static_cast<uint32_t>( rsStage.iStage ) );
+		PutFloat( auiHeader, rsStage.cBounds.origin.x );
+		PutFloat( auiHeader, rsStage.cBounds.origin.y );
+		PutFloat( auiHeader, rsStage.cBounds.size.width );
+		PutFloat( auiHeader, rsStage.cBounds.size.height );
+	}
+
+	// Chunks: the tiles of every layer, then the objects with their scalar values as strings
+	std::vector<std::vector<uint8_t>> aauiChunks( iChunks );
+
+	for( int iChunk = 0; iChunk < iChunks; iChunk++ )
+	{
+		std::vector<uint8_t>& rauiChunk = aauiChunks[ iChunk ];
+		const int iFirstColumn = ( iChunk % iChunkColumns ) * iChunkSize;
+		const int iFirstRow = ( iChunk / iChunkColumns ) * iChunkSize;
+		const int iColumns = std::min( iChunkSize, iMapColumns - iFirstColumn );
+		const int iRows = std::min( iChunkSize, iMapRows - iFirstRow );
+
+		for( const cocos2d::TMXLayerInfo* pcLayer : pcMapInfo->getLayers() )
+		{
+			for( int iRow = iFirstRow; iRow < iFirstRow + iRows; iRow++ )
+			{
+				for( int iColumn = iFirstColumn; iColumn < iFirstColumn + iColumns; iColumn++ )
+				{
+					PutUInt32( rauiChunk, pcLayer->_tiles[ iRow * iMapColumns + iColumn ] );
+				}
+			}
+		}
+
+		PutUInt32( rauiChunk, static_cast<uint32_t>( aacObjects[ iChunk ].size() ) );
+
+		for( const std::pair<std::string, const ValueMap*>& rcObject : aacObjects[ iChunk ] )
+		{
+			PutString( rauiChunk, rcObject.first );
+
+			// Nested values, e.g. polyline points, are not used by the game
+			std::vector<std::pair<std::string, std::string>> asValues;
+
+			for( const auto& rcValue : *rcObject.second )
+			{
+				const Value::Type eType = rcValue.second.getType();
+
+				if( Value::Type::NONE != eType && Value::Type::VECTOR != eType && Value::Type::MAP != eType
+					&& Value::Type::INT_KEY_MAP != eType )
+				{
+					asValues.emplace_back( rcValue.first, rcValue.second.asString() );
+				}
+			}
+
+			PutUInt16( rauiChunk, static_cast<uint16_t>( asValues.size() ) );
+
+			for( const std::pair<std::string, std::string>& rsValue : asValues )
+			{
+				PutString( rauiChunk, rsValue.first );
+				PutString( rauiChunk, rsValue.second );
+			}
+		}
+	}
+
+	// Table of the chunks, their offsets follow the preamble, the header and the table itself
+	std::vector<uint8_t> auiTable;
+	PutUInt32( auiTable, static_cast<uint32_t>( iChunkColumns ) );
+	PutUInt32( auiTable, static_cast<uint32_t>( iChunkRows ) );
+
+	uint32_t uiOffset = static_cast<uint32_t>( k_uiPreambleSize + auiHeader.size() + 8 + iChunks * 8 );
+
+	for( const std::vector<uint8_t>& rauiChunk : aauiChunks )
+	{
+		PutUInt32( auiTable, uiOffset );
+		PutUInt32( auiTable, static_cast<uint32_t>( rauiChunk.size() ) );
+		uiOffset += static_cast<uint32_t>( rauiChunk.size() );
+	}
+
+	auiHeader.insert( auiHeader.end(), auiTable.begin(), auiTable.end() );
+
+	std::vector<uint8_t> auiPreamble( k_auiMagic, k_auiMagic + sizeof( k_auiMagic ) );
+	PutUInt16( auiPreamble, k_uiVersion );
+	PutUInt16( auiPreamble, 0 );
+	PutUInt32( auiPreamble, static_cast<uint32_t>( auiHeader.size() ) );
+
+	FILE* pFile = fopen( rsChunkFile.c_str(), "wb" );
+
+	if( nullptr == pFile )
+	{
+		return false;
+	}
+
+	bool bIsWritten = fwrite( auiPreamble.data(), 1, auiPreamble.size(), pFile ) == auiPreamble.size()
+		&& fwrite( auiHeader.data(), 1, auiHeader.size(), pFile ) == auiHeader.size();
+
+	for( const std::vector<uint8_t>& rauiChunk : aauiChunks )
+	{
+		bIsWritten = bIsWritten && ( rauiChunk.empty() || fwrite( rauiChunk.data(), 1, rauiChunk.size(), pFile ) == rauiChunk.size() );
+	}
+
+	bIsWritten = ( 0 == fclose( pFile ) ) && bIsWritten;
+
+	// Warn the designers about the stages that would break the memory budget
+	for( const SStage& rsStage : asStages )
+	{
+		const int iFirstColumn = std::max( 0, static_cast<int>( rsStage.cBounds.getMinX() / rcTileSize.width ) - k_iStageMarginTiles );
+		const int iLastColumn = std::min( iMapColumns - 1, static_cast<int>( rsStage.cBounds.getMaxX() / rcTileSize.width ) + k_iStageMarginTiles );
+		const int iFirstRow = std::max( 0, iMapRows - 1 - static_cast<int>( rsStage.cBounds.getMaxY() / rcTileSize.height ) - k_iStageMarginTiles );
+		const int iLastRow = std::min( iMapRows - 1, iMapRows - 1 - static_cast<int>( rsStage.cBounds.getMinY() / rcTileSize.height ) + k_iStageMarginTiles );
+
+		const int iStageChunks = ( iLastColumn / iChunkSize - iFirstColumn / iChunkSize + 1 ) * ( iLastRow / iChunkSize - iFirstRow / iChunkSize + 1 );
+
+		if( iStageChunks * 3 > k_iChunkBudget )
+		{
+			CCLOG( "Chunked map: stage %d of %s spans %d chunks, its neighbourhood may not fit in the budget of %d",
+				rsStage.iStage, rsMapFile.c_str(), iStageChunks, k_iChunkBudget );
+		}
+	}
+
+	return bIsWritten;
+}
+
+bool CChunkedMap::Open( const std::string& rsChunkFile, cocos2d::Node* pcParent, const std::vector<std::string>& rasKeptLayers )
+{
+	Close();
+
+	m_pFile = fopen( rsChunkFile.c_str(), "rb" );
+
+	if( nullptr == m_pFile )
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> auiPreamble( k_uiPreambleSize );
+
+	if( fread( auiPreamble.data(), 1, auiPreamble.size(), m_pFile ) != auiPreamble.size()
+		|| !std::equal( k_auiMagic, k_auiMagic + sizeof( k_auiMagic ), auiPreamble.begin() ) )
+	{
+		Close();
+		return false;
+	}
+
+	SReader sPreamble( auiPreamble );
+	sPreamble.uiPosition = sizeof( k_auiMagic );
+	const uint16_t uiVersion = sPreamble.GetUInt16();
+	sPreamble.GetUInt16();
+	std::vector<uint8_t> auiHeader( sPreamble.GetUInt32() );
+
+	if( k_uiVersion != uiVersion || fread( auiHeader.data(), 1, auiHeader.size(), m_pFile ) != auiHeader.size() )
+	{
+		Close();
+		return false;
+	}
+
+	SReader sHeader( auiHeader );
+
+	m_iMapColumns = static_cast<int>( sHeader.GetUInt32() );
+	m_iMapRows = static_cast<int>( sHeader.GetUInt32() );
+	const float fTileWidth = sHeader.GetFloat();
+	const float fTileHeight = sHeader.GetFloat();
+	const int iOrientation = static_cast<int>( sHeader.GetUInt32() );
+	m_iChunkSize = static_cast<int>( sHeader.GetUInt32() );
+
+	// The chunks' layers are created from the same descriptions the map's parser gives FastTMXLayer
+	m_pcMapInfo = new ( std::nothrow ) cocos2d::TMXMapInfo();
+	m_pcMapInfo->setOrientation( iOrientation );
+	m_pcMapInfo->setMapSize( Size( static_cast<float>( m_iMapColumns ), static_cast<float>( m_iMapRows ) ) );
+	m_pcMapInfo->setTileSize( Size( fTileWidth, fTileHeight ) );
+
+	const uint32_t uiTilesets = sHeader.GetUInt32();
+
+	for( uint32_t i = 0; i < uiTilesets && sHeader.bIsValid; i++ )
+	{
+		cocos2d::TMXTilesetInfo* pcTileset = new ( std::nothrow ) cocos2d::TMXTilesetInfo();
+		pcTileset->_name = sHeader.GetString();
+		pcTileset->_firstGid = sHeader.GetUInt32();
+		pcTileset->_tileSize.width = sHeader.GetFloat();
+		pcTileset->_tileSize.height = sHeader.GetFloat();
+		pcTileset->_spacing = static_cast<int>( sHeader.GetUInt32() );
+		pcTileset->_margin = static_cast<int>( sHeader.GetUInt32() );
+		pcTileset->_sourceImage = sHeader.GetString();
+		pcTileset->_imageSize.width = sHeader.GetFloat();
+		pcTileset->_imageSize.height = sHeader.GetFloat();
+
+		m_pcMapInfo->getTilesets().pushBack( pcTileset );
+		pcTileset->release();
+	}
+
+	const uint32_t uiLayers = sHeader.GetUInt32();
+
+	for( uint32_t i = 0; i < uiLayers && sHeader.bIsValid; i++ )
+	{
+		SLayer sLayer;
+		sLayer.sName = sHeader.GetString();
+		sLayer.bIsVisible = 0 != sHeader.GetUInt8();
+		sLayer.uiOpacity = sHeader.GetUInt8();
+		sLayer.bIsStreamed = ( nullptr != pcParent )
+			&& std::find( rasKeptLayers.begin(), rasKeptLayers.end(), sLayer.sName ) == rasKeptLayers.end();
+		m_asLayers.push_back( sLayer );
+	}
+
+	const uint32_t uiStages = sHeader.GetUInt32();
+
+	for( uint32_t i = 0; i < uiStages && sHeader.bIsValid; i++ )
+	{
+		SStage sStage;
+		sStage.iStage = static_cast<int>( sHeader.GetUInt32() );
+		sStage.cBounds.origin.x = sHeader.GetFloat();
+		sStage.cBounds.origin.y = sHeader.GetFloat();
+		sStage.cBounds.size.width = sHeader.GetFloat();
+		sStage.cBounds.size.height = sHeader.GetFloat();
+		m_asStages.push_back( sStage );
+	}
+
+	m_iChunkColumns = static_cast<int>( sHeader.GetUInt32() );
+	m_iChunkRows = static_cast<int>( sHeader.GetUInt32() );
+
+	const int iChunks = m_iChunkColumns * m_iChunkRows;
+
+	for( int i = 0; i < iChunks && sHeader.bIsValid; i++ )
+	{
+		m_auiChunkOffsets.push_back( sHeader.GetUInt32() );
+		m_auiChunkSizes.push_back( sHeader.GetUInt32() );
+	}
+
+	if( !sHeader.bIsValid || m_iChunkSize <= 0 )
+	{
+		Close();
+		return false;
+	}
+
+	m_pcParent = pcParent;
+	m_apsChunks.assign( iChunks, nullptr );
+
+	return true;
+}
+
+void CChunkedMap::Close()
+{
+	for( int i = 0; i < static_cast<int>( m_apsChunks.size() ); i++ )
+	{
+		EvictChunk( i );
+	}
+
+	if( nullptr != m_pFile )
+	{
+		fclose( m_pFile );
+		m_pFile = nullptr;
+	}
+
+	CC_SAFE_RELEASE_NULL( m_pcMapInfo );
+
+	m_pcParent = nullptr;
+	m_asLayers.clear();
+	m_asStages.clear();
+	m_auiChunkOffsets.clear();
+	m_auiChunkSizes.clear();
+	m_apsChunks.clear();
+}
+
+void CChunkedMap::SetActiveStage( const int iStage )
+{
+	if( !IsOpen() )
+	{
+		return;
+	}
+
+	// The previous and next stages stay resident so that moving to them never waits on the disk
+	std::vector<bool> abRequired( m_apsChunks.size(), false );
+
+	for( int iNeighbour = iStage - 1; iNeighbour <= iStage + 1; iNeighbour++ )
+	{
+		GetStageChunks( iNeighbour, abRequired );
+	}
+
+	// Evict first so the budget is never exceeded while loading
+	for( int i = 0; i < static_cast<int>( m_apsChunks.size() ); i++ )
+	{
+		if( !abRequired[ i ] )
+		{
+			EvictChunk( i );
+		}
+	}
+
+	for( int i = 0; i < static_cast<int>( m_apsChunks.size() ); i++ )
+	{
+		if( abRequired[ i ] && nullptr == m_apsChunks[ i ] && !LoadChunk( i ) )
+		{
+			CCLOG( "Chunked map: failed to load chunk %d", i );
+		}
+	}
+
+	if( m_iResidentChunks > k_iChunkBudget )
+	{
+		CCLOG( "Chunked map: stage %d needs %d chunks, over the budget of %d", iStage, m_iResidentChunks, k_iChunkBudget );
+	}
+}
+
+void CChunkedMap::GetStageChunks( const int iStage, std::vector<bool>& rabRequired ) const
+{
+	const Size& rcTileSize = m_pcMapInfo->getTileSize();
+
+	for( const SStage& rsStage : m_asStages )
+	{
+		if( rsStage.iStage != iStage )
+		{
+			continue;
+		}
+
+		// Tiles seen during the stage, rows are counted from the top of the map
+		const int iFirstColumn = std::max( 0, static_cast<int>( rsStage.cBounds.getMinX() / rcTileSize.width ) - k_iStageMarginTiles );
+		const int iLastColumn = std::min( m_iMapColumns - 1, static_cast<int>( rsStage.cBounds.getMaxX() / rcTileSize.width ) + k_iStageMarginTiles );
+		const int iFirstRow = std::max( 0, m_iMapRows - 1 - static_cast<int>( rsStage.cBounds.getMaxY() / rcTileSize.height ) - k_iStageMarginTiles );
+		const int iLastRow = std::min( m_iMapRows - 1, m_iMapRows - 1 - static_cast<int>( rsStage.cBounds.getMinY() / rcTileSize.height ) + k_iStageMarginTiles );
+
+		for( int iChunkRow = iFirstRow / m_iChunkSize; iChunkRow <= iLastRow / m_iChunkSize; iChunkRow++ )
+		{
+			for( int iChunkColumn = iFirstColumn / m_iChunkSize; iChunkColumn <= iLastColumn / m_iChunkSize; iChunkColumn++ )
+			{
+				rabRequired[ iChunkRow * m_iChunkColumns + iChunkColumn ] = true;
+			}
+		}
+	}
+}
+
+bool CChunkedMap::LoadChunk( const int iIndex )
+{
+	std::vector<uint8_t> auiData( m_auiChunkSizes[ iIndex ] );
+
+	if( 0 != fseek( m_pFile, static_cast<long>( m_auiChunkOffsets[ iIndex ] ), SEEK_SET )
+		|| fread( auiData.data(), 1, auiData.size(), m_pFile ) != auiData.size() )
+	{
+		return false;
+	}
+
+	SChunk* psChunk = new SChunk();
+	psChunk->iIndex = iIndex;
+	psChunk->iFirstColumn = ( iIndex % m_iChunkColumns ) * m_iChunkSize;
+	psChunk->iFirstRow = ( iIndex / m_iChunkColumns ) * m_iChunkSize;
+	psChunk->iColumns = std::min( m_iChunkSize, m_iMapColumns - psChunk->iFirstColumn );
+	psChunk->iRows = std::min( m_iChunkSize, m_iMapRows - psChunk->iFirstRow );
+	psChunk->uiBytes = auiData.size();
+
+	SReader sReader( auiData );
+
+	psChunk->aauiTiles.resize( m_asLayers.size() );
+
+	for( std::vector<uint32_t>& rauiTiles : psChunk->aauiTiles )
+	{
+		rauiTiles.resize( psChunk->iColumns * psChunk->iRows );
+
+		for( uint32_t& ruiTile : rauiTiles )
+		{
+			ruiTile = sReader.GetUInt32();
+		}
+	}
+
+	const uint32_t uiObjects = sReader.GetUInt32();
+
+	for( uint32_t i = 0; i < uiObjects && sReader.bIsValid; i++ )
+	{
+		psChunk->asObjectGroups.push_back( sReader.GetString() );
+
+		ValueMap cObject;
+		const uint16_t uiValues = sReader.GetUInt16();
+
+		for( uint16_t j = 0; j < uiValues && sReader.bIsValid; j++ )
+		{
+			const std::string sKey = sReader.GetString();
+			cObject[ sKey ] = Value( sReader.GetString() );
+		}
+
+		psChunk->acObjects.push_back( Value( cObject ) );
+	}
+
+	if( !sReader.bIsValid )
+	{
+		delete psChunk;
+		return false;
+	}
+
+	if( nullptr != m_pcParent )
+	{
+		CreateChunkLayers( *psChunk );
+	}
+
+	m_apsChunks[ iIndex ] = psChunk;
+	m_iResidentChunks++;
+	m_uiResidentBytes += psChunk->uiBytes;
+
+	return true;
+}
+
+void CChunkedMap::CreateChunkLayers( SChunk& rsChunk )
+{
+	const Size& rcTileSize = m_pcMapInfo->getTileSize();
+	const size_t uiTiles = rsChunk.iColumns * rsChunk.iRows;
+
+	for( unsigned int iLayer = 0; iLayer < m_asLayers.size(); iLayer++ )
+	{
+		if( !m_asLayers[ iLayer ].bIsStreamed )
+		{
+			continue;
+		}
+
+		const std::vector<uint32_t>& rauiTiles = rsChunk.aauiTiles[ iLayer ];
+
+		// A FastTMXLayer uses one tileset, the one of its first tile like in TMXTiledMap
+		const auto cFirstTile = std::find_if( rauiTiles.begin(), rauiTiles.end(), []( const uint32_t uiTile ) { return 0 != uiTile; } );
+
+		if( cFirstTile == rauiTiles.end() )
+		{
+			continue;
+		}
+
+		const uint32_t uiGID = *cFirstTile & cocos2d::kTMXFlippedMask;
+		cocos2d::TMXTilesetInfo* pcTileset = nullptr;
+
+		for( cocos2d::TMXTilesetInfo* pcCandidate : m_pcMapInfo->getTilesets() )
+		{
+			if( static_cast<uint32_t>( pcCandidate->_firstGid ) <= uiGID
+				&& ( nullptr == pcTileset || pcCandidate->_firstGid > pcTileset->_firstGid ) )
+			{
+				pcTileset = pcCandidate;
+			}
+		}
+
+		if( nullptr == pcTileset )
+		{
+			continue;
+		}
+
+		// The layer takes the ownership of the tiles from its description
+		cocos2d::TMXLayerInfo* pcLayerInfo = new ( std::nothrow ) cocos2d::TMXLayerInfo();
+		pcLayerInfo->_name = m_asLayers[ iLayer ].sName;
+		pcLayerInfo->_layerSize = Size( static_cast<float>( rsChunk.iColumns ), static_cast<float>( rsChunk.iRows ) );
+		pcLayerInfo->_tiles = static_cast<uint32_t*>( malloc( uiTiles * sizeof( uint32_t ) ) );
+		pcLayerInfo->_ownTiles = true;
+		pcLayerInfo->_visible = m_asLayers[ iLayer ].bIsVisible;
+		pcLayerInfo->_opacity = m_asLayers[ iLayer ].uiOpacity;
+		memcpy( pcLayerInfo->_tiles, rauiTiles.data(), uiTiles * sizeof( uint32_t ) );
+
+		cocos2d::FastTMXLayer* pcLayer = cocos2d::FastTMXLayer::create( pcTileset, pcLayerInfo, m_pcMapInfo );
+		pcLayerInfo->release();
+
+		if( nullptr == pcLayer )
+		{
+			continue;
+		}
+
+		// Bottom left corner of the chunk in the map, layers of the map keep their index as z order
+		pcLayer->setPosition( CC_POINT_PIXELS_TO_POINTS( Vec2( rsChunk.iFirstColumn * rcTileSize.width,
+			( m_iMapRows - rsChunk.iFirstRow - rsChunk.iRows ) * rcTileSize.height ) ) );
+		pcLayer->setVisible( m_asLayers[ iLayer ].bIsVisible );
+		m_pcParent->addChild( pcLayer, static_cast<int>( iLayer ) );
+
+		// Kept alive until evicted, the parent may be destroyed before the map is closed
+		pcLayer->retain();
+		rsChunk.apcLayers.push_back( pcLayer );
+	}
+}
+
+void CChunkedMap::EvictChunk( const int iIndex )
+{
+	SChunk* psChunk = m_apsChunks[ iIndex ];
+
+	if( nullptr == psChunk )
+	{
+		return;
+	}
+
+	for( cocos2d::Node* pcLayer : psChunk->apcLayers )
+	{
+		pcLayer->removeFromParent();
+		pcLayer->release();
+	}
+
+	m_iResidentChunks--;
+	m_uiResidentBytes -= psChunk->uiBytes;
+
+	delete psChunk;
+	m_apsChunks[ iIndex ] = nullptr;
+}
+
+void CChunkedMap::GetObjects( const std::string& rsGroupName, cocos2d::ValueVector& racObjects ) const
+{
+	racObjects.clear();
+
+	for( const SChunk* psChunk : m_apsChunks )
+	{
+		if( nullptr == psChunk )
+		{
+			continue;
+		}
+
+		for( unsigned int i = 0; i < psChunk->acObjects.size(); i++ )
+		{
+			if( psChunk->asObjectGroups[ i ] == rsGroupName )
+			{
+				racObjects.push_back( psChunk->acObjects[ i ] );
+			}
+		}
+	}
+}
+
+uint32_t CChunkedMap::GetTileGID( const int iLayer, const int iColumn, const int iRow ) const
+{
+	if( iLayer < 0 || iLayer >= static_cast<int>( m_asLayers.size() ) || iColumn < 0 || iColumn >= m_iMapColumns
+		|| iRow < 0 || iRow >= m_iMapRows )
+	{
+		return 0;
+	}
+
+	const SChunk* psChunk = m_apsChunks[ ( iRow / m_iChunkSize ) * m_iChunkColumns + iColumn / m_iChunkSize ];
+
+	if( nullptr == psChunk )
+	{
+		return 0;
+	}
+
+	return psChunk->aauiTiles[ iLayer ][ ( iRow - psChunk->iFirstRow ) * psChunk->iColumns + ( iColumn - psChunk->iFirstColumn ) ];
+}
+
+bool CChunkedMap::IsLayerStreamed( const std::string& rsLayerName ) const
+{
+	for( const SLayer& rsLayer : m_asLayers )
+	{
+		if( rsLayer.sName == rsLayerName )
+		{
+			return rsLayer.bIsStreamed;
+		}
+	}
+
+	return false;
+}
+
+bool CChunkedMap::IsOpen() const							{ return nullptr != m_pFile; }
+
+int CChunkedMap::GetResidentChunks() const					{ return m_iResidentChunks; }
+
+size_t CChunkedMap::GetResidentBytes() const				{ return m_uiResidentBytes; }
+
+const std::vector<CChunkedMap::SStage>& CChunkedMap::GetStages() const	{ return m_asStages; }
@@ -0,0 +1,230 @@
+#ifndef CHUNKEDMAP_H
+#define CHUNKEDMAP_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <CCValue.h>
+#include <cocos/2d/CCTMXXMLParser.h>
+#include <cocos/math/CCGeometry.h>
+
+namespace cocos2d
+{
+	class Node;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CChunkedMap
+// Purpose				: To stream a level split in square chunks of tiles instead of keeping its whole Tiled map in memory.
+//						: Bake() converts a Tiled map into a chunk file holding, for every chunk, the tiles of all the layers
+//						: and the objects whose origin lies in it, along with the bounds of every stage. Once the file is
+//						: open, SetActiveStage() keeps the chunks of the active stage and of its neighbours resident and
+//						: evicts the others, so the memory used is bounded by the chunk budget rather than the level's size
+// Notes				: Resident chunks get one FastTMXLayer per map layer when a parent node is given, except for the layers
+//						: the parent keeps drawing itself, otherwise only their data is kept, e.g. for levels simulated
+//						: without rendering. The chunks' layers are retained until evicted, so the parent may be destroyed
+//						: first. Objects are read back as Tiled objects whose values are strings, which convert like the
+//						: parser's values
+// Example				: CChunkedMap::Bake( "Levels/Level1.tmx", sChunkFile ); cMap.Open( sChunkFile, pcMapNode, {} );
+//						: cMap.SetActiveStage( 2 ); cMap.GetObjects( "Platforms 2", acPlatforms );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CChunkedMap
+{
+
+public:
+
+	// Version of the file layout, increased whenever it changes
+	static const uint16_t k_uiVersion = 1;
+
+	// Side of a chunk in tiles used by Bake() unless told otherwise
+	static const int k_iDefaultChunkSize = 32;
+
+	// Most chunks resident at once, the active stage and its neighbours have to fit in it
+	static const int k_iChunkBudget = 24;
+
+	// Area of the map covered by the objects of a stage
+	struct SStage
+	{
+		int				iStage;
+		cocos2d::Rect	cBounds;
+	};
+
+	// Chunk loaded from the file
+	struct SChunk
+	{
+		// Index of the chunk in the file, row major from the top left of the map
+		int									iIndex;
+		// First tile and amount of tiles of the chunk, rows are counted from the top of the map like in Tiled
+		int									iFirstColumn;
+		int									iFirstRow;
+		int									iColumns;
+		int									iRows;
+		// GIDs of the chunk's tiles for every layer of the map, with their flip flags
+		std::vector<std::vector<uint32_t>>	aauiTiles;
+		// Name of the object group of every object and the object's values
+		std::vector<std::string>			asObjectGroups;
+		cocos2d::ValueVector				acObjects;
+		// Layers of the chunk attached to the parent node, empty if the map is not rendered
+		std::vector<cocos2d::Node*>			apcLayers;
+		// Bytes used by the tiles and the objects
+		size_t								uiBytes;
+	};
+
+private:
+
+	// Layer of the map as stored in the file
+	struct SLayer
+	{
+		std::string		sName;
+		bool			bIsVisible;
+		uint8_t			uiOpacity;
+		// False if the parent draws the layer itself, the chunks only hold its tiles
+		bool			bIsStreamed;
+	};
+
+	// Open chunk file, nullptr if no map is open
+	FILE* m_pFile;
+
+	// Node the layers of the resident chunks are attached to, nullptr if the map is not rendered
+	cocos2d::Node* m_pcParent;
+
+	// Map description shared by the layers of the chunks
+	cocos2d::TMXMapInfo* m_pcMapInfo;
+
+	// Size of the map and of a chunk in tiles
+	int m_iMapColumns;
+	int m_iMapRows;
+	int m_iChunkSize;
+
+	// Amount of chunks on each axis
+	int m_iChunkColumns;
+	int m_iChunkRows;
+
+	// Tile layers of the map, in drawing order
+	std::vector<SLayer> m_asLayers;
+
+	// Stages found in the map
+	std::vector<SStage> m_asStages;
+
+	// Offset and size of every chunk in the file
+	std::vector<uint32_t> m_auiChunkOffsets;
+	std::vector<uint32_t> m_auiChunkSizes;
+
+	// Resident chunks, nullptr for the evicted ones
+	std::vector<SChunk*> m_apsChunks;
+
+	// Amount of resident chunks and the bytes they use
+	int m_iResidentChunks;
+	size_t m_uiResidentBytes;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: LoadChunk()
+	// Parameters		: iIndex			- Index of the chunk in the file
+	// Purpose			: Read the chunk and create its layers
+	// Returns			: False if the chunk could not be read
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool LoadChunk( const int iIndex );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: EvictChunk()
+	// Parameters		: iIndex			- Index of the chunk in the file
+	// Purpose			: Remove the chunk's layers from the parent and free its data
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void EvictChunk( const int iIndex );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreateChunkLayers()
+	// Parameters		: rsChunk			- Chunk whose layers are created
+	// Purpose			: Create a FastTMXLayer for every streamed layer of the chunk holding tiles and attach it to the parent
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void CreateChunkLayers( SChunk& rsChunk );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetStageChunks()
+	// Parameters		: iStage			- ID of the stage
+	//					: rabRequired		- Chunks overlapping the stage are set to true
+	// Purpose			: Mark the chunks the stage needs
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GetStageChunks( const int iStage, std::vector<bool>& rabRequired ) const;
+
+	// Non copyable, the map owns its file and its chunks
+	CChunkedMap( const CChunkedMap& ) = delete;
+	CChunkedMap& operator=( const CChunkedMap& ) = delete;
+
+public:
+
+	CChunkedMap();
+	~CChunkedMap();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Bake()
+	// Parameters		: rsMapFile			- Tiled map to convert
+	//					: rsChunkFile		- Path of the chunk file to write
+	//					: iChunkSize		- Side of a chunk in tiles
+	// Purpose			: Split the map's tile layers and objects in chunks and write them with the bounds of every stage,
+	//					: run when the level is built or the first time it is played. Warns about the stages whose
+	//					: neighbourhood does not fit in the chunk budget
+	// Returns			: False if the map could not be parsed or the file could not be written
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static bool Bake( const std::string& rsMapFile, const std::string& rsChunkFile, const int iChunkSize = k_iDefaultChunkSize );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Open()
+	// Parameters		: rsChunkFile		- Chunk file written by Bake()
+	//					: pcParent			- Node the chunks' layers are attached to, nullptr to only keep their data
+	//					: rasKeptLayers		- Names of the layers the parent keeps drawing, no chunk layer is created for them
+	// Purpose			: Read the header, the layers, the stages and the chunk table, no chunk is loaded yet
+	// Returns			: False if the file is missing or not a chunk file of the current version
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Open( const std::string& rsChunkFile, cocos2d::Node* pcParent, const std::vector<std::string>& rasKeptLayers );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Close()
+	// Purpose			: Evict every chunk and close the file
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Close();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetActiveStage()
+	// Parameters		: iStage			- ID of the stage the player is in
+	// Purpose			: Load the chunks of the stage and of the previous and next stages and evict all the others
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetActiveStage( const int iStage );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetObjects()
+	// Parameters		: rsGroupName		- Name of the object group in the Tiled map
+	//					: racObjects		- Filled with the group's objects found in the resident chunks
+	// Purpose			: Gather an object group like TMXObjectGroup::getObjects(), complete for the groups of the active
+	//					: stage and of its neighbours
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GetObjects( const std::string& rsGroupName, cocos2d::ValueVector& racObjects ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTileGID()
+	// Parameters		: iLayer			- Index of the layer
+	//					: iColumn			- Column of the tile
+	//					: iRow				- Row of the tile, counted from the top of the map
+	// Returns			: The tile's GID with its flip flags, 0 if the tile is empty or its chunk is not resident
+	//-----------------------------------------------------------------------------------------------------------------------------
+	uint32_t GetTileGID( const int iLayer, const int iColumn, const int iRow ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: IsLayerStreamed()
+	// Parameters		: rsLayerName		- Name of a tile layer of the map
+	// Returns			: True if the resident chunks draw the layer, the parent's own layer can then be removed
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsLayerStreamed( const std::string& rsLayerName ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Getters
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsOpen() const;
+	int GetResidentChunks() const;
+	size_t GetResidentBytes() const;
+	const std::vector<SStage>& GetStages() const;
+};
+
+#endif // !CHUNKEDMAP_H
@@ -0,0 +1,286 @@
+#include "CollisionBitmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <cocos/base/ccMacros.h>
+
+using cocos2d::Rect;
+using cocos2d::Vec2;
+
+// Distance under which an edge is considered lying on a tile boundary
+static const float k_fEdgeTolerance = 0.001f;
+
+CCollisionBitmap::CCollisionBitmap()
+	: m_iColumns( 0 )
+	, m_iRows( 0 )
+{}
+
+void CCollisionBitmap::Initialise( const int iColumns, const int iRows, const cocos2d::Size& rcTileSize )
+{
+	CCASSERT( iColumns > 0 && iRows > 0, "Collision bitmap needs at least one tile" );
+	CCASSERT( rcTileSize.width > 0.0f && rcTileSize.height > 0.0f, "Collision bitmap tile size must be positive" );
+
+	m_iColumns = iColumns;
+	m_iRows = iRows;
+	m_cTileSize = rcTileSize;
+
+	m_auiTiles.assign( m_iColumns * m_iRows, 0 );
+}
+
+bool CCollisionBitmap::GetTileRange( const Rect& rcArea, int& riMinColumn, int& riMinRow, int& riMaxColumn, int& riMaxRow ) const
+{
+	riMinColumn = static_cast<int>( std::floor( rcArea.getMinX() / m_cTileSize.width + k_fEdgeTolerance ) );
+	riMinRow = static_cast<int>( std::floor( rcArea.getMinY() / m_cTileSize.height + k_fEdgeTolerance ) );
+	riMaxColumn = static_cast<int>( std::ceil( rcArea.getMaxX() / m_cTileSize.width - k_fEdgeTolerance ) ) - 1;
+	riMaxRow = static_cast<int>( std::ceil( rcArea.getMaxY() / m_cTileSize.height - k_fEdgeTolerance ) ) - 1;
+
+	// An area smaller than a tile still overlaps the tile it is in
+	riMaxColumn = std::max( riMaxColumn, riMinColumn );
+	riMaxRow = std::max( riMaxRow, riMinRow );
+
+	if( riMaxColumn < 0 || riMaxRow < 0 || riMinColumn >= m_iColumns || riMinRow >= m_iRows )
+	{
+		return false;
+	}
+
+	riMinColumn = std::max( riMinColumn, 0 );
+	riMinRow = std::max( riMinRow, 0 );
+	riMaxColumn = std::min( riMaxColumn, m_iColumns - 1 );
+	riMaxRow = std::min( riMaxRow, m_iRows - 1 );
+
+	return true;
+}
+
+Rect CCollisionBitmap::GetTileRect( const int iColumn, const int iRow ) const
+{
+	return Rect( iColumn * m_cTileSize.width, iRow * m_cTileSize.height, m_cTileSize.width, m_cTileSize.height );
+}
+
+void CCollisionBitmap::AddBox( const Rect& rcBox, const uint8_t uiLayers )
+{
+	int iMinColumn, iMinRow, iMaxColumn, iMaxRow;
+
+	if( !GetTileRange( rcBox, iMinColumn, iMinRow, iMaxColumn, iMaxRow ) )
+	{
+		return;
+	}
+
+	for( int iRow = iMinRow; iRow <= iMaxRow; iRow++ )
+	{
+		for( int iColumn = iMinColumn; iColumn <= iMaxColumn; iColumn++ )
+		{
+			m_auiTiles[ iRow * m_iColumns + iColumn ] |= uiLayers;
+		}
+	}
+}
+
+uint8_t CCollisionBitmap::GetTile( const int iColumn, const int iRow ) const
+{
+	if( iColumn < 0 || iRow < 0 || iColumn >= m_iColumns || iRow >= m_iRows )
+	{
+		return 0;
+	}
+
+	return m_auiTiles[ iRow * m_iColumns + iColumn ];
+}
+
+bool CCollisionBitmap::TestPoint( const Vec2& rcPoint, const uint8_t uiLayerMask ) const
+{
+	const int iColumn = static_cast<int>( std::floor( rcPoint.x / m_cTileSize.width ) );
+	const int iRow = static_cast<int>( std::floor( rcPoint.y / m_cTileSize.height ) );
+
+	return 0 != ( GetTile( iColumn, iRow ) & uiLayerMask );
+}
+
+bool CCollisionBitmap::Raycast( const Vec2& rcStart, const Vec2& rcEnd, const uint8_t uiLayerMask, SHit* psHit ) const
+{
+	const float fInfinity = std::numeric_limits<float>::infinity();
+
+	// Ray in tile units
+	const float fStartX = rcStart.x / m_cTileSize.width;
+	const float fStartY = rcStart.y / m_cTileSize.height;
+	const float fDirectionX = ( rcEnd.x - rcStart.x ) / m_cTileSize.width;
+	const float fDirectionY = ( rcEnd.y - rcStart.y ) / m_cTileSize.height;
+
+	int iColumn = static_cast<int>( std::floor( fStartX ) );
+	int iRow = static_cast<int>( std::floor( fStartY ) );
+
+	const int iStepX = ( fDirectionX > 0.0f ) ? 1 : -1;
+	const int iStepY = ( fDirectionY > 0.0f ) ? 1 : -1;
+
+	// Fraction of the ray needed to cross a whole tile on each axis
+	const float fDeltaX = ( 0.0f != fDirectionX ) ? std::abs( 1.0f / fDirectionX ) : fInfinity;
+	const float fDeltaY = ( 0.0f != fDirectionY ) ? std::abs( 1.0f / fDirectionY ) : fInfinity;
+
+	// Fraction of the ray at which the next vertical and horizontal tile boundaries are crossed
+	float fNextX = ( 0.0f == fDirectionX ) ? fInfinity
+		: ( fDirectionX > 0.0f ) ? ( iColumn + 1 - fStartX ) * fDeltaX : ( fStartX - iColumn ) * fDeltaX;
+	float fNextY = ( 0.0f == fDirectionY ) ? fInfinity
+		: ( fDirectionY > 0.0f ) ? ( iRow + 1 - fStartY ) * fDeltaY : ( fStartY - iRow ) * fDeltaY;
+
+	float fFraction = 0.0f;
+	Vec2 cNormal = Vec2::ZERO;
+
+	while( fFraction <= 1.0f )
+	{
+		const uint8_t uiTile = GetTile( iColumn, iRow );
+
+		if( 0 != ( uiTile & uiLayerMask ) )
+		{
+			if( nullptr != psHit )
+			{
+				psHit->fFraction = fFraction;
+				psHit->cPoint = rcStart + ( rcEnd - rcStart ) * fFraction;
+				psHit->cNormal = cNormal;
+				psHit->iColumn = iColumn;
+				psHit->iRow = iRow;
+				psHit->uiLayers = uiTile;
+			}
+
+			return true;
+		}
+
+		// Step into the tile whose boundary is crossed first
+		if( fNextX < fNextY )
+		{
+			fFraction = fNextX;
+			fNextX += fDeltaX;
+			iColumn += iStepX;
+			cNormal = Vec2( static_cast<float>( -iStepX ), 0.0f );
+		}
+		else
+		{
+			fFraction = fNextY;
+			fNextY += fDeltaY;
+			iRow += iStepY;
+			cNormal = Vec2( 0.0f, static_cast<float>( -iStepY ) );
+		}
+	}
+
+	return false;
+}
+
+bool CCollisionBitmap::SweepBox( const Rect& rcBox, const Vec2& rcMovement, const uint8_t uiLayerMask, SHit* psHit ) const
+{
+	const float fInfinity = std::numeric_limits<float>::infinity();
+
+	// Only the tiles overlapped by the area covered during the whole movement can be hit
+	Rect cSweptArea = rcBox;
+	cSweptArea.merge( Rect( rcBox.origin + rcMovement, rcBox.size ) );
+
+	int iMinColumn, iMinRow, iMaxColumn, iMaxRow;
+
+	if( !GetTileRange( cSweptArea, iMinColumn, iMinRow, iMaxColumn, iMaxRow ) )
+	{
+		return false;
+	}
+
+	bool bHasHit = false;
+	float fFirstFraction = fInfinity;
+
+	for( int iRow = iMinRow; iRow <= iMaxRow; iRow++ )
+	{
+		for( int iColumn = iMinColumn; iColumn <= iMaxColumn; iColumn++ )
+		{
+			const uint8_t uiTile = m_auiTiles[ iRow * m_iColumns + iColumn ];
+
+			if( 0 == ( uiTile & uiLayerMask ) )
+			{
+				continue;
+			}
+
+			const Rect cTile = GetTileRect( iColumn, iRow );
+
+			// Fractions of the movement at which the box enters and exits the tile's slab on each axis
+			float fEntryX = -fInfinity;
+			float fExitX = fInfinity;
+			float fEntryY = -fInfinity;
+			float fExitY = fInfinity;
+
+			if( 0.0f != rcMovement.x )
+			{
+				const float fNear = ( rcMovement.x > 0.0f ) ? cTile.getMinX() - rcBox.getMaxX() : cTile.getMaxX() - rcBox.getMinX();
+				const float fFar = ( rcMovement.x > 0.0f ) ? cTile.getMaxX() - rcBox.getMinX() : cTile.getMinX() - rcBox.getMaxX();
+				fEntryX = fNear / rcMovement.x;
+				fExitX = fFar / rcMovement.x;
+			}
+			else if( rcBox.getMaxX() <= cTile.getMinX() || rcBox.getMinX() >= cTile.getMaxX() )
+			{
+				// Not moving on this axis and not overlapping the tile on it, the tile cannot be hit
+				continue;
+			}
+
+			if( 0.0f != rcMovement.y )
+			{
+				const float fNear = ( rcMovement.y > 0.0f ) ? cTile.getMinY() - rcBox.getMaxY() : cTile.getMaxY() - rcBox.getMinY();
+				const float fFar = ( rcMovement.y > 0.0f ) ? cTile.getMaxY() - rcBox.getMinY() : cTile.getMinY() - rcBox.getMaxY();
+				fEntryY = fNear / rcMovement.y;
+				fExitY = fFar / rcMovement.y;
+			}
+			else if( rcBox.getMaxY() <= cTile.getMinY() || rcBox.getMinY() >= cTile.getMaxY() )
+			{
+				continue;
+			}
+
+			const float fEntry = std::max( fEntryX, fEntryY );
+			const float fExit = std::min( fExitX, fExitY );
+
+			// Missed, moving away from the tile or reaching it after the end of the movement
+			if( fEntry >= fExit || fExit <= 0.0f || fEntry > 1.0f )
+			{
+				continue;
+			}
+
+			// A box starting inside the tile hits it straight away
+			const float fFraction = std::max( fEntry, 0.0f );
+
+			if( fFraction < fFirstFraction )
+			{
+				fFirstFraction = fFraction;
+				bHasHit = true;
+
+				if( nullptr != psHit )
+				{
+					psHit->fFraction = fFraction;
+					psHit->cPoint = rcBox.origin + rcMovement * fFraction;
+					psHit->iColumn = iColumn;
+					psHit->iRow = iRow;
+					psHit->uiLayers = uiTile;
+
+					// The side hit is the one of the axis entered last
+					if( fEntry < 0.0f )
+					{
+						psHit->cNormal = Vec2::ZERO;
+					}
+					else if( fEntryX > fEntryY )
+					{
+						psHit->cNormal = Vec2( ( rcMovement.x > 0.0f ) ? -1.0f : 1.0f, 0.0f );
+					}
+					else
+					{
+						psHit->cNormal = Vec2( 0.0f, ( rcMovement.y > 0.0f ) ? -1.0f : 1.0f );
+					}
+				}
+			}
+		}
+	}
+
+	return bHasHit;
+}
+
+int CCollisionBitmap::GetColumns() const
+{
+	return m_iColumns;
+}
+
+int CCollisionBitmap::GetRows() const
+{
+	return m_iRows;
+}
+
+const cocos2d::Size& CCollisionBitmap::GetTileSize() const
+{
+	return m_cTileSize;
+}
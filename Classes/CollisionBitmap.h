@@ -0,0 +1,165 @@
+#ifndef COLLISIONBITMAP_H
+#define COLLISIONBITMAP_H
+
+#include <cstdint>
+#include <vector>
+
+#include <cocos/math/CCGeometry.h>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CCollisionBitmap
+// Purpose				: To answer "is there floor, wall or something climbable here" without going through the physics
+//						: engine. The static environment of a level is baked at tile resolution, every tile storing one bit
+//						: per environment layer, and queried with point tests, DDA raycasts and box sweeps
+// Notes				: Coordinates are in map space, row 0 is the bottom row of the map as in cocos2d-x
+//-----------------------------------------------------------------------------------------------------------------------------
+class CCollisionBitmap
+{
+
+public:
+
+	// Bits stored per tile, combined into masks to select the layers a query is interested in
+	enum ELayer : uint8_t
+	{
+		Bound		= 1 << 0,
+		Wall		= 1 << 1,
+		Floor		= 1 << 2,
+		Obstacle	= 1 << 3,
+		Climb		= 1 << 4,
+		All			= Bound | Wall | Floor | Obstacle | Climb
+	};
+
+	// Result of a raycast or a box sweep
+	struct SHit
+	{
+		// Fraction of the ray or of the sweep's movement travelled before the hit, 0 if it started inside a tile
+		float			fFraction;
+		// Position of the hit, the start of the ray or the origin of the box at the time of impact
+		cocos2d::Vec2	cPoint;
+		// Normal of the tile's side that has been hit, zero if the query started inside the tile
+		cocos2d::Vec2	cNormal;
+		// Tile that has been hit
+		int				iColumn;
+		int				iRow;
+		// Every layer set in the tile that has been hit
+		uint8_t			uiLayers;
+	};
+
+private:
+
+	// Size of a tile in map space
+	cocos2d::Size m_cTileSize;
+
+	// Amount of tiles along the x and y axis
+	int m_iColumns;
+	int m_iRows;
+
+	// Layer bits of every tile, row by row from the bottom of the map
+	std::vector<uint8_t> m_auiTiles;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTileRange()
+	// Parameters		: rcArea			- Area in map space
+	//					: riMinColumn		- First column overlapped by the area
+	//					: riMinRow			- First row overlapped by the area
+	//					: riMaxColumn		- Last column overlapped by the area
+	//					: riMaxRow			- Last row overlapped by the area
+	// Purpose			: Find the tiles overlapped by the area, clamped to the map. Edges lying on a tile boundary do not
+	//					: overlap the next tile
+	// Returns			: False if the area is completely outside the map
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool GetTileRange( const cocos2d::Rect& rcArea, int& riMinColumn, int& riMinRow, int& riMaxColumn, int& riMaxRow ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTileRect()
+	// Parameters		: iColumn			- Column of the tile
+	//					: iRow				- Row of the tile
+	// Returns			: The area of the tile in map space
+	//-----------------------------------------------------------------------------------------------------------------------------
+	cocos2d::Rect GetTileRect( const int iColumn, const int iRow ) const;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CCollisionBitmap()
+	// Purpose			: Create an empty bitmap with no tiles
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CCollisionBitmap();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Initialise()
+	// Parameters		: iColumns			- Amount of tiles along the x axis
+	//					: iRows				- Amount of tiles along the y axis
+	//					: rcTileSize		- Size of a tile in map space
+	// Purpose			: Allocate the tiles and clear all their layers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Initialise( const int iColumns, const int iRows, const cocos2d::Size& rcTileSize );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddBox()
+	// Parameters		: rcBox				- Area in map space, usually a static object of the Tiled map
+	//					: uiLayers			- Layers to set in every tile overlapped by the area
+	// Purpose			: Bake an area of the environment in the bitmap
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void AddBox( const cocos2d::Rect& rcBox, const uint8_t uiLayers );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTile()
+	// Parameters		: iColumn			- Column of the tile
+	//					: iRow				- Row of the tile
+	// Returns			: The layers set in the tile, 0 for tiles outside the map
+	//-----------------------------------------------------------------------------------------------------------------------------
+	uint8_t GetTile( const int iColumn, const int iRow ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: TestPoint()
+	// Parameters		: rcPoint			- Point in map space
+	//					: uiLayerMask		- Layers to test
+	// Returns			: True if the tile containing the point has one of the layers set
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool TestPoint( const cocos2d::Vec2& rcPoint, const uint8_t uiLayerMask ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Raycast()
+	// Parameters		: rcStart			- Start of the ray in map space
+	//					: rcEnd				- End of the ray in map space
+	//					: uiLayerMask		- Layers that stop the ray
+	//					: psHit				- Filled with the first hit, can be nullptr for a line of sight test
+	// Purpose			: Walk the tiles crossed by the segment in order, using a DDA traversal, until one of them has one of
+	//					: the layers set
+	// Returns			: True if the segment hits a tile
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Raycast( const cocos2d::Vec2& rcStart, const cocos2d::Vec2& rcEnd, const uint8_t uiLayerMask, SHit* psHit ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SweepBox()
+	// Parameters		: rcBox				- Box in map space at the start of the movement
+	//					: rcMovement		- Movement of the box
+	//					: uiLayerMask		- Layers that stop the box
+	//					: psHit				- Filled with the first hit, can be nullptr
+	// Purpose			: Find the first tile the box would touch moving along the given vector. Touching a tile without
+	//					: moving into it is not a hit, so a box resting on the floor can slide along it
+	// Returns			: True if the box hits a tile before the end of the movement
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool SweepBox( const cocos2d::Rect& rcBox, const cocos2d::Vec2& rcMovement, const uint8_t uiLayerMask, SHit* psHit ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetColumns()
+	// Returns			: The amount of tiles along the x axis
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetColumns() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetRows()
+	// Returns			: The amount of tiles along the y axis
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetRows() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTileSize()
+	// Returns			: The size of a tile in map space
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const cocos2d::Size& GetTileSize() const;
+};
+
+#endif // !COLLISIONBITMAP_H
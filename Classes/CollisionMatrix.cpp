@@ -0,0 +1,206 @@
+#include "CollisionMatrix.h"
+
+#include "Settings.h"
+
+#include <utility>
+
+#include <CCEventDispatcher.h>
+#include <CCEventListenerCustom.h>
+#include <cocos/physics/CCPhysicsContact.h>
+#include <cocos/physics/CCPhysicsShape.h>
+
+// Name of the custom event used by cocos2d-x to dispatch physics contacts
+static const char* const k_pszPhysicsContactEvent = "PhysicsContactEvent";
+
+// Names of the categories, in the same order of CollisionMatrix::ECategory
+static const char* const k_apszCategoryNames[] =
+{
+	"Player",
+	"Wall",
+	"Platform",
+	"Trigger",
+	"Enemy",
+	"Pickup",
+};
+
+static_assert( sizeof( k_apszCategoryNames ) / sizeof( k_apszCategoryNames[ 0 ] ) == CollisionMatrix::k_iNumOfCategories,
+	"Every collision category needs a name" );
+
+// The classes outside the matrix still test the masks of Settings.h, every category has to own the same bit
+static_assert( CollisionMatrix::CategoryBitmask( CollisionMatrix::ECategory::Player ) == PLAYER_BITMASK_CATEGORY,
+	"Player category out of sync with Settings.h" );
+static_assert( CollisionMatrix::CategoryBitmask( CollisionMatrix::ECategory::Wall ) == WALL_BITMASK_CATEGORY,
+	"Wall category out of sync with Settings.h" );
+static_assert( CollisionMatrix::CategoryBitmask( CollisionMatrix::ECategory::Platform ) == PLATFORM_BITMASK_CATEGORY,
+	"Platform category out of sync with Settings.h" );
+static_assert( CollisionMatrix::CategoryBitmask( CollisionMatrix::ECategory::Trigger ) == TRIGGER_BITMASK_CATEGORY,
+	"Trigger category out of sync with Settings.h" );
+static_assert( CollisionMatrix::CategoryBitmask( CollisionMatrix::ECategory::Enemy ) == ENEMY_BITMASK_CATEGORY,
+	"Enemy category out of sync with Settings.h" );
+static_assert( CollisionMatrix::CategoryBitmask( CollisionMatrix::ECategory::Pickup ) == PICKUP_BITMASK_CATEGORY,
+	"Pickup category out of sync with Settings.h" );
+
+void CollisionMatrix::ApplyFilter( cocos2d::PhysicsShape* pcShape, const ECategory eCategory )
+{
+	CCASSERT( nullptr != pcShape, "Shape is null" );
+
+	pcShape->setCategoryBitmask( CategoryBitmask( eCategory ) );
+	pcShape->setCollisionBitmask( CollisionBitmask( eCategory ) );
+	pcShape->setContactTestBitmask( ContactTestBitmask( eCategory ) );
+}
+
+int CollisionMatrix::GetCategoryIndex( const int iCategoryBitmask )
+{
+	for( int i = 0; i < k_iNumOfCategories; i++ )
+	{
+		if( 0 != ( iCategoryBitmask & ( 1 << i ) ) )
+		{
+			return i;
+		}
+	}
+
+	return k_iNumOfCategories;
+}
+
+const char* CollisionMatrix::GetCategoryName( const int iCategory )
+{
+	return ( iCategory >= 0 && iCategory < k_iNumOfCategories ) ? k_apszCategoryNames[ iCategory ] : "Unknown";
+}
+
+CContactStats::CContactStats()
+	: m_pcEventDispatcher( nullptr )
+	, m_pcListener( nullptr )
+{
+	Reset();
+}
+
+CContactStats::~CContactStats()
+{
+	Detach();
+}
+
+void CContactStats::Attach( cocos2d::EventDispatcher* pcEventDispatcher )
+{
+	CCASSERT( nullptr != pcEventDispatcher, "Event dispatcher is null" );
+
+	Detach();
+
+	m_pcEventDispatcher = pcEventDispatcher;
+
+	// A custom listener only reads the contact, a physics contact listener would overwrite the result set by the game's one
+	m_pcListener = cocos2d::EventListenerCustom::create( k_pszPhysicsContactEvent, [this]( cocos2d::EventCustom* pcEvent )
+	{
+		cocos2d::PhysicsContact* pcContact = static_cast<cocos2d::PhysicsContact*>( pcEvent );
+
+		const cocos2d::PhysicsContact::EventCode eCode = pcContact->getEventCode();
+
+		if( cocos2d::PhysicsContact::EventCode::BEGIN == eCode || cocos2d::PhysicsContact::EventCode::SEPARATE == eCode )
+		{
+			RecordContact( pcContact->getShapeA()->getCategoryBitmask(), pcContact->getShapeB()->getCategoryBitmask(),
+				cocos2d::PhysicsContact::EventCode::BEGIN == eCode );
+		}
+	} );
+
+	// Lowest priority so the game's listeners are called first
+	m_pcEventDispatcher->addEventListenerWithFixedPriority( m_pcListener, 1 );
+}
+
+void CContactStats::Detach()
+{
+	if( nullptr != m_pcListener )
+	{
+		m_pcEventDispatcher->removeEventListener( m_pcListener );
+		m_pcListener = nullptr;
+		m_pcEventDispatcher = nullptr;
+	}
+}
+
+void CContactStats::RecordContact( const int iCategoryBitmaskA, const int iCategoryBitmaskB, const bool bBegin )
+{
+	int iFirst = CollisionMatrix::GetCategoryIndex( iCategoryBitmaskA );
+	int iSecond = CollisionMatrix::GetCategoryIndex( iCategoryBitmaskB );
+
+	if( iFirst >= CollisionMatrix::k_iNumOfCategories || iSecond >= CollisionMatrix::k_iNumOfCategories )
+	{
+		return;
+	}
+
+	// Pairs are stored once, with the lowest category first
+	if( iFirst > iSecond )
+	{
+		std::swap( iFirst, iSecond );
+	}
+
+	if( bBegin )
+	{
+		m_auiBeginContacts[ iFirst ][ iSecond ]++;
+	}
+	else
+	{
+		m_auiSeparateContacts[ iFirst ][ iSecond ]++;
+	}
+}
+
+void CContactStats::Tick()
+{
+	m_uiFrames++;
+}
+
+unsigned int CContactStats::GetBeginContacts( const CollisionMatrix::ECategory eFirst, const CollisionMatrix::ECategory eSecond ) const
+{
+	int iFirst = static_cast<int>( eFirst );
+	int iSecond = static_cast<int>( eSecond );
+
+	if( iFirst > iSecond )
+	{
+		std::swap( iFirst, iSecond );
+	}
+
+	return m_auiBeginContacts[ iFirst ][ iSecond ];
+}
+
+void CContactStats::Log() const
+{
+	CCLOG( "Contact callbacks over %u frames", m_uiFrames );
+
+	for( int iFirst = 0; iFirst < CollisionMatrix::k_iNumOfCategories; iFirst++ )
+	{
+		for( int iSecond = iFirst; iSecond < CollisionMatrix::k_iNumOfCategories; iSecond++ )
+		{
+			const CollisionMatrix::EResponse eResponse = CollisionMatrix::GetResponse(
+				static_cast<CollisionMatrix::ECategory>( iFirst ), static_cast<CollisionMatrix::ECategory>( iSecond ) );
+
+			const bool bNotifies = CollisionMatrix::EResponse::Trigger == eResponse
+				|| CollisionMatrix::EResponse::CollideAndNotify == eResponse;
+
+			const unsigned int uiBegin = m_auiBeginContacts[ iFirst ][ iSecond ];
+			const unsigned int uiSeparate = m_auiSeparateContacts[ iFirst ][ iSecond ];
+
+			// Pairs that never notify and never fired are not interesting
+			if( !bNotifies && 0 == uiBegin && 0 == uiSeparate )
+			{
+				continue;
+			}
+
+			const float fPerFrame = ( m_uiFrames > 0 ) ? static_cast<float>( uiBegin + uiSeparate ) / m_uiFrames : 0.0f;
+
+			CCLOG( "%s - %s: begin %u, separate %u, %.3f per frame%s", CollisionMatrix::GetCategoryName( iFirst ),
+				CollisionMatrix::GetCategoryName( iSecond ), uiBegin, uiSeparate, fPerFrame,
+				( bNotifies && 0 == uiBegin ) ? " (never fired, candidate for removal)" : "" );
+		}
+	}
+}
+
+void CContactStats::Reset()
+{
+	for( int iFirst = 0; iFirst < CollisionMatrix::k_iNumOfCategories; iFirst++ )
+	{
+		for( int iSecond = 0; iSecond < CollisionMatrix::k_iNumOfCategories; iSecond++ )
+		{
+			m_auiBeginContacts[ iFirst ][ iSecond ] = 0;
+			m_auiSeparateContacts[ iFirst ][ iSecond ] = 0;
+		}
+	}
+
+	m_uiFrames = 0;
+}
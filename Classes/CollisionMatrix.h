@@ -0,0 +1,269 @@
+#ifndef COLLISIONMATRIX_H
+#define COLLISIONMATRIX_H
+
+namespace cocos2d
+{
+	class EventDispatcher;
+	class EventListener;
+	class PhysicsShape;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Namespace Name		: CollisionMatrix
+// Purpose				: Central declaration of how every physics category interacts with the others. The category, collision
+//						: and contact test bitmasks of all the game's shapes are derived at compile time from the rules table,
+//						: so a pair is changed in one place instead of in every class that creates a shape
+// Notes				: Every shape of the game, including the player's, has to get its bitmasks through ApplyFilter()
+//-----------------------------------------------------------------------------------------------------------------------------
+namespace CollisionMatrix
+{
+	// Physics categories of the game, each one owns a bit of the bitmasks. The bits are the ones of the *_BITMASK_CATEGORY
+	// masks of Settings.h, which CollisionMatrix.cpp checks at compile time
+	enum class ECategory : int
+	{
+		Player = 0,
+		Wall,
+		Platform,
+		Trigger,
+		Enemy,
+		Pickup,
+		Count
+	};
+
+	// How two categories respond to each other
+	enum class EResponse : int
+	{
+		// No collision and no contact callback
+		Ignore = 0,
+		// Solid collision, the contact callbacks are not woken up
+		Collide,
+		// Solid collision and contact callbacks
+		CollideAndNotify,
+		// Contact callbacks only, the shapes go through each other
+		Trigger
+	};
+
+	// Response between a pair of categories, the order of the pair does not matter
+	struct SRule
+	{
+		ECategory	eFirst;
+		ECategory	eSecond;
+		EResponse	eResponse;
+	};
+
+	// Every pair not listed here is ignored
+	constexpr SRule k_asRules[] =
+	{
+		{ ECategory::Player,	ECategory::Wall,		EResponse::CollideAndNotify },
+		{ ECategory::Player,	ECategory::Platform,	EResponse::CollideAndNotify },
+		{ ECategory::Player,	ECategory::Enemy,		EResponse::Trigger },
+		{ ECategory::Player,	ECategory::Trigger,		EResponse::Trigger },
+		{ ECategory::Player,	ECategory::Pickup,		EResponse::Trigger },
+		{ ECategory::Enemy,		ECategory::Wall,		EResponse::Collide },
+		{ ECategory::Enemy,		ECategory::Platform,	EResponse::Collide },
+	};
+
+	// Amount of rules in the matrix
+	constexpr int k_iNumOfRules = sizeof( k_asRules ) / sizeof( k_asRules[ 0 ] );
+
+	// Amount of categories in the matrix
+	constexpr int k_iNumOfCategories = static_cast<int>( ECategory::Count );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CategoryBitmask()
+	// Parameters		: eCategory			- Category of the shape
+	// Returns			: The bit owned by the category
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr int CategoryBitmask( const ECategory eCategory )
+	{
+		return 1 << static_cast<int>( eCategory );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: PartnerBitmask()
+	// Parameters		: rsRule			- Rule to check
+	//					: eCategory			- Category looking for its partner in the rule
+	// Returns			: The bit of the other category of the rule, 0 if the rule does not involve eCategory
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr int PartnerBitmask( const SRule& rsRule, const ECategory eCategory )
+	{
+		return ( rsRule.eFirst == eCategory ) ? CategoryBitmask( rsRule.eSecond )
+			: ( rsRule.eSecond == eCategory ) ? CategoryBitmask( rsRule.eFirst )
+			: 0;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CollisionBitmask()
+	// Parameters		: eCategory			- Category of the shape
+	//					: iRule				- First rule to check, only used by the recursion
+	// Returns			: The categories the shape physically collides with
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr int CollisionBitmask( const ECategory eCategory, const int iRule = 0 )
+	{
+		return ( iRule >= k_iNumOfRules ) ? 0
+			: ( ( EResponse::Collide == k_asRules[ iRule ].eResponse || EResponse::CollideAndNotify == k_asRules[ iRule ].eResponse )
+				? PartnerBitmask( k_asRules[ iRule ], eCategory ) : 0 )
+			| CollisionBitmask( eCategory, iRule + 1 );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ContactTestBitmask()
+	// Parameters		: eCategory			- Category of the shape
+	//					: iRule				- First rule to check, only used by the recursion
+	// Returns			: The categories that wake up the contact callbacks when touching the shape
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr int ContactTestBitmask( const ECategory eCategory, const int iRule = 0 )
+	{
+		return ( iRule >= k_iNumOfRules ) ? 0
+			: ( ( EResponse::Trigger == k_asRules[ iRule ].eResponse || EResponse::CollideAndNotify == k_asRules[ iRule ].eResponse )
+				? PartnerBitmask( k_asRules[ iRule ], eCategory ) : 0 )
+			| ContactTestBitmask( eCategory, iRule + 1 );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetResponse()
+	// Parameters		: eFirst			- Category of the first shape
+	//					: eSecond			- Category of the second shape
+	//					: iRule				- First rule to check, only used by the recursion
+	// Returns			: The response declared for the pair, Ignore if the pair is not in the matrix
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr EResponse GetResponse( const ECategory eFirst, const ECategory eSecond, const int iRule = 0 )
+	{
+		return ( iRule >= k_iNumOfRules ) ? EResponse::Ignore
+			: ( ( k_asRules[ iRule ].eFirst == eFirst && k_asRules[ iRule ].eSecond == eSecond )
+				|| ( k_asRules[ iRule ].eFirst == eSecond && k_asRules[ iRule ].eSecond == eFirst ) ) ? k_asRules[ iRule ].eResponse
+			: GetResponse( eFirst, eSecond, iRule + 1 );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AreRulesUnique()
+	// Parameters		: iFirst			- Index of the first rule of the pair to compare
+	//					: iSecond			- Index of the second rule of the pair to compare
+	// Purpose			: Used to catch at compile time a pair of categories declared twice with different responses
+	// Returns			: True if every pair of categories appears at most once
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr bool AreRulesUnique( const int iFirst = 0, const int iSecond = 1 )
+	{
+		return ( iFirst >= k_iNumOfRules ) ? true
+			: ( iSecond >= k_iNumOfRules ) ? AreRulesUnique( iFirst + 1, iFirst + 2 )
+			: !( ( k_asRules[ iFirst ].eFirst == k_asRules[ iSecond ].eFirst && k_asRules[ iFirst ].eSecond == k_asRules[ iSecond ].eSecond )
+				|| ( k_asRules[ iFirst ].eFirst == k_asRules[ iSecond ].eSecond && k_asRules[ iFirst ].eSecond == k_asRules[ iSecond ].eFirst ) )
+				&& AreRulesUnique( iFirst, iSecond + 1 );
+	}
+
+	static_assert( AreRulesUnique(), "A pair of categories is declared more than once in the collision matrix" );
+	static_assert( k_iNumOfCategories <= 32, "Physics bitmasks only have 32 bits" );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ApplyFilter()
+	// Parameters		: pcShape			- Shape to configure
+	//					: eCategory			- Category of the shape
+	// Purpose			: Set the category, collision and contact test bitmasks of the shape from the matrix
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ApplyFilter( cocos2d::PhysicsShape* pcShape, const ECategory eCategory );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetCategoryIndex()
+	// Parameters		: iCategoryBitmask	- Category bitmask of a shape
+	// Returns			: The index of the lowest category in the bitmask, ECategory::Count if there is none
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetCategoryIndex( const int iCategoryBitmask );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetCategoryName()
+	// Parameters		: iCategory			- Index of the category
+	// Returns			: The name of the category, used for logging
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const char* GetCategoryName( const int iCategory );
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CContactStats
+// Purpose				: To count at runtime the contact callbacks woken up by every pair of categories. Pairs declared as
+//						: notifying that never fire, or firing far more than expected, show which contact test bits can be removed
+//						: from the matrix and how much they cost per physics step
+//-----------------------------------------------------------------------------------------------------------------------------
+class CContactStats
+{
+
+private:
+	// Dispatcher the counting listener is registered to
+	cocos2d::EventDispatcher* m_pcEventDispatcher;
+
+	// Listener counting the contact events, it never changes the contact's result
+	cocos2d::EventListener* m_pcListener;
+
+	// Begin contact events per pair of categories
+	unsigned int m_auiBeginContacts[ CollisionMatrix::k_iNumOfCategories ][ CollisionMatrix::k_iNumOfCategories ];
+
+	// Separate contact events per pair of categories
+	unsigned int m_auiSeparateContacts[ CollisionMatrix::k_iNumOfCategories ][ CollisionMatrix::k_iNumOfCategories ];
+
+	// Frames counted since the last reset
+	unsigned int m_uiFrames;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CContactStats()
+	// Purpose			: Create the stats with all counters to 0, not attached to any dispatcher
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CContactStats();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Destructor name	: ~CContactStats()
+	// Purpose			: Detach the counting listener if still registered
+	//-----------------------------------------------------------------------------------------------------------------------------
+	~CContactStats();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Attach()
+	// Parameters		: pcEventDispatcher	- Dispatcher receiving the physics contact events
+	// Purpose			: Register the counting listener
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Attach( cocos2d::EventDispatcher* pcEventDispatcher );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Detach()
+	// Purpose			: Unregister the counting listener
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Detach();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: RecordContact()
+	// Parameters		: iCategoryBitmaskA	- Category bitmask of the first shape of the contact
+	//					: iCategoryBitmaskB	- Category bitmask of the second shape of the contact
+	//					: bBegin			- True for a begin event, false for a separate event
+	// Purpose			: Count a contact event for the pair of categories
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void RecordContact( const int iCategoryBitmaskA, const int iCategoryBitmaskB, const bool bBegin );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Tick()
+	// Purpose			: Count a frame, used to report the average callbacks per frame
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Tick();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetBeginContacts()
+	// Parameters		: eFirst			- Category of the first shape
+	//					: eSecond			- Category of the second shape
+	// Returns			: The begin contact events counted for the pair
+	//-----------------------------------------------------------------------------------------------------------------------------
+	unsigned int GetBeginContacts( const CollisionMatrix::ECategory eFirst, const CollisionMatrix::ECategory eSecond ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Log()
+	// Purpose			: Log the counters of every pair that notifies or received contact events, flagging the notifying pairs
+	//					: that never fired
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Log() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Reset()
+	// Purpose			: Set all counters to 0
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Reset();
+};
+
+#endif // !COLLISIONMATRIX_H
@@ -0,0 +1,219 @@
+#include "DecodedImageCache.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cocos/base/ccMacros.h>
+#include <cocos/platform/CCFileUtils.h>
+#include <cocos/platform/CCImage.h>
+
+// Magic number at the start of every cached image, "DIMG" read in the byte order of the device writing it
+static const uint32_t k_uiMagic = 0x474D4944u;
+
+// Version of the file layout, older files are decoded again
+static const uint32_t k_uiVersion = 1;
+
+// Offset of the pixels in the file, aligned for the texture upload
+static const size_t k_uiPixelsOffset = 64;
+
+// Layout of the start of a cached image, in the byte order of the device
+struct SHeader
+{
+	uint32_t	uiMagic;
+	uint32_t	uiVersion;
+	uint64_t	uiSourceHash;
+	uint64_t	uiSourceSize;
+	int32_t		iWidth;
+	int32_t		iHeight;
+	uint32_t	uiPremultipliedAlpha;
+	uint32_t	uiPixelsSize;
+};
+
+static_assert( sizeof( SHeader ) <= k_uiPixelsOffset, "Cached image header overlaps the pixels" );
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: IsValidHeader()
+// Parameters		: rsHeader			- Header read from a cached image
+//					: uiSourceHash		- Hash of the image file's content
+//					: uiSourceSize		- Size of the image file
+//					: uiFileSize		- Size of the cached image's file
+// Returns			: True if the header describes the source and the file holds all its pixels
+//-----------------------------------------------------------------------------------------------------------------------------
+static bool IsValidHeader( const SHeader& rsHeader, const uint64_t uiSourceHash, const size_t uiSourceSize, const size_t uiFileSize )
+{
+	return k_uiMagic == rsHeader.uiMagic && k_uiVersion == rsHeader.uiVersion
+		&& uiSourceHash == rsHeader.uiSourceHash && uiSourceSize == rsHeader.uiSourceSize
+		&& rsHeader.iWidth > 0 && rsHeader.iHeight > 0
+		&& static_cast<uint64_t>( rsHeader.iWidth ) * rsHeader.iHeight * 4 == rsHeader.uiPixelsSize
+		&& k_uiPixelsOffset + rsHeader.uiPixelsSize == uiFileSize;
+}
+
+CDecodedImageCache::CDecodedImageCache( const std::string& rsDirectory )
+	: m_sDirectory( rsDirectory )
+{
+	if( !m_sDirectory.empty() && '/' != m_sDirectory.back() )
+	{
+		m_sDirectory += '/';
+	}
+
+	cocos2d::FileUtils* pcFileUtils = cocos2d::FileUtils::getInstance();
+
+	if( !pcFileUtils->isDirectoryExist( m_sDirectory ) && !pcFileUtils->createDirectory( m_sDirectory ) )
+	{
+		CCLOG( "Decoded image cache: cannot create %s, every image is decoded", m_sDirectory.c_str() );
+	}
+}
+
+uint64_t CDecodedImageCache::HashContent( const unsigned char* puiBytes, const size_t uiSize )
+{
+	uint64_t uiHash = 14695981039346656037ull;
+
+	for( size_t i = 0; i < uiSize; i++ )
+	{
+		uiHash = ( uiHash ^ puiBytes[ i ] ) * 1099511628211ull;
+	}
+
+	return uiHash;
+}
+
+std::string CDecodedImageCache::GetPath( const uint64_t uiSourceHash ) const
+{
+	char szName[ 32 ];
+	snprintf( szName, sizeof( szName ), "%016" PRIx64 ".rgba", uiSourceHash );
+
+	return m_sDirectory + szName;
+}
+
+bool CDecodedImageCache::Load( const uint64_t uiSourceHash, const size_t uiSourceSize, cocos2d::Image* pcImage ) const
+{
+	const std::string sPath = GetPath( uiSourceHash );
+	bool bIsLoaded = false;
+
+#ifdef _WIN32
+	// Read rather than mapped, the file is small next to the cost of the decoding it saves
+	FILE* pFile = fopen( sPath.c_str(), "rb" );
+
+	if( nullptr == pFile )
+	{
+		return false;
+	}
+
+	SHeader sHeader;
+	fseek( pFile, 0, SEEK_END );
+	const size_t uiFileSize = static_cast<size_t>( ftell( pFile ) );
+	fseek( pFile, 0, SEEK_SET );
+
+	if( uiFileSize >= k_uiPixelsOffset && 1 == fread( &sHeader, sizeof( sHeader ), 1, pFile )
+		&& IsValidHeader( sHeader, uiSourceHash, uiSourceSize, uiFileSize ) )
+	{
+		std::vector<unsigned char> auiPixels( sHeader.uiPixelsSize );
+
+		if( 0 == fseek( pFile, static_cast<long>( k_uiPixelsOffset ), SEEK_SET )
+			&& auiPixels.size() == fread( auiPixels.data(), 1, auiPixels.size(), pFile ) )
+		{
+			bIsLoaded = pcImage->initWithRawData( auiPixels.data(), auiPixels.size(), sHeader.iWidth, sHeader.iHeight, 8,
+				0 != sHeader.uiPremultipliedAlpha );
+		}
+	}
+
+	fclose( pFile );
+#else
+	const int iFile = open( sPath.c_str(), O_RDONLY );
+
+	if( iFile < 0 )
+	{
+		return false;
+	}
+
+	struct stat sStat;
+	const bool bHasStat = ( 0 == fstat( iFile, &sStat ) && static_cast<size_t>( sStat.st_size ) >= k_uiPixelsOffset );
+
+	// The pixels are copied by the image straight from the page cache
+	void* pMapping = bHasStat ? mmap( nullptr, sStat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0 ) : MAP_FAILED;
+	close( iFile );
+
+	if( MAP_FAILED == pMapping )
+	{
+		return false;
+	}
+
+	SHeader sHeader;
+	memcpy( &sHeader, pMapping, sizeof( sHeader ) );
+
+	if( IsValidHeader( sHeader, uiSourceHash, uiSourceSize, static_cast<size_t>( sStat.st_size ) ) )
+	{
+		bIsLoaded = pcImage->initWithRawData( static_cast<const unsigned char*>( pMapping ) + k_uiPixelsOffset,
+			sHeader.uiPixelsSize, sHeader.iWidth, sHeader.iHeight, 8, 0 != sHeader.uiPremultipliedAlpha );
+	}
+
+	munmap( pMapping, sStat.st_size );
+#endif
+
+	return bIsLoaded;
+}
+
+bool CDecodedImageCache::Store( const uint64_t uiSourceHash, const size_t uiSourceSize, const cocos2d::Image* pcImage ) const
+{
+	const size_t uiPixelsSize = static_cast<size_t>( pcImage->getWidth() ) * pcImage->getHeight() * 4;
+
+	if( cocos2d::Texture2D::PixelFormat::RGBA8888 != pcImage->getRenderFormat()
+		|| static_cast<size_t>( pcImage->getDataLen() ) != uiPixelsSize )
+	{
+		return false;
+	}
+
+	SHeader sHeader;
+	sHeader.uiMagic = k_uiMagic;
+	sHeader.uiVersion = k_uiVersion;
+	sHeader.uiSourceHash = uiSourceHash;
+	sHeader.uiSourceSize = uiSourceSize;
+	sHeader.iWidth = pcImage->getWidth();
+	sHeader.iHeight = pcImage->getHeight();
+	sHeader.uiPremultipliedAlpha = pcImage->hasPremultipliedAlpha() ? 1 : 0;
+	sHeader.uiPixelsSize = static_cast<uint32_t>( uiPixelsSize );
+
+	unsigned char auiHeader[ k_uiPixelsOffset ] = {};
+	memcpy( auiHeader, &sHeader, sizeof( sHeader ) );
+
+	// Several threads may store the same content found under different names, each writes its own temporary file
+	const std::string sPath = GetPath( uiSourceHash );
+	const std::string sTemporaryPath = sPath + "." + std::to_string( std::hash<std::thread::id>()( std::this_thread::get_id() ) );
+
+	FILE* pFile = fopen( sTemporaryPath.c_str(), "wb" );
+
+	if( nullptr == pFile )
+	{
+		return false;
+	}
+
+	bool bIsWritten = 1 == fwrite( auiHeader, sizeof( auiHeader ), 1, pFile )
+		&& uiPixelsSize == fwrite( pcImage->getData(), 1, uiPixelsSize, pFile );
+
+	bIsWritten = ( 0 == fclose( pFile ) ) && bIsWritten;
+
+	// The file is not synced, a file cut short by a crash fails the size check of IsValidHeader() and is decoded again
+	if( !bIsWritten )
+	{
+		remove( sTemporaryPath.c_str() );
+		return false;
+	}
+
+#ifdef _WIN32
+	return 0 != MoveFileExA( sTemporaryPath.c_str(), sPath.c_str(), MOVEFILE_REPLACE_EXISTING );
+#else
+	return 0 == rename( sTemporaryPath.c_str(), sPath.c_str() );
+#endif
+}
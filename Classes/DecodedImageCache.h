@@ -0,0 +1,76 @@
+#ifndef DECODEDIMAGECACHE_H
+#define DECODEDIMAGECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cocos2d
+{
+	class Image;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CDecodedImageCache
+// Purpose				: To decode every image only once across launches. The pixels of a decoded image are written raw in a
+//						: file named after the hash of the image file's content, so a later launch finds them with the same
+//						: bytes it would have decoded and maps them instead of running the PNG decoder. An edited image
+//						: hashes differently and is decoded and stored again
+// Notes				: A file is a fixed header followed by the pixels at a 64 bytes offset, ready to be memory mapped.
+//						: Only 32 bits RGBA images are stored, the only raw format cocos2d::Image can be created from, the
+//						: others are decoded every time. Load() and Store() can be called from any thread
+// Example				: CDecodedImageCache cCache( FileUtils::getInstance()->getWritablePath() + "decoded_images/" );
+//						: if( !cCache.Load( uiHash, uiSize, pcImage ) && pcImage->initWithImageData( ... ) ) cCache.Store( ... );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CDecodedImageCache
+{
+
+private:
+
+	// Directory of the cached images, ending with a separator
+	std::string m_sDirectory;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetPath()
+	// Parameters		: uiSourceHash		- Hash of the image file's content
+	// Returns			: The path of the cached pixels of the image
+	//-----------------------------------------------------------------------------------------------------------------------------
+	std::string GetPath( const uint64_t uiSourceHash ) const;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CDecodedImageCache()
+	// Parameters		: rsDirectory		- Directory of the cached images, created if missing
+	//-----------------------------------------------------------------------------------------------------------------------------
+	explicit CDecodedImageCache( const std::string& rsDirectory );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: HashContent()
+	// Parameters		: puiBytes			- Content of the image file
+	//					: uiSize			- Size of the content in bytes
+	// Returns			: The 64 bits FNV-1a hash of the content, the key of the image in the cache
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static uint64_t HashContent( const unsigned char* puiBytes, const size_t uiSize );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Load()
+	// Parameters		: uiSourceHash		- Hash of the image file's content
+	//					: uiSourceSize		- Size of the image file
+	//					: pcImage			- Image initialised with the cached pixels
+	// Returns			: False if the image is not cached or its file does not match the source, the image is left as is
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Load( const uint64_t uiSourceHash, const size_t uiSourceSize, cocos2d::Image* pcImage ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Store()
+	// Parameters		: uiSourceHash		- Hash of the image file's content
+	//					: uiSourceSize		- Size of the image file
+	//					: pcImage			- Image decoded from the file
+	// Purpose			: Write the pixels of the image in the cache, through a temporary file renamed once complete
+	// Returns			: False if the image's format is not cached or the file could not be written
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Store( const uint64_t uiSourceHash, const size_t uiSourceSize, const cocos2d::Image* pcImage ) const;
+};
+
+#endif // !DECODEDIMAGECACHE_H
@@ -0,0 +1,361 @@
+#include "EntityLayer.h"
+
+#include <algorithm>
+#include <new>
+
+#include <CCDirector.h>
+#include <cocos/2d/CCCamera.h>
+#include <cocos/2d/CCSprite.h>
+#include <cocos/base/CCEventDispatcher.h>
+
+// Instruction set of the batched transforms, chosen by the compiler's target. AVX computes two transforms at once, SSE
+// and NEON one column of four floats at a time
+#if defined( __AVX__ )
+#include <immintrin.h>
+#define ENTITY_TRANSFORMS_AVX 1
+#define ENTITY_TRANSFORMS_SSE 1
+#elif defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#include <xmmintrin.h>
+#define ENTITY_TRANSFORMS_SSE 1
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#include <arm_neon.h>
+#define ENTITY_TRANSFORMS_NEON 1
+#endif
+
+using cocos2d::Mat4;
+using cocos2d::Node;
+
+// Scale and translation of the batched children to the layer, in contiguous arrays
+struct SLocalTransforms
+{
+	const float*	pfScaleX;
+	const float*	pfScaleY;
+	const float*	pfScaleZ;
+	const float*	pfTranslateX;
+	const float*	pfTranslateY;
+	const float*	pfTranslateZ;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: IsTranslateAndScale()
+// Parameters		: rcTransform		- Transform of a child to its parent
+// Returns			: True if the transform only scales along the axes and translates, the layout of Mat4 is column major
+//-----------------------------------------------------------------------------------------------------------------------------
+static bool IsTranslateAndScale( const Mat4& rcTransform )
+{
+	const float* pfM = rcTransform.m;
+
+	return 0.0f == pfM[ 1 ] && 0.0f == pfM[ 2 ] && 0.0f == pfM[ 3 ]
+		&& 0.0f == pfM[ 4 ] && 0.0f == pfM[ 6 ] && 0.0f == pfM[ 7 ]
+		&& 0.0f == pfM[ 8 ] && 0.0f == pfM[ 9 ] && 0.0f == pfM[ 11 ]
+		&& 1.0f == pfM[ 15 ];
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: ComputeWorldTransforms()
+// Parameters		: rcParent			- World transform of the layer
+//					: rsLocal			- Scale and translation of the children, indexed by their position
+//					: piIndices			- Positions of the children to compute
+//					: iCount			- Amount of positions
+//					: pcWorld			- World transforms of the children, indexed by their position
+// Purpose			: Multiply the layer's transform by every child's. With a child only scaled and translated, the
+//					: columns of the product are the layer's first three columns scaled, and its translation moved
+//					: along them: a few multiply-adds per column instead of a full matrix product
+//-----------------------------------------------------------------------------------------------------------------------------
+static void ComputeWorldTransforms( const Mat4& rcParent, const SLocalTransforms& rsLocal, const int* piIndices, const int iCount,
+	Mat4* pcWorld )
+{
+	const float* pfP = rcParent.m;
+	int i = 0;
+
+#if defined( ENTITY_TRANSFORMS_AVX )
+	// Both halves hold the same column of the layer, each half computes the column of one child
+	const __m256 cColumn0 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( pfP + 0 ) );
+	const __m256 cColumn1 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( pfP + 4 ) );
+	const __m256 cColumn2 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( pfP + 8 ) );
+	const __m256 cColumn3 = _mm256_broadcast_ps( reinterpret_cast<const __m128*>( pfP + 12 ) );
+
+	for( ; i + 1 < iCount; i += 2 )
+	{
+		const int iA = piIndices[ i ];
+		const int iB = piIndices[ i + 1 ];
+
+		const __m256 cScaleX = _mm256_set_m128( _mm_set1_ps( rsLocal.pfScaleX[ iB ] ), _mm_set1_ps( rsLocal.pfScaleX[ iA ] ) );
+		const __m256 cScaleY = _mm256_set_m128( _mm_set1_ps( rsLocal.pfScaleY[ iB ] ), _mm_set1_ps( rsLocal.pfScaleY[ iA ] ) );
+		const __m256 cScaleZ = _mm256_set_m128( _mm_set1_ps( rsLocal.pfScaleZ[ iB ] ), _mm_set1_ps( rsLocal.pfScaleZ[ iA ] ) );
+		const __m256 cTranslateX = _mm256_set_m128( _mm_set1_ps( rsLocal.pfTranslateX[ iB ] ), _mm_set1_ps( rsLocal.pfTranslateX[ iA ] ) );
+		const __m256 cTranslateY = _mm256_set_m128( _mm_set1_ps( rsLocal.pfTranslateY[ iB ] ), _mm_set1_ps( rsLocal.pfTranslateY[ iA ] ) );
+		const __m256 cTranslateZ = _mm256_set_m128( _mm_set1_ps( rsLocal.pfTranslateZ[ iB ] ), _mm_set1_ps( rsLocal.pfTranslateZ[ iA ] ) );
+
+		const __m256 cWorld0 = _mm256_mul_ps( cColumn0, cScaleX );
+		const __m256 cWorld1 = _mm256_mul_ps( cColumn1, cScaleY );
+		const __m256 cWorld2 = _mm256_mul_ps( cColumn2, cScaleZ );
+		const __m256 cWorld3 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( cColumn0, cTranslateX ), _mm256_mul_ps( cColumn1, cTranslateY ) ),
+			_mm256_add_ps( _mm256_mul_ps( cColumn2, cTranslateZ ), cColumn3 ) );
+
+		float* pfA = pcWorld[ iA ].m;
+		float* pfB = pcWorld[ iB ].m;
+
+		_mm_storeu_ps( pfA + 0, _mm256_castps256_ps128( cWorld0 ) );
+		_mm_storeu_ps( pfA + 4, _mm256_castps256_ps128( cWorld1 ) );
+		_mm_storeu_ps( pfA + 8, _mm256_castps256_ps128( cWorld2 ) );
+		_mm_storeu_ps( pfA + 12, _mm256_castps256_ps128( cWorld3 ) );
+		_mm_storeu_ps( pfB + 0, _mm256_extractf128_ps( cWorld0, 1 ) );
+		_mm_storeu_ps( pfB + 4, _mm256_extractf128_ps( cWorld1, 1 ) );
+		_mm_storeu_ps( pfB + 8, _mm256_extractf128_ps( cWorld2, 1 ) );
+		_mm_storeu_ps( pfB + 12, _mm256_extractf128_ps( cWorld3, 1 ) );
+	}
+#endif
+
+#if defined( ENTITY_TRANSFORMS_SSE )
+	// Also computes the last child left by the AVX loop
+	const __m128 cColumn0x4 = _mm_loadu_ps( pfP + 0 );
+	const __m128 cColumn1x4 = _mm_loadu_ps( pfP + 4 );
+	const __m128 cColumn2x4 = _mm_loadu_ps( pfP + 8 );
+	const __m128 cColumn3x4 = _mm_loadu_ps( pfP + 12 );
+
+	for( ; i < iCount; i++ )
+	{
+		const int iIndex = piIndices[ i ];
+		float* pfW = pcWorld[ iIndex ].m;
+
+		_mm_storeu_ps( pfW + 0, _mm_mul_ps( cColumn0x4, _mm_set1_ps( rsLocal.pfScaleX[ iIndex ] ) ) );
+		_mm_storeu_ps( pfW + 4, _mm_mul_ps( cColumn1x4, _mm_set1_ps( rsLocal.pfScaleY[ iIndex ] ) ) );
+		_mm_storeu_ps( pfW + 8, _mm_mul_ps( cColumn2x4, _mm_set1_ps( rsLocal.pfScaleZ[ iIndex ] ) ) );
+		_mm_storeu_ps( pfW + 12, _mm_add_ps(
+			_mm_add_ps( _mm_mul_ps( cColumn0x4, _mm_set1_ps( rsLocal.pfTranslateX[ iIndex ] ) ),
+				_mm_mul_ps( cColumn1x4, _mm_set1_ps( rsLocal.pfTranslateY[ iIndex ] ) ) ),
+			_mm_add_ps( _mm_mul_ps( cColumn2x4, _mm_set1_ps( rsLocal.pfTranslateZ[ iIndex ] ) ), cColumn3x4 ) ) );
+	}
+#elif defined( ENTITY_TRANSFORMS_NEON )
+	const float32x4_t cColumn0x4 = vld1q_f32( pfP + 0 );
+	const float32x4_t cColumn1x4 = vld1q_f32( pfP + 4 );
+	const float32x4_t cColumn2x4 = vld1q_f32( pfP + 8 );
+	const float32x4_t cColumn3x4 = vld1q_f32( pfP + 12 );
+
+	for( ; i < iCount; i++ )
+	{
+		const int iIndex = piIndices[ i ];
+		float* pfW = pcWorld[ iIndex ].m;
+
+		float32x4_t cTranslation = vmlaq_n_f32( cColumn3x4, cColumn0x4, rsLocal.pfTranslateX[ iIndex ] );
+		cTranslation = vmlaq_n_f32( cTranslation, cColumn1x4, rsLocal.pfTranslateY[ iIndex ] );
+		cTranslation = vmlaq_n_f32( cTranslation, cColumn2x4, rsLocal.pfTranslateZ[ iIndex ] );
+
+		vst1q_f32( pfW + 0, vmulq_n_f32( cColumn0x4, rsLocal.pfScaleX[ iIndex ] ) );
+		vst1q_f32( pfW + 4, vmulq_n_f32( cColumn1x4, rsLocal.pfScaleY[ iIndex ] ) );
+		vst1q_f32( pfW + 8, vmulq_n_f32( cColumn2x4, rsLocal.pfScaleZ[ iIndex ] ) );
+		vst1q_f32( pfW + 12, cTranslation );
+	}
+#else
+	for( ; i < iCount; i++ )
+	{
+		const int iIndex = piIndices[ i ];
+		float* pfW = pcWorld[ iIndex ].m;
+
+		for( int iRow = 0; iRow < 4; iRow++ )
+		{
+			pfW[ iRow ] = pfP[ iRow ] * rsLocal.pfScaleX[ iIndex ];
+			pfW[ 4 + iRow ] = pfP[ 4 + iRow ] * rsLocal.pfScaleY[ iIndex ];
+			pfW[ 8 + iRow ] = pfP[ 8 + iRow ] * rsLocal.pfScaleZ[ iIndex ];
+			pfW[ 12 + iRow ] = pfP[ iRow ] * rsLocal.pfTranslateX[ iIndex ] + pfP[ 4 + iRow ] * rsLocal.pfTranslateY[ iIndex ]
+				+ pfP[ 8 + iRow ] * rsLocal.pfTranslateZ[ iIndex ] + pfP[ 12 + iRow ];
+		}
+	}
+#endif
+}
+
+CEntityLayer::CEntityLayer()
+{}
+
+CEntityLayer* CEntityLayer::create()
+{
+	CEntityLayer* pcLayer = new ( std::nothrow ) CEntityLayer();
+
+	if( nullptr != pcLayer && pcLayer->init() )
+	{
+		pcLayer->autorelease();
+		return pcLayer;
+	}
+
+	CC_SAFE_DELETE( pcLayer );
+	return nullptr;
+}
+
+void CEntityLayer::sortAllChildren()
+{
+	if( !_reorderChildDirty )
+	{
+		return;
+	}
+
+	// Insertion sort, a single pass when the children are in order. Added entities are at the end and only move back
+	// past the ones with a greater z order, entities with the same z order keep the order they were added in
+	for( auto cIter = _children.begin(); cIter != _children.end(); ++cIter )
+	{
+		if( cIter == _children.begin() || ( *( cIter - 1 ) )->getLocalZOrder() <= ( *cIter )->getLocalZOrder() )
+		{
+			continue;
+		}
+
+		auto cPosition = std::upper_bound( _children.begin(), cIter, *cIter,
+			[]( const Node* pcMoved, const Node* pcNode ) { return pcMoved->getLocalZOrder() < pcNode->getLocalZOrder(); } );
+
+		std::rotate( cPosition, cIter, cIter + 1 );
+	}
+
+	_reorderChildDirty = false;
+
+	// Listeners registered with scene graph priority follow the drawing order, like in Node::sortAllChildren()
+	_eventDispatcher->setDirtyForNode( this );
+}
+
+void CEntityLayer::visit( cocos2d::Renderer* pcRenderer, const Mat4& rcParentTransform, uint32_t uiParentFlags )
+{
+	if( !_visible )
+	{
+		return;
+	}
+
+	const uint32_t uiFlags = processParentFlags( rcParentTransform, uiParentFlags );
+	const bool bIsLayerDirty = 0 != ( uiFlags & FLAGS_DIRTY_MASK );
+
+	sortAllChildren();
+
+	// The arrays only grow with the amount of children, a frame with as many children as before never allocates
+	const int iChildren = static_cast<int>( _children.size() );
+
+	if( static_cast<int>( m_apcNodes.size() ) < iChildren )
+	{
+		m_afScaleX.resize( iChildren );
+		m_afScaleY.resize( iChildren );
+		m_afScaleZ.resize( iChildren );
+		m_afTranslateX.resize( iChildren );
+		m_afTranslateY.resize( iChildren );
+		m_afTranslateZ.resize( iChildren );
+		m_apcNodes.resize( iChildren, nullptr );
+		m_acContentSizes.resize( iChildren );
+		m_acWorldTransforms.resize( iChildren );
+		m_auiFlags.resize( iChildren );
+		m_abIsBatched.resize( iChildren );
+		m_aiDirty.reserve( iChildren );
+	}
+
+	m_aiDirty.clear();
+
+	// Gather the children whose transform to the layer is a scale and a translation, and the ones of those that changed
+	for( int i = 0; i < iChildren; i++ )
+	{
+		Node* pcChild = _children.at( i );
+		m_abIsBatched[ i ] = false;
+
+		// A child leaving the batch is forgotten, its world transform is not kept up to date until it comes back
+		const Node* pcCachedChild = m_apcNodes[ i ];
+		m_apcNodes[ i ] = nullptr;
+
+		// Other nodes may override visit(), e.g. to render to a texture, only the entities' sprites are drawn directly
+		if( !pcChild->isVisible() || nullptr == dynamic_cast<cocos2d::Sprite*>( pcChild ) )
+		{
+			continue;
+		}
+
+		// Cached by the child, only recomputed when it moved
+		const Mat4& rcLocal = pcChild->getNodeToParentTransform();
+
+		if( !IsTranslateAndScale( rcLocal ) )
+		{
+			continue;
+		}
+
+		const bool bHasMoved = pcCachedChild != pcChild
+			|| m_afScaleX[ i ] != rcLocal.m[ 0 ] || m_afScaleY[ i ] != rcLocal.m[ 5 ] || m_afScaleZ[ i ] != rcLocal.m[ 10 ]
+			|| m_afTranslateX[ i ] != rcLocal.m[ 12 ] || m_afTranslateY[ i ] != rcLocal.m[ 13 ] || m_afTranslateZ[ i ] != rcLocal.m[ 14 ];
+		const bool bIsResized = pcCachedChild != pcChild || !m_acContentSizes[ i ].equals( pcChild->getContentSize() );
+
+		if( bIsLayerDirty || bHasMoved )
+		{
+			m_afScaleX[ i ] = rcLocal.m[ 0 ];
+			m_afScaleY[ i ] = rcLocal.m[ 5 ];
+			m_afScaleZ[ i ] = rcLocal.m[ 10 ];
+			m_afTranslateX[ i ] = rcLocal.m[ 12 ];
+			m_afTranslateY[ i ] = rcLocal.m[ 13 ];
+			m_afTranslateZ[ i ] = rcLocal.m[ 14 ];
+			m_aiDirty.push_back( i );
+		}
+
+		m_apcNodes[ i ] = pcChild;
+		m_acContentSizes[ i ] = pcChild->getContentSize();
+		m_abIsBatched[ i ] = true;
+
+		// Children without a dirty flag keep the culling and the vertices of their last frame
+		m_auiFlags[ i ] = uiFlags | ( bHasMoved ? FLAGS_TRANSFORM_DIRTY : 0 ) | ( bIsResized ? FLAGS_CONTENT_SIZE_DIRTY : 0 );
+	}
+
+	const SLocalTransforms sLocal = { m_afScaleX.data(), m_afScaleY.data(), m_afScaleZ.data(), m_afTranslateX.data(),
+		m_afTranslateY.data(), m_afTranslateZ.data() };
+
+	ComputeWorldTransforms( _modelViewTransform, sLocal, m_aiDirty.data(), static_cast<int>( m_aiDirty.size() ),
+		m_acWorldTransforms.data() );
+
+	_director->pushMatrix( cocos2d::MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW );
+	_director->loadMatrix( cocos2d::MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, _modelViewTransform );
+
+	// The layer draws nothing itself, the children are drawn in order whatever their z order
+	for( int i = 0; i < iChildren; i++ )
+	{
+		if( m_abIsBatched[ i ] )
+		{
+			VisitBatched( _children.at( i ), pcRenderer, m_acWorldTransforms[ i ], m_auiFlags[ i ] );
+		}
+		else
+		{
+			_children.at( i )->visit( pcRenderer, _modelViewTransform, uiFlags );
+		}
+	}
+
+	_director->popMatrix( cocos2d::MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW );
+}
+
+void CEntityLayer::VisitBatched( Node* pcChild, cocos2d::Renderer* pcRenderer, const Mat4& rcTransform, const uint32_t uiFlags )
+{
+	// Same test as Node::isVisitableByVisitingCamera(), which only the child can call
+	const cocos2d::Camera* pcCamera = cocos2d::Camera::getVisitingCamera();
+	const bool bIsVisibleByCamera = ( nullptr == pcCamera )
+		|| 0 != ( static_cast<unsigned short>( pcCamera->getCameraFlag() ) & pcChild->getCameraMask() );
+
+	// Leave the child as Node::visit() would: its model view transform is the world transform computed for it and its
+	// transform and content size are no longer dirty. The members are protected, they are reached through pointers to
+	// members named from this class, which is a node too
+	pcChild->*( &CEntityLayer::_modelViewTransform ) = rcTransform;
+	pcChild->*( &CEntityLayer::_transformUpdated ) = false;
+	pcChild->*( &CEntityLayer::_contentSizeDirty ) = false;
+
+	_director->pushMatrix( cocos2d::MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW );
+	_director->loadMatrix( cocos2d::MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW, rcTransform );
+
+	// Children of the entity, e.g. its effects, behind it first, then the entity and the ones in front of it
+	cocos2d::Vector<Node*>& rcChildren = pcChild->getChildren();
+	auto cIter = rcChildren.begin();
+
+	if( !rcChildren.empty() )
+	{
+		pcChild->sortAllChildren();
+
+		for( ; cIter != rcChildren.end() && ( *cIter )->getLocalZOrder() < 0; ++cIter )
+		{
+			( *cIter )->visit( pcRenderer, rcTransform, uiFlags );
+		}
+	}
+
+	if( bIsVisibleByCamera )
+	{
+		pcChild->draw( pcRenderer, rcTransform, uiFlags );
+	}
+
+	for( ; cIter != rcChildren.end(); ++cIter )
+	{
+		( *cIter )->visit( pcRenderer, rcTransform, uiFlags );
+	}
+
+	_director->popMatrix( cocos2d::MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW );
+}
@@ -0,0 +1,94 @@
+#ifndef ENTITYLAYER_H
+#define ENTITYLAYER_H
+
+#include <vector>
+
+#include <cocos/2d/CCNode.h>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CEntityLayer
+// Classes Inherited	: Node
+// Purpose				: To hold the entities of one render layer of a map, e.g. its platforms or its pickups, apart from the
+//						: map's tile layers. The map only traverses a handful of tile and entity layers and adding, removing or
+//						: reordering an entity only touches the children of its own layer
+// Notes				: Children are kept sorted by local z order as they are added, entities of a layer usually share one z
+//						: order so they stay in the order they were added. The layer never moves within the map, so the
+//						: transforms of its children are only recomputed when the map or the children themselves change.
+//						: Almost every entity is only translated and scaled from the layer, the world transforms of these
+//						: children are computed together from contiguous arrays with SIMD instructions, and the children
+//						: are drawn with them, which leaves them as Node::visit() would. Rotated or skewed children and the
+//						: children that are not sprites are visited as usual
+//-----------------------------------------------------------------------------------------------------------------------------
+class CEntityLayer : public cocos2d::Node
+{
+
+private:
+
+	// Scale and translation of every child to the layer, indexed by the child's position in the drawing order. Only the
+	// entries of batched children are meaningful
+	std::vector<float> m_afScaleX;
+	std::vector<float> m_afScaleY;
+	std::vector<float> m_afScaleZ;
+	std::vector<float> m_afTranslateX;
+	std::vector<float> m_afTranslateY;
+	std::vector<float> m_afTranslateZ;
+
+	// Child and content size the entry was computed for, a different child at the same position is recomputed
+	std::vector<cocos2d::Node*> m_apcNodes;
+	std::vector<cocos2d::Size> m_acContentSizes;
+
+	// Children drawn with the batched transforms this frame, the others are visited as usual
+	std::vector<bool> m_abIsBatched;
+
+	// World transforms of the batched children and the dirty flags they are drawn with
+	std::vector<cocos2d::Mat4> m_acWorldTransforms;
+	std::vector<uint32_t> m_auiFlags;
+
+	// Positions of the batched children whose world transform is recomputed this frame
+	std::vector<int> m_aiDirty;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: VisitBatched()
+	// Parameters		: pcChild			- Batched child
+	//					: pcRenderer		- Renderer of the frame
+	//					: rcTransform		- World transform of the child computed by the batched pass
+	//					: uiFlags			- Dirty flags of the child
+	// Purpose			: Draw the child and visit its own children with its transform, as Node::visit() would once the
+	//					: child's transform is known
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void VisitBatched( cocos2d::Node* pcChild, cocos2d::Renderer* pcRenderer, const cocos2d::Mat4& rcTransform, const uint32_t uiFlags );
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: create()
+	// Purpose			: Create an empty layer, the usual cocos2d-x factory
+	// Returns			: An autoreleased layer, nullptr on failure
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CEntityLayer* create();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: sortAllChildren()
+	// Purpose			: Restore the z order of the children after an entity has been added or reordered. The children are
+	//					: already sorted but for the changed ones, so they are moved in place instead of sorting them all
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void sortAllChildren() override;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: visit()
+	// Parameters		: pcRenderer		- Renderer of the frame
+	//					: rcParentTransform	- World transform of the map
+	//					: uiParentFlags		- Dirty flags of the map
+	// Purpose			: Recompute the world transforms of the translated and scaled children that moved, or all of them
+	//					: if the map moved, in one batch, then draw every child in order
+	// Notes			: A batched child is drawn without going through its own visit(), so the model view transform it
+	//					: keeps is the one of the last frame it was visited as usual. Drawing uses the transform given
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void visit( cocos2d::Renderer* pcRenderer, const cocos2d::Mat4& rcParentTransform, uint32_t uiParentFlags ) override;
+
+protected:
+
+	CEntityLayer();
+};
+
+#endif // !ENTITYLAYER_H
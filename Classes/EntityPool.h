@@ -0,0 +1,209 @@
+#ifndef ENTITYPOOL_H
+#define ENTITYPOOL_H
+
+#include <vector>
+
+#include <cocos/2d/CCNode.h>
+#include <cocos/physics/CCPhysicsBody.h>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CEntityPool
+// Purpose				: To store a pool of entities created once and shared by all the stages of a level. Each member is either
+//						: active, so attached to the parent node with its physics body in the world, or inactive, so detached
+//						: from the parent, skipped by the renderer and with its physics body disabled. A stage claims the members
+//						: it needs, the members it does not claim are deactivated when the stage finishes loading
+// Example				: CEntityPool<CPort> cPorts; cPorts.BeginClaiming(); cPorts.Claim( 0 )->Initialise( ... );
+//						: cPorts.ReleaseUnclaimed();
+//-----------------------------------------------------------------------------------------------------------------------------
+template<typename T>
+class CEntityPool
+{
+
+private:
+	// Node the active members are attached to
+	cocos2d::Node* m_pcParent;
+
+	// Local z order used when attaching a member to the parent
+	int m_iZOrder;
+
+	// All the members of the pool, active or not
+	std::vector<T*> m_pcMembers;
+
+	// Active state of every member
+	std::vector<bool> m_abActive;
+
+	// Members claimed by the stage being loaded
+	std::vector<bool> m_abClaimed;
+
+	// Amount of active members
+	int m_iActiveCount;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CEntityPool()
+	// Purpose			: Create an empty pool with no parent
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CEntityPool()
+		: m_pcParent( nullptr )
+		, m_iZOrder( 0 )
+		, m_iActiveCount( 0 )
+	{}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetParent()
+	// Parameters		: pcParent			- Node the active members are attached to
+	//					: iZOrder			- Local z order of the members in the parent
+	// Purpose			: Set where the active members are attached, must be called before adding members
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetParent( cocos2d::Node* pcParent, const int iZOrder = 0 )
+	{
+		m_pcParent = pcParent;
+		m_iZOrder = iZOrder;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Add()
+	// Parameters		: pcEntity			- New member of the pool
+	// Purpose			: Store the entity and attach it to the parent. New members start active so that the
+	//					: "pre-initialisation" stage can set them up, that stage does not claim them
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Add( T* pcEntity )
+	{
+		CCASSERT( nullptr != m_pcParent, "Pool parent not set" );
+
+		m_pcMembers.push_back( pcEntity );
+		m_abActive.push_back( false );
+		m_abClaimed.push_back( false );
+
+		Activate( m_pcMembers.size() - 1 );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Activate()
+	// Parameters		: iIndex			- Index of the member in the pool
+	// Purpose			: Attach the member to the parent and enable its physics body
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Activate( const int iIndex )
+	{
+		if( m_abActive[ iIndex ] )
+		{
+			return;
+		}
+
+		T* pcEntity = m_pcMembers[ iIndex ];
+
+		// Attaching the member makes it traversed again, entering the scene adds its body to the physics world
+		m_pcParent->addChild( pcEntity, m_iZOrder );
+
+		if( nullptr != pcEntity->getPhysicsBody() )
+		{
+			pcEntity->getPhysicsBody()->setEnabled( true );
+		}
+
+		m_abActive[ iIndex ] = true;
+		m_iActiveCount++;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Deactivate()
+	// Parameters		: iIndex			- Index of the member in the pool
+	// Purpose			: Disable the member's physics body and detach it from the parent
+	// Notes			: The member is not cleaned up so it keeps its actions and schedules, paused until it is activated again
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Deactivate( const int iIndex )
+	{
+		if( !m_abActive[ iIndex ] )
+		{
+			return;
+		}
+
+		T* pcEntity = m_pcMembers[ iIndex ];
+
+		// Take the body out of the physics space so it cannot produce contacts
+		if( nullptr != pcEntity->getPhysicsBody() )
+		{
+			pcEntity->getPhysicsBody()->setEnabled( false );
+		}
+
+		// Detached members are not traversed by the renderer, the pool keeps them alive
+		pcEntity->removeFromParentAndCleanup( false );
+
+		m_abActive[ iIndex ] = false;
+		m_iActiveCount--;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: BeginClaiming()
+	// Purpose			: Forget the members claimed by the previous stage, called before positioning a new stage
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BeginClaiming()
+	{
+		m_abClaimed.assign( m_abClaimed.size(), false );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Claim()
+	// Parameters		: iIndex			- Index of the member in the pool
+	// Purpose			: Mark the member as used by the current stage and activate it
+	// Returns			: The claimed member
+	//-----------------------------------------------------------------------------------------------------------------------------
+	T* Claim( const int iIndex )
+	{
+		CCASSERT( iIndex >= 0 && iIndex < static_cast<int>( m_pcMembers.size() ), "Not enough pooled entities for the stage" );
+
+		m_abClaimed[ iIndex ] = true;
+		Activate( iIndex );
+
+		return m_pcMembers[ iIndex ];
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ReleaseUnclaimed()
+	// Purpose			: Deactivate every member the current stage did not claim, called once the stage is positioned
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ReleaseUnclaimed()
+	{
+		for( unsigned int i = 0; i < m_pcMembers.size(); i++ )
+		{
+			if( !m_abClaimed[ i ] )
+			{
+				Deactivate( i );
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: IsActive()
+	// Parameters		: iIndex			- Index of the member in the pool
+	// Returns			: True if the member is attached to the parent
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsActive( const int iIndex ) const				{ return m_abActive[ iIndex ]; }
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetActiveCount()
+	// Returns			: The amount of active members
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetActiveCount() const							{ return m_iActiveCount; }
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetMembers()
+	// Returns			: All the members of the pool, indexed by the ID given at creation
+	//-----------------------------------------------------------------------------------------------------------------------------
+	std::vector<T*>& GetMembers()						{ return m_pcMembers; }
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetSize()
+	// Returns			: The amount of members, active or not
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetSize() const									{ return m_pcMembers.size(); }
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: operator[]()
+	// Parameters		: iIndex			- Index of the member in the pool
+	// Returns			: The member at the given index
+	//-----------------------------------------------------------------------------------------------------------------------------
+	T* operator[]( const int iIndex ) const				{ return m_pcMembers[ iIndex ]; }
+};
+
+#endif // !ENTITYPOOL_H
@@ -0,0 +1,16 @@
+#include "EntityRegistry.h"
+
+#include "PlatformCrumbling.h"
+#include "TextureManager.h"
+#include "Travellator.h"
+
+template<typename T>
+CPlatformBase* EntityRegistry::TCreatePlatform( CTextureManager& rcTextureManager, const int iID )
+{
+	// Create the platform, its collider is named "Platform iID" by the constructor
+	return new T( rcTextureManager, iID );
+}
+
+// Factories referenced by the platform types' table
+template CPlatformBase* EntityRegistry::TCreatePlatform<CPlatformCrumbling>( CTextureManager& rcTextureManager, const int iID );
+template CPlatformBase* EntityRegistry::TCreatePlatform<CTravellator>( CTextureManager& rcTextureManager, const int iID );
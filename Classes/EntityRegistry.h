@@ -0,0 +1,187 @@
+#ifndef ENTITYREGISTRY_H
+#define ENTITYREGISTRY_H
+
+#include <cstdint>
+#include <string>
+
+#include "CollisionBitmap.h"
+#include "CollisionMatrix.h"
+#include "Settings.h"
+
+class CPlatformBase;
+class CPlatformCrumbling;
+class CTextureManager;
+class CTravellator;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Namespace Name		: EntityRegistry
+// Purpose				: Compile time description of every entity type that can be placed in a Tiled map. Each entry maps the
+//						: Tiled type name to its hashed ID, its range in the pooled storage, its collision category and the factory
+//						: used to build it, so adding a type only means adding a row to the relevant table
+//-----------------------------------------------------------------------------------------------------------------------------
+namespace EntityRegistry
+{
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: HashTypeName()
+	// Parameters		: pszName			- Null terminated type name as written in Tiled
+	//					: uHash				- Running hash value, only used by the recursion
+	// Purpose			: FNV-1a hash of a type name, evaluated at compile time for the tables below
+	// Returns			: The 32 bit hash of the name
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr uint32_t HashTypeName( const char* pszName, const uint32_t uHash = 2166136261u )
+	{
+		return ( '\0' == *pszName ) ? uHash
+			: HashTypeName( pszName + 1, ( uHash ^ static_cast<uint8_t>( *pszName ) ) * 16777619u );
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: HashTypeName()
+	// Parameters		: rsName			- Type name read from a Tiled object
+	// Purpose			: Runtime version of the hash above, used when resolving the type of a map object
+	// Returns			: The 32 bit hash of the name
+	//-----------------------------------------------------------------------------------------------------------------------------
+	inline uint32_t HashTypeName( const std::string& rsName )
+	{
+		uint32_t uHash = 2166136261u;
+
+		for( const char cCharacter : rsName )
+		{
+			uHash = ( uHash ^ static_cast<uint8_t>( cCharacter ) ) * 16777619u;
+		}
+
+		return uHash;
+	}
+
+	// Signature of the functions used to fill the platforms' pool
+	typedef CPlatformBase* ( *PlatformFactory )( CTextureManager& rcTextureManager, const int iID );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: TCreatePlatform()
+	// Parameters		: T					- Specific platform class to create
+	//					: rcTextureManager	- The texture manager used to load the platform sprite
+	//					: iID				- Id of the platform in the platforms' vector
+	// Purpose			: Factory stored in the platform types' table, defined and instantiated in EntityRegistry.cpp
+	// Returns			: A new platform of type T
+	//-----------------------------------------------------------------------------------------------------------------------------
+	template<typename T>
+	CPlatformBase* TCreatePlatform( CTextureManager& rcTextureManager, const int iID );
+
+	// Description of a platform type and of its slice of the platforms' pool
+	struct SPlatformType
+	{
+		// Type name as written in the Tiled object "type" field
+		const char*			pszTypeName;
+		// Hashed type name used for the lookup
+		uint32_t			uTypeHash;
+		// Index of the first platform of this type in the platforms' vector
+		int					iPoolOffset;
+		// Amount of platforms of this type in the platforms' vector
+		int					iPoolSize;
+		// Category of the platform's physics shape, its bitmasks come from the collision matrix
+		CollisionMatrix::ECategory	eCategory;
+		// Function used to create the pooled platforms
+		PlatformFactory		pfnCreate;
+		// The platform needs its VUpdate called every frame
+		bool				bUpdatedEveryFrame;
+		// The platform has to be reset when the stage is reset
+		bool				bResetWithStage;
+	};
+
+	// Pool size of every platform type, in the same order of k_asPlatformTypes
+	constexpr int k_aiPlatformPoolSizes[] =
+	{
+		Platforms::k_iMaxAmountOfCrumblingPlatforms,
+		Platforms::k_iMaxAmountOfTravellatorsPlatforms,
+	};
+
+	// Amount of platform types known by the registry
+	constexpr int k_iNumOfPlatformTypes = sizeof( k_aiPlatformPoolSizes ) / sizeof( k_aiPlatformPoolSizes[ 0 ] );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: PlatformPoolOffset()
+	// Parameters		: iTypeIndex		- Index of the platform type in k_asPlatformTypes
+	// Purpose			: Sum the pool sizes of all the types stored before the given one
+	// Returns			: Index of the first platform of the type in the platforms' vector
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr int PlatformPoolOffset( const int iTypeIndex )
+	{
+		return ( 0 == iTypeIndex ) ? 0 : PlatformPoolOffset( iTypeIndex - 1 ) + k_aiPlatformPoolSizes[ iTypeIndex - 1 ];
+	}
+
+	// Total amount of platforms in the platforms' vector
+	constexpr int k_iPlatformPoolSize = PlatformPoolOffset( k_iNumOfPlatformTypes );
+
+	// Every platform type that can be placed in a "Platforms N" object group
+	constexpr SPlatformType k_asPlatformTypes[] =
+	{
+		{ "Crumbling",		HashTypeName( "Crumbling" ),	PlatformPoolOffset( 0 ), k_aiPlatformPoolSizes[ 0 ],
+			CollisionMatrix::ECategory::Platform, &TCreatePlatform<CPlatformCrumbling>,	true,	true },
+		{ "Travellator",	HashTypeName( "Travellator" ),	PlatformPoolOffset( 1 ), k_aiPlatformPoolSizes[ 1 ],
+			CollisionMatrix::ECategory::Platform, &TCreatePlatform<CTravellator>,		true,	false },
+	};
+
+	static_assert( sizeof( k_asPlatformTypes ) / sizeof( k_asPlatformTypes[ 0 ] ) == k_iNumOfPlatformTypes,
+		"Every platform type needs a pool size" );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: FindPlatformType()
+	// Parameters		: uTypeHash			- Hashed type name of a Tiled object
+	// Purpose			: Look up the platform type matching the hash
+	// Returns			: The platform type or nullptr if the hash is unknown
+	//-----------------------------------------------------------------------------------------------------------------------------
+	inline const SPlatformType* FindPlatformType( const uint32_t uTypeHash )
+	{
+		for( const SPlatformType& rsType : k_asPlatformTypes )
+		{
+			if( rsType.uTypeHash == uTypeHash )
+			{
+				return &rsType;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// Static object group of the map turned into shapes of the environment's collider
+	struct SEnvironmentGroup
+	{
+		// Name of the object group in the Tiled map
+		const char*			pszGroupName;
+		// Tag given to the shapes, used to identify obstacles from walls
+		int					iTag;
+		// Layer set in the collision bitmap for the tiles covered by the group's objects
+		uint8_t				uiBitmapLayer;
+	};
+
+	// Category shared by every environment shape
+	constexpr CollisionMatrix::ECategory k_eEnvironmentCategory = CollisionMatrix::ECategory::Wall;
+
+	// Every object group turned into the map's static collider
+	constexpr SEnvironmentGroup k_asEnvironmentGroups[] =
+	{
+		{ "Stage Bounds",	Environment::k_iBoundLayer,		CCollisionBitmap::Bound },
+		{ "Walls",			Environment::k_iWallLayer,		CCollisionBitmap::Wall },
+		{ "Floor",			Environment::k_iFloorLayer,		CCollisionBitmap::Floor },
+		{ "Obstacles",		Environment::k_iObstacleLayer,	CCollisionBitmap::Obstacle },
+		{ "Climbable",		Environment::k_iClimbLayer,		CCollisionBitmap::Climb },
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AreTypeHashesUnique()
+	// Parameters		: iFirst			- Index of the first type of the pair to compare
+	//					: iSecond			- Index of the second type of the pair to compare
+	// Purpose			: Compare the hashes of every pair of platform types, used to catch hash collisions at compile time
+	// Returns			: True if no two types share the same hash
+	//-----------------------------------------------------------------------------------------------------------------------------
+	constexpr bool AreTypeHashesUnique( const int iFirst = 0, const int iSecond = 1 )
+	{
+		return ( iFirst >= k_iNumOfPlatformTypes ) ? true
+			: ( iSecond >= k_iNumOfPlatformTypes ) ? AreTypeHashesUnique( iFirst + 1, iFirst + 2 )
+			: ( k_asPlatformTypes[ iFirst ].uTypeHash != k_asPlatformTypes[ iSecond ].uTypeHash )
+				&& AreTypeHashesUnique( iFirst, iSecond + 1 );
+	}
+
+	static_assert( AreTypeHashesUnique(), "Two platform types share the same hashed name" );
+}
+
+#endif // !ENTITYREGISTRY_H
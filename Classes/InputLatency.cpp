@@ -0,0 +1,172 @@
+#include "InputLatency.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <CCDirector.h>
+#include <CCEventDispatcher.h>
+#include <CCEventListenerCustom.h>
+#include <cocos/base/ccMacros.h>
+
+// Inputs kept while no frame is presented, e.g. while the game is paused, the oldest ones are dropped past it
+static const size_t k_uiMaxInputsInFlight = 256;
+
+const int CInputLatencyTracker::k_iBuckets;
+constexpr float CInputLatencyTracker::k_fBucketMs;
+
+CInputLatencyTracker::CInputLatencyTracker()
+	: m_pcEventDispatcher( nullptr )
+	, m_pcListener( nullptr )
+{
+	// Stamping an input never allocates
+	m_asInputs.reserve( k_uiMaxInputsInFlight );
+
+	Reset();
+}
+
+CInputLatencyTracker::~CInputLatencyTracker()
+{
+	Detach();
+}
+
+void CInputLatencyTracker::Attach( cocos2d::EventDispatcher* pcEventDispatcher )
+{
+	CCASSERT( nullptr != pcEventDispatcher, "Event dispatcher is null" );
+
+	Detach();
+
+	m_pcEventDispatcher = pcEventDispatcher;
+
+	// Sent once the scene is drawn, right before the buffers are swapped
+	m_pcListener = cocos2d::EventListenerCustom::create( cocos2d::Director::EVENT_AFTER_DRAW, [this]( cocos2d::EventCustom* )
+	{
+		OnFramePresented();
+	} );
+
+	m_pcEventDispatcher->addEventListenerWithFixedPriority( m_pcListener, 1 );
+}
+
+void CInputLatencyTracker::Detach()
+{
+	if( nullptr != m_pcListener )
+	{
+		m_pcEventDispatcher->removeEventListener( m_pcListener );
+		m_pcListener = nullptr;
+		m_pcEventDispatcher = nullptr;
+	}
+}
+
+void CInputLatencyTracker::OnInput( const TimePoint cTime )
+{
+	if( m_asInputs.size() >= k_uiMaxInputsInFlight )
+	{
+		m_asInputs.erase( m_asInputs.begin() );
+	}
+
+	SInput sInput;
+	sInput.cArrival = cTime;
+	sInput.cTick = cTime;
+	sInput.bIsTicked = false;
+
+	m_asInputs.push_back( sInput );
+}
+
+void CInputLatencyTracker::OnSimulationTick( const TimePoint cTime )
+{
+	// An input is used by the first tick after its arrival, later ticks before the frame is presented do not change it
+	for( SInput& rsInput : m_asInputs )
+	{
+		if( !rsInput.bIsTicked )
+		{
+			rsInput.cTick = cTime;
+			rsInput.bIsTicked = true;
+		}
+	}
+}
+
+void CInputLatencyTracker::OnFramePresented( const TimePoint cTime )
+{
+	// Inputs arrived after the last tick wait for the next frame
+	std::vector<SInput>::iterator itFirstWaiting = std::stable_partition( m_asInputs.begin(), m_asInputs.end(),
+		[]( const SInput& rsInput ) { return rsInput.bIsTicked; } );
+
+	for( std::vector<SInput>::const_iterator it = m_asInputs.begin(); it != itFirstWaiting; ++it )
+	{
+		AddSample( m_sInputToTick, it->cTick - it->cArrival );
+		AddSample( m_sTickToPresent, cTime - it->cTick );
+		AddSample( m_sInputToPresent, cTime - it->cArrival );
+	}
+
+	m_asInputs.erase( m_asInputs.begin(), itFirstWaiting );
+}
+
+void CInputLatencyTracker::AddSample( SHistogram& rsHistogram, const std::chrono::steady_clock::duration cDelay )
+{
+	const float fDelayMs = std::max( 0.0f, std::chrono::duration<float, std::milli>( cDelay ).count() );
+	const int iBucket = std::min( k_iBuckets, static_cast<int>( fDelayMs / k_fBucketMs ) );
+
+	rsHistogram.auiCounts[ iBucket ]++;
+	rsHistogram.iSamples++;
+	rsHistogram.fMaxMs = std::max( rsHistogram.fMaxMs, fDelayMs );
+}
+
+void CInputLatencyTracker::GetPercentiles( const SHistogram& rsHistogram, SPercentiles& rsPercentiles )
+{
+	rsPercentiles.iSamples = rsHistogram.iSamples;
+	rsPercentiles.fMaxMs = rsHistogram.fMaxMs;
+
+	const float afRanks[] = { 0.5f, 0.9f, 0.99f };
+	float* apfPercentiles[] = { &rsPercentiles.fP50Ms, &rsPercentiles.fP90Ms, &rsPercentiles.fP99Ms };
+
+	for( int i = 0; i < 3; i++ )
+	{
+		// Smallest bucket holding the rank's sample, the overflow bucket reports the slowest sample
+		const unsigned int uiRank = static_cast<unsigned int>( afRanks[ i ] * rsHistogram.iSamples );
+		unsigned int uiCount = 0;
+		int iBucket = 0;
+
+		while( iBucket < k_iBuckets && uiCount + rsHistogram.auiCounts[ iBucket ] <= uiRank )
+		{
+			uiCount += rsHistogram.auiCounts[ iBucket ];
+			iBucket++;
+		}
+
+		*apfPercentiles[ i ] = ( 0 == rsHistogram.iSamples ) ? 0.0f
+			: ( iBucket < k_iBuckets ) ? std::min( ( iBucket + 1 ) * k_fBucketMs, rsHistogram.fMaxMs ) : rsHistogram.fMaxMs;
+	}
+}
+
+void CInputLatencyTracker::GetReport( SReport& rsReport ) const
+{
+	GetPercentiles( m_sInputToTick, rsReport.sInputToTick );
+	GetPercentiles( m_sTickToPresent, rsReport.sTickToPresent );
+	GetPercentiles( m_sInputToPresent, rsReport.sInputToPresent );
+}
+
+void CInputLatencyTracker::Log() const
+{
+	SReport sReport;
+	GetReport( sReport );
+
+	const SPercentiles* apsDelays[] = { &sReport.sInputToTick, &sReport.sTickToPresent, &sReport.sInputToPresent };
+	const char* apszNames[] = { "input to tick", "tick to present", "input to present" };
+
+	for( int i = 0; i < 3; i++ )
+	{
+		CCLOG( "Input latency, %s: %d samples, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms", apszNames[ i ],
+			apsDelays[ i ]->iSamples, apsDelays[ i ]->fP50Ms, apsDelays[ i ]->fP90Ms, apsDelays[ i ]->fP99Ms,
+			apsDelays[ i ]->fMaxMs );
+	}
+}
+
+void CInputLatencyTracker::Reset()
+{
+	m_asInputs.clear();
+
+	for( SHistogram* psHistogram : { &m_sInputToTick, &m_sTickToPresent, &m_sInputToPresent } )
+	{
+		memset( psHistogram->auiCounts, 0, sizeof( psHistogram->auiCounts ) );
+		psHistogram->iSamples = 0;
+		psHistogram->fMaxMs = 0.0f;
+	}
+}
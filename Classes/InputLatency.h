@@ -0,0 +1,158 @@
+#ifndef INPUTLATENCY_H
+#define INPUTLATENCY_H
+
+#include <chrono>
+#include <vector>
+
+namespace cocos2d
+{
+	class EventDispatcher;
+	class EventListener;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CInputLatencyTracker
+// Purpose				: To measure how long an input takes to show on screen. Every input is stamped when it arrives, again
+//						: by the first simulation tick that can use it, and once more when the frame drawn after that tick
+//						: is presented. The three delays (waiting for the tick, tick to display and the whole latency)
+//						: are gathered in histograms for the whole session and reported as percentiles
+// Notes				: Once attached, the frames are stamped after the Director has drawn them, right before the buffers
+//						: are swapped, so waiting for the vertical sync is not counted. Without a Director, e.g. in a
+//						: headless run fed with synthetic input, the owner calls OnFramePresented() itself
+// Example				: cTracker.OnInput(); ... cTracker.OnSimulationTick(); ... cTracker.OnFramePresented(); cTracker.Log();
+//-----------------------------------------------------------------------------------------------------------------------------
+class CInputLatencyTracker
+{
+
+public:
+
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	// Percentiles of one of the delays, in milliseconds
+	struct SPercentiles
+	{
+		int		iSamples;
+		float	fP50Ms;
+		float	fP90Ms;
+		float	fP99Ms;
+		float	fMaxMs;
+	};
+
+	// Delays of the session
+	struct SReport
+	{
+		SPercentiles	sInputToTick;
+		SPercentiles	sTickToPresent;
+		SPercentiles	sInputToPresent;
+	};
+
+private:
+
+	// Resolution and range of the histograms, slower samples are counted in the last bucket
+	static const int k_iBuckets = 1000;
+	static constexpr float k_fBucketMs = 0.25f;
+
+	// Distribution of a delay
+	struct SHistogram
+	{
+		unsigned int	auiCounts[ k_iBuckets + 1 ];
+		int				iSamples;
+		float			fMaxMs;
+	};
+
+	// Input waiting to be shown, the tick is set once a simulation tick has used it
+	struct SInput
+	{
+		TimePoint		cArrival;
+		TimePoint		cTick;
+		bool			bIsTicked;
+	};
+
+	// Inputs not shown yet, in their arrival order
+	std::vector<SInput> m_asInputs;
+
+	SHistogram m_sInputToTick;
+	SHistogram m_sTickToPresent;
+	SHistogram m_sInputToPresent;
+
+	// Dispatcher of the Director's events and listener stamping the presented frames
+	cocos2d::EventDispatcher* m_pcEventDispatcher;
+	cocos2d::EventListener* m_pcListener;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddSample()
+	// Parameters		: rsHistogram		- Histogram of the delay
+	//					: cDelay			- Delay measured
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static void AddSample( SHistogram& rsHistogram, const std::chrono::steady_clock::duration cDelay );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetPercentiles()
+	// Parameters		: rsHistogram		- Histogram of the delay
+	//					: rsPercentiles		- Filled with the percentiles, each one the upper end of its bucket
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static void GetPercentiles( const SHistogram& rsHistogram, SPercentiles& rsPercentiles );
+
+	// Non copyable, the listener points to the tracker
+	CInputLatencyTracker( const CInputLatencyTracker& ) = delete;
+	CInputLatencyTracker& operator=( const CInputLatencyTracker& ) = delete;
+
+public:
+
+	CInputLatencyTracker();
+	~CInputLatencyTracker();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Attach()
+	// Parameters		: pcEventDispatcher	- Dispatcher of the Director's events
+	// Purpose			: Stamp every frame drawn by the Director as presented
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Attach( cocos2d::EventDispatcher* pcEventDispatcher );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Detach()
+	// Purpose			: Stop stamping the Director's frames
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Detach();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: OnInput()
+	// Parameters		: cTime				- Arrival of the input, now unless replaying synthetic input
+	// Purpose			: Stamp an input, called by the input listeners for every key or touch event
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void OnInput( const TimePoint cTime = std::chrono::steady_clock::now() );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: OnSimulationTick()
+	// Parameters		: cTime				- Start of the tick
+	// Purpose			: Stamp the inputs arrived since the last tick as used by this one
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void OnSimulationTick( const TimePoint cTime = std::chrono::steady_clock::now() );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: OnFramePresented()
+	// Parameters		: cTime				- Presentation of the frame
+	// Purpose			: Record the delays of the ticked inputs, which this frame shows
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void OnFramePresented( const TimePoint cTime = std::chrono::steady_clock::now() );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetReport()
+	// Parameters		: rsReport			- Filled with the percentiles of the session
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GetReport( SReport& rsReport ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Log()
+	// Purpose			: Log the percentiles of the session
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Log() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Reset()
+	// Purpose			: Drop the samples and the inputs in flight, starting a new session
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Reset();
+};
+
+#endif // !INPUTLATENCY_H
@@ -0,0 +1,302 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#include <cocos/base/ccMacros.h>
+
+const unsigned int CJobSystem::k_uiMaxWorkers;
+
+CJobSystem::CJobSystem( const unsigned int uiWorkers )
+	: m_iJobCount( 0 )
+	, m_iBatchCount( 0 )
+	, m_iJobsLeft( 0 )
+	, m_iJobsQueued( 0 )
+	, m_uiFrame( 0 )
+	, m_bStop( false )
+{
+	const unsigned int uiThreads = std::min( uiWorkers, k_uiMaxWorkers ) + 1;
+
+	for( unsigned int i = 0; i < uiThreads; i++ )
+	{
+		m_apsQueues.emplace_back( new SQueue() );
+	}
+
+	// The first queue is the one of the thread calling Run()
+	for( unsigned int i = 1; i < uiThreads; i++ )
+	{
+		m_acWorkers.emplace_back( &CJobSystem::WorkerLoop, this, i );
+	}
+}
+
+CJobSystem::~CJobSystem()
+{
+	{
+		std::lock_guard<std::mutex> cLock( m_cMutex );
+		m_bStop = true;
+	}
+
+	m_cCondition.notify_all();
+
+	for( std::thread& rcWorker : m_acWorkers )
+	{
+		rcWorker.join();
+	}
+}
+
+CJobSystem::JobID CJobSystem::Add( const JobFunction& fnWork, std::initializer_list<JobID> aiDependencies )
+{
+	const JobID iJob = NewJob();
+
+	SJob& rsJob = m_asJobs[ iJob ];
+	rsJob.fnWork = fnWork;
+	rsJob.iWaitingFor = static_cast<int>( aiDependencies.size() );
+
+	// Dependencies are always added before, so the graph has no cycle
+	for( const JobID iDependency : aiDependencies )
+	{
+		CCASSERT( iDependency >= 0 && iDependency < iJob, "Unknown dependency" );
+		m_asJobs[ iDependency ].aiSuccessors.push_back( iJob );
+	}
+
+	return iJob;
+}
+
+CJobSystem::JobID CJobSystem::AddParallelFor( const int iCount, const int iBatchSize, const BatchFunction& fnBatch,
+	std::initializer_list<JobID> aiDependencies )
+{
+	const int iSize = std::max( 1, iBatchSize );
+	const int iBatches = ( std::max( 0, iCount ) + iSize - 1 ) / iSize;
+
+	// One copy of the work for every batch, the caller's may be a temporary
+	if( m_iBatchCount == static_cast<int>( m_afnBatches.size() ) )
+	{
+		m_afnBatches.emplace_back();
+	}
+
+	BatchFunction& rfnBatch = m_afnBatches[ m_iBatchCount++ ];
+	rfnBatch = fnBatch;
+
+	// Empty job gathering the batches, added right after them, later jobs depend on it instead of every batch
+	const JobID iJoin = m_iJobCount + iBatches;
+
+	for( int iBegin = 0; iBegin < iCount; iBegin += iSize )
+	{
+		SJob& rsBatch = m_asJobs[ Add( JobFunction(), aiDependencies ) ];
+		rsBatch.pfnBatch = &rfnBatch;
+		rsBatch.iBegin = iBegin;
+		rsBatch.iEnd = std::min( iCount, iBegin + iSize );
+		rsBatch.aiSuccessors.push_back( iJoin );
+	}
+
+	Add( JobFunction() );
+	m_asJobs[ iJoin ].iWaitingFor = iBatches;
+
+	return iJoin;
+}
+
+CJobSystem::JobID CJobSystem::NewJob()
+{
+	const JobID iJob = m_iJobCount++;
+
+	if( iJob == static_cast<JobID>( m_asJobs.size() ) )
+	{
+		m_asJobs.emplace_back();
+	}
+
+	// A job kept from an earlier frame keeps the capacity of its successors
+	SJob& rsJob = m_asJobs[ iJob ];
+	rsJob.fnWork = nullptr;
+	rsJob.pfnBatch = nullptr;
+	rsJob.iBegin = 0;
+	rsJob.iEnd = 0;
+	rsJob.iWaitingFor = 0;
+	rsJob.aiSuccessors.clear();
+
+	return iJob;
+}
+
+void CJobSystem::Run()
+{
+	if( 0 == m_iJobCount )
+	{
+		return;
+	}
+
+	m_iJobsLeft = m_iJobCount;
+
+	// Spread the jobs that can start straight away over every queue
+	unsigned int uiQueue = 0;
+
+	for( int i = 0; i < m_iJobCount; i++ )
+	{
+		if( 0 == m_asJobs[ i ].iWaitingFor )
+		{
+			Push( uiQueue, i );
+			uiQueue = ( uiQueue + 1 ) % m_apsQueues.size();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> cLock( m_cMutex );
+		m_uiFrame++;
+	}
+
+	m_cCondition.notify_all();
+
+	// The calling thread works too instead of waiting
+	HelpUntilDone( 0 );
+
+	// Every job is done, the workers no longer read the graph, its storage is kept for the next frame
+	m_iJobCount = 0;
+	m_iBatchCount = 0;
+}
+
+void CJobSystem::WorkerLoop( const unsigned int uiQueue )
+{
+	uint64_t uiLastFrame = 0;
+
+	while( true )
+	{
+		{
+			std::unique_lock<std::mutex> cLock( m_cMutex );
+			m_cCondition.wait( cLock, [this, uiLastFrame]() { return m_bStop || m_uiFrame != uiLastFrame; } );
+
+			if( m_bStop )
+			{
+				return;
+			}
+
+			uiLastFrame = m_uiFrame;
+		}
+
+		// Help until the frame is done, the jobs still waiting for others show up in the queues as they are released
+		HelpUntilDone( uiQueue );
+	}
+}
+
+void CJobSystem::HelpUntilDone( const unsigned int uiQueue )
+{
+	while( m_iJobsLeft.load( std::memory_order_acquire ) > 0 )
+	{
+		if( !RunOneJob( uiQueue ) )
+		{
+			// The jobs left are running or waiting for running ones, sleep until one is released or the frame is done
+			std::unique_lock<std::mutex> cLock( m_cMutex );
+			m_cCondition.wait( cLock, [this]()
+				{
+					return m_bStop || m_iJobsQueued.load( std::memory_order_acquire ) > 0
+						|| 0 == m_iJobsLeft.load( std::memory_order_acquire );
+				} );
+
+			if( m_bStop )
+			{
+				return;
+			}
+		}
+	}
+}
+
+bool CJobSystem::RunOneJob( const unsigned int uiQueue )
+{
+	JobID iJob = -1;
+
+	// Newest job of the own queue, its data is the most likely to still be in the cache
+	{
+		SQueue& rsQueue = *m_apsQueues[ uiQueue ];
+		std::lock_guard<std::mutex> cLock( rsQueue.cMutex );
+
+		if( rsQueue.uiFront < rsQueue.aiJobs.size() )
+		{
+			iJob = rsQueue.aiJobs.back();
+			rsQueue.aiJobs.pop_back();
+			m_iJobsQueued.fetch_sub( 1, std::memory_order_acq_rel );
+
+			if( rsQueue.uiFront == rsQueue.aiJobs.size() )
+			{
+				rsQueue.aiJobs.clear();
+				rsQueue.uiFront = 0;
+			}
+		}
+	}
+
+	// Otherwise steal the oldest job of another queue
+	for( unsigned int i = 1; i < m_apsQueues.size() && iJob < 0; i++ )
+	{
+		SQueue& rsQueue = *m_apsQueues[ ( uiQueue + i ) % m_apsQueues.size() ];
+		std::lock_guard<std::mutex> cLock( rsQueue.cMutex );
+
+		if( rsQueue.uiFront < rsQueue.aiJobs.size() )
+		{
+			iJob = rsQueue.aiJobs[ rsQueue.uiFront++ ];
+			m_iJobsQueued.fetch_sub( 1, std::memory_order_acq_rel );
+
+			if( rsQueue.uiFront == rsQueue.aiJobs.size() )
+			{
+				rsQueue.aiJobs.clear();
+				rsQueue.uiFront = 0;
+			}
+		}
+	}
+
+	if( iJob < 0 )
+	{
+		return false;
+	}
+
+	SJob& rsJob = m_asJobs[ iJob ];
+
+	if( nullptr != rsJob.pfnBatch )
+	{
+		( *rsJob.pfnBatch )( rsJob.iBegin, rsJob.iEnd );
+	}
+	else if( rsJob.fnWork )
+	{
+		rsJob.fnWork();
+	}
+
+	bool bReleased = false;
+
+	for( const JobID iSuccessor : rsJob.aiSuccessors )
+	{
+		if( 1 == m_asJobs[ iSuccessor ].iWaitingFor.fetch_sub( 1, std::memory_order_acq_rel ) )
+		{
+			Push( uiQueue, iSuccessor );
+			bReleased = true;
+		}
+	}
+
+	// Last access to the graph, Run() may clear it as soon as the count reaches zero
+	const bool bIsLast = ( 1 == m_iJobsLeft.fetch_sub( 1, std::memory_order_acq_rel ) );
+
+	// Wake the sleeping threads to run the released jobs, or the thread calling Run() to end the frame. The lock makes
+	// sure none of them is between checking the counts and going to sleep
+	if( bReleased || bIsLast )
+	{
+		{
+			std::lock_guard<std::mutex> cLock( m_cMutex );
+		}
+
+		m_cCondition.notify_all();
+	}
+
+	return true;
+}
+
+void CJobSystem::Push( const unsigned int uiQueue, const JobID iJob )
+{
+	SQueue& rsQueue = *m_apsQueues[ uiQueue ];
+	std::lock_guard<std::mutex> cLock( rsQueue.cMutex );
+	rsQueue.aiJobs.push_back( iJob );
+	m_iJobsQueued.fetch_add( 1, std::memory_order_acq_rel );
+}
+
+unsigned int CJobSystem::GetWorkerCount() const
+{
+	return static_cast<unsigned int>( m_acWorkers.size() );
+}
+
+unsigned int CJobSystem::GetDefaultWorkerCount()
+{
+	const unsigned int uiCores = std::thread::hardware_concurrency();
+	return std::min( uiCores > 1 ? uiCores - 1 : 0u, k_uiMaxWorkers );
+}
@@ -0,0 +1,199 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CJobSystem
+// Purpose				: To run the independent work of a frame on every core. The frame is described as a graph of jobs, each
+//						: job starts once the jobs it depends on are done. Run() executes the graph on the worker threads and
+//						: the calling thread, every thread takes the newest job of its own queue and steals the oldest one
+//						: of the others when its queue is empty, then Run() returns once every job is done
+// Notes				: Jobs must not call cocos2d-x, the engine is not thread safe: they compute and store results, which
+//						: the caller applies to the nodes and the physics bodies after Run(). The graph is built and run by
+//						: one thread, it is cleared by Run() which keeps its storage, so a frame building a graph no bigger
+//						: than the previous ones allocates nothing
+// Example				: CJobSystem::JobID iAI = cJobs.AddParallelFor( iEnemies, 8, fnThink );
+//						: cJobs.Add( fnSteer, { iAI } ); cJobs.Run();
+//-----------------------------------------------------------------------------------------------------------------------------
+class CJobSystem
+{
+
+public:
+
+	// Index of a job in the frame's graph
+	typedef int JobID;
+
+	// Work of a job
+	typedef std::function<void()> JobFunction;
+
+	// Work of a batch of a parallel for, called with the first index and one past the last index of the batch
+	typedef std::function<void( int, int )> BatchFunction;
+
+	// Most worker threads created, the main thread works too
+	static const unsigned int k_uiMaxWorkers = 7;
+
+private:
+
+	// Job of the frame's graph
+	struct SJob
+	{
+		JobFunction			fnWork;
+
+		// Work of the parallel for the job is a batch of, run instead of fnWork, and the batch's items
+		const BatchFunction*	pfnBatch;
+		int					iBegin;
+		int					iEnd;
+		// Jobs this one still waits for
+		std::atomic<int>	iWaitingFor;
+		// Jobs waiting for this one
+		std::vector<JobID>	aiSuccessors;
+	};
+
+	// Jobs ready to run owned by one thread, the owner works on the back and the thieves on the front
+	struct SQueue
+	{
+		std::mutex			cMutex;
+		// Queued jobs from aiJobs[ uiFront ] to the back, emptied when the front reaches the back so that the vector
+		// keeps its capacity
+		std::vector<JobID>	aiJobs;
+		size_t				uiFront;
+
+		SQueue()
+			: uiFront( 0 )
+		{}
+	};
+
+	// Jobs of the frames run until now, a deque so that adding jobs never moves the existing ones. The first
+	// m_iJobCount ones make the graph of the running frame, the others are kept for the next frames
+	std::deque<SJob> m_asJobs;
+	int m_iJobCount;
+
+	// Copies of the work of the frame's parallel fors, shared by their batches and kept like the jobs
+	std::deque<BatchFunction> m_afnBatches;
+	int m_iBatchCount;
+
+	// One queue per thread, the first one belongs to the thread calling Run()
+	std::vector<std::unique_ptr<SQueue>> m_apsQueues;
+
+	// Worker threads
+	std::vector<std::thread> m_acWorkers;
+
+	// Jobs of the running frame not done yet
+	std::atomic<int> m_iJobsLeft;
+
+	// Jobs waiting in the queues
+	std::atomic<int> m_iJobsQueued;
+
+	// Wakes the workers when a frame starts, when jobs are released or when they have to stop, and the thread calling
+	// Run() when the frame is done
+	std::mutex m_cMutex;
+	std::condition_variable m_cCondition;
+	uint64_t m_uiFrame;
+	bool m_bStop;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: NewJob()
+	// Purpose			: Take the next job of the storage, reset with no work, dependency or successor
+	// Returns			: The ID of the job
+	//-----------------------------------------------------------------------------------------------------------------------------
+	JobID NewJob();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: WorkerLoop()
+	// Parameters		: uiQueue			- Index of the worker's queue
+	// Purpose			: Body of the worker threads, help with every frame until stopped
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void WorkerLoop( const unsigned int uiQueue );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: HelpUntilDone()
+	// Parameters		: uiQueue			- Index of the calling thread's queue
+	// Purpose			: Run jobs until every job of the frame is done, sleeping while the jobs left are running on other
+	//					: threads and none is queued
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void HelpUntilDone( const unsigned int uiQueue );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: RunOneJob()
+	// Parameters		: uiQueue			- Index of the calling thread's queue
+	// Purpose			: Run the newest job of the thread's queue, or steal the oldest job of another queue, then queue the
+	//					: jobs that were only waiting for it
+	// Returns			: False if there was no job to run
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool RunOneJob( const unsigned int uiQueue );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Push()
+	// Parameters		: uiQueue			- Index of the queue
+	//					: iJob				- Job ready to run
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Push( const unsigned int uiQueue, const JobID iJob );
+
+	// Non copyable, the workers point to the system
+	CJobSystem( const CJobSystem& ) = delete;
+	CJobSystem& operator=( const CJobSystem& ) = delete;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CJobSystem()
+	// Parameters		: uiWorkers			- Amount of worker threads, 0 runs every job on the thread calling Run()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	explicit CJobSystem( const unsigned int uiWorkers = GetDefaultWorkerCount() );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Destructor name	: ~CJobSystem()
+	// Purpose			: Stop and join the workers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	~CJobSystem();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Add()
+	// Parameters		: fnWork			- Work of the job
+	//					: aiDependencies	- Jobs that have to be done before this one starts
+	// Returns			: The ID of the job, used as a dependency of later jobs
+	//-----------------------------------------------------------------------------------------------------------------------------
+	JobID Add( const JobFunction& fnWork, std::initializer_list<JobID> aiDependencies = {} );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddParallelFor()
+	// Parameters		: iCount			- Amount of items
+	//					: iBatchSize		- Items per job
+	//					: fnBatch			- Work of a batch of items
+	//					: aiDependencies	- Jobs that have to be done before any batch starts
+	// Purpose			: Split the items in batches run as separate jobs
+	// Returns			: The ID of a job done once every batch is done
+	//-----------------------------------------------------------------------------------------------------------------------------
+	JobID AddParallelFor( const int iCount, const int iBatchSize, const BatchFunction& fnBatch,
+		std::initializer_list<JobID> aiDependencies = {} );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Run()
+	// Purpose			: Run every job added since the last call and wait for them, then clear the graph
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Run();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetWorkerCount()
+	// Returns			: The amount of worker threads
+	//-----------------------------------------------------------------------------------------------------------------------------
+	unsigned int GetWorkerCount() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetDefaultWorkerCount()
+	// Returns			: One worker per core left to the main thread, at most k_uiMaxWorkers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static unsigned int GetDefaultWorkerCount();
+};
+
+#endif // !JOBSYSTEM_H
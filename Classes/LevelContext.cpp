@@ -0,0 +1,157 @@
+#include "LevelContext.h"
+
+#include <AudioEngine.h>
+#include <CCDirector.h>
+#include <CCEventDispatcher.h>
+#include <CCScheduler.h>
+#include <cocos/2d/CCActionManager.h>
+#include <cocos/2d/CCNode.h>
+#include <cocos/base/CCConfiguration.h>
+#include <cocos/renderer/CCTextureCache.h>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CEngineAudioService
+// Classes Inherited	: CAudioService
+// Purpose				: Forward the sounds to cocos2d-x's audio engine
+//-----------------------------------------------------------------------------------------------------------------------------
+class CEngineAudioService : public CAudioService
+{
+public:
+
+	int VPlay2D( const std::string& rsFilePath, const bool bLoop, const float fVolume ) override
+	{
+		return cocos2d::AudioEngine::play2d( rsFilePath, bLoop, fVolume );
+	}
+
+	void VStop( const int iAudioID ) override
+	{
+		cocos2d::AudioEngine::stop( iAudioID );
+	}
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CSilentAudioService
+// Classes Inherited	: CAudioService
+// Purpose				: Ignore the sounds of a level simulated without a window
+//-----------------------------------------------------------------------------------------------------------------------------
+class CSilentAudioService : public CAudioService
+{
+public:
+
+	int VPlay2D( const std::string&, const bool, const float ) override
+	{
+		return -1;
+	}
+
+	void VStop( const int ) override {}
+};
+
+CLevelContext::CLevelContext( cocos2d::EventDispatcher* pcEventDispatcher, cocos2d::Scheduler* pcScheduler,
+	cocos2d::ActionManager* pcActionManager, CAudioService* pcAudioService, cocos2d::TextureCache* pcTextureCache,
+	const float fContentScaleFactor, const cocos2d::Rect& rcVisibleRect, const bool bOwnsSystems )
+	: m_pcEventDispatcher( pcEventDispatcher )
+	, m_pcScheduler( pcScheduler )
+	, m_pcActionManager( pcActionManager )
+	, m_pcAudioService( pcAudioService )
+	, m_pcTextureCache( pcTextureCache )
+	, m_fContentScaleFactor( fContentScaleFactor )
+	, m_cVisibleRect( rcVisibleRect )
+	, m_uiSteps( 0 )
+	, m_bOwnsSystems( bOwnsSystems )
+{}
+
+CLevelContext* CLevelContext::CreateShared()
+{
+	cocos2d::Director* pcDirector = cocos2d::Director::getInstance();
+
+	return new CLevelContext( pcDirector->getEventDispatcher(), pcDirector->getScheduler(), pcDirector->getActionManager(),
+		new CEngineAudioService(), pcDirector->getTextureCache(), pcDirector->getContentScaleFactor(),
+		cocos2d::Rect::ZERO, false );
+}
+
+CLevelContext* CLevelContext::CreateIsolated( const float fContentScaleFactor, const cocos2d::Rect& rcVisibleRect )
+{
+	// Same set up done by the Director for its own systems
+	cocos2d::EventDispatcher* pcEventDispatcher = new cocos2d::EventDispatcher();
+	pcEventDispatcher->setEnabled( true );
+
+	cocos2d::Scheduler* pcScheduler = new cocos2d::Scheduler();
+	cocos2d::ActionManager* pcActionManager = new cocos2d::ActionManager();
+	pcScheduler->scheduleUpdate( pcActionManager, cocos2d::Scheduler::PRIORITY_SYSTEM, false );
+
+	// No texture is preloaded and nothing is rendered, an isolated level is only simulated
+	return new CLevelContext( pcEventDispatcher, pcScheduler, pcActionManager, new CSilentAudioService(), nullptr,
+		fContentScaleFactor, rcVisibleRect, true );
+}
+
+CLevelContext::~CLevelContext()
+{
+	if( m_bOwnsSystems )
+	{
+		m_pcScheduler->unscheduleUpdate( m_pcActionManager );
+
+		CC_SAFE_RELEASE( m_pcActionManager );
+		CC_SAFE_RELEASE( m_pcScheduler );
+		CC_SAFE_RELEASE( m_pcEventDispatcher );
+	}
+
+	CC_SAFE_DELETE( m_pcAudioService );
+}
+
+void CLevelContext::ApplyTo( cocos2d::Node* pcNode ) const
+{
+	CCASSERT( nullptr != pcNode, "Node is null" );
+
+	pcNode->setEventDispatcher( m_pcEventDispatcher );
+	pcNode->setScheduler( m_pcScheduler );
+	pcNode->setActionManager( m_pcActionManager );
+
+	for( cocos2d::Node* pcChild : pcNode->getChildren() )
+	{
+		ApplyTo( pcChild );
+	}
+}
+
+void CLevelContext::Step( const float fDeltaTime )
+{
+	if( m_bOwnsSystems )
+	{
+		m_pcScheduler->update( fDeltaTime );
+		m_uiSteps++;
+	}
+}
+
+cocos2d::Rect CLevelContext::GetVisibleRect() const
+{
+	if( m_bOwnsSystems )
+	{
+		return m_cVisibleRect;
+	}
+
+	// The window of the game may be resized, so its view is read every time
+	const cocos2d::Director* pcDirector = cocos2d::Director::getInstance();
+	return cocos2d::Rect( pcDirector->getVisibleOrigin(), pcDirector->getVisibleSize() );
+}
+
+unsigned int CLevelContext::GetFrame() const
+{
+	return m_bOwnsSystems ? m_uiSteps : cocos2d::Director::getInstance()->getTotalFrames();
+}
+
+cocos2d::Renderer* CLevelContext::GetRenderer() const
+{
+	return m_bOwnsSystems ? nullptr : cocos2d::Director::getInstance()->getRenderer();
+}
+
+int CLevelContext::GetMaxTextureSize() const
+{
+	return m_bOwnsSystems ? 0 : cocos2d::Configuration::getInstance()->getMaxTextureSize();
+}
+
+cocos2d::EventDispatcher* CLevelContext::GetEventDispatcher() const	{ return m_pcEventDispatcher; }
+cocos2d::Scheduler* CLevelContext::GetScheduler() const				{ return m_pcScheduler; }
+cocos2d::ActionManager* CLevelContext::GetActionManager() const		{ return m_pcActionManager; }
+CAudioService& CLevelContext::GetAudio() const						{ return *m_pcAudioService; }
+cocos2d::TextureCache* CLevelContext::GetTextureCache() const			{ return m_pcTextureCache; }
+float CLevelContext::GetContentScaleFactor() const					{ return m_fContentScaleFactor; }
+bool CLevelContext::IsIsolated() const								{ return m_bOwnsSystems; }
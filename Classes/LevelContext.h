@@ -0,0 +1,152 @@
+#ifndef LEVELCONTEXT_H
+#define LEVELCONTEXT_H
+
+#include <string>
+
+#include <cocos/math/CCGeometry.h>
+
+namespace cocos2d
+{
+	class ActionManager;
+	class EventDispatcher;
+	class Node;
+	class Renderer;
+	class Scheduler;
+	class TextureCache;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CAudioService
+// Purpose				: To play the sounds of a level without reaching the global audio engine directly, so that levels
+//						: simulated without a window can be silent
+//-----------------------------------------------------------------------------------------------------------------------------
+class CAudioService
+{
+
+public:
+
+	virtual ~CAudioService() {}
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: VPlay2D()
+	// Parameters		: rsFilePath		- Path of the sound to play
+	//					: bLoop				- True if the sound has to loop
+	//					: fVolume			- Volume of the sound between 0 and 1
+	// Returns			: The ID of the playing sound, used to stop it
+	//-----------------------------------------------------------------------------------------------------------------------------
+	virtual int VPlay2D( const std::string& rsFilePath, const bool bLoop, const float fVolume ) = 0;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: VStop()
+	// Parameters		: iAudioID			- ID returned by VPlay2D()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	virtual void VStop( const int iAudioID ) = 0;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CLevelContext
+// Purpose				: To hold the engine systems a level works with instead of reaching the Director's singletons, so
+//						: that a level can be simulated next to the game's without sharing its events, schedules or sounds.
+//						: The shared context forwards to the Director's systems and the audio engine; an isolated context
+//						: owns its own event dispatcher, scheduler and action manager, plays no sound, renders nothing and
+//						: is ticked by whoever owns it, e.g. the stress harness
+// Notes				: Every level, isolated or not, runs on the cocos2d-x thread: creating nodes goes through the
+//						: autorelease pool and the file utilities, which are not thread safe. The level's code reaches the
+//						: view, the frame count and the renderer through its context only
+//-----------------------------------------------------------------------------------------------------------------------------
+class CLevelContext
+{
+
+private:
+
+	// Systems used by the level's nodes
+	cocos2d::EventDispatcher* m_pcEventDispatcher;
+	cocos2d::Scheduler* m_pcScheduler;
+	cocos2d::ActionManager* m_pcActionManager;
+
+	// Service used to play the level's sounds
+	CAudioService* m_pcAudioService;
+
+	// Texture cache the level's textures are preloaded in, nullptr if the level is simulated without rendering
+	cocos2d::TextureCache* m_pcTextureCache;
+
+	// Content scale factor used to convert design sizes to pixels
+	float m_fContentScaleFactor;
+
+	// Visible part of the design resolution of an isolated context, the shared one reads the Director's
+	cocos2d::Rect m_cVisibleRect;
+
+	// Steps of an isolated context, the shared one counts the Director's frames
+	unsigned int m_uiSteps;
+
+	// True if the systems above have been created by this context and are released with it
+	bool m_bOwnsSystems;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CLevelContext()
+	// Purpose			: Store the systems, only used by the factories below
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CLevelContext( cocos2d::EventDispatcher* pcEventDispatcher, cocos2d::Scheduler* pcScheduler,
+		cocos2d::ActionManager* pcActionManager, CAudioService* pcAudioService, cocos2d::TextureCache* pcTextureCache,
+		const float fContentScaleFactor, const cocos2d::Rect& rcVisibleRect, const bool bOwnsSystems );
+
+	// Non copyable, the context may own its systems
+	CLevelContext( const CLevelContext& ) = delete;
+	CLevelContext& operator=( const CLevelContext& ) = delete;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreateShared()
+	// Purpose			: Create a context using the Director's systems and the audio engine, the one used by the game
+	// Returns			: A new context, deleted by the caller
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CLevelContext* CreateShared();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreateIsolated()
+	// Parameters		: fContentScaleFactor	- Content scale factor the level is simulated with
+	//					: rcVisibleRect			- Part of the design resolution the level's camera would show
+	// Purpose			: Create a context with its own systems, no sound and no rendering, used to simulate a level next
+	//					: to the game's on the same thread. Its scheduler is only ticked by Step()
+	// Returns			: A new context, deleted by the caller
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CLevelContext* CreateIsolated( const float fContentScaleFactor, const cocos2d::Rect& rcVisibleRect );
+
+	~CLevelContext();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ApplyTo()
+	// Parameters		: pcNode			- Node to move to this context, with all its children
+	// Purpose			: Make the node use the context's event dispatcher, scheduler and action manager
+	// Notes			: Changing the event dispatcher drops the listeners already registered by the node, so nodes have to
+	//					: be moved right after their creation
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ApplyTo( cocos2d::Node* pcNode ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Step()
+	// Parameters		: fDeltaTime		- Time to simulate
+	// Purpose			: Tick the scheduler of an isolated context, which also updates its actions. Does nothing for the
+	//					: shared context as the Director ticks it
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Step( const float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Getters
+	// Notes			: The renderer is nullptr and the maximum texture size 0 for an isolated context
+	//-----------------------------------------------------------------------------------------------------------------------------
+	cocos2d::EventDispatcher* GetEventDispatcher() const;
+	cocos2d::Scheduler* GetScheduler() const;
+	cocos2d::ActionManager* GetActionManager() const;
+	CAudioService& GetAudio() const;
+	cocos2d::TextureCache* GetTextureCache() const;
+	float GetContentScaleFactor() const;
+	cocos2d::Rect GetVisibleRect() const;
+	unsigned int GetFrame() const;
+	cocos2d::Renderer* GetRenderer() const;
+	int GetMaxTextureSize() const;
+	bool IsIsolated() const;
+};
+
+#endif // !LEVELCONTEXT_H
@@ -1,606 +1,1491 @@
-#include "LevelManager.h"
-
-#include <CCDirector.h>
-
-#include "Enemy.h"
-#include "ExitDoor.h"
-#include "PlatformCrumbling.h"
-#include "PickupsManager.h"
-#include "Settings.h"
-#include "TextureManager.h"
-#include "Travellator.h"
-
-#include <cocos/2d/CCFastTMXLayer.h>
-
-using cocos2d::FastTMXTiledMap;
-using cocos2d::TMXObjectGroup;
-using cocos2d::TMXMapInfo;
-using cocos2d::PhysicsBody;
-using cocos2d::Vec2;
-using cocos2d::Size;
-using cocos2d::PhysicsShapeBox;
-using cocos2d::Sprite;
-using cocos2d::ValueMap;
-using cocos2d::ValueVector;
-
-CLevelManager::CLevelManager()
-	: m_pcCurrentLevel( nullptr )
-	, m_pcColliderContainer( nullptr )
-	, m_pcTextureManager( nullptr )
-	, m_pcPickupsManager( nullptr )
-	, m_bExitDoorExist( false )
-	, m_iCurrentStage( -1 )
-	, m_iNumOfTravellatorInStage( 0 )
-{
-	// Convert the current stage ID to a string
-	m_sCurrentStage = std::to_string( m_iCurrentStage );
-	// Creating platforms' vector
-	m_pcPlatforms.resize( 0 );
-	// Creating enemies' vector
-	m_pcEnemies.resize( 0 );
-
-	// Creating a vector to store all checkpoints in the game
-	m_pcCheckpoints.resize( 0 );
-	// Create a vector for all ports.
-	m_pcPorts.resize( 0 );
-
-	// Create an exit door.
-	m_pcExitDoor = new CExitDoor();
-}
-
-CLevelManager::~CLevelManager()
-{
-
-	// Cycle over all the platforms' vector and safe destroy them
-	for( CPlatformBase* pcPlatform : m_pcPlatforms )
-	{
-		m_pcCurrentLevel->removeChild( pcPlatform );
-		CC_SAFE_DELETE( pcPlatform );
-	}
-
-	// Cycle over all the enemies' vector and safe destroy them
-	for( CEnemy* pcEnemy : m_pcEnemies )
-	{
-		m_pcCurrentLevel->removeChild( pcEnemy );
-		CC_SAFE_DELETE( pcEnemy );
-	}
-
-	// Removing pickups from map
-	for( auto pickup : m_pcPickupsManager->GetPickups() )
-	{
-		m_pcCurrentLevel->removeChild( pickup );
-	}
-
-	// Cycle over all the ports' vector and safe destroy them
-	for( CPort* pcPort : m_pcPorts )
-	{
-		m_pcCurrentLevel->removeChild( pcPort );
-		CC_SAFE_DELETE( pcPort );
-	}
-
-	for( CCheckpoint* pcCheckpoint : m_pcCheckpoints )
-	{
-		m_pcCurrentLevel->removeChild( pcCheckpoint );
-		CC_SAFE_DELETE( pcCheckpoint );
-	}
-
-	m_pcCurrentLevel->removeChild( m_pcExitDoor );
-	CC_SAFE_DELETE( m_pcExitDoor );
-
-}
-
-void CLevelManager::Initialise( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD )
-{
-	m_pcHUD = pcHUD;
-
-	CCASSERT( nullptr != pcTextureManager, "Texture Manager is null" );
-	// Setting the texture manager in order to pass it to others classes
-	m_pcTextureManager = pcTextureManager;
-
-	CCASSERT( nullptr != pcPickupsManager, "Pickups Manager is null" );
-	// Setting the pickups manager in order to retrieve the pickups vector
-	m_pcPickupsManager = pcPickupsManager;
-
-	LoadAllMaps();
-
-	// Creating all platforms of all types based on the settings values
-	TCreateEntities<CPlatformCrumbling>( m_pcPlatforms, Platforms::k_iMaxAmountOfCrumblingPlatforms, *m_pcTextureManager );
-	TCreateEntities<CTravellator>( m_pcPlatforms, Platforms::k_iMaxAmountOfTravellatorsPlatforms, *m_pcTextureManager );
-
-	// Creating all ports based on the settings values
-	TCreateEntities<CPort>( m_pcPorts, Ports::k_iMaxAmountOfPorts, *m_pcTextureManager );
-	// Creating all enemies based on the settings values
-	TCreateEntities<CEnemy>( m_pcEnemies, Enemies::k_iMaxAmountOfEnemies, *m_pcTextureManager );
-
-	TCreateEntities<CCheckpoint>( m_pcCheckpoints, 1, *m_pcTextureManager );
-
-	// Create a collider for the map with no shape and all values set to 0
-	CreateColliderContainer();
-
-	// Create physics shapes for all map static objects and add them to the map's collider
-	CreateCollidableObjects( "Stage Bounds" );
-	CreateCollidableObjects( "Walls" );
-	CreateCollidableObjects( "Floor" );
-	CreateCollidableObjects( "Obstacles" );
-	CreateCollidableObjects( "Climbable" );
-
-	// Initialise the exit door
-	m_pcExitDoor->Initialise( m_pcTextureManager );
-
-	// Adding all pickups to the map
-	for( auto pickup : m_pcPickupsManager->GetPickups() )
-	{
-		m_pcCurrentLevel->addChild( pickup, 1 );
-	}
-
-	// Loading a special stage, this call is used to properly initialise all objects which can be
-	// placed in a stage. Their physics collider is set and cannot be reshaped from this point
-	LoadNewStage( -1 );
-
-}
-
-void CLevelManager::Update( float fDeltaTime )
-{
-	// Call the update of the exit door
-	m_pcExitDoor->VUpdate( fDeltaTime );
-	// Call the update of the pickups manager
-	m_pcPickupsManager->VUpdate( fDeltaTime );
-
-	// Call the update of all the travellators in the current stage
-	for( int i = 0; i < m_iNumOfTravellatorInStage; i++ )
-	{
-		CPlatformBase* pcPlatform = m_pcPlatforms[ i + Platforms::k_iMaxAmountOfCrumblingPlatforms ];
-		pcPlatform->VUpdate( fDeltaTime );
-	}
-
-}
-
-void CLevelManager::LoadAllMaps()
-{
-	// Create a map from the Tiled map of the first level
-	m_pcCurrentLevel = cocos2d::FastTMXTiledMap::create( Levels::k_cLevelOne );
-
-	CCASSERT( nullptr != m_pcCurrentLevel, "No level loaded" );
-
-}
-
-void CLevelManager::CreateColliderContainer()
-{
-
-	if( m_pcColliderContainer == nullptr )
-	{
-		// Create a physics body for the map and add it to the map
-		m_pcColliderContainer = PhysicsBody::create();
-		m_pcCurrentLevel->addComponent( m_pcColliderContainer );
-	}
-	else
-	{
-		// If the map has already a physics body then clean previous added shapes
-		// in preparation to the new level initialisation
-		m_pcColliderContainer->removeAllShapes();
-	}
-
-	// This collider will only contains walls so we don't need dynamic physics properties activated
-	m_pcColliderContainer->setMass( 0.0f );
-	m_pcColliderContainer->setMoment( 0.0f );
-	m_pcColliderContainer->setDynamic( false );
-
-#pragma region Collider Positioning Example
-	// Collider position correction
-
-	//-------------------------------------------	By default cocos2d position the collider at the
-	//|											|	center of the screen as show by X.
-	//|											|	Tilemap is rendered from the bottom left corner
-	//|											|	of the screen.
-	//|					  X						|	
-	//|											|	
-	//|											|	
-	//|											|
-	//-------------------------------------------
-
-	//-------------------------------------------	To fix this problem the collider needs to be
-	//|											|	shifted back of half the map's width and height.
-	//|											|	
-	//|											|	This offset is calculated multiplying map's
-	//|					  						|	current dimensions in tiles by the tile's
-	//|											|	dimensions and factoring the content scale   
-	//|											|	factor derived from the design resolution
-	//|											|	The result is shown as the new position of X
-	//X------------------------------------------
-#pragma endregion
-
-	float fColliderOffsetX = -m_pcCurrentLevel->getMapSize().width * m_pcCurrentLevel->getTileSize().width *
-		0.5f * m_pcCurrentLevel->getScaleX();
-	float fColliderOffsetY = -m_pcCurrentLevel->getMapSize().height * m_pcCurrentLevel->getTileSize().height *
-		0.5f * m_pcCurrentLevel->getScaleY();
-	m_pcColliderContainer->setPositionOffset( Vec2( fColliderOffsetX, fColliderOffsetY ) /
-		cocos2d::Director::getInstance()->getContentScaleFactor() );
-
-	// Set a name for the map collider which is used in the collision manager
-	m_pcColliderContainer->setName( "Environment" );
-}
-
-void CLevelManager::CreateCollidableObjects( const std::string& rsObjectGroup )
-{
-	// Get map rcObjects and make them collidable walls
-	ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObjects();
-
-	CCASSERT( !rcObjectsVector.empty(), rsObjectGroup.c_str() );
-
-	// Adding shapes to the map collider based on the Tilemap group object and 
-	// adjusting position with respect to the map's physics body
-	for( cocos2d::Value& rcObject : rcObjectsVector )
-	{
-		ValueMap& rcObjectValues = rcObject.asValueMap();
-
-		Size cShapeDimensions = Size( rcObjectValues[ "width" ].asFloat(), rcObjectValues[ "height" ].asFloat() );
-
-		// Similarly to the map's collider position correction here another coordinate correction is required
-		// but in this case the original point has to be shifted forward instead of back
-		float fOffsetCorrectionX = rcObjectValues[ "x" ].asFloat() + rcObjectValues[ "width" ].asFloat() * 0.5f;
-		float fOffsetCorrectionY = rcObjectValues[ "y" ].asFloat() + rcObjectValues[ "height" ].asFloat() * 0.5f;
-
-		// Create a collider shape for a single wall and add it to map's collider
-		PhysicsShapeBox* pCBox = PhysicsShapeBox::create( cShapeDimensions, cocos2d::PhysicsMaterial( 1.0f, 0.0f, 1.0f ),
-			Vec2( fOffsetCorrectionX, fOffsetCorrectionY ) );
-		m_pcColliderContainer->addShape( pCBox, false );
-
-		// Set tag to identify obstacles from walls
-		if( rsObjectGroup == "Stage Bounds" )	// 0
-			pCBox->setTag( Environment::k_iBoundLayer );
-		if( rsObjectGroup == "Walls" )			// 1
-			pCBox->setTag( Environment::k_iWallLayer );
-		if( rsObjectGroup == "Floor" )			// 2
-			pCBox->setTag( Environment::k_iFloorLayer );
-		if( rsObjectGroup == "Obstacles" )		// 3
-			pCBox->setTag( Environment::k_iObstacleLayer );
-		if( rsObjectGroup == "Climbable" )		// 4
-			pCBox->setTag( Environment::k_iClimbLayer );
-
-		// Set shape to collide and trigger only with the player
-		pCBox->setCollisionBitmask( WALL_BITMASK_COLLIDER );
-		pCBox->setCategoryBitmask( WALL_BITMASK_CATEGORY );
-		pCBox->setContactTestBitmask( WALL_BITMASK_CONTACT );
-	}
-}
-
-void CLevelManager::PickUpPositioning( const std::string& rsObjectGroup )
-{
-	// There is no object group with this name which means no object of this kind in this stage
-	if( nullptr == m_pcCurrentLevel->getObjectGroup( rsObjectGroup ) )
-	{
-		return;
-	}
-
-	// Get map's current stage pickups as vector of values
-	ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObjects();
-
-	// Position and reset the pickups of the value's vector
-	m_pcPickupsManager->PositionPickups( rcObjectsVector );
-	m_pcPickupsManager->ResetPickups( rcObjectsVector );
-}
-
-void CLevelManager::ExitPositioning( const std::string& rsObjectGroup )
-{
-	// Get map's current stage exit door as map of values
-	const ValueMap& rcObjectsValues = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObject( "ExitDoor " + m_sCurrentStage );
-
-	CCASSERT( !rcObjectsValues.empty(), "Missing ExitDoor " + *m_sCurrentStage.c_str() );
-
-	// Position is corrected with respect to the map's anchor point which is a the bottom left of the screen
-	float fOffsetCorrectionX = rcObjectsValues.at( "x" ).asFloat() + rcObjectsValues.at( "width" ).asFloat() * 0.5f;
-	float fOffsetCorrectionY = rcObjectsValues.at( "y" ).asFloat() + rcObjectsValues.at( "height" ).asFloat() * 0.5f;
-
-	// Set position of the pickups based on the map's object positioning
-	m_pcExitDoor->setPosition( fOffsetCorrectionX, fOffsetCorrectionY );
-
-	// Add the pickup to the current map if not present already
-	if( !m_bExitDoorExist )
-	{
-		m_pcCurrentLevel->addChild( m_pcExitDoor, 1 );
-		m_bExitDoorExist = true;
-	}
-	// Reset the door to default values
-	m_pcExitDoor->ResetDoor();
-
-}
-
-void CLevelManager::EnemiesPositioning( const std::string& rsObjectGroup )
-{
-	// Get map's current stage enemies as object group
-	TMXObjectGroup* rcObjectGroup = m_pcCurrentLevel->getObjectGroup( rsObjectGroup );
-
-	// There is no object group with this name which means no object of this kind in this stage
-	if( nullptr == rcObjectGroup )
-	{
-		return;
-	}
-
-	ValueVector& rcObjectsVector = rcObjectGroup->getObjects();
-
-	// IF there are enemies in the current stage this vector should NOT be empy
-	CCASSERT( !rcObjectsVector.empty(), *rsObjectGroup.c_str() + " empty" );
-
-	// Do this if loading the "pre-initialisation" stage
-	if( -1 == m_iCurrentStage )
-	{
-		// Initialise all enemies of the enemy vector with the values from the object vector
-		for( CEnemy* pcEnemy : m_pcEnemies )
-		{
-			pcEnemy->Initialise( rcObjectsVector[ 0 ] );
-		}
-	}
-	// Do this for every normal stage
-	else
-	{
-		// Initialise the amount of enemies present in the current stage with the objects vector's values
-		for( unsigned int i = 0; i < rcObjectsVector.size(); i++ )
-		{
-			CEnemy* pcEnemy = m_pcEnemies[ i ];
-			pcEnemy->Initialise( rcObjectsVector[ i ], true );
-		}
-	}
-
-}
-
-void CLevelManager::CheckpointPositioning( const std::string& rsObjectGroup )
-{
-	ValueMap& rcObjectsValues = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObject( "Checkpoint" + m_sCurrentStage );
-
-	// There is no object group with this name which means no object of this kind in this stage
-	if( rcObjectsValues.size() == 0 )
-	{
-		return;
-	}
-
-	CCheckpoint* pcCheckpoint = m_pcCheckpoints[ 0 ];
-	pcCheckpoint->Initialise( rcObjectsValues, m_pcHUD, m_iCurrentStage );
-}
-
-void CLevelManager::PlatformsPositioning( const std::string& rsObjectGroup )
-{
-	// Get map's current stage platforms as object group
-	TMXObjectGroup* rcObjectGroup = m_pcCurrentLevel->getObjectGroup( rsObjectGroup );
-
-	// There is no object group with this name which means no object of this kind in this stage
-	if( nullptr == rcObjectGroup )
-	{
-		return;
-	}
-
-	ValueVector& rcObjectsVector = rcObjectGroup->getObjects();
-
-	// IF there are platforms in the current stage this vector should NOT be empy
-	CCASSERT( !rcObjectsVector.empty(), *rsObjectGroup.c_str() + "empty" );
-
-	// Platform index
-	int iPlatformID = 0;
-	// Number of travellators and crumblings counted until now
-	int iPlatformTravellatorCount = 0;
-	int iPLatformCrumblingCount = 0;
-
-	for( unsigned int i = 0; i < rcObjectsVector.size(); ++i )
-	{
-		iPlatformID = 0;
-
-		const ValueMap& rcObjectValues = rcObjectsVector[ i ].asValueMap();
-
-		// Position is corrected with respect to the map's anchor point which is a the bottom left of the screen
-		float fOffsetCorrectionX = rcObjectValues.at( "x" ).asFloat() + rcObjectValues.at( "width" ).asFloat() * 0.5f;
-		float fOffsetCorrectionY = rcObjectValues.at( "y" ).asFloat() + rcObjectValues.at( "height" ).asFloat() * 0.5f;
-
-		std::string cType = rcObjectValues.at( "type" ).asString();
-
-		// Do this if the current platform type is crumbling
-		if( cType == "Crumbling" )
-		{
-			// Do this if loading the "pre-initialisation" stage
-			if( -1 == m_iCurrentStage )
-			{
-				// Initialise all the crumbling platform in the platforms' vector based on the object values
-				for( unsigned int j = 0; j < Platforms::k_iMaxAmountOfCrumblingPlatforms; j++ )
-				{
-					CPlatformBase* pcPlatform = m_pcPlatforms[ iPlatformID + j ];
-					pcPlatform->Initialise( rcObjectValues );
-				}
-
-			}
-			// Do this for every normal stage
-			else
-			{
-				iPlatformID = +iPLatformCrumblingCount;
-				// Initialise all the crumbling platform in the current stage based on the object values
-				CPlatformBase* pcPlatform = m_pcPlatforms[ iPlatformID ];
-				pcPlatform->Initialise( rcObjectValues );
-
-				iPLatformCrumblingCount++;
-			}
-			continue;
-		}
-
-		// Travellator are stored after crumbling platforms so we skip crumbling indices
-		iPlatformID += Platforms::k_iMaxAmountOfCrumblingPlatforms;
-
-		// Do this if the current platform type is travellator
-		if( cType == "Travellator" )
-		{
-			// Do this if loading the "pre-initialisation" stage
-			if( -1 == m_iCurrentStage )
-			{
-				// Initialise all the travellators in the platforms' vector based on the object values
-				for( unsigned int j = 0; j < Platforms::k_iMaxAmountOfTravellatorsPlatforms; j++ )
-				{
-					// Set position of the pickups based on the map's object positioning
-					CPlatformBase* pcPlatform = m_pcPlatforms[ iPlatformID + j ];
-					pcPlatform->Initialise( rcObjectValues );
-
-				}
-			}
-			// Do this for every normal stage
-			else
-			{
-				iPlatformID += iPlatformTravellatorCount;
-
-				// Initialise all the travellators in the current stage based on the object values
-				CPlatformBase* pcPlatform = m_pcPlatforms[ iPlatformID ];
-				pcPlatform->Initialise( rcObjectValues );
-				// Increase the amount of travellators counted until now
-				iPlatformTravellatorCount++;
-			}
-		}
-	}
-
-	m_iNumOfTravellatorInStage = iPlatformTravellatorCount;
-
-}
-
-void CLevelManager::PortsPositioning( const std::string& rsObjectGroup )
-{
-	// Get map's current stage ports as vector of values
-	ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObjects();
-
-	CCASSERT( !rcObjectsVector.empty(), rsObjectGroup.c_str() );
-	// Crossreference between the amount of pickups and ports within the stage to ensure progression
-	CCASSERT( m_pcPickupsManager->GetActiveAmountOfKeys() == rcObjectsVector.size(),
-		"Chips amount not match port amount in stage" );
-
-	// Do this if loading the "pre-initialisation" stage
-	if( -1 == m_iCurrentStage )
-	{
-		// Initialise all ports of the ports' vector with the values from the object vector
-		for( CPort* pcPort : m_pcPorts )
-		{
-			pcPort->Initialise( rcObjectsVector[ 0 ] );
-		}
-	}
-	// Do this for every normal stage
-	else
-	{
-		// Initialise the amount of ports present in the current stage with the object's vector values
-		for( unsigned int i = 0; i < rcObjectsVector.size(); i++ )
-		{
-			CPort* pcPort = m_pcPorts[ i ];
-			pcPort->Initialise( rcObjectsVector[ i ] );
-		}
-	}
-
-	// Set the amount of ports activatable in the current stage based on the size of the object vector
-	m_pcExitDoor->SetAmountOfPortsInAStage( rcObjectsVector.size() );
-}
-
-void CLevelManager::LoadNewStage( const int iStageNumber )
-{
-	// Set the current stage to the parameter value passed through.
-	m_iCurrentStage = iStageNumber;
-
-	if( m_iCurrentStage == 1 && Audio::k_iAudioEnabled )
-	{
-		cocos2d::AudioEngine::play2d( "/Audio/Alexander Zhelanov-Battle_1.ogg", false, 0.2f );
-	}
-
-	m_sCurrentStage = std::to_string( m_iCurrentStage );
-
-	// Position all platforms of the current stage
-	PlatformsPositioning( "Platforms " + m_sCurrentStage );
-	// Position all pickups of the stage level
-	PickUpPositioning( "Pickups " + m_sCurrentStage );
-	// Position all enemies of the current stage
-	EnemiesPositioning( "Enemies " + m_sCurrentStage );
-	// Position all ports of the current stage
-	PortsPositioning( "Ports " + m_sCurrentStage );
-	// Position all checkpoints of the current stage
-	CheckpointPositioning( "Checkpoints" );
-	// Position the exit door of the current stage
-	ExitPositioning( "ExitDoors" );
-}
-
-void CLevelManager::ResetCurrentStage()
-{
-	// Get the pickups of the current stage and reset them
-	TMXObjectGroup* rcPickupsObjectGroup = m_pcCurrentLevel->getObjectGroup( "Pickups " + m_sCurrentStage );
-	ValueVector& rcPickupsObjectsVector = rcPickupsObjectGroup->getObjects();
-	m_pcPickupsManager->ResetPickups( rcPickupsObjectsVector );
-
-	// Reset the ports of the current stage based on how many chips are in the stage
-	for( int i = 0; i < m_pcPickupsManager->GetActiveAmountOfKeys(); i++ )
-	{
-		CPort* pcPort = m_pcPorts[ i ];
-		pcPort->Reset();
-	}
-
-	// Get the object group of the platfoms in the current stage
-	TMXObjectGroup* rcPlatformsObjectGroup = m_pcCurrentLevel->getObjectGroup( "Platforms " + m_sCurrentStage );
-
-	// If there are platforms in the stage reset them
-	if( nullptr != rcPlatformsObjectGroup )
-	{
-
-		ValueVector& rcPlatformsObjectsVector = rcPlatformsObjectGroup->getObjects();
-
-		int iPlatformID = 0;
-		int iPlatformTravellatorCount = 0;
-		int iPlatformCrumblingCount = 0;
-		// Reset all the specific platforms present in the current stage
-		for( unsigned int i = 0; i < rcPlatformsObjectsVector.size(); ++i )
-		{
-			iPlatformID = 0;
-
-			ValueMap& rcObjectValues = rcPlatformsObjectsVector[ i ].asValueMap();
-
-			if( rcObjectValues[ "type" ].asString() == "Crumbling" )
-			{
-				// Get the correct crumbling platform ID
-				iPlatformID += iPlatformCrumblingCount;
-				CPlatformBase* pPlatform = m_pcPlatforms[ iPlatformID ];
-				// Reset the platform to its original state within the current room
-				pPlatform->Reset();
-				iPlatformCrumblingCount++;
-				continue;
-			}
-
-			//iPlatformID += Platforms::k_iMaxAmountOfCrumblingPlatforms;
-
-			//if( rcObjectValues[ "type" ].asString() == "Travellator" )
-			//{
-			//	iPlatformTravellatorCount++;
-			//	iPlatformID += iPlatformTravellatorCount;
-			//	   Set position of the pickups based on the map's object positioning
-			//	( *m_pcPlatforms )[ iPlaftormID ]->Initialise( rcObjectValues );
-			//}
-
-		}
-	}
-
-
-	// Reset the door to the standard values
-	m_pcExitDoor->ResetDoor();
-}
-
-void CLevelManager::HideSecondaryBackground()
-{
-	// Hide the secondary background if is visible
-	if( m_pcCurrentLevel->getLayer( "Second Background" )->isVisible() == true )
-	{
-		m_pcCurrentLevel->getLayer( "Second Background" )->setVisible( false );
-	}
-	// Make the secondary background visible if it is not
-	else
-	{
-		m_pcCurrentLevel->getLayer( "Second Background" )->setVisible( true );
-	}
-}
-
-std::vector<CPlatformBase*>& CLevelManager::GetPlatforms()	{ return m_pcPlatforms; }
-
-std::vector<CEnemy*>& CLevelManager::GetEnemies()			{ return m_pcEnemies; }
-
-std::vector<CPort*>& CLevelManager::GetPorts()				{ return m_pcPorts; }
-
-std::vector<CCheckpoint*>& CLevelManager::GetCheckpoints()	{ return m_pcCheckpoints; }
-
-FastTMXTiledMap* CLevelManager::GetCurrentLevel() const		{ return m_pcCurrentLevel; }
-
-const int CLevelManager::GetCurrentLevelID() const			{ return m_iCurrentStage; }
-
-void CLevelManager::SetCurrentLevel( const int iLevel )		{ m_iCurrentStage = iLevel; }
-
+#include "LevelManager.h"
+
+#include "AllocationTracker.h"
+#include "DecodedImageCache.h"
+#include "Enemy.h"
+#include "ExitDoor.h"
+#include "PickupsManager.h"
+#include "Settings.h"
+#include "TextureLoader.h"
+#include "TextureManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+#include <CCDirector.h>
+#include <CCEventDispatcher.h>
+#include <cocos/2d/CCFastTMXLayer.h>
+#include <cocos/physics/CCPhysicsWorld.h>
+#include <cocos/platform/CCFileUtils.h>
+
+using cocos2d::FastTMXTiledMap;
+using cocos2d::TMXObjectGroup;
+using cocos2d::TMXMapInfo;
+using cocos2d::PhysicsBody;
+using cocos2d::Vec2;
+using cocos2d::Size;
+using cocos2d::PhysicsShapeBox;
+using cocos2d::Sprite;
+using cocos2d::ValueMap;
+using cocos2d::ValueVector;
+
+// Name of the progress save in the writable path
+static const char* const k_pszSaveFileName = "progress.sav";
+
+// The save records the pickups and the ports as one bit each
+static const unsigned int k_uiProgressMaskBits = sizeof( CSaveSystem::SRecord::uiPlacedPorts ) * 8;
+static_assert( Ports::k_iMaxAmountOfPorts <= static_cast<int>( k_uiProgressMaskBits ), "More ports than the save can record" );
+
+// Tile layers that never change during a stage, drawn through background caches. Layers missing from a map are skipped
+static const char* const k_apszStaticLayers[] = { "Background", "Second Background" };
+
+// Directory of the maps' chunk files in the writable path
+static const char* const k_pszChunkedMapsDirectory = "chunked_maps/";
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: MillisecondsSince()
+// Parameters		: rcStart			- Start of the timed section
+// Returns			: The time passed since the start in milliseconds
+//-----------------------------------------------------------------------------------------------------------------------------
+static float MillisecondsSince( const std::chrono::steady_clock::time_point& rcStart )
+{
+	return std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - rcStart ).count();
+}
+
+// Decode the level's textures on worker threads during initialisation, false to compare with the serial path
+static const bool k_bParallelTextureDecoding = true;
+
+// Keep the decoded pixels of the level's textures for the next launches, false to compare with decoding every time
+static const bool k_bUseDecodedImageCache = true;
+
+// Directory of the decoded image cache in the writable path
+static const char* const k_pszDecodedImagesDirectory = "decoded_images/";
+
+// Platforms simulated by one job, enough work to outweigh the cost of queueing it
+static const int k_iPlatformsPerJob = 16;
+
+// Environment objects turned into shapes by one initialisation step, a few milliseconds of work on a phone
+static const int k_iCollidableObjectsPerStep = 64;
+
+// Textures uploaded by one initialisation step, each upload can take a few milliseconds for a big tileset
+static const int k_iTexturesPerStep = 2;
+
+CLevelManager::CLevelManager()
+	: m_pcCurrentLevel( nullptr )
+	, m_apcEntityLayers()
+	, m_pcColliderContainer( nullptr )
+	, m_pcTextureManager( nullptr )
+	, m_pcContext( nullptr )
+	, m_bOwnsContext( false )
+	, m_pcPickupsManager( nullptr )
+	, m_pcHUD( nullptr )
+	, m_bExitDoorExist( false )
+	, m_iCurrentStage( -1 )
+	, m_aiPlatformsInStage()
+	, m_sSavedProgress()
+	, m_bIsPipelined( false )
+	, m_bIsSimulating( false )
+	, m_fSimulatedDeltaTime( 0.0f )
+	, m_sStats()
+	, m_iNextInitialiseStep( 0 )
+	, m_iInitialiseCursor( 0 )
+	, m_fInitialiseMs( 0.0f )
+	, m_fLongestInitialiseSliceMs( 0.0f )
+	, m_iInitialiseSlices( 0 )
+	, m_pcDecodedImages( nullptr )
+	, m_pcTextureLoader( nullptr )
+{
+	// Convert the current stage ID to a string
+	m_sCurrentStage = std::to_string( m_iCurrentStage );
+	// Create an exit door.
+	m_pcExitDoor = new CExitDoor();
+}
+
+CLevelManager::~CLevelManager()
+{
+	// The simulation thread may still be working on the platforms
+	WaitForSimulation();
+
+	// Report the input latency of the session
+	m_cInputLatency.Log();
+
+	// Cycle over all the platforms' vector and safe destroy them
+	for( CPlatformBase* pcPlatform : m_cPlatforms.GetMembers() )
+	{
+		pcPlatform->removeFromParent();
+		CC_SAFE_DELETE( pcPlatform );
+	}
+
+	// Cycle over all the enemies' vector and safe destroy them
+	for( CEnemy* pcEnemy : m_cEnemies.GetMembers() )
+	{
+		pcEnemy->removeFromParent();
+		CC_SAFE_DELETE( pcEnemy );
+	}
+
+	// Removing pickups from map, a level left during its initialisation may not have added them yet
+	if( nullptr != m_apcEntityLayers[ Pickups ] )
+	{
+		for( auto pickup : m_pcPickupsManager->GetPickups() )
+		{
+			m_apcEntityLayers[ Pickups ]->removeChild( pickup );
+		}
+	}
+
+	// Cycle over all the ports' vector and safe destroy them
+	for( CPort* pcPort : m_cPorts.GetMembers() )
+	{
+		pcPort->removeFromParent();
+		CC_SAFE_DELETE( pcPort );
+	}
+
+	for( CCheckpoint* pcCheckpoint : m_cCheckpoints.GetMembers() )
+	{
+		pcCheckpoint->removeFromParent();
+		CC_SAFE_DELETE( pcCheckpoint );
+	}
+
+	if( nullptr != m_apcEntityLayers[ Doors ] )
+	{
+		m_apcEntityLayers[ Doors ]->removeChild( m_pcExitDoor );
+	}
+	CC_SAFE_DELETE( m_pcExitDoor );
+
+	// A level left while loading its textures stops the decoding
+	CC_SAFE_DELETE( m_pcTextureLoader );
+	CC_SAFE_DELETE( m_pcDecodedImages );
+
+	if( m_bOwnsContext )
+	{
+		CC_SAFE_DELETE( m_pcContext );
+	}
+
+}
+
+void CLevelManager::Initialise( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD,
+	CLevelContext* pcContext, const std::string& rsMapFile )
+{
+	BeginInitialise( pcTextureManager, pcPickupsManager, pcHUD, pcContext, rsMapFile );
+
+	while( !ContinueInitialise( std::numeric_limits<float>::infinity() ) )
+	{
+	}
+}
+
+void CLevelManager::BeginInitialise( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD,
+	CLevelContext* pcContext, const std::string& rsMapFile )
+{
+	CCASSERT( m_asInitialiseSteps.empty() && nullptr == m_pcCurrentLevel, "Level initialised twice" );
+
+	m_pcHUD = pcHUD;
+	m_sMapFile = rsMapFile;
+
+	// Without a given context the level runs on the Director's systems, like the game does
+	m_bOwnsContext = ( nullptr == pcContext );
+	m_pcContext = m_bOwnsContext ? CLevelContext::CreateShared() : pcContext;
+
+	CCASSERT( nullptr != pcTextureManager, "Texture Manager is null" );
+	// Setting the texture manager in order to pass it to others classes
+	m_pcTextureManager = pcTextureManager;
+
+	CCASSERT( nullptr != pcPickupsManager, "Pickups Manager is null" );
+	// Setting the pickups manager in order to retrieve the pickups vector
+	m_pcPickupsManager = pcPickupsManager;
+
+	// Gathered every frame, sized once for the whole pool
+	m_apcUpdatedPlatforms.reserve( EntityRegistry::k_iPlatformPoolSize );
+
+	m_iNextInitialiseStep = 0;
+	m_iInitialiseCursor = 0;
+	m_fInitialiseMs = 0.0f;
+	m_fLongestInitialiseSliceMs = 0.0f;
+	m_iInitialiseSlices = 0;
+
+	// A level simulated next to the game's would overwrite its progress, only the game's level saves
+	if( !m_pcContext->IsIsolated() )
+	{
+		m_cSaveSystem.Start( cocos2d::FileUtils::getInstance()->getWritablePath() + k_pszSaveFileName );
+	}
+
+	// Decode the textures requested below before the map and the entities are created, so that they are only
+	// uploaded on this thread. Levels simulated without rendering have no texture cache and skip it
+	if( nullptr != m_pcContext->GetTextureCache() )
+	{
+		AddInitialiseStep( "Loading textures", [this]()
+		{
+			// The first slice starts the decoding, every slice uploads a few of the textures decoded meanwhile
+			if( nullptr == m_pcTextureLoader )
+			{
+				m_pcDecodedImages = new CDecodedImageCache( cocos2d::FileUtils::getInstance()->getWritablePath()
+					+ k_pszDecodedImagesDirectory );
+				m_pcTextureLoader = new CTextureLoader( m_pcContext->GetTextureCache(),
+					k_bUseDecodedImageCache ? m_pcDecodedImages : nullptr );
+				m_pcTextureLoader->AddTilesets( m_sMapFile );
+				// Loading bar of the ports
+				m_pcTextureLoader->AddFile( "MP_Meter2.png" );
+				m_pcTextureLoader->BeginLoad( k_bParallelTextureDecoding );
+			}
+
+			if( !m_pcTextureLoader->ContinueLoad( k_iTexturesPerStep ) )
+			{
+				return false;
+			}
+
+			CC_SAFE_DELETE( m_pcTextureLoader );
+			CC_SAFE_DELETE( m_pcDecodedImages );
+			return true;
+		} );
+	}
+
+	AddInitialiseStep( "Loading map", [this]()
+	{
+		LoadAllMaps();
+
+		// Trigger volumes are bucketed in cells of a few tiles over the whole map
+		const cocos2d::Size& rcTileSize = m_pcCurrentLevel->getTileSize();
+		const cocos2d::Size& rcMapSize = m_pcCurrentLevel->getMapSize();
+		m_cTriggerGrid.Initialise( cocos2d::Rect( 0.0f, 0.0f, rcMapSize.width * rcTileSize.width, rcMapSize.height * rcTileSize.height ),
+			rcTileSize.width * 4.0f );
+
+		// The environment is baked in the bitmap along with its physics shapes
+		m_cCollisionBitmap.Initialise( static_cast<int>( rcMapSize.width ), static_cast<int>( rcMapSize.height ), rcTileSize );
+
+		// Active pooled entities are attached to the entity layers of the current map
+		m_cPlatforms.SetParent( m_apcEntityLayers[ Platforms ] );
+		m_cPorts.SetParent( m_apcEntityLayers[ Ports ] );
+		m_cEnemies.SetParent( m_apcEntityLayers[ Enemies ] );
+		m_cCheckpoints.SetParent( m_apcEntityLayers[ Checkpoints ] );
+		return true;
+	} );
+
+	// Creating all platforms of all types registered in the entity registry
+	for( const EntityRegistry::SPlatformType& rsType : EntityRegistry::k_asPlatformTypes )
+	{
+		AddInitialiseStep( "Creating platforms", [this, &rsType]()
+		{
+			CreatePlatforms( rsType );
+			return true;
+		} );
+	}
+
+	AddInitialiseStep( "Creating ports", [this]()
+	{
+		// Creating all ports based on the settings values
+		TCreateEntities<CPort>( m_cPorts, Ports::k_iMaxAmountOfPorts, *m_pcTextureManager );
+		// Ports play their sounds through the level's audio service and are animated by the level's animator
+		for( CPort* pcPort : m_cPorts.GetMembers() )
+		{
+			pcPort->SetAudioService( &m_pcContext->GetAudio() );
+			pcPort->SetAnimator( &m_cSpriteAnimator );
+		}
+		return true;
+	} );
+
+	AddInitialiseStep( "Creating enemies", [this]()
+	{
+		// Creating all enemies based on the settings values
+		TCreateEntities<CEnemy>( m_cEnemies, Enemies::k_iMaxAmountOfEnemies, *m_pcTextureManager );
+
+		TCreateEntities<CCheckpoint>( m_cCheckpoints, 1, *m_pcTextureManager );
+		return true;
+	} );
+
+	AddInitialiseStep( "Building colliders", [this]()
+	{
+		// Create a collider for the map with no shape and all values set to 0
+		CreateColliderContainer();
+		return true;
+	} );
+
+	// Create physics shapes for all map static objects and add them to the map's collider, a slice of each group at a time
+	for( const EntityRegistry::SEnvironmentGroup& rsGroup : EntityRegistry::k_asEnvironmentGroups )
+	{
+		AddInitialiseStep( "Building colliders", [this, &rsGroup]()
+		{
+			const bool bIsDone = CreateCollidableObjects( rsGroup, m_iInitialiseCursor, k_iCollidableObjectsPerStep );
+			m_iInitialiseCursor = bIsDone ? 0 : m_iInitialiseCursor + k_iCollidableObjectsPerStep;
+			return bIsDone;
+		} );
+	}
+
+	AddInitialiseStep( "Building navigation", [this]()
+	{
+		// Build the enemies' navigation graph from the environment baked above
+		m_cNavigationGraph.Bake( m_cCollisionBitmap );
+		return true;
+	} );
+
+	AddInitialiseStep( "Placing pickups", [this]()
+	{
+		// Initialise the exit door, moved to the level's context before it registers its listeners
+		m_pcContext->ApplyTo( m_pcExitDoor );
+		m_pcExitDoor->Initialise( m_pcTextureManager );
+
+		// Adding all pickups to the map
+		for( auto pickup : m_pcPickupsManager->GetPickups() )
+		{
+			m_pcContext->ApplyTo( pickup );
+			m_apcEntityLayers[ Pickups ]->addChild( pickup );
+		}
+
+		// Frames drawn by the Director end the latency of the inputs they show, isolated levels are presented by their owner
+		if( !m_pcContext->IsIsolated() )
+		{
+			m_cInputLatency.Attach( m_pcContext->GetEventDispatcher() );
+		}
+
+#if COCOS2D_DEBUG > 0
+		// Count the contact callbacks of every pair of categories, logged through GetContactStats()
+		m_cContactStats.Attach( m_pcCurrentLevel->getEventDispatcher() );
+#endif
+		return true;
+	} );
+
+	AddInitialiseStep( "Preparing stage", [this]()
+	{
+		// Loading a special stage, this call is used to properly initialise all objects which can be
+		// placed in a stage. Their physics collider is set and cannot be reshaped from this point.
+		// No entity is claimed by this stage so all pools are left inactive
+		LoadNewStage( -1 );
+		return true;
+	} );
+}
+
+bool CLevelManager::ContinueInitialise( const float fBudgetMs )
+{
+	if( m_asInitialiseSteps.empty() )
+	{
+		return true;
+	}
+
+	// Building the level allocates, the frames of the loading screen are not checked
+	AllocationTracker::CAllowScope cAllowAllocations;
+
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	// Always make progress, even if the previous frame used up the budget
+	do
+	{
+		if( m_asInitialiseSteps[ m_iNextInitialiseStep ].fnRun() )
+		{
+			m_iNextInitialiseStep++;
+		}
+	}
+	while( m_iNextInitialiseStep < static_cast<int>( m_asInitialiseSteps.size() ) && MillisecondsSince( cStart ) < fBudgetMs );
+
+	const float fSliceMs = MillisecondsSince( cStart );
+	m_fInitialiseMs += fSliceMs;
+	m_fLongestInitialiseSliceMs = std::max( m_fLongestInitialiseSliceMs, fSliceMs );
+	m_iInitialiseSlices++;
+
+	if( m_iNextInitialiseStep < static_cast<int>( m_asInitialiseSteps.size() ) )
+	{
+		return false;
+	}
+
+	m_asInitialiseSteps.clear();
+
+	CCLOG( "Level initialised in %.2f ms over %d frames, longest frame %.2f ms, parallel texture decoding %s",
+		m_fInitialiseMs, m_iInitialiseSlices, m_fLongestInitialiseSliceMs, k_bParallelTextureDecoding ? "on" : "off" );
+
+	return true;
+}
+
+void CLevelManager::AddInitialiseStep( const char* pszName, const std::function<bool()>& fnRun )
+{
+	SInitialiseStep sStep;
+	sStep.pszName = pszName;
+	sStep.fnRun = fnRun;
+
+	m_asInitialiseSteps.push_back( sStep );
+}
+
+float CLevelManager::GetInitialiseProgress() const
+{
+	if( m_asInitialiseSteps.empty() )
+	{
+		return ( nullptr != m_pcCurrentLevel ) ? 1.0f : 0.0f;
+	}
+
+	return static_cast<float>( m_iNextInitialiseStep ) / m_asInitialiseSteps.size();
+}
+
+const char* CLevelManager::GetInitialiseStepName() const
+{
+	return m_asInitialiseSteps.empty() ? "" : m_asInitialiseSteps[ m_iNextInitialiseStep ].pszName;
+}
+
+float CLevelManager::GetLongestInitialiseSliceMs() const	{ return m_fLongestInitialiseSliceMs; }
+
+void CLevelManager::Update( float fDeltaTime )
+{
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	m_cContactStats.Tick();
+
+	// The inputs received until now are used by this update
+	m_cInputLatency.OnSimulationTick( cStart );
+
+	float fPlatformsDeltaTime = fDeltaTime;
+
+	if( m_bIsPipelined )
+	{
+		// The platforms and the animations have been simulated while the last frame rendered
+		WaitForSimulation();
+		fPlatformsDeltaTime = m_fSimulatedDeltaTime;
+	}
+	else
+	{
+		GatherUpdatedPlatforms();
+		SimulatePlatforms( fDeltaTime );
+	}
+
+	// Apply the results on the main thread, the only one allowed to touch the scene and the physics world
+	// Call the update of the exit door
+	m_pcExitDoor->VUpdate( fDeltaTime );
+	// Call the update of the pickups manager
+	m_pcPickupsManager->VUpdate( fDeltaTime );
+	// Fill the loading bars of the stage's ports
+	for( int i = 0; i < m_cPorts.GetSize(); i++ )
+	{
+		if( m_cPorts.IsActive( i ) )
+		{
+			m_cPorts[ i ]->VUpdate( fDeltaTime );
+		}
+	}
+
+	// Pickups are collected by the player's contacts and ports placed by the triggers, both are saved as soon as they are seen
+	if( m_cSaveSystem.IsStarted() && m_iCurrentStage >= 0 )
+	{
+		CSaveSystem::SRecord sProgress;
+		GetProgress( sProgress );
+
+		if( sProgress.uiCollectedPickups != m_sSavedProgress.uiCollectedPickups
+			|| sProgress.uiPlacedPorts != m_sSavedProgress.uiPlacedPorts )
+		{
+			SaveProgress();
+		}
+	}
+
+	for( CPlatformBase* pcPlatform : m_apcUpdatedPlatforms )
+	{
+		pcPlatform->VUpdate( fPlatformsDeltaTime );
+	}
+
+	// Consumed, SetPipelined() must not apply the same simulation again
+	m_apcUpdatedPlatforms.clear();
+
+	// Show the animation frames that changed since the last frame
+	if( !m_bIsPipelined )
+	{
+		m_cSpriteAnimator.Step( fDeltaTime );
+	}
+
+	m_sStats.iFrameChanges = m_cSpriteAnimator.GetLastChanges();
+	m_sStats.fUpdateMs = MillisecondsSince( cStart );
+}
+
+void CLevelManager::BeginSimulation( float fDeltaTime )
+{
+	if( !m_bIsPipelined )
+	{
+		return;
+	}
+
+	// Update() normally waited already, a frame without it must not gather the platforms under a running simulation
+	WaitForSimulation();
+
+	GatherUpdatedPlatforms();
+	m_fSimulatedDeltaTime = fDeltaTime;
+
+	// The frames written by the last simulation and by this frame's update are shown by this frame, the simulation
+	// writes the next ones in the other buffer meanwhile
+	m_cRenderState.Publish();
+
+	m_cSimulationThread.Start( [this]()
+		{
+			SimulatePlatforms( m_fSimulatedDeltaTime );
+			m_cSpriteAnimator.Step( m_fSimulatedDeltaTime );
+		} );
+	m_bIsSimulating = true;
+
+	// cocos2d-x renders on this thread, the nodes are only changed here
+	m_cRenderState.Apply();
+}
+
+void CLevelManager::SetPipelined( const bool bIsPipelined )
+{
+	if( bIsPipelined == m_bIsPipelined )
+	{
+		return;
+	}
+
+	WaitForSimulation();
+
+	if( m_bIsPipelined )
+	{
+		// Finish the frame in flight as the next Update() will simulate again in place, the list is empty if Update()
+		// already applied it
+		for( CPlatformBase* pcPlatform : m_apcUpdatedPlatforms )
+		{
+			pcPlatform->VUpdate( m_fSimulatedDeltaTime );
+		}
+
+		m_cRenderState.Publish();
+		m_cRenderState.Apply();
+	}
+
+	m_apcUpdatedPlatforms.clear();
+	m_cSpriteAnimator.SetRenderState( bIsPipelined ? &m_cRenderState : nullptr );
+	m_bIsPipelined = bIsPipelined;
+}
+
+bool CLevelManager::IsPipelined() const	{ return m_bIsPipelined; }
+
+void CLevelManager::GatherUpdatedPlatforms()
+{
+	// Gather all the platforms in the current stage whose type needs an update
+	m_apcUpdatedPlatforms.clear();
+
+	for( int iType = 0; iType < EntityRegistry::k_iNumOfPlatformTypes; iType++ )
+	{
+		const EntityRegistry::SPlatformType& rsType = EntityRegistry::k_asPlatformTypes[ iType ];
+
+		if( rsType.bUpdatedEveryFrame )
+		{
+			for( int i = 0; i < m_aiPlatformsInStage[ iType ]; i++ )
+			{
+				m_apcUpdatedPlatforms.push_back( m_cPlatforms[ rsType.iPoolOffset + i ] );
+			}
+		}
+	}
+}
+
+void CLevelManager::SimulatePlatforms( const float fDeltaTime )
+{
+	// Simulate the platforms in parallel, each one only works on its own state
+	m_cJobSystem.AddParallelFor( static_cast<int>( m_apcUpdatedPlatforms.size() ), k_iPlatformsPerJob,
+		[this, fDeltaTime]( int iBegin, int iEnd )
+		{
+			for( int i = iBegin; i < iEnd; i++ )
+			{
+				m_apcUpdatedPlatforms[ i ]->VSimulate( fDeltaTime );
+			}
+		} );
+
+	m_cJobSystem.Run();
+}
+
+void CLevelManager::WaitForSimulation()
+{
+	// Waited for once, the later calls of the frame keep its timings
+	if( !m_bIsSimulating )
+	{
+		return;
+	}
+
+	m_sStats.fSimulationWaitMs = m_cSimulationThread.Wait();
+	m_sStats.fSimulationMs = m_cSimulationThread.GetLastFrameMs();
+	m_bIsSimulating = false;
+}
+
+void CLevelManager::UpdateEnemies( const cocos2d::Rect& rcView, float fDeltaTime )
+{
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	m_cEnemyTiers.BeginFrame( rcView );
+
+	for( int i = 0; i < m_cEnemies.GetSize(); i++ )
+	{
+		if( m_cEnemies.IsActive( i ) )
+		{
+			const float fEnemyDeltaTime = m_cEnemyTiers.Schedule( i, m_cEnemies[ i ], fDeltaTime );
+
+			if( fEnemyDeltaTime > 0.0f )
+			{
+				m_cEnemies[ i ]->VUpdate( fEnemyDeltaTime );
+			}
+		}
+	}
+
+	m_sStats.fEnemiesMs = MillisecondsSince( cStart );
+}
+
+void CLevelManager::LoadAllMaps()
+{
+	// Create a map from the level's Tiled map
+	m_pcCurrentLevel = cocos2d::FastTMXTiledMap::create( m_sMapFile );
+
+	CCASSERT( nullptr != m_pcCurrentLevel, "No level loaded" );
+
+	OpenChunkedMap();
+
+	// The caches take the place of their layers before the entity layers are added on top
+	CreateBackgroundCaches();
+	CreateEntityLayers();
+
+	// The map and its layers use the level's systems
+	m_pcContext->ApplyTo( m_pcCurrentLevel );
+
+}
+
+void CLevelManager::OpenChunkedMap()
+{
+	cocos2d::FileUtils* pcFileUtils = cocos2d::FileUtils::getInstance();
+	const cocos2d::Data cMapData = pcFileUtils->getDataFromFile( m_sMapFile );
+
+	if( cMapData.isNull() )
+	{
+		return;
+	}
+
+	// Named after the map's content like the decoded images, so an edited map is baked again
+	char szName[ 32 ];
+	snprintf( szName, sizeof( szName ), "%016" PRIx64 ".chunks",
+		CDecodedImageCache::HashContent( cMapData.getBytes(), static_cast<size_t>( cMapData.getSize() ) ) );
+
+	const std::string sDirectory = pcFileUtils->getWritablePath() + k_pszChunkedMapsDirectory;
+	const std::string sChunkFile = sDirectory + szName;
+
+	if( !pcFileUtils->isDirectoryExist( sDirectory ) )
+	{
+		pcFileUtils->createDirectory( sDirectory );
+	}
+
+	// Levels simulated without rendering only keep the chunks' data
+	cocos2d::Node* pcParent = ( nullptr != m_pcContext->GetTextureCache() ) ? m_pcCurrentLevel : nullptr;
+	const std::vector<std::string> asKeptLayers( std::begin( k_apszStaticLayers ), std::end( k_apszStaticLayers ) );
+
+	if( !m_cChunkedMap.Open( sChunkFile, pcParent, asKeptLayers )
+		&& !( CChunkedMap::Bake( m_sMapFile, sChunkFile ) && m_cChunkedMap.Open( sChunkFile, pcParent, asKeptLayers ) ) )
+	{
+		CCLOG( "Chunked map: cannot bake %s, its tile layers stay whole", m_sMapFile.c_str() );
+		return;
+	}
+
+	// The resident chunks draw the other layers from the first stage on, the map's own copies are freed
+	std::vector<cocos2d::Node*> apcStreamedLayers;
+
+	for( cocos2d::Node* pcChild : m_pcCurrentLevel->getChildren() )
+	{
+		cocos2d::FastTMXLayer* pcLayer = dynamic_cast<cocos2d::FastTMXLayer*>( pcChild );
+
+		if( nullptr != pcLayer && m_cChunkedMap.IsLayerStreamed( pcLayer->getLayerName() ) )
+		{
+			apcStreamedLayers.push_back( pcChild );
+		}
+	}
+
+	for( cocos2d::Node* pcLayer : apcStreamedLayers )
+	{
+		m_pcCurrentLevel->removeChild( pcLayer );
+	}
+}
+
+void CLevelManager::CreateBackgroundCaches()
+{
+	// Levels simulated without rendering draw nothing to cache
+	if( nullptr == m_pcContext->GetTextureCache() )
+	{
+		return;
+	}
+
+	for( const char* pszLayerName : k_apszStaticLayers )
+	{
+		cocos2d::FastTMXLayer* pcLayer = m_pcCurrentLevel->getLayer( pszLayerName );
+
+		if( nullptr != pcLayer )
+		{
+			// Same z order as the layer and added after it, so the cache is drawn where the layer was
+			CBackgroundCache* pcCache = CBackgroundCache::create( pcLayer, m_pcContext );
+			m_pcCurrentLevel->addChild( pcCache, pcLayer->getLocalZOrder() );
+			m_apcBackgroundCaches.push_back( pcCache );
+		}
+	}
+}
+
+cocos2d::Rect CLevelManager::GetStageBounds() const
+{
+	cocos2d::Rect cBounds;
+	bool bIsEmpty = true;
+
+	const auto MergeObject = [&cBounds, &bIsEmpty]( const ValueMap& rcObjectValues )
+	{
+		const cocos2d::Rect cObject( rcObjectValues.at( "x" ).asFloat(), rcObjectValues.at( "y" ).asFloat(),
+			rcObjectValues.at( "width" ).asFloat(), rcObjectValues.at( "height" ).asFloat() );
+
+		cBounds = bIsEmpty ? cObject : cBounds.unionWithRect( cObject );
+		bIsEmpty = false;
+	};
+
+	for( const char* pszGroup : { "Platforms ", "Pickups ", "Enemies ", "Ports " } )
+	{
+		TMXObjectGroup* pcObjectGroup = m_pcCurrentLevel->getObjectGroup( pszGroup + m_sCurrentStage );
+
+		if( nullptr != pcObjectGroup )
+		{
+			for( const cocos2d::Value& rcObject : pcObjectGroup->getObjects() )
+			{
+				MergeObject( rcObject.asValueMap() );
+			}
+		}
+	}
+
+	TMXObjectGroup* pcExitDoors = m_pcCurrentLevel->getObjectGroup( "ExitDoors" );
+
+	if( nullptr != pcExitDoors )
+	{
+		const ValueMap& rcExitDoor = pcExitDoors->getObject( "ExitDoor " + m_sCurrentStage );
+
+		if( !rcExitDoor.empty() )
+		{
+			MergeObject( rcExitDoor );
+		}
+	}
+
+	if( bIsEmpty )
+	{
+		return cocos2d::Rect::ZERO;
+	}
+
+	// Half a screen, in the map's coordinates, on every side of the stage's objects
+	const Size cVisibleSize = m_pcContext->GetVisibleRect().size;
+	const float fMarginX = cVisibleSize.width * 0.5f / m_pcCurrentLevel->getScaleX();
+	const float fMarginY = cVisibleSize.height * 0.5f / m_pcCurrentLevel->getScaleY();
+
+	// The camera never shows past the map, so the margin is cut to the map's bounds
+	const Size& rcMapSize = m_pcCurrentLevel->getContentSize();
+	const float fMinX = std::max( cBounds.getMinX() - fMarginX, 0.0f );
+	const float fMinY = std::max( cBounds.getMinY() - fMarginY, 0.0f );
+	const float fMaxX = std::min( cBounds.getMaxX() + fMarginX, rcMapSize.width );
+	const float fMaxY = std::min( cBounds.getMaxY() + fMarginY, rcMapSize.height );
+
+	if( fMinX >= fMaxX || fMinY >= fMaxY )
+	{
+		return cocos2d::Rect::ZERO;
+	}
+
+	return cocos2d::Rect( fMinX, fMinY, fMaxX - fMinX, fMaxY - fMinY );
+}
+
+void CLevelManager::CreateEntityLayers()
+{
+	// The map gives its tile layers their index as z order, the pools used to attach the stage's entities at 0 and the
+	// pickups and the exit door at 1. Keeping these z orders draws the entities between the same tile layers as before
+	static const int k_aiZOrders[ NumOfEntityLayers ] = { 0, 0, 0, 0, 1, 1 };
+
+	for( int i = 0; i < NumOfEntityLayers; i++ )
+	{
+		m_apcEntityLayers[ i ] = CEntityLayer::create();
+		m_pcCurrentLevel->addChild( m_apcEntityLayers[ i ], k_aiZOrders[ i ] );
+	}
+}
+
+void CLevelManager::CreateColliderContainer()
+{
+
+	if( m_pcColliderContainer == nullptr )
+	{
+		// Create a physics body for the map and add it to the map
+		m_pcColliderContainer = PhysicsBody::create();
+		m_pcCurrentLevel->addComponent( m_pcColliderContainer );
+	}
+	else
+	{
+		// If the map has already a physics body then clean previous added shapes
+		// in preparation to the new level initialisation, keeping them for the new level's objects
+		m_cShapePool.ReleaseShapes( m_pcColliderContainer );
+	}
+
+	// This collider will only contains walls so we don't need dynamic physics properties activated
+	m_pcColliderContainer->setMass( 0.0f );
+	m_pcColliderContainer->setMoment( 0.0f );
+	m_pcColliderContainer->setDynamic( false );
+
+#pragma region Collider Positioning Example
+	// Collider position correction
+
+	//-------------------------------------------	By default cocos2d position the collider at the
+	//|											|	center of the screen as show by X.
+	//|											|	Tilemap is rendered from the bottom left corner
+	//|											|	of the screen.
+	//|					  X						|	
+	//|											|	
+	//|											|	
+	//|											|
+	//-------------------------------------------
+
+	//-------------------------------------------	To fix this problem the collider needs to be
+	//|											|	shifted back of half the map's width and height.
+	//|											|	
+	//|											|	This offset is calculated multiplying map's
+	//|					  						|	current dimensions in tiles by the tile's
+	//|											|	dimensions and factoring the content scale   
+	//|											|	factor derived from the design resolution
+	//|											|	The result is shown as the new position of X
+	//X------------------------------------------
+#pragma endregion
+
+	float fColliderOffsetX = -m_pcCurrentLevel->getMapSize().width * m_pcCurrentLevel->getTileSize().width *
+		0.5f * m_pcCurrentLevel->getScaleX();
+	float fColliderOffsetY = -m_pcCurrentLevel->getMapSize().height * m_pcCurrentLevel->getTileSize().height *
+		0.5f * m_pcCurrentLevel->getScaleY();
+	m_pcColliderContainer->setPositionOffset( Vec2( fColliderOffsetX, fColliderOffsetY ) /
+		m_pcContext->GetContentScaleFactor() );
+
+	// Set a name for the map collider which is used in the collision manager
+	m_pcColliderContainer->setName( "Environment" );
+}
+
+void CLevelManager::CreatePlatforms( const EntityRegistry::SPlatformType& rsType )
+{
+	CCASSERT( m_cPlatforms.GetSize() == rsType.iPoolOffset, "Platform types created out of registry order" );
+
+	for( int i = 0; i < rsType.iPoolSize; i++ )
+	{
+		// The ID of the platform is its index in the platforms' pool, used for collision management
+		int iID = m_cPlatforms.GetSize();
+		// Create the platform, move it to the level's context, store it and add it to the current map
+		CPlatformBase* pcPlatform = rsType.pfnCreate( *m_pcTextureManager, iID );
+		m_pcContext->ApplyTo( pcPlatform );
+		m_cPlatforms.Add( pcPlatform );
+		m_cPlatforms[ iID ]->SetCollisionCategory( rsType.eCategory );
+	}
+}
+
+bool CLevelManager::CreateCollidableObjects( const EntityRegistry::SEnvironmentGroup& rsGroup, const int iFirstObject,
+	const int iMaxObjects )
+{
+	// Get map rcObjects and make them collidable walls
+	ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rsGroup.pszGroupName )->getObjects();
+
+	CCASSERT( !rcObjectsVector.empty(), rsGroup.pszGroupName );
+
+	const int iEndObject = std::min( static_cast<int>( rcObjectsVector.size() ), iFirstObject + iMaxObjects );
+
+	// Adding shapes to the map collider based on the Tilemap group object and 
+	// adjusting position with respect to the map's physics body
+	for( int i = iFirstObject; i < iEndObject; i++ )
+	{
+		ValueMap& rcObjectValues = rcObjectsVector[ i ].asValueMap();
+
+		Size cShapeDimensions = Size( rcObjectValues[ "width" ].asFloat(), rcObjectValues[ "height" ].asFloat() );
+
+		// Similarly to the map's collider position correction here another coordinate correction is required
+		// but in this case the original point has to be shifted forward instead of back
+		float fOffsetCorrectionX = rcObjectValues[ "x" ].asFloat() + rcObjectValues[ "width" ].asFloat() * 0.5f;
+		float fOffsetCorrectionY = rcObjectValues[ "y" ].asFloat() + rcObjectValues[ "height" ].asFloat() * 0.5f;
+
+		// Take a collider shape for a single wall from the pool and add it to map's collider
+		PhysicsShapeBox* pCBox = m_cShapePool.AcquireBox( cShapeDimensions, cocos2d::PhysicsMaterial( 1.0f, 0.0f, 1.0f ),
+			Vec2( fOffsetCorrectionX, fOffsetCorrectionY ) );
+		m_pcColliderContainer->addShape( pCBox, false );
+
+		// Set tag to identify obstacles from walls
+		pCBox->setTag( rsGroup.iTag );
+
+		// Set shape to collide and trigger only with the categories declared in the collision matrix
+		CollisionMatrix::ApplyFilter( pCBox, EntityRegistry::k_eEnvironmentCategory );
+
+		// Count the shape in the statistics the physics world is tuned with
+		m_sEnvironmentShapes.AddBox( cShapeDimensions );
+
+		// Bake the object in the group's layer of the collision bitmap
+		m_cCollisionBitmap.AddBox( cocos2d::Rect( rcObjectValues[ "x" ].asFloat(), rcObjectValues[ "y" ].asFloat(),
+			cShapeDimensions.width, cShapeDimensions.height ), rsGroup.uiBitmapLayer );
+	}
+
+	return iEndObject >= static_cast<int>( rcObjectsVector.size() );
+}
+
+void CLevelManager::PickUpPositioning( const std::string& rsObjectGroup )
+{
+	// There is no object group with this name which means no object of this kind in this stage
+	if( nullptr == m_pcCurrentLevel->getObjectGroup( rsObjectGroup ) )
+	{
+		return;
+	}
+
+	// Get map's current stage pickups as vector of values
+	ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObjects();
+
+	// Position and reset the pickups of the value's vector
+	m_pcPickupsManager->PositionPickups( rcObjectsVector );
+	m_pcPickupsManager->ResetPickups( rcObjectsVector );
+}
+
+void CLevelManager::ExitPositioning( const std::string& rsObjectGroup )
+{
+	// Get map's current stage exit door as map of values
+	const ValueMap& rcObjectsValues = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObject( "ExitDoor " + m_sCurrentStage );
+
+	CCASSERT( !rcObjectsValues.empty(), "Missing ExitDoor " + *m_sCurrentStage.c_str() );
+
+	// Position is corrected with respect to the map's anchor point which is a the bottom left of the screen
+	float fOffsetCorrectionX = rcObjectsValues.at( "x" ).asFloat() + rcObjectsValues.at( "width" ).asFloat() * 0.5f;
+	float fOffsetCorrectionY = rcObjectsValues.at( "y" ).asFloat() + rcObjectsValues.at( "height" ).asFloat() * 0.5f;
+
+	// Set position of the pickups based on the map's object positioning
+	m_pcExitDoor->setPosition( fOffsetCorrectionX, fOffsetCorrectionY );
+
+	// Add the pickup to the current map if not present already
+	if( !m_bExitDoorExist )
+	{
+		m_apcEntityLayers[ Doors ]->addChild( m_pcExitDoor );
+		m_bExitDoorExist = true;
+	}
+	// Reset the door to default values
+	m_pcExitDoor->ResetDoor();
+
+}
+
+void CLevelManager::EnemiesPositioning( const std::string& rsObjectGroup )
+{
+	// Get map's current stage enemies as object group
+	TMXObjectGroup* rcObjectGroup = m_pcCurrentLevel->getObjectGroup( rsObjectGroup );
+
+	// There is no object group with this name which means no object of this kind in this stage
+	if( nullptr == rcObjectGroup )
+	{
+		return;
+	}
+
+	ValueVector& rcObjectsVector = rcObjectGroup->getObjects();
+
+	// IF there are enemies in the current stage this vector should NOT be empy
+	CCASSERT( !rcObjectsVector.empty(), *rsObjectGroup.c_str() + " empty" );
+
+	// Do this if loading the "pre-initialisation" stage
+	if( -1 == m_iCurrentStage )
+	{
+		// Initialise all enemies of the enemy vector with the values from the object vector
+		for( CEnemy* pcEnemy : m_cEnemies.GetMembers() )
+		{
+			pcEnemy->Initialise( rcObjectsVector[ 0 ] );
+		}
+	}
+	// Do this for every normal stage
+	else
+	{
+		// Initialise the amount of enemies present in the current stage with the objects vector's values
+		for( unsigned int i = 0; i < rcObjectsVector.size(); i++ )
+		{
+			CEnemy* pcEnemy = m_cEnemies.Claim( i );
+			pcEnemy->Initialise( rcObjectsVector[ i ], true );
+		}
+	}
+
+}
+
+void CLevelManager::CheckpointPositioning( const std::string& rsObjectGroup )
+{
+	ValueMap& rcObjectsValues = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObject( "Checkpoint" + m_sCurrentStage );
+
+	// There is no object group with this name which means no object of this kind in this stage
+	if( rcObjectsValues.size() == 0 )
+	{
+		return;
+	}
+
+	CCheckpoint* pcCheckpoint = m_cCheckpoints.Claim( 0 );
+	pcCheckpoint->Initialise( rcObjectsValues, m_pcHUD, m_iCurrentStage );
+
+	// Reaching the checkpoint saves the progress made since the start of the stage
+	m_cTriggerGrid.AddTrigger( pcCheckpoint->getBoundingBox(), [this]( const CTriggerGrid::EEvent eEvent, const float )
+	{
+		if( CTriggerGrid::EEvent::Enter == eEvent )
+		{
+			SaveProgress();
+		}
+	} );
+}
+
+void CLevelManager::PlatformsPositioning( const std::string& rsObjectGroup )
+{
+	// No platform of the previous stage is used anymore
+	std::fill( std::begin( m_aiPlatformsInStage ), std::end( m_aiPlatformsInStage ), 0 );
+
+	// Get map's current stage platforms as object group
+	TMXObjectGroup* rcObjectGroup = m_pcCurrentLevel->getObjectGroup( rsObjectGroup );
+
+	// There is no object group with this name which means no object of this kind in this stage
+	if( nullptr == rcObjectGroup )
+	{
+		return;
+	}
+
+	ValueVector& rcObjectsVector = rcObjectGroup->getObjects();
+
+	// IF there are platforms in the current stage this vector should NOT be empy
+	CCASSERT( !rcObjectsVector.empty(), *rsObjectGroup.c_str() + "empty" );
+
+	// Platform types whose pool slice has been initialised by the "pre-initialisation" stage
+	bool abPoolInitialised[ EntityRegistry::k_iNumOfPlatformTypes ] = {};
+
+	for( unsigned int i = 0; i < rcObjectsVector.size(); ++i )
+	{
+		const ValueMap& rcObjectValues = rcObjectsVector[ i ].asValueMap();
+
+		// Resolve the platform type through the registry
+		const EntityRegistry::SPlatformType* psType =
+			EntityRegistry::FindPlatformType( EntityRegistry::HashTypeName( rcObjectValues.at( "type" ).asString() ) );
+
+		CCASSERT( nullptr != psType, "Unknown platform type" );
+
+		if( nullptr == psType )
+		{
+			continue;
+		}
+
+		// Index of the type in the registry, used to count the platforms of this type in the stage
+		const int iType = psType - EntityRegistry::k_asPlatformTypes;
+
+		// Do this if loading the "pre-initialisation" stage
+		if( -1 == m_iCurrentStage )
+		{
+			// The first object of each type sets the collider of the whole pool slice, the others would be ignored
+			if( !abPoolInitialised[ iType ] )
+			{
+				// Initialise all the platforms of this type in the platforms' vector based on the object values
+				for( int j = 0; j < psType->iPoolSize; j++ )
+				{
+					CPlatformBase* pcPlatform = m_cPlatforms[ psType->iPoolOffset + j ];
+					pcPlatform->Initialise( rcObjectValues );
+					// Shapes created by the initialisation take the bitmasks of the type's category
+					pcPlatform->SetCollisionCategory( psType->eCategory );
+				}
+
+				abPoolInitialised[ iType ] = true;
+			}
+		}
+		// Do this for every normal stage
+		else
+		{
+			CCASSERT( m_aiPlatformsInStage[ iType ] < psType->iPoolSize, "Not enough pooled platforms for the stage" );
+
+			// Claim and initialise the next free platform of this type in the current stage based on the object values
+			CPlatformBase* pcPlatform = m_cPlatforms.Claim( psType->iPoolOffset + m_aiPlatformsInStage[ iType ] );
+			pcPlatform->Initialise( rcObjectValues );
+
+			// Increase the amount of platforms of this type counted until now
+			m_aiPlatformsInStage[ iType ]++;
+		}
+	}
+
+}
+
+void CLevelManager::PortsPositioning( const std::string& rsObjectGroup )
+{
+	// Get map's current stage ports as vector of values
+	ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rsObjectGroup )->getObjects();
+
+	CCASSERT( !rcObjectsVector.empty(), rsObjectGroup.c_str() );
+	// Crossreference between the amount of pickups and ports within the stage to ensure progression
+	CCASSERT( m_pcPickupsManager->GetActiveAmountOfKeys() == rcObjectsVector.size(),
+		"Chips amount not match port amount in stage" );
+
+	// Do this if loading the "pre-initialisation" stage
+	if( -1 == m_iCurrentStage )
+	{
+		// Initialise all ports of the ports' vector with the values from the object vector
+		for( CPort* pcPort : m_cPorts.GetMembers() )
+		{
+			pcPort->Initialise( rcObjectsVector[ 0 ] );
+		}
+	}
+	// Do this for every normal stage
+	else
+	{
+		// Initialise the amount of ports present in the current stage with the object's vector values
+		for( unsigned int i = 0; i < rcObjectsVector.size(); i++ )
+		{
+			CPort* pcPort = m_cPorts.Claim( i );
+			// Only the ports of the stage are stepped by the animator, a port released by a previous stage registers again
+			pcPort->SetAnimator( &m_cSpriteAnimator );
+			pcPort->Initialise( rcObjectsVector[ i ] );
+
+			// The port's standing zone is detected by the trigger grid instead of a physics sensor
+			m_cTriggerGrid.AddTrigger( pcPort->GetTriggerVolume(), [pcPort]( const CTriggerGrid::EEvent eEvent, const float )
+			{
+				pcPort->OnTriggerEvent( eEvent );
+			} );
+		}
+	}
+
+	// Set the amount of ports activatable in the current stage based on the size of the object vector
+	m_pcExitDoor->SetAmountOfPortsInAStage( rcObjectsVector.size() );
+}
+
+void CLevelManager::LoadNewStage( const int iStageNumber )
+{
+	// Stage transitions are the only part of the play allowed to allocate
+	AllocationTracker::CAllowScope cAllowAllocations;
+
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	// The platforms simulated for the last stage are not updated with their simulation
+	WaitForSimulation();
+	m_apcUpdatedPlatforms.clear();
+
+	// Set the current stage to the parameter value passed through.
+	m_iCurrentStage = iStageNumber;
+
+	if( m_iCurrentStage == 1 && Audio::k_iAudioEnabled )
+	{
+		m_pcContext->GetAudio().VPlay2D( "/Audio/Alexander Zhelanov-Battle_1.ogg", false, 0.2f );
+	}
+
+	m_sCurrentStage = std::to_string( m_iCurrentStage );
+	m_sPickupsGroup = "Pickups " + m_sCurrentStage;
+
+	// Frozen enemies get their bodies back before the pool claims them, every enemy starts the stage updated every frame
+	m_cEnemyTiers.Reset( m_cEnemies.GetSize() );
+
+	// Pooled entities are claimed again by the positioning of the new stage
+	m_cPlatforms.BeginClaiming();
+	m_cEnemies.BeginClaiming();
+	m_cPorts.BeginClaiming();
+	m_cCheckpoints.BeginClaiming();
+
+	// Trigger volumes are registered again by the positioning of the new stage
+	m_cTriggerGrid.Clear();
+
+	// Position all platforms of the current stage
+	PlatformsPositioning( "Platforms " + m_sCurrentStage );
+	// Position all pickups of the stage level
+	PickUpPositioning( m_sPickupsGroup );
+	// Position all enemies of the current stage
+	EnemiesPositioning( "Enemies " + m_sCurrentStage );
+	// Position all ports of the current stage
+	PortsPositioning( "Ports " + m_sCurrentStage );
+	// Position all checkpoints of the current stage
+	CheckpointPositioning( "Checkpoints" );
+	// Position the exit door of the current stage
+	ExitPositioning( "ExitDoors" );
+
+	// Remove from the map and the physics world every pooled entity not used by the stage
+	m_cPlatforms.ReleaseUnclaimed();
+	m_cEnemies.ReleaseUnclaimed();
+	m_cPorts.ReleaseUnclaimed();
+	m_cCheckpoints.ReleaseUnclaimed();
+
+	// Only the tiles around the new stage stay resident, the pre-initialisation stage loads the first stage's
+	m_cChunkedMap.SetActiveStage( std::max( m_iCurrentStage, 0 ) );
+
+	// The released ports leave the animator until a stage claims them again
+	for( int i = 0; i < m_cPorts.GetSize(); i++ )
+	{
+		if( !m_cPorts.IsActive( i ) )
+		{
+			m_cPorts[ i ]->SetAnimator( nullptr );
+		}
+	}
+
+	// The pre-initialisation stage has nothing to show and is no progress
+	if( m_iCurrentStage >= 0 )
+	{
+		// Render the static layers around the new stage, a level simulated without rendering has none cached
+		if( !m_apcBackgroundCaches.empty() )
+		{
+			const cocos2d::Rect cStageBounds = GetStageBounds();
+
+			for( CBackgroundCache* pcCache : m_apcBackgroundCaches )
+			{
+				pcCache->Rebuild( cStageBounds );
+			}
+		}
+
+		// Reaching a stage is progress
+		SaveProgress();
+	}
+
+	m_sStats.fStageTransitionMs = MillisecondsSince( cStart );
+}
+
+void CLevelManager::ResetCurrentStage()
+{
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	// The simulation started before the reset would move the platforms back from their starting state
+	WaitForSimulation();
+	m_apcUpdatedPlatforms.clear();
+
+	// Get the pickups of the current stage and reset them
+	TMXObjectGroup* rcPickupsObjectGroup = m_pcCurrentLevel->getObjectGroup( m_sPickupsGroup );
+	ValueVector& rcPickupsObjectsVector = rcPickupsObjectGroup->getObjects();
+	m_pcPickupsManager->ResetPickups( rcPickupsObjectsVector );
+
+	// Reset the ports of the current stage based on how many chips are in the stage
+	for( int i = 0; i < m_pcPickupsManager->GetActiveAmountOfKeys(); i++ )
+	{
+		CPort* pcPort = m_cPorts[ i ];
+		pcPort->Reset();
+	}
+
+	// Reset the platforms of the current stage whose type needs it
+	for( int iType = 0; iType < EntityRegistry::k_iNumOfPlatformTypes; iType++ )
+	{
+		const EntityRegistry::SPlatformType& rsType = EntityRegistry::k_asPlatformTypes[ iType ];
+
+		if( rsType.bResetWithStage )
+		{
+			for( int i = 0; i < m_aiPlatformsInStage[ iType ]; i++ )
+			{
+				CPlatformBase* pcPlatform = m_cPlatforms[ rsType.iPoolOffset + i ];
+				// Reset the platform to its original state within the current room
+				pcPlatform->Reset();
+			}
+		}
+	}
+
+	// Reset the door to the standard values
+	m_pcExitDoor->ResetDoor();
+
+	// A player respawning inside a trigger volume has to enter it again
+	m_cTriggerGrid.ResetStates();
+
+	m_sStats.fResetMs = MillisecondsSince( cStart );
+}
+
+void CLevelManager::UpdateTriggers( const cocos2d::Rect& rcPlayerBounds, float fDeltaTime )
+{
+	// The simulation thread steps the ports' animations
+	WaitForSimulation();
+
+	m_cTriggerGrid.Update( rcPlayerBounds, fDeltaTime );
+}
+
+bool CLevelManager::IsEnvironmentAt( const Vec2& rcPoint, const uint8_t uiLayerMask ) const
+{
+	return m_cCollisionBitmap.TestPoint( rcPoint, uiLayerMask );
+}
+
+bool CLevelManager::RaycastEnvironment( const Vec2& rcStart, const Vec2& rcEnd, const uint8_t uiLayerMask,
+	CCollisionBitmap::SHit* psHit ) const
+{
+	return m_cCollisionBitmap.Raycast( rcStart, rcEnd, uiLayerMask, psHit );
+}
+
+bool CLevelManager::SweepEnvironment( const cocos2d::Rect& rcBox, const Vec2& rcMovement, const uint8_t uiLayerMask,
+	CCollisionBitmap::SHit* psHit ) const
+{
+	return m_cCollisionBitmap.SweepBox( rcBox, rcMovement, uiLayerMask, psHit );
+}
+
+bool CLevelManager::FindPath( const Vec2& rcStart, const Vec2& rcGoal, std::vector<CNavigationGraph::SWaypoint>& rasWaypoints )
+{
+	return m_cNavigationGraph.FindPath( rcStart, rcGoal, rasWaypoints );
+}
+
+void CLevelManager::GetProgress( CSaveSystem::SRecord& rsRecord ) const
+{
+	// All the stages are in the same map
+	rsRecord.iLevel = 0;
+	rsRecord.iStage = m_iCurrentStage;
+	rsRecord.uiCollectedPickups = 0;
+	rsRecord.uiPlacedPorts = 0;
+
+	// A collected pickup is hidden by the pickups manager
+	const std::vector<CPickup*>& rapcPickups = m_pcPickupsManager->GetPickups();
+	CCASSERT( rapcPickups.size() <= k_uiProgressMaskBits, "More pickups than the save can record" );
+
+	for( unsigned int i = 0; i < rapcPickups.size() && i < k_uiProgressMaskBits; i++ )
+	{
+		if( !rapcPickups[ i ]->isVisible() )
+		{
+			rsRecord.uiCollectedPickups |= 1u << i;
+		}
+	}
+
+	for( int i = 0; i < m_cPorts.GetSize(); i++ )
+	{
+		if( m_cPorts.IsActive( i ) && m_cPorts[ i ]->IsPlaced() )
+		{
+			rsRecord.uiPlacedPorts |= 1u << i;
+		}
+	}
+}
+
+void CLevelManager::SaveProgress()
+{
+	// Progress is saved a few times per stage, encoding it may allocate
+	AllocationTracker::CAllowScope cAllowAllocations;
+
+	GetProgress( m_sSavedProgress );
+	m_cSaveSystem.Save( m_sSavedProgress );
+}
+
+bool CLevelManager::LoadProgress()
+{
+	CSaveSystem::SRecord sRecord;
+
+	if( !m_cSaveSystem.IsStarted() || !m_cSaveSystem.Load( sRecord ) || sRecord.iStage < 0 )
+	{
+		return false;
+	}
+
+	LoadNewStage( sRecord.iStage );
+
+	int iPlacedPorts = 0;
+
+	for( int i = 0; i < m_cPorts.GetSize(); i++ )
+	{
+		if( m_cPorts.IsActive( i ) && 0 != ( sRecord.uiPlacedPorts & ( 1u << i ) ) )
+		{
+			iPlacedPorts++;
+			m_cPorts[ i ]->RestorePlaced();
+		}
+	}
+
+	// The stage's pickups are its chips, one per port, and every placed port spent one. The player and the HUD hold the
+	// count of the chips carried, so only the spent ones are hidden again, along with their colliders
+	std::vector<CPickup*>& rapcPickups = m_pcPickupsManager->GetPickups();
+
+	for( unsigned int i = 0; i < rapcPickups.size() && i < k_uiProgressMaskBits && iPlacedPorts > 0; i++ )
+	{
+		if( 0 != ( sRecord.uiCollectedPickups & ( 1u << i ) ) )
+		{
+			iPlacedPorts--;
+			rapcPickups[ i ]->setVisible( false );
+
+			if( nullptr != rapcPickups[ i ]->getPhysicsBody() )
+			{
+				rapcPickups[ i ]->getPhysicsBody()->setEnabled( false );
+			}
+		}
+	}
+
+	// The stage load above saved an empty progress, save the restored one
+	SaveProgress();
+
+	return true;
+}
+
+void CLevelManager::StepPhysics( cocos2d::PhysicsWorld* pcPhysicsWorld, float fDeltaTime )
+{
+	CCASSERT( nullptr != pcPhysicsWorld, "Physics world is null" );
+	CCASSERT( !pcPhysicsWorld->isAutoStep(), "The physics world would be stepped twice" );
+
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	pcPhysicsWorld->step( fDeltaTime );
+
+	m_sStats.fPhysicsMs = MillisecondsSince( cStart );
+}
+
+void CLevelManager::TunePhysics( cocos2d::PhysicsWorld* pcPhysicsWorld )
+{
+	CCASSERT( nullptr != pcPhysicsWorld, "Physics world is null" );
+
+	// Every other body of the world is dynamic, the inactive pooled entities have left the world and are not counted
+	int iDynamicShapes = 0;
+
+	for( const PhysicsBody* pcBody : pcPhysicsWorld->getAllBodies() )
+	{
+		if( pcBody != m_pcColliderContainer )
+		{
+			iDynamicShapes += static_cast<int>( pcBody->getShapes().size() );
+		}
+	}
+
+	const PhysicsTuning::SSettings sSettings = PhysicsTuning::Derive( m_sEnvironmentShapes, iDynamicShapes );
+
+	if( !PhysicsTuning::Apply( sSettings, m_pcColliderContainer ) )
+	{
+		CCLOG( "Physics tuning: the level's bodies are not in the world yet, the defaults are kept" );
+		return;
+	}
+
+	CCLOG( "Physics tuning: %d static shapes of %.1f +/- %.1f points, %d dynamic shapes", m_sEnvironmentShapes.iShapes,
+		m_sEnvironmentShapes.GetMeanSize(), m_sEnvironmentShapes.GetSizeDeviation(), iDynamicShapes );
+
+	if( sSettings.bUseSpatialHash )
+	{
+		CCLOG( "Physics tuning: spatial hash of %d cells of %.1f points, %d iterations", sSettings.iHashCells,
+			sSettings.fCellSize, sSettings.iIterations );
+	}
+	else
+	{
+		CCLOG( "Physics tuning: bounding box tree, %d iterations", sSettings.iIterations );
+	}
+}
+
+void CLevelManager::GetStats( SLevelStats& rsStats ) const
+{
+	rsStats = m_sStats;
+
+	rsStats.iEnvironmentShapes = ( nullptr != m_pcColliderContainer ) ? m_pcColliderContainer->getShapes().size() : 0;
+	rsStats.iEntityShapes = TCountShapes( m_cPlatforms ) + TCountShapes( m_cPorts ) + TCountShapes( m_cEnemies )
+		+ TCountShapes( m_cCheckpoints );
+	rsStats.iCreatedShapes = m_cShapePool.GetCreatedCount();
+
+	rsStats.iActivePlatforms = m_cPlatforms.GetActiveCount();
+	rsStats.iActivePorts = m_cPorts.GetActiveCount();
+	rsStats.iActiveEnemies = m_cEnemies.GetActiveCount();
+
+	rsStats.iAnimatedSprites = m_cSpriteAnimator.GetAnimationCount();
+
+	rsStats.iFullRateEnemies = m_cEnemyTiers.GetTierCount( CUpdateTiers::ETier::Full );
+	rsStats.iReducedRateEnemies = m_cEnemyTiers.GetTierCount( CUpdateTiers::ETier::Reduced );
+	rsStats.iFrozenEnemies = m_cEnemyTiers.GetTierCount( CUpdateTiers::ETier::Frozen );
+
+	// Pickups are not pooled, the ones in play are the visible ones
+	rsStats.iActivePickups = 0;
+
+	for( const CPickup* pcPickup : m_pcPickupsManager->GetPickups() )
+	{
+		if( pcPickup->isVisible() )
+		{
+			rsStats.iActivePickups++;
+		}
+	}
+}
+
+void CLevelManager::HideSecondaryBackground()
+{
+	// A cached layer is shown and hidden through its cache, which releases or renders its textures
+	for( CBackgroundCache* pcCache : m_apcBackgroundCaches )
+	{
+		if( pcCache->GetLayer()->getLayerName() == "Second Background" )
+		{
+			pcCache->SetLayerVisible( !pcCache->IsLayerVisible() );
+			return;
+		}
+	}
+
+	// Hide the secondary background if is visible
+	if( m_pcCurrentLevel->getLayer( "Second Background" )->isVisible() == true )
+	{
+		m_pcCurrentLevel->getLayer( "Second Background" )->setVisible( false );
+	}
+	// Make the secondary background visible if it is not
+	else
+	{
+		m_pcCurrentLevel->getLayer( "Second Background" )->setVisible( true );
+	}
+}
+
+std::vector<CPlatformBase*>& CLevelManager::GetPlatforms()	{ return m_cPlatforms.GetMembers(); }
+
+std::vector<CEnemy*>& CLevelManager::GetEnemies()			{ return m_cEnemies.GetMembers(); }
+
+std::vector<CPort*>& CLevelManager::GetPorts()				{ return m_cPorts.GetMembers(); }
+
+std::vector<CCheckpoint*>& CLevelManager::GetCheckpoints()	{ return m_cCheckpoints.GetMembers(); }
+
+CContactStats& CLevelManager::GetContactStats()				{ return m_cContactStats; }
+
+CInputLatencyTracker& CLevelManager::GetInputLatency()		{ return m_cInputLatency; }
+CNavigationGraph& CLevelManager::GetNavigationGraph()			{ return m_cNavigationGraph; }
+
+FastTMXTiledMap* CLevelManager::GetCurrentLevel() const		{ return m_pcCurrentLevel; }
+const CLevelContext* CLevelManager::GetContext() const			{ return m_pcContext; }
+
+const int CLevelManager::GetCurrentLevelID() const			{ return m_iCurrentStage; }
+
+void CLevelManager::SetCurrentLevel( const int iLevel )		{ m_iCurrentStage = iLevel; }
+
@@ -1,14 +1,42 @@
 #ifndef LEVELMANAGER_H
 #define LEVELMANAGER_H
 
-#include <cocos/2d/CCTMXTiledMap.h>
+#include <functional>
+
+#include <cocos/2d/CCFastTMXTiledMap.h>
 #include <cocos/2d/CCTMXXMLParser.h>
 
+#include "Checkpoint.h"
+#include "BackgroundCache.h"
+#include "ChunkedMap.h"
+#include "CollisionBitmap.h"
+#include "CollisionMatrix.h"
 #include "Enemy.h"
+#include "EntityLayer.h"
+#include "EntityPool.h"
+#include "EntityRegistry.h"
+#include "InputLatency.h"
+#include "JobSystem.h"
+#include "LevelContext.h"
+#include "NavigationGraph.h"
+#include "PhysicsTuning.h"
 #include "PlatformBase.h"
+#include "Port.h"
+#include "RenderStateBuffer.h"
+#include "SaveSystem.h"
+#include "ShapePool.h"
+#include "SimulationThread.h"
+#include "SpriteAnimator.h"
+#include "TriggerGrid.h"
+#include "UpdateTiers.h"
 
+class CCheckpoint;
+class CDecodedImageCache;
 class CExitDoor;
+class CHUD;
 class CPickupsManager;
+class CPort;
+class CTextureLoader;
 class CTextureManager;
 
 //-----------------------------------------------------------------------------------------------------------------------------
@@ -18,11 +46,70 @@ class CTextureManager;
 class CLevelManager
 {
 
+public:
+
+	// Costs and counts of the level shown by the performance overlay
+	struct SLevelStats
+	{
+		// Time spent in the last call of Update(), in milliseconds
+		float		fUpdateMs;
+		// Time spent in the last call of StepPhysics(), in milliseconds
+		float		fPhysicsMs;
+		// Time spent by the last LoadNewStage() and ResetCurrentStage(), in milliseconds
+		float		fStageTransitionMs;
+		float		fResetMs;
+		// Shapes of the environment's body and of the enabled bodies of the active pooled entities
+		int			iEnvironmentShapes;
+		int			iEntityShapes;
+		// Boxes the shape pool created since the level was loaded, steady once the biggest stage has been visited
+		int			iCreatedShapes;
+		// Active entities of every pool
+		int			iActivePlatforms;
+		int			iActivePorts;
+		int			iActiveEnemies;
+		int			iActivePickups;
+		// Sprites of the level's animator and frames it changed in the last update
+		int			iAnimatedSprites;
+		int			iFrameChanges;
+		// Time spent in the last call of UpdateEnemies(), in milliseconds, and the enemies it put in each update tier
+		float		fEnemiesMs;
+		int			iFullRateEnemies;
+		int			iReducedRateEnemies;
+		int			iFrozenEnemies;
+		// Time the simulation thread spent on the last frame, and time Update() waited for it, in milliseconds.
+		// Both are 0 unless the level is pipelined
+		float		fSimulationMs;
+		float		fSimulationWaitMs;
+	};
+
 private:
-	int m_iCurrentLevel;
+
+	// Render layers of the entities, drawn in this order
+	enum EEntityLayer
+	{
+		Platforms,
+		Checkpoints,
+		Ports,
+		Enemies,
+		Pickups,
+		Doors,
+		NumOfEntityLayers
+	};
 
 	// Pointer to the current level
-	cocos2d::TMXTiledMap* m_pcCurrentLevel;
+	cocos2d::FastTMXTiledMap* m_pcCurrentLevel;
+
+	// Tiled map the level is loaded from
+	std::string m_sMapFile;
+
+	// Nodes of the map holding its entities, one per render layer, kept apart from the map's tile layers
+	CEntityLayer* m_apcEntityLayers[ NumOfEntityLayers ];
+
+	// Static tile layers of the map drawn from textures rendered once per stage, empty if the level is not rendered
+	std::vector<CBackgroundCache*> m_apcBackgroundCaches;
+
+	// Other tile layers of the map, only the chunks around the current stage are resident
+	CChunkedMap m_cChunkedMap;
 
 	// Physics body of the whole map that will contains only static things
 	cocos2d::PhysicsBody* m_pcColliderContainer;
@@ -30,19 +117,152 @@ private:
 	// Pointer to the texture manager needed for child classes of the map
 	CTextureManager* m_pcTextureManager;
 
-	// Vector of pointers to tiled maps which represents the levels
-	std::vector<cocos2d::TMXTiledMap*> m_pcLevels;
-	
-	// Vector of pointers to store all platforms of the levels
-	std::vector<CPlatformBase*>* m_pcPlatforms;
+	// Engine systems used by the level instead of the Director's singletons
+	CLevelContext* m_pcContext;
 
-	// Vector of pointers to store all enemies of the levels
-	std::vector<CEnemy*>* m_pcEnemies;
+	// True if the context has been created by the level manager and is deleted with it
+	bool m_bOwnsContext;
+
+	// Pool of all platforms of the levels, grouped by type as described by EntityRegistry
+	CEntityPool<CPlatformBase> m_cPlatforms;
+
+	// Pool of all enemies of the levels
+	CEntityPool<CEnemy> m_cEnemies;
+
+	// Pool of all ports of the levels
+	CEntityPool<CPort> m_cPorts;
+
+	// Pool of all checkpoints of the levels
+	CEntityPool<CCheckpoint> m_cCheckpoints;
 
 	CPickupsManager* m_pcPickupsManager;	
 	
 	CExitDoor* m_pcExitDoor;
 
+	// Pointer to the HUD passed to the checkpoints
+	CHUD* m_pcHUD;
+
+	// True once the exit door has been added to the map
+	bool m_bExitDoorExist;
+
+	// ID of the current stage, -1 is the pre-initialisation stage
+	int m_iCurrentStage;
+
+	// ID of the current stage as string, used to retrieve the stage's object groups
+	std::string m_sCurrentStage;
+
+	// Name of the current stage's pickups group, built by the stage transition so that resetting the stage never allocates
+	std::string m_sPickupsGroup;
+
+	// Amount of platforms of every registered type used by the current stage
+	int m_aiPlatformsInStage[ EntityRegistry::k_iNumOfPlatformTypes ];
+
+	// Contact callbacks counted per pair of collision categories
+	CContactStats m_cContactStats;
+
+	// Delays between the player's inputs, the update using them and the frame showing the result
+	CInputLatencyTracker m_cInputLatency;
+
+	// Trigger volumes of the current stage, tested against the player's bounds
+	CTriggerGrid m_cTriggerGrid;
+
+	// Static environment of the map baked at tile resolution, used by the environment queries
+	CCollisionBitmap m_cCollisionBitmap;
+
+	// Surfaces of the map and the moves linking them, baked from the collision bitmap for the enemies' paths
+	CNavigationGraph m_cNavigationGraph;
+
+	// Sizes of the environment's shapes, used to tune the physics world
+	PhysicsTuning::SShapeStats m_sEnvironmentShapes;
+
+	// Boxes of the environment's body, kept from one stage to the next
+	CShapePool m_cShapePool;
+
+	// Writes the player's progress in the background
+	CSaveSystem m_cSaveSystem;
+
+	// Progress last given to the save system, a new one is saved as soon as the play changes it
+	CSaveSystem::SRecord m_sSavedProgress;
+
+	// Steps the sprite sheet animations of the level's entities together
+	CSpriteAnimator m_cSpriteAnimator;
+
+	// Update rate of every enemy of the pool, from its distance to the camera's view
+	CUpdateTiers m_cEnemyTiers;
+
+	// Runs the entities' simulation on every core
+	CJobSystem m_cJobSystem;
+
+	// Platforms of the current stage updated this frame, gathered once for the jobs
+	std::vector<CPlatformBase*> m_apcUpdatedPlatforms;
+
+	// True if the platforms and the animations are simulated on the simulation thread while the scene renders
+	bool m_bIsPipelined;
+
+	// True from BeginSimulation() until the simulation thread has been waited for
+	bool m_bIsSimulating;
+
+	// Runs the simulation of the next frame while the current one renders, when the level is pipelined
+	CSimulationThread m_cSimulationThread;
+
+	// Animation frames written by the simulation thread, shown by the next frame
+	CRenderStateBuffer m_cRenderState;
+
+	// Time passed to the simulation started by BeginSimulation()
+	float m_fSimulatedDeltaTime;
+
+	// Timings of the last update, physics step, stage transition and reset, the counts are filled by GetStats()
+	SLevelStats m_sStats;
+
+	// Resumable part of the initialisation, returns false while it has work left for the next call
+	struct SInitialiseStep
+	{
+		// Shown by the loading screen while the step runs
+		const char*				pszName;
+		std::function<bool()>	fnRun;
+	};
+
+	// Steps of the initialisation in their order, empty once the level is initialised
+	std::vector<SInitialiseStep> m_asInitialiseSteps;
+
+	// Step run by the next call of ContinueInitialise() and progress of the steps run in several calls
+	int m_iNextInitialiseStep;
+	int m_iInitialiseCursor;
+
+	// Time spent in the initialisation until now and in its longest call of ContinueInitialise(), in milliseconds
+	float m_fInitialiseMs;
+	float m_fLongestInitialiseSliceMs;
+	int m_iInitialiseSlices;
+
+	// Textures loaded by the initialisation, created by its first slice and deleted once every texture is uploaded
+	CDecodedImageCache* m_pcDecodedImages;
+	CTextureLoader* m_pcTextureLoader;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: TCountShapes()
+	// Parameters		: T						- Class of the pooled entities
+	//					: rcPool				- Pool to count
+	// Purpose			: Count the shapes of the enabled physics bodies of the pool's active entities
+	// Returns			: The amount of shapes in the physics world coming from the pool
+	//-----------------------------------------------------------------------------------------------------------------------------
+	template<typename T>
+	int TCountShapes( const CEntityPool<T>& rcPool ) const
+	{
+		int iShapes = 0;
+
+		for( int i = 0; i < rcPool.GetSize(); i++ )
+		{
+			cocos2d::PhysicsBody* pcBody = rcPool[ i ]->getPhysicsBody();
+
+			if( rcPool.IsActive( i ) && nullptr != pcBody && pcBody->isEnabled() )
+			{
+				iShapes += pcBody->getShapes().size();
+			}
+		}
+
+		return iShapes;
+	}
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Constructor name	: LoadAllLevels()
 	// Parameters		: None
@@ -50,6 +270,35 @@ private:
 	//-----------------------------------------------------------------------------------------------------------------------------
 	void LoadAllMaps();
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: OpenChunkedMap()
+	// Purpose			: Open the chunk file of the current map, baking it the first time the map is played, and remove
+	//					: the map's tile layers the chunks draw. The static layers stay whole for the background caches
+	// Notes			: The map is still parsed whole once for its object groups, the tiles it keeps are bounded by the
+	//					: chunk budget. A map that cannot be chunked keeps all its layers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void OpenChunkedMap();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreateBackgroundCaches()
+	// Purpose			: Add a background cache to the current map for every static tile layer it has
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void CreateBackgroundCaches();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetStageBounds()
+	// Purpose			: Compute the part of the map seen during the current stage, from the bounds of the stage's objects
+	//					: grown by half a screen on every side so that the camera never sees past it, within the map's bounds
+	// Returns			: The bounds in the map's coordinates, empty if the stage has no objects
+	//-----------------------------------------------------------------------------------------------------------------------------
+	cocos2d::Rect GetStageBounds() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreateEntityLayers()
+	// Purpose			: Add the entity layers to the current map, above the tile layers the entities were drawn with
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void CreateEntityLayers();
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: CreateColliderContainer()
 	// Purpose			: Create empty collider for the map and set its properties
@@ -58,43 +307,47 @@ private:
 	void CreateColliderContainer();
 
 	//-----------------------------------------------------------------------------------------------------------------------------
-	// Function Name	: CreateCollidableObjects( String rcObjectGroup)
-	// Parameters		: rcObjectGroup		- String for the Object group name
+	// Function Name	: CreateCollidableObjects()
+	// Parameters		: rsGroup			- Registry entry of the object group, holding its name and shape tag
+	//					: iFirstObject		- Index of the first object of the group to add
+	//					: iMaxObjects		- Most objects added by this call
 	// Purpose			: Retrieve a specific object group from the tilemap and add new shape to map's collider
-	//					: for every object in the object group
+	//					: for every object in the object group, a slice of it at a time
 	// Notes			: Position of the added shapes is adjusted to match position in tilemap
+	// Returns			: True once the last object of the group has been added
 	//-----------------------------------------------------------------------------------------------------------------------------
-	void CreateCollidableObjects( const std::string& rcObjectGroup );
+	bool CreateCollidableObjects( const EntityRegistry::SEnvironmentGroup& rsGroup, const int iFirstObject, const int iMaxObjects );
 
 	//-----------------------------------------------------------------------------------------------------------------------------
-	// Function Name	: CreateResponsiveEntities()
+	// Function Name	: TCreateEntities()
 	// Parameters		: T						- Specific class type of the entities to create
-	//					    : storage				- Templated vector of the that specify where store new entities
-	//					    : rcObjectGroup			- The specific tiled object group of the platforms
-	// Purpose			: Create entities of the specified object group a room, store them and add them to map
-	// Example			: TCreateResponsiveEntities<CEnemy>( m_pcEnemies, "Enemies" )
+	//					: rPool					- Pool where the new entities are stored
+	//					: iAmount				- Amount of entities to create
+	//					: rcTextureManager		- The texture manager passed to the entities
+	// Purpose			: Create a pool of entities, store them and add them to map
+	// Example			: TCreateEntities<CEnemy>( m_cEnemies, Enemies::k_iMaxAmountOfEnemies, *m_pcTextureManager )
 	//-----------------------------------------------------------------------------------------------------------------------------
-	template<typename T, typename J = std::vector<T*>>
-	void TCreateResponsiveEntities( J& rStorage, const std::string& rcObjectGroup )
+	template<typename T, typename J>
+	void TCreateEntities( CEntityPool<J>& rPool, const int iAmount, CTextureManager& rcTextureManager )
 	{
-		// Retrieve the correct map object group
-		cocos2d::ValueVector& rcObjectsVector = m_pcCurrentLevel->getObjectGroup( rcObjectGroup )->getObjects();
-
-		CCASSERT( !rcObjectsVector.empty(), rcObjectGroup.c_str() );
-
-		// Create and add enemies from the object of the map
-		for( cocos2d::Value& rcObject : rcObjectsVector )
-		{	
-			// Set the name of the enemy to be like "Enemy id", used for collision management
-			int iID = rStorage->size();
-			// Create the enemy and stores it in the platform vecto
-			rStorage->push_back( new T( rcObject, *m_pcTextureManager, iID)  );
-			
-			// Add the enemy to the current map
-			m_pcCurrentLevel->addChild( rStorage->back() );
+		for( int i = 0; i < iAmount; i++ )
+		{
+			// The ID of the entity is its index in the pool, used for collision management
+			int iID = rPool.GetSize();
+			// Create the entity, move it to the level's context, store it and add it to the current map
+			T* pcEntity = new T( rcTextureManager, iID );
+			m_pcContext->ApplyTo( pcEntity );
+			rPool.Add( pcEntity );
 		}
 	}
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CreatePlatforms()
+	// Parameters		: rsType				- Registry entry of the platform type to create
+	// Purpose			: Fill the slice of the platforms' vector reserved to the type using the type's factory
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void CreatePlatforms( const EntityRegistry::SPlatformType& rsType );
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: PickUpPositioning()
 	// Parameters		: rcObjectGroup			- The specific tiled object group of the pickups
@@ -103,13 +356,76 @@ private:
 	void PickUpPositioning( const std::string& rcObjectGroup );
 
 	//-----------------------------------------------------------------------------------------------------------------------------
-	// Function Name	: PickUpPositioning()
+	// Function Name	: ExitPositioning()
 	// Author			: Gaetano Trovato
-	// Parameters		: rcObjectGroup			- The specific tiled object group of the pickups
-	// Purpose			: Position correctly all pickups of the current object group
+	// Parameters		: rcObjectGroup			- The specific tiled object group of the exit doors
+	// Purpose			: Position the exit door of the current stage
 	//---------------------------------------------------------------------------------------------------------------
 	void ExitPositioning( const std::string& rcObjectGroup );
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: EnemiesPositioning()
+	// Parameters		: rsObjectGroup			- The specific tiled object group of the enemies
+	// Purpose			: Initialise the enemies of the current stage, or all of them in the pre-initialisation stage
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void EnemiesPositioning( const std::string& rsObjectGroup );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: CheckpointPositioning()
+	// Parameters		: rsObjectGroup			- The specific tiled object group of the checkpoints
+	// Purpose			: Initialise the checkpoint of the current stage if present
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void CheckpointPositioning( const std::string& rsObjectGroup );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetProgress()
+	// Parameters		: rsRecord				- Filled with the current stage, the collected pickups and the placed ports
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GetProgress( CSaveSystem::SRecord& rsRecord ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: PlatformsPositioning()
+	// Parameters		: rsObjectGroup			- The specific tiled object group of the platforms
+	// Purpose			: Resolve the type of every platform object through the entity registry and claim and initialise the
+	//					: platforms of the matching pool slice, or initialise all of them in the pre-initialisation stage
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void PlatformsPositioning( const std::string& rsObjectGroup );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: PortsPositioning()
+	// Parameters		: rsObjectGroup			- The specific tiled object group of the ports
+	// Purpose			: Initialise the ports of the current stage, or all of them in the pre-initialisation stage
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void PortsPositioning( const std::string& rsObjectGroup );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddInitialiseStep()
+	// Parameters		: pszName				- Name of the step shown by the loading screen
+	//					: fnRun					- Work of the step, returning false while it has work left
+	// Purpose			: Queue a step of the initialisation after the ones added before
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void AddInitialiseStep( const char* pszName, const std::function<bool()>& fnRun );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GatherUpdatedPlatforms()
+	// Purpose			: Fill the updated platforms with the ones of the current stage whose type needs an update
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GatherUpdatedPlatforms();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SimulatePlatforms()
+	// Parameters		: fDeltaTime			- Time passed since the last frame
+	// Purpose			: Simulate the updated platforms on the job system, without touching their nodes
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SimulatePlatforms( const float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: WaitForSimulation()
+	// Purpose			: Block until the simulation started by BeginSimulation() is done and time it, nothing to wait for
+	//					: unless a simulation is in flight. Called before the main thread touches the platforms or the animator
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void WaitForSimulation();
+
 public:
 
 #pragma region Constructor/Destructors
@@ -136,9 +452,206 @@ public:
 	// Function name	: Initialise()
 	// Parameters		  : pcTextureManager		- The texture manager of the game
 	//					      : pcPickupsManager		- The pickup manager of the game
+	//					      : pcHUD					- The HUD passed to the checkpoints
+	//					      : pcContext				- Engine systems used by the level, nullptr to use the Director's ones
+	//					      : rsMapFile				- Tiled map of the level, e.g. a stress level written by CStressLevel
 	// Purpose			  : This function will load all the levels and create the correlated object from the Tiled maps
+	// Notes			  : Levels simulated next to the game's each need their own isolated context, see CLevelContext.
+	//					  : Blocks until done, a loading screen uses BeginInitialise() and ContinueInitialise() instead
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Initialise( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD,
+		CLevelContext* pcContext = nullptr, const std::string& rsMapFile = Levels::k_cLevelOne );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: BeginInitialise()
+	// Parameters		: Same as Initialise()
+	// Purpose			: Queue the initialisation of the level without running it, the work is done by ContinueInitialise()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BeginInitialise( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD,
+		CLevelContext* pcContext = nullptr, const std::string& rsMapFile = Levels::k_cLevelOne );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: ContinueInitialise()
+	// Parameters		: fBudgetMs				- Time the call may take, in milliseconds
+	// Purpose			: Run the queued initialisation steps until the budget is spent, called once per frame
+	// Notes			: A step is never interrupted, so a call takes at least one step and may exceed the budget by the
+	//					: length of its last step. The map decoding and the pre-initialisation stage are the longest ones
+	// Returns			: True once the level is initialised
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool ContinueInitialise( const float fBudgetMs );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: GetInitialiseProgress()
+	// Returns			: The share of the initialisation steps done, between 0 and 1
+	//-----------------------------------------------------------------------------------------------------------------------------
+	float GetInitialiseProgress() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: GetInitialiseStepName()
+	// Returns			: The name of the next initialisation step, an empty string once the level is initialised
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const char* GetInitialiseStepName() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: GetLongestInitialiseSliceMs()
+	// Returns			: The longest call of ContinueInitialise() in milliseconds, the worst frame of the loading screen
+	//-----------------------------------------------------------------------------------------------------------------------------
+	float GetLongestInitialiseSliceMs() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: Update()
+	// Parameters		: fDeltaTime			- Time passed since the last frame
+	// Purpose			: Update the exit door, the pickups and the platforms of the current stage that need it
+	// Notes			: When the level is pipelined, the platforms apply the simulation run since the last BeginSimulation()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Update( float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: BeginSimulation()
+	// Parameters		: fDeltaTime			- Time passed since the last frame
+	// Purpose			: When the level is pipelined, show the animation frames of the last simulation and start simulating
+	//					: the platforms and the animations of the next frame on the simulation thread. Called by the scene
+	//					: once per frame after the physics step, just before the frame renders, so that the simulation
+	//					: overlaps the rendering. Does nothing otherwise, Update() simulates in place
+	// Notes			: Until the next Update(), the scene must leave the platforms and the animator alone: input handlers
+	//					: only queue their input, as the input latency tracker expects. Animations lag one frame behind
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BeginSimulation( float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: SetPipelined()
+	// Parameters		: bIsPipelined			- True to simulate the next frame while the current one renders
+	// Purpose			: Switch between simulating in Update() and on the simulation thread, the simulation in flight is
+	//					: finished and shown first
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetPipelined( const bool bIsPipelined );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: IsPipelined()
+	// Returns			: True if the simulation runs on the simulation thread
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsPipelined() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: UpdateEnemies()
+	// Parameters		: rcView				- Part of the map seen by the camera, in the map's coordinates
+	//					: fDeltaTime			- Time passed since the last frame
+	// Purpose			: Update the enemies of the current stage at the rate of their update tier: every frame near the
+	//					: view, every few frames farther off screen, and not at all, with their bodies asleep, far from it.
+	//					: Called by the scene once per frame in place of updating every enemy itself
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void UpdateEnemies( const cocos2d::Rect& rcView, float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: LoadNewStage()
+	// Parameters		: iStageNumber			- ID of the stage to load, -1 is the pre-initialisation stage
+	// Purpose			: Position and initialise all the entities of the given stage
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void LoadNewStage( const int iStageNumber );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: ResetCurrentStage()
+	// Purpose			: Reset pickups, ports, platforms and exit door of the current stage to their starting state
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ResetCurrentStage();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: UpdateTriggers()
+	// Parameters		: rcPlayerBounds		- Bounds of the player in the map's coordinates
+	//					: fDeltaTime			- Time passed since the last frame
+	// Purpose			: Send the enter, stay and exit events of the current stage's trigger volumes, called by the scene
+	//					: once per frame after the player moved. The triggers change the ports, so the simulation in flight
+	//					: is waited for first
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void UpdateTriggers( const cocos2d::Rect& rcPlayerBounds, float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: IsEnvironmentAt()
+	// Parameters		: rcPoint				- Point in the map's coordinates
+	//					: uiLayerMask			- Environment layers to test, see CCollisionBitmap::ELayer
+	// Purpose			: Test the baked environment without going through the physics engine, e.g. for ground checks
+	// Returns			: True if the tile containing the point belongs to one of the layers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsEnvironmentAt( const cocos2d::Vec2& rcPoint, const uint8_t uiLayerMask ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: RaycastEnvironment()
+	// Parameters		: rcStart				- Start of the ray in the map's coordinates
+	//					: rcEnd					- End of the ray in the map's coordinates
+	//					: uiLayerMask			- Environment layers that stop the ray
+	//					: psHit					- Filled with the first hit, can be nullptr for a line of sight test
+	// Purpose			: Raycast against the baked environment
+	// Returns			: True if the ray hits the environment
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool RaycastEnvironment( const cocos2d::Vec2& rcStart, const cocos2d::Vec2& rcEnd, const uint8_t uiLayerMask,
+		CCollisionBitmap::SHit* psHit = nullptr ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: SweepEnvironment()
+	// Parameters		: rcBox					- Box in the map's coordinates at the start of the movement
+	//					: rcMovement			- Movement of the box
+	//					: uiLayerMask			- Environment layers that stop the box
+	//					: psHit					- Filled with the first hit, can be nullptr
+	// Purpose			: Sweep a box against the baked environment
+	// Returns			: True if the box hits the environment before the end of the movement
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool SweepEnvironment( const cocos2d::Rect& rcBox, const cocos2d::Vec2& rcMovement, const uint8_t uiLayerMask,
+		CCollisionBitmap::SHit* psHit = nullptr ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: FindPath()
+	// Parameters		: rcStart				- Position of the feet of the entity in the map's coordinates
+	//					: rcGoal				- Position to reach in the map's coordinates
+	//					: rasWaypoints			- Filled with the waypoints to follow and the move needed to reach each of them
+	// Purpose			: Find a path over the baked navigation graph, used by the enemies' movement and chase logic
+	// Returns			: False if there is no path between the two positions
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool FindPath( const cocos2d::Vec2& rcStart, const cocos2d::Vec2& rcGoal, std::vector<CNavigationGraph::SWaypoint>& rasWaypoints );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: SaveProgress()
+	// Purpose			: Save the current stage, the collected pickups and the placed ports without waiting for the disk.
+	//					: Called when a new stage is loaded and when the player reaches the checkpoint, Update() calls it
+	//					: once a pickup is collected or a port is placed
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SaveProgress();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: StepPhysics()
+	// Parameters		: pcPhysicsWorld		- Physics world of the scene, with its automatic step disabled
+	//					: fDeltaTime			- Time passed since the last frame
+	// Purpose			: Step the physics world and time it for the performance overlay
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void StepPhysics( cocos2d::PhysicsWorld* pcPhysicsWorld, float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: TunePhysics()
+	// Parameters		: pcPhysicsWorld		- Physics world of the scene, once the current map has been added to it
+	// Purpose			: Derive the broadphase and the solver iterations from the level's shapes, log them and apply them
+	//					: to the physics world
 	//-----------------------------------------------------------------------------------------------------------------------------
-	void Initialise(CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CExitDoor* pcExitDoor );
+	void TunePhysics( cocos2d::PhysicsWorld* pcPhysicsWorld );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: GetStats()
+	// Parameters		: rsStats				- Filled with the latest timings and the current counts
+	// Purpose			: Collect the costs of the level, used by the performance overlay
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void GetStats( SLevelStats& rsStats ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: LoadProgress()
+	// Purpose			: Load the saved stage and restore its placed ports along with the pickups spent on them. The chips
+	//					: the player carried are not saved, their pickups are left in the stage to be collected again
+	// Returns			: False if there is no valid save, the current stage is left untouched
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool LoadProgress();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: HideSecondaryBackground()
+	// Purpose			: Toggle the visibility of the "Second Background" layer
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void HideSecondaryBackground();
 
 
 	#pragma region Getters and Setter
@@ -147,7 +660,7 @@ public:
 	// Function Name	: GetPlatforms()
 	// Editors			  : None
 	// Purpose			  : Retrieve a pointer to the platform's vector used by the level's manager
-	// Return			    : m_pcPlatforms
+	// Return			    : m_cPlatforms
 	//-----------------------------------------------------------------------------------------------------------------------------
 	std::vector<CPlatformBase*>& GetPlatforms();
 	
@@ -155,21 +668,63 @@ public:
 	// Function Name	: GetEnemies()
 	// Editors			: None
 	// Purpose			: Retrieve a pointer to the enemies's vector used by the level's manager
-	// Return			: m_pcEnemies
+	// Return			: m_cEnemies
 	//-----------------------------------------------------------------------------------------------------------------------------
 	std::vector<CEnemy*>& GetEnemies();
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetPorts()
+	// Purpose			: Retrieve a reference to the ports' vector used by the level's manager
+	// Return			: m_cPorts
+	//-----------------------------------------------------------------------------------------------------------------------------
+	std::vector<CPort*>& GetPorts();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetCheckpoints()
+	// Purpose			: Retrieve a reference to the checkpoints' vector used by the level's manager
+	// Return			: m_cCheckpoints
+	//-----------------------------------------------------------------------------------------------------------------------------
+	std::vector<CCheckpoint*>& GetCheckpoints();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetContactStats()
+	// Purpose			: Retrieve the contact callbacks counted since the level was initialised, only filled in debug builds
+	// Return			: m_cContactStats
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CContactStats& GetContactStats();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetInputLatency()
+	// Purpose			: Retrieve the input latency tracker, the player's input listeners stamp every event through it
+	// Return			: m_cInputLatency
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CInputLatencyTracker& GetInputLatency();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetNavigationGraph()
+	// Purpose			: Retrieve the segments and links baked for the enemies' movement
+	// Return			: m_cNavigationGraph
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CNavigationGraph& GetNavigationGraph();
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: GetCurrentLevel()
 	// Purpose			: Retrieve a pointer to the current level
 	// Return			: m_pcCurrentLevel
 	//-----------------------------------------------------------------------------------------------------------------------------
-	cocos2d::TMXTiledMap* GetCurrentLevel() const;
+	cocos2d::FastTMXTiledMap* GetCurrentLevel() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetContext()
+	// Purpose			: Retrieve the engine systems the level works with, set by BeginInitialise()
+	// Return			: m_pcContext
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const CLevelContext* GetContext() const;
 
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: GetCurrentLevelID()
-	// Purpose			: Get the integer id of the current level
-	// Return			: m_iCurrentLevel
+	// Purpose			: Get the integer id of the current stage
+	// Return			: m_iCurrentStage
 	//-----------------------------------------------------------------------------------------------------------------------------
 	const int GetCurrentLevelID() const;
 
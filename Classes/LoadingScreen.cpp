@@ -0,0 +1,118 @@
+#include "LoadingScreen.h"
+
+#include <cmath>
+#include <new>
+
+#include <cocos/2d/CCDrawNode.h>
+#include <cocos/2d/CCLabel.h>
+
+#include "LevelManager.h"
+
+using cocos2d::Color4F;
+using cocos2d::Vec2;
+
+// Size of the progress bar in points
+static const float k_fBarWidth = 320.0f;
+static const float k_fBarHeight = 12.0f;
+
+// Radius and speed of the spinner, in points and turns per second
+static const float k_fSpinnerRadius = 10.0f;
+static const float k_fSpinnerTurnsPerSecond = 1.0f;
+
+constexpr float CLoadingScreen::k_fDefaultBudgetMs;
+
+CLoadingScreen::CLoadingScreen()
+	: m_pcLevelManager( nullptr )
+	, m_fBudgetMs( k_fDefaultBudgetMs )
+	, m_pcLabel( nullptr )
+	, m_pcProgress( nullptr )
+	, m_fSpinnerAngle( 0.0f )
+{}
+
+CLoadingScreen* CLoadingScreen::create( CLevelManager* pcLevelManager, const float fBudgetMs, const std::function<void()>& fnOnLoaded )
+{
+	CLoadingScreen* pcLoadingScreen = new ( std::nothrow ) CLoadingScreen();
+
+	if( nullptr != pcLoadingScreen && pcLoadingScreen->init( pcLevelManager, fBudgetMs, fnOnLoaded ) )
+	{
+		pcLoadingScreen->autorelease();
+		return pcLoadingScreen;
+	}
+
+	CC_SAFE_DELETE( pcLoadingScreen );
+	return nullptr;
+}
+
+bool CLoadingScreen::init( CLevelManager* pcLevelManager, const float fBudgetMs, const std::function<void()>& fnOnLoaded )
+{
+	if( !Node::init() )
+	{
+		return false;
+	}
+
+	CCASSERT( nullptr != pcLevelManager, "Level manager is null" );
+	m_pcLevelManager = pcLevelManager;
+	m_fBudgetMs = fBudgetMs;
+	m_fnOnLoaded = fnOnLoaded;
+
+	// Bar centred on the visible area, text right above it
+	const cocos2d::Rect cVisibleRect = pcLevelManager->GetContext()->GetVisibleRect();
+	setPosition( Vec2( cVisibleRect.getMidX(), cVisibleRect.getMidY() ) );
+
+	m_pcProgress = cocos2d::DrawNode::create();
+	addChild( m_pcProgress );
+
+	m_pcLabel = cocos2d::Label::createWithSystemFont( "", "Arial", 16.0f );
+	m_pcLabel->setPosition( Vec2( 0.0f, k_fBarHeight + 12.0f ) );
+	addChild( m_pcLabel );
+
+	DrawProgress();
+	scheduleUpdate();
+
+	return true;
+}
+
+void CLoadingScreen::update( float fDeltaTime )
+{
+	m_fSpinnerAngle = fmodf( m_fSpinnerAngle + fDeltaTime * k_fSpinnerTurnsPerSecond * 2.0f * M_PI, 2.0f * M_PI );
+
+	const bool bIsLoaded = m_pcLevelManager->ContinueInitialise( m_fBudgetMs );
+
+	// Only rebuild the label's glyphs when the step changes
+	const char* pszStepName = m_pcLevelManager->GetInitialiseStepName();
+
+	if( m_pcLabel->getString() != pszStepName )
+	{
+		m_pcLabel->setString( pszStepName );
+	}
+
+	DrawProgress();
+
+	if( bIsLoaded )
+	{
+		unscheduleUpdate();
+
+		if( m_fnOnLoaded )
+		{
+			m_fnOnLoaded();
+		}
+	}
+}
+
+void CLoadingScreen::DrawProgress()
+{
+	m_pcProgress->clear();
+
+	const Vec2 cBarOrigin( -k_fBarWidth * 0.5f, -k_fBarHeight * 0.5f );
+	const float fFilledWidth = k_fBarWidth * m_pcLevelManager->GetInitialiseProgress();
+
+	m_pcProgress->drawSolidRect( cBarOrigin, cBarOrigin + Vec2( k_fBarWidth, k_fBarHeight ), Color4F( 0.0f, 0.0f, 0.0f, 0.5f ) );
+	m_pcProgress->drawSolidRect( cBarOrigin, cBarOrigin + Vec2( fFilledWidth, k_fBarHeight ), Color4F::WHITE );
+
+	// Spinner right of the bar
+	const Vec2 cSpinnerCentre( k_fBarWidth * 0.5f + k_fSpinnerRadius * 2.0f, 0.0f );
+	const Vec2 cSpinnerTip( cosf( m_fSpinnerAngle ) * k_fSpinnerRadius, sinf( m_fSpinnerAngle ) * k_fSpinnerRadius );
+
+	m_pcProgress->drawCircle( cSpinnerCentre, k_fSpinnerRadius, 0.0f, 16, false, Color4F::GRAY );
+	m_pcProgress->drawLine( cSpinnerCentre, cSpinnerCentre + cSpinnerTip, Color4F::WHITE );
+}
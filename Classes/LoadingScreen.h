@@ -0,0 +1,91 @@
+#ifndef LOADINGSCREEN_H
+#define LOADINGSCREEN_H
+
+#include <functional>
+
+#include <cocos/2d/CCNode.h>
+
+class CLevelManager;
+
+namespace cocos2d
+{
+	class DrawNode;
+	class Label;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CLoadingScreen
+// Classes Inherited	: Node
+// Purpose				: To build a level over several frames while showing its progress. Every frame the screen runs the
+//						: level's queued initialisation steps for a fixed budget, then draws a progress bar, the name of the
+//						: next step and a spinner, which keeps turning because no frame waits for the whole level
+// Notes				: The level must have been started with CLevelManager::BeginInitialise(). Once done the screen stops
+//						: updating and calls its callback, which usually adds the level's map to the game scene
+// Example				: pcLevelManager->BeginInitialise( pcTextureManager, pcPickupsManager, pcHUD );
+//						: addChild( CLoadingScreen::create( pcLevelManager, 8.0f, [this](){ OnLevelLoaded(); } ) );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CLoadingScreen : public cocos2d::Node
+{
+
+private:
+
+	// Level being initialised
+	CLevelManager* m_pcLevelManager;
+
+	// Time given to the initialisation every frame, in milliseconds
+	float m_fBudgetMs;
+
+	// Called once the level is initialised
+	std::function<void()> m_fnOnLoaded;
+
+	// Name of the next step
+	cocos2d::Label* m_pcLabel;
+
+	// Progress bar and spinner
+	cocos2d::DrawNode* m_pcProgress;
+
+	// Angle of the spinner, in radians
+	float m_fSpinnerAngle;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: DrawProgress()
+	// Purpose			: Draw the progress bar filled up to the level's progress and the spinner at its current angle
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void DrawProgress();
+
+public:
+
+	// Time given to the initialisation every frame by default, half a frame at 60 frames per second
+	static constexpr float k_fDefaultBudgetMs = 8.0f;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: create()
+	// Parameters		: pcLevelManager	- Level started with BeginInitialise()
+	//					: fBudgetMs			- Time given to the initialisation every frame, in milliseconds
+	//					: fnOnLoaded		- Called once the level is initialised
+	// Purpose			: Create a loading screen that starts working on its first update, the usual cocos2d-x factory
+	// Returns			: An autoreleased loading screen, nullptr on failure
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CLoadingScreen* create( CLevelManager* pcLevelManager, const float fBudgetMs, const std::function<void()>& fnOnLoaded );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: init()
+	// Parameters		: Same as create()
+	// Purpose			: Create the label and the progress bar, centred on the visible area
+	// Returns			: False if the node could not be initialised
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool init( CLevelManager* pcLevelManager, const float fBudgetMs, const std::function<void()>& fnOnLoaded );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: update()
+	// Parameters		: fDeltaTime		- Time passed since the last frame
+	// Purpose			: Continue the initialisation and redraw the progress
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void update( float fDeltaTime ) override;
+
+protected:
+
+	CLoadingScreen();
+};
+
+#endif // !LOADINGSCREEN_H
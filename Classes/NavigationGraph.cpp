@@ -0,0 +1,486 @@
+#include "NavigationGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include <cocos/base/ccMacros.h>
+
+#include "CollisionBitmap.h"
+
+using cocos2d::Vec2;
+
+// Layers an entity cannot move through
+static const uint8_t k_uiSolidLayers = CCollisionBitmap::Bound | CCollisionBitmap::Wall | CCollisionBitmap::Floor
+	| CCollisionBitmap::Obstacle;
+
+// Extra cost of the moves, on top of the tiles they cross
+static const float k_fJumpCost = 2.0f;
+static const float k_fDropCostPerRow = 0.5f;
+static const float k_fClimbCostPerRow = 1.5f;
+
+// Amount of rows below an entity searched for the surface it is about to land on
+static const int k_iMaxRowsAboveSurface = 2;
+
+CNavigationGraph::CNavigationGraph()
+	: m_iColumns( 0 )
+	, m_iRows( 0 )
+{}
+
+void CNavigationGraph::Bake( const CCollisionBitmap& rcBitmap )
+{
+	m_cTileSize = rcBitmap.GetTileSize();
+	m_iColumns = rcBitmap.GetColumns();
+	m_iRows = rcBitmap.GetRows();
+
+	m_asSegments.clear();
+	m_asLinks.clear();
+	m_aiSegmentAtTile.assign( m_iColumns * m_iRows, -1 );
+
+	ClearPathCache();
+
+	BuildSegments( rcBitmap );
+	BuildLinks( rcBitmap );
+
+	m_afCostSoFar.resize( m_asSegments.size() );
+	m_aiCameFromLink.resize( m_asSegments.size() );
+	m_aiEntryColumn.resize( m_asSegments.size() );
+	m_abIsClosed.resize( m_asSegments.size() );
+
+	CCLOG( "Navigation graph baked: %d segments, %d links", static_cast<int>( m_asSegments.size() ),
+		static_cast<int>( m_asLinks.size() ) );
+}
+
+void CNavigationGraph::BuildSegments( const CCollisionBitmap& rcBitmap )
+{
+	// Row 0 has nothing below it so nothing can stand in it
+	for( int iRow = 1; iRow < m_iRows; iRow++ )
+	{
+		int iColumn = 0;
+
+		while( iColumn < m_iColumns )
+		{
+			// A tile is walkable if it is free and has floor right below it
+			const bool bIsWalkable = 0 == ( rcBitmap.GetTile( iColumn, iRow ) & k_uiSolidLayers )
+				&& 0 != ( rcBitmap.GetTile( iColumn, iRow - 1 ) & CCollisionBitmap::Floor );
+
+			if( !bIsWalkable )
+			{
+				iColumn++;
+				continue;
+			}
+
+			SSegment sSegment;
+			sSegment.iRow = iRow;
+			sSegment.iFirstColumn = iColumn;
+			sSegment.iFirstLink = 0;
+			sSegment.iAmountOfLinks = 0;
+
+			const int iSegment = m_asSegments.size();
+
+			// Extend the segment as long as the tiles are walkable
+			while( iColumn < m_iColumns
+				&& 0 == ( rcBitmap.GetTile( iColumn, iRow ) & k_uiSolidLayers )
+				&& 0 != ( rcBitmap.GetTile( iColumn, iRow - 1 ) & CCollisionBitmap::Floor ) )
+			{
+				m_aiSegmentAtTile[ iRow * m_iColumns + iColumn ] = iSegment;
+				iColumn++;
+			}
+
+			sSegment.iLastColumn = iColumn - 1;
+
+			// A side is a ledge when the entity can walk past it and fall, tiles outside the map are not
+			const int iLeftColumn = sSegment.iFirstColumn - 1;
+			const int iRightColumn = sSegment.iLastColumn + 1;
+			sSegment.bIsLeftLedge = iLeftColumn >= 0 && 0 == ( rcBitmap.GetTile( iLeftColumn, iRow ) & k_uiSolidLayers );
+			sSegment.bIsRightLedge = iRightColumn < m_iColumns && 0 == ( rcBitmap.GetTile( iRightColumn, iRow ) & k_uiSolidLayers );
+
+			m_asSegments.push_back( sSegment );
+		}
+	}
+}
+
+void CNavigationGraph::BuildLinks( const CCollisionBitmap& rcBitmap )
+{
+	// Adds a link unless the same move already links the two segments
+	auto AddLink = [this]( const int iSource, const int iTarget, const EMove eMove, const int iFromColumn, const int iToColumn,
+		const float fCost )
+	{
+		for( int i = m_asSegments[ iSource ].iFirstLink; i < static_cast<int>( m_asLinks.size() ); i++ )
+		{
+			if( m_asLinks[ i ].iTarget == iTarget && m_asLinks[ i ].eMove == eMove )
+			{
+				return;
+			}
+		}
+
+		SLink sLink;
+		sLink.iSource = iSource;
+		sLink.iTarget = iTarget;
+		sLink.eMove = eMove;
+		sLink.iFromColumn = iFromColumn;
+		sLink.iToColumn = iToColumn;
+		sLink.fCost = fCost;
+		m_asLinks.push_back( sLink );
+	};
+
+	// True if the centres of the two tiles see each other through free tiles
+	auto IsClear = [this, &rcBitmap]( const int iFromColumn, const int iFromRow, const int iToColumn, const int iToRow )
+	{
+		const Vec2 cFrom( ( iFromColumn + 0.5f ) * m_cTileSize.width, ( iFromRow + 0.5f ) * m_cTileSize.height );
+		const Vec2 cTo( ( iToColumn + 0.5f ) * m_cTileSize.width, ( iToRow + 0.5f ) * m_cTileSize.height );
+
+		return !rcBitmap.Raycast( cFrom, cTo, k_uiSolidLayers, nullptr );
+	};
+
+	// Segments are built row by row from left to right, so the segments of a row are contiguous and sorted by column.
+	// The jump candidates of a segment are looked up in the rows it can reach instead of among all the segments
+	std::vector<int> aiFirstSegmentOfRow( m_iRows + 1, 0 );
+
+	for( const SSegment& rsSegment : m_asSegments )
+	{
+		aiFirstSegmentOfRow[ rsSegment.iRow + 1 ]++;
+	}
+
+	for( int iRow = 0; iRow < m_iRows; iRow++ )
+	{
+		aiFirstSegmentOfRow[ iRow + 1 ] += aiFirstSegmentOfRow[ iRow ];
+	}
+
+	for( int iSegment = 0; iSegment < static_cast<int>( m_asSegments.size() ); iSegment++ )
+	{
+		const SSegment& rsSegment = m_asSegments[ iSegment ];
+		m_asSegments[ iSegment ].iFirstLink = m_asLinks.size();
+
+		// Drop links, falling straight down from each ledge to the first surface below it
+		for( int iSide = 0; iSide < 2; iSide++ )
+		{
+			const bool bIsLedge = ( 0 == iSide ) ? rsSegment.bIsLeftLedge : rsSegment.bIsRightLedge;
+
+			if( !bIsLedge )
+			{
+				continue;
+			}
+
+			const int iFromColumn = ( 0 == iSide ) ? rsSegment.iFirstColumn : rsSegment.iLastColumn;
+			const int iColumn = ( 0 == iSide ) ? iFromColumn - 1 : iFromColumn + 1;
+
+			for( int iRow = rsSegment.iRow - 1; iRow >= std::max( 1, rsSegment.iRow - k_iMaxDropRows ); iRow-- )
+			{
+				const int iTarget = m_aiSegmentAtTile[ iRow * m_iColumns + iColumn ];
+
+				if( iTarget >= 0 )
+				{
+					AddLink( iSegment, iTarget, EMove::Drop, iFromColumn, iColumn,
+						1.0f + ( rsSegment.iRow - iRow ) * k_fDropCostPerRow );
+					break;
+				}
+
+				if( 0 != ( rcBitmap.GetTile( iColumn, iRow ) & k_uiSolidLayers ) )
+				{
+					break;
+				}
+			}
+		}
+
+		// Jump links, to the segments close enough on both axis with free space on the way
+		const int iLowestTargetRow = std::max( rsSegment.iRow - k_iMaxJumpRows, 0 );
+		const int iHighestTargetRow = std::min( rsSegment.iRow + k_iMaxJumpRows, m_iRows - 1 );
+
+		// Columns a jump can reach, segments ending before or starting after them are too far
+		const int iLeftmostColumn = rsSegment.iFirstColumn - k_iMaxJumpColumns - 1;
+		const int iRightmostColumn = rsSegment.iLastColumn + k_iMaxJumpColumns + 1;
+
+		for( int iTargetRow = iLowestTargetRow; iTargetRow <= iHighestTargetRow; iTargetRow++ )
+		{
+			const auto cRowBegin = m_asSegments.begin() + aiFirstSegmentOfRow[ iTargetRow ];
+			const auto cRowEnd = m_asSegments.begin() + aiFirstSegmentOfRow[ iTargetRow + 1 ];
+
+			// First segment of the row ending within reach
+			const auto cFirstCandidate = std::lower_bound( cRowBegin, cRowEnd, iLeftmostColumn,
+				[]( const SSegment& rsCandidate, const int iColumn ) { return rsCandidate.iLastColumn < iColumn; } );
+
+			for( int iTarget = cFirstCandidate - m_asSegments.begin(); iTarget < aiFirstSegmentOfRow[ iTargetRow + 1 ]
+				&& m_asSegments[ iTarget ].iFirstColumn <= iRightmostColumn; iTarget++ )
+			{
+				const SSegment& rsTarget = m_asSegments[ iTarget ];
+				const int iRowDifference = rsTarget.iRow - rsSegment.iRow;
+
+				if( iTarget == iSegment )
+				{
+					continue;
+				}
+
+				int iFromColumn, iToColumn;
+
+				if( rsTarget.iFirstColumn > rsSegment.iLastColumn )
+				{
+					iFromColumn = rsSegment.iLastColumn;
+					iToColumn = rsTarget.iFirstColumn;
+				}
+				else if( rsTarget.iLastColumn < rsSegment.iFirstColumn )
+				{
+					iFromColumn = rsSegment.iFirstColumn;
+					iToColumn = rsTarget.iLastColumn;
+				}
+				else if( iRowDifference > 0 )
+				{
+					// Straight up to a surface overlapping this one
+					iFromColumn = std::max( rsSegment.iFirstColumn, rsTarget.iFirstColumn );
+					iToColumn = iFromColumn;
+				}
+				else
+				{
+					// Surfaces below and overlapping are reached by dropping
+					continue;
+				}
+
+				const int iGap = std::abs( iToColumn - iFromColumn ) - 1;
+
+				if( iGap > k_iMaxJumpColumns )
+				{
+					continue;
+				}
+
+				// The jump goes up to the highest of the two rows then across
+				const int iTopRow = std::max( rsSegment.iRow, rsTarget.iRow );
+
+				if( IsClear( iFromColumn, rsSegment.iRow, iFromColumn, iTopRow ) && IsClear( iFromColumn, iTopRow, iToColumn, iTopRow ) )
+				{
+					AddLink( iSegment, iTarget, EMove::Jump, iFromColumn, iToColumn,
+						k_fJumpCost + std::max( iGap, 0 ) + std::abs( iRowDifference ) );
+				}
+			}
+		}
+
+		// Climb links, to every surface touched by the climbable tiles the segment crosses
+		for( int iColumn = rsSegment.iFirstColumn; iColumn <= rsSegment.iLastColumn; iColumn++ )
+		{
+			int iLowestRow = rsSegment.iRow;
+
+			// The climbable run can start in the segment's row or go down through the floor below it
+			if( 0 != ( rcBitmap.GetTile( iColumn, iLowestRow - 1 ) & CCollisionBitmap::Climb ) )
+			{
+				while( 0 != ( rcBitmap.GetTile( iColumn, iLowestRow - 1 ) & CCollisionBitmap::Climb ) )
+				{
+					iLowestRow--;
+				}
+			}
+			else if( 0 == ( rcBitmap.GetTile( iColumn, iLowestRow ) & CCollisionBitmap::Climb ) )
+			{
+				continue;
+			}
+
+			int iHighestRow = rsSegment.iRow;
+
+			while( 0 != ( rcBitmap.GetTile( iColumn, iHighestRow + 1 ) & CCollisionBitmap::Climb ) )
+			{
+				iHighestRow++;
+			}
+
+			// The top of the run leads to the tile above it
+			for( int iRow = std::max( iLowestRow, 1 ); iRow <= std::min( iHighestRow + 1, m_iRows - 1 ); iRow++ )
+			{
+				const int iTarget = m_aiSegmentAtTile[ iRow * m_iColumns + iColumn ];
+
+				if( iTarget >= 0 && iTarget != iSegment )
+				{
+					AddLink( iSegment, iTarget, EMove::Climb, iColumn, iColumn,
+						std::abs( iRow - rsSegment.iRow ) * k_fClimbCostPerRow );
+				}
+			}
+		}
+
+		m_asSegments[ iSegment ].iAmountOfLinks = m_asLinks.size() - m_asSegments[ iSegment ].iFirstLink;
+	}
+}
+
+Vec2 CNavigationGraph::GetSurfacePosition( const int iColumn, const int iRow ) const
+{
+	return Vec2( ( iColumn + 0.5f ) * m_cTileSize.width, iRow * m_cTileSize.height );
+}
+
+int CNavigationGraph::FindSegment( const Vec2& rcPosition ) const
+{
+	if( m_aiSegmentAtTile.empty() )
+	{
+		return -1;
+	}
+
+	const int iColumn = static_cast<int>( std::floor( rcPosition.x / m_cTileSize.width ) );
+	const int iRow = static_cast<int>( std::floor( rcPosition.y / m_cTileSize.height ) );
+
+	if( iColumn < 0 || iColumn >= m_iColumns )
+	{
+		return -1;
+	}
+
+	for( int iCurrentRow = std::min( iRow, m_iRows - 1 ); iCurrentRow >= std::max( iRow - k_iMaxRowsAboveSurface, 0 ); iCurrentRow-- )
+	{
+		const int iSegment = m_aiSegmentAtTile[ iCurrentRow * m_iColumns + iColumn ];
+
+		if( iSegment >= 0 )
+		{
+			return iSegment;
+		}
+	}
+
+	return -1;
+}
+
+bool CNavigationGraph::SearchPath( const int iStartSegment, const int iStartColumn, const int iGoalSegment, std::vector<int>& raiLinks )
+{
+	const float fInfinity = std::numeric_limits<float>::infinity();
+	const SSegment& rsGoal = m_asSegments[ iGoalSegment ];
+
+	// Horizontal distance to the goal, never more than the cost of reaching it
+	auto Heuristic = [&rsGoal]( const int iColumn )
+	{
+		return static_cast<float>( std::max( 0, std::max( rsGoal.iFirstColumn - iColumn, iColumn - rsGoal.iLastColumn ) ) );
+	};
+
+	std::fill( m_afCostSoFar.begin(), m_afCostSoFar.end(), fInfinity );
+	std::fill( m_aiCameFromLink.begin(), m_aiCameFromLink.end(), -1 );
+	std::fill( m_abIsClosed.begin(), m_abIsClosed.end(), false );
+
+	// Open segments ordered by estimated total cost, lowest first
+	typedef std::pair<float, int> TOpenEntry;
+	std::priority_queue<TOpenEntry, std::vector<TOpenEntry>, std::greater<TOpenEntry>> cOpen;
+
+	m_afCostSoFar[ iStartSegment ] = 0.0f;
+	m_aiEntryColumn[ iStartSegment ] = iStartColumn;
+	cOpen.push( TOpenEntry( Heuristic( iStartColumn ), iStartSegment ) );
+
+	while( !cOpen.empty() )
+	{
+		const int iSegment = cOpen.top().second;
+		cOpen.pop();
+
+		if( m_abIsClosed[ iSegment ] )
+		{
+			continue;
+		}
+
+		m_abIsClosed[ iSegment ] = true;
+
+		if( iSegment == iGoalSegment )
+		{
+			// Walk back the links from the goal to the start
+			raiLinks.clear();
+
+			for( int iLink = m_aiCameFromLink[ iGoalSegment ]; iLink >= 0; iLink = m_aiCameFromLink[ m_asLinks[ iLink ].iSource ] )
+			{
+				raiLinks.push_back( iLink );
+			}
+
+			std::reverse( raiLinks.begin(), raiLinks.end() );
+			return true;
+		}
+
+		const SSegment& rsSegment = m_asSegments[ iSegment ];
+
+		for( int iLink = rsSegment.iFirstLink; iLink < rsSegment.iFirstLink + rsSegment.iAmountOfLinks; iLink++ )
+		{
+			const SLink& rsLink = m_asLinks[ iLink ];
+
+			if( m_abIsClosed[ rsLink.iTarget ] )
+			{
+				continue;
+			}
+
+			// Walk along the segment to the link, then follow it
+			const float fCost = m_afCostSoFar[ iSegment ] + std::abs( rsLink.iFromColumn - m_aiEntryColumn[ iSegment ] ) + rsLink.fCost;
+
+			if( fCost < m_afCostSoFar[ rsLink.iTarget ] )
+			{
+				m_afCostSoFar[ rsLink.iTarget ] = fCost;
+				m_aiCameFromLink[ rsLink.iTarget ] = iLink;
+				m_aiEntryColumn[ rsLink.iTarget ] = rsLink.iToColumn;
+				cOpen.push( TOpenEntry( fCost + Heuristic( rsLink.iToColumn ), rsLink.iTarget ) );
+			}
+		}
+	}
+
+	return false;
+}
+
+bool CNavigationGraph::FindPath( const Vec2& rcStart, const Vec2& rcGoal, std::vector<SWaypoint>& rasWaypoints )
+{
+	rasWaypoints.clear();
+
+	const int iStartSegment = FindSegment( rcStart );
+	const int iGoalSegment = FindSegment( rcGoal );
+
+	if( iStartSegment < 0 || iGoalSegment < 0 )
+	{
+		return false;
+	}
+
+	const int iStartColumn = static_cast<int>( std::floor( rcStart.x / m_cTileSize.width ) );
+
+	// The search depends on the column the path starts from, so the key holds the start tile, which also identifies the
+	// start segment, and the goal segment
+	const int iStartTile = m_asSegments[ iStartSegment ].iRow * m_iColumns + iStartColumn;
+	const uint64_t uiKey = ( static_cast<uint64_t>( static_cast<uint32_t>( iStartTile ) ) << 32 )
+		| static_cast<uint32_t>( iGoalSegment );
+	auto cCachedPath = m_cPathCache.find( uiKey );
+
+	if( m_cPathCache.end() == cCachedPath )
+	{
+		std::vector<int> aiLinks;
+
+		if( !SearchPath( iStartSegment, iStartColumn, iGoalSegment, aiLinks ) )
+		{
+			return false;
+		}
+
+		if( m_cPathCache.size() >= k_uiMaxCachedPaths )
+		{
+			ClearPathCache();
+		}
+
+		cCachedPath = m_cPathCache.emplace( uiKey, std::move( aiLinks ) ).first;
+	}
+
+	int iColumn = iStartColumn;
+
+	for( const int iLink : cCachedPath->second )
+	{
+		const SLink& rsLink = m_asLinks[ iLink ];
+
+		if( rsLink.iFromColumn != iColumn )
+		{
+			rasWaypoints.push_back( { GetSurfacePosition( rsLink.iFromColumn, m_asSegments[ rsLink.iSource ].iRow ), EMove::Walk } );
+		}
+
+		rasWaypoints.push_back( { GetSurfacePosition( rsLink.iToColumn, m_asSegments[ rsLink.iTarget ].iRow ), rsLink.eMove } );
+		iColumn = rsLink.iToColumn;
+	}
+
+	// Finish by walking to the goal along its surface
+	const SSegment& rsGoal = m_asSegments[ iGoalSegment ];
+	const int iGoalColumn = static_cast<int>( std::floor( rcGoal.x / m_cTileSize.width ) );
+	const int iClampedGoalColumn = std::min( std::max( iGoalColumn, rsGoal.iFirstColumn ), rsGoal.iLastColumn );
+
+	rasWaypoints.push_back( { GetSurfacePosition( iClampedGoalColumn, rsGoal.iRow ), EMove::Walk } );
+
+	return true;
+}
+
+void CNavigationGraph::ClearPathCache()
+{
+	m_cPathCache.clear();
+}
+
+const std::vector<CNavigationGraph::SSegment>& CNavigationGraph::GetSegments() const
+{
+	return m_asSegments;
+}
+
+const std::vector<CNavigationGraph::SLink>& CNavigationGraph::GetLinks() const
+{
+	return m_asLinks;
+}
@@ -0,0 +1,202 @@
+#ifndef NAVIGATIONGRAPH_H
+#define NAVIGATIONGRAPH_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <cocos/math/CCGeometry.h>
+
+class CCollisionBitmap;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CNavigationGraph
+// Purpose				: To give enemies precomputed adjacency between the surfaces of a level instead of probing the physics
+//						: world. The graph is baked once from the Floor and Climbable layers of the collision bitmap: every run
+//						: of free tiles standing on the floor becomes a segment, and segments are linked by the jumps, drops
+//						: and climbs that connect them. Paths are searched with A* over the segments and cached
+// Notes				: Positions are in map space, a segment's row is the row of the tiles an entity stands in
+//-----------------------------------------------------------------------------------------------------------------------------
+class CNavigationGraph
+{
+
+public:
+
+	// How an entity moves to reach a waypoint
+	enum class EMove
+	{
+		Walk,
+		Jump,
+		Drop,
+		Climb
+	};
+
+	// A point of a path and the move used to reach it
+	struct SWaypoint
+	{
+		// Position on the surface in map space
+		cocos2d::Vec2	cPosition;
+		// Move needed to reach the position from the previous waypoint
+		EMove			eMove;
+	};
+
+	// Horizontal run of free tiles standing on the floor
+	struct SSegment
+	{
+		// Row of the tiles the entity stands in
+		int				iRow;
+		// First and last column of the run
+		int				iFirstColumn;
+		int				iLastColumn;
+		// True if the side of the segment ends on a drop instead of a wall
+		bool			bIsLeftLedge;
+		bool			bIsRightLedge;
+		// Range of the segment's links in m_asLinks
+		int				iFirstLink;
+		int				iAmountOfLinks;
+	};
+
+	// Connection from a segment to another one
+	struct SLink
+	{
+		// Segment the link starts from
+		int				iSource;
+		// Segment reached by the link
+		int				iTarget;
+		// Move needed to follow the link
+		EMove			eMove;
+		// Column the link is taken from on the source segment
+		int				iFromColumn;
+		// Column reached on the target segment
+		int				iToColumn;
+		// Cost of the move, walking a tile costs 1
+		float			fCost;
+	};
+
+private:
+
+	// Size of a tile in map space
+	cocos2d::Size m_cTileSize;
+
+	// Amount of tiles along the x and y axis
+	int m_iColumns;
+	int m_iRows;
+
+	// Every surface of the level
+	std::vector<SSegment> m_asSegments;
+
+	// Links of all the segments, grouped by source segment
+	std::vector<SLink> m_asLinks;
+
+	// Segment standing in each tile, -1 if the tile is not on a surface
+	std::vector<int> m_aiSegmentAtTile;
+
+	// Segment paths found by previous queries, as the list of links to follow, keyed by start tile and goal segment
+	std::unordered_map<uint64_t, std::vector<int>> m_cPathCache;
+
+	// Scratch buffers of the A* search, kept to avoid allocating on every query
+	std::vector<float> m_afCostSoFar;
+	std::vector<int> m_aiCameFromLink;
+	std::vector<int> m_aiEntryColumn;
+	std::vector<bool> m_abIsClosed;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: BuildSegments()
+	// Parameters		: rcBitmap			- Baked environment of the level
+	// Purpose			: Find every run of free tiles standing on the floor and mark its ledges
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BuildSegments( const CCollisionBitmap& rcBitmap );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: BuildLinks()
+	// Parameters		: rcBitmap			- Baked environment of the level
+	// Purpose			: Link every segment to the segments reachable dropping from its ledges, jumping over a short gap
+	//					: or climbing the climbable tiles it touches
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BuildLinks( const CCollisionBitmap& rcBitmap );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SearchPath()
+	// Parameters		: iStartSegment		- Segment the path starts on
+	//					: iStartColumn		- Column the path starts from
+	//					: iGoalSegment		- Segment the path ends on
+	//					: raiLinks			- Filled with the links to follow, in order
+	// Purpose			: A* search over the segments, walking along a segment costs the columns crossed
+	// Returns			: False if the goal cannot be reached
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool SearchPath( const int iStartSegment, const int iStartColumn, const int iGoalSegment, std::vector<int>& raiLinks );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetSurfacePosition()
+	// Parameters		: iColumn			- Column of the tile
+	//					: iRow				- Row of the tile the entity stands in
+	// Returns			: The point at the bottom centre of the tile in map space
+	//-----------------------------------------------------------------------------------------------------------------------------
+	cocos2d::Vec2 GetSurfacePosition( const int iColumn, const int iRow ) const;
+
+public:
+
+	// Highest amount of rows a jump link can climb
+	static const int k_iMaxJumpRows = 2;
+
+	// Widest gap in columns a jump link can cross
+	static const int k_iMaxJumpColumns = 3;
+
+	// Highest amount of rows a drop link can fall
+	static const int k_iMaxDropRows = 8;
+
+	// Amount of paths kept in the cache before it is cleared
+	static const unsigned int k_uiMaxCachedPaths = 256;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CNavigationGraph()
+	// Purpose			: Create an empty graph
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CNavigationGraph();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Bake()
+	// Parameters		: rcBitmap			- Baked environment of the level
+	// Purpose			: Build the segments and their links from the Floor and Climbable layers, clearing the path cache
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Bake( const CCollisionBitmap& rcBitmap );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: FindSegment()
+	// Parameters		: rcPosition		- Position of the feet of an entity in map space
+	// Purpose			: Find the surface the entity stands on, looking a couple of rows below for entities in the air
+	// Returns			: The index of the segment or -1 if no surface is close
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int FindSegment( const cocos2d::Vec2& rcPosition ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: FindPath()
+	// Parameters		: rcStart			- Position of the feet of the entity in map space
+	//					: rcGoal			- Position to reach in map space
+	//					: rasWaypoints		- Filled with the waypoints to follow, the last one being the goal
+	// Purpose			: Find a path between the surfaces of the two positions, reusing the cached segment path if a query
+	//					: has already started from the same tile towards the same surface
+	// Returns			: False if either position is not on a surface or the goal cannot be reached
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool FindPath( const cocos2d::Vec2& rcStart, const cocos2d::Vec2& rcGoal, std::vector<SWaypoint>& rasWaypoints );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ClearPathCache()
+	// Purpose			: Forget the cached paths
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ClearPathCache();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetSegments()
+	// Returns			: Every surface of the level
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const std::vector<SSegment>& GetSegments() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetLinks()
+	// Returns			: The links of all the segments, a segment's links are in [ iFirstLink, iFirstLink + iAmountOfLinks )
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const std::vector<SLink>& GetLinks() const;
+};
+
+#endif // !NAVIGATIONGRAPH_H
@@ -0,0 +1,164 @@
+#include "PerformanceOverlay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+
+#include <cocos/2d/CCDrawNode.h>
+#include <cocos/2d/CCLabel.h>
+#include <cocos/renderer/CCRenderer.h>
+
+#include "LevelManager.h"
+
+using cocos2d::Color4F;
+using cocos2d::Vec2;
+
+// Size of the graph in points and the frame time reaching its top
+static const float k_fGraphWidth = 240.0f;
+static const float k_fGraphHeight = 60.0f;
+static const float k_fGraphMaxMs = 50.0f;
+
+// Frame budgets drawn on the graph
+static const float k_f60FPSMs = 1000.0f / 60.0f;
+static const float k_f30FPSMs = 1000.0f / 30.0f;
+
+CPerformanceOverlay::CPerformanceOverlay()
+	: m_pcLevelManager( nullptr )
+	, m_pcLabel( nullptr )
+	, m_pcGraph( nullptr )
+	, m_iNextFrameTime( 0 )
+	, m_iFramesBeforeRefresh( 0 )
+{}
+
+CPerformanceOverlay* CPerformanceOverlay::create( const CLevelManager* pcLevelManager )
+{
+	CPerformanceOverlay* pcOverlay = new ( std::nothrow ) CPerformanceOverlay();
+
+	if( nullptr != pcOverlay && pcOverlay->init( pcLevelManager ) )
+	{
+		pcOverlay->autorelease();
+		return pcOverlay;
+	}
+
+	CC_SAFE_DELETE( pcOverlay );
+	return nullptr;
+}
+
+bool CPerformanceOverlay::init( const CLevelManager* pcLevelManager )
+{
+	if( !Node::init() )
+	{
+		return false;
+	}
+
+	CCASSERT( nullptr != pcLevelManager, "Level manager is null" );
+	m_pcLevelManager = pcLevelManager;
+
+	m_afFrameTimes.assign( k_iGraphFrames, 0.0f );
+
+	// Graph at the bottom left corner of the overlay, text right above it
+	m_pcGraph = cocos2d::DrawNode::create();
+	addChild( m_pcGraph );
+
+	m_pcLabel = cocos2d::Label::createWithSystemFont( "", "Arial", 12.0f );
+	m_pcLabel->setAnchorPoint( Vec2( 0.0f, 0.0f ) );
+	m_pcLabel->setPosition( Vec2( 0.0f, k_fGraphHeight + 4.0f ) );
+	addChild( m_pcLabel );
+
+	// Hidden until toggled by the tester
+	setVisible( false );
+
+	return true;
+}
+
+void CPerformanceOverlay::update( float fDeltaTime )
+{
+	m_afFrameTimes[ m_iNextFrameTime ] = fDeltaTime * 1000.0f;
+	m_iNextFrameTime = ( m_iNextFrameTime + 1 ) % k_iGraphFrames;
+
+	DrawGraph();
+
+	// Rebuilding the label's glyphs every frame would show up in the numbers it displays
+	if( --m_iFramesBeforeRefresh <= 0 )
+	{
+		RefreshText();
+		m_iFramesBeforeRefresh = k_iRefreshFrames;
+	}
+}
+
+void CPerformanceOverlay::Toggle()
+{
+	if( isVisible() )
+	{
+		setVisible( false );
+		unscheduleUpdate();
+	}
+	else
+	{
+		setVisible( true );
+		m_iFramesBeforeRefresh = 0;
+		scheduleUpdate();
+	}
+}
+
+void CPerformanceOverlay::RefreshText()
+{
+	CLevelManager::SLevelStats sStats;
+	m_pcLevelManager->GetStats( sStats );
+
+	const int iLastFrame = ( m_iNextFrameTime + k_iGraphFrames - 1 ) % k_iGraphFrames;
+	const float fWorstFrame = *std::max_element( m_afFrameTimes.begin(), m_afFrameTimes.end() );
+
+	// A level simulated without rendering draws nothing
+	const cocos2d::Renderer* pcRenderer = m_pcLevelManager->GetContext()->GetRenderer();
+	const int iDrawCalls = ( nullptr != pcRenderer ) ? static_cast<int>( pcRenderer->getDrawnBatches() ) : 0;
+
+	char szText[ 512 ];
+	snprintf( szText, sizeof( szText ),
+		"Frame %.2f ms (worst %.2f)\n"
+		"Level update %.3f ms   Physics step %.3f ms\n"
+		"Shapes: environment %d   entities %d   created %d\n"
+		"Active: platforms %d   ports %d   enemies %d   pickups %d\n"
+		"Animated sprites %d   frame changes %d\n"
+		"Enemies %.3f ms: full rate %d   reduced %d   frozen %d\n"
+		"Simulation thread %.3f ms   waited %.3f ms\n"
+		"Draw calls %d\n"
+		"Stage transition %.2f ms   Reset %.2f ms",
+		m_afFrameTimes[ iLastFrame ], fWorstFrame,
+		sStats.fUpdateMs, sStats.fPhysicsMs,
+		sStats.iEnvironmentShapes, sStats.iEntityShapes, sStats.iCreatedShapes,
+		sStats.iActivePlatforms, sStats.iActivePorts, sStats.iActiveEnemies, sStats.iActivePickups,
+		sStats.iAnimatedSprites, sStats.iFrameChanges,
+		sStats.fEnemiesMs, sStats.iFullRateEnemies, sStats.iReducedRateEnemies, sStats.iFrozenEnemies,
+		sStats.fSimulationMs, sStats.fSimulationWaitMs,
+		iDrawCalls,
+		sStats.fStageTransitionMs, sStats.fResetMs );
+
+	m_pcLabel->setString( szText );
+}
+
+void CPerformanceOverlay::DrawGraph()
+{
+	m_pcGraph->clear();
+
+	// Background
+	m_pcGraph->drawSolidRect( Vec2::ZERO, Vec2( k_fGraphWidth, k_fGraphHeight ), Color4F( 0.0f, 0.0f, 0.0f, 0.5f ) );
+
+	const float fBarWidth = k_fGraphWidth / k_iGraphFrames;
+	const float fScale = k_fGraphHeight / k_fGraphMaxMs;
+
+	// Oldest frame on the left
+	for( int i = 0; i < k_iGraphFrames; i++ )
+	{
+		const float fFrameTime = m_afFrameTimes[ ( m_iNextFrameTime + i ) % k_iGraphFrames ];
+		const float fHeight = std::min( fFrameTime, k_fGraphMaxMs ) * fScale;
+
+		const Color4F& rcColour = ( fFrameTime > k_f30FPSMs ) ? Color4F::RED
+			: ( fFrameTime > k_f60FPSMs ) ? Color4F::YELLOW : Color4F::GREEN;
+
+		m_pcGraph->drawSolidRect( Vec2( i * fBarWidth, 0.0f ), Vec2( ( i + 1 ) * fBarWidth, fHeight ), rcColour );
+	}
+
+	m_pcGraph->drawLine( Vec2( 0.0f, k_f60FPSMs * fScale ), Vec2( k_fGraphWidth, k_f60FPSMs * fScale ), Color4F::WHITE );
+	m_pcGraph->drawLine( Vec2( 0.0f, k_f30FPSMs * fScale ), Vec2( k_fGraphWidth, k_f30FPSMs * fScale ), Color4F::GRAY );
+}
@@ -0,0 +1,102 @@
+#ifndef PERFORMANCEOVERLAY_H
+#define PERFORMANCEOVERLAY_H
+
+#include <vector>
+
+#include <cocos/2d/CCNode.h>
+
+class CLevelManager;
+
+namespace cocos2d
+{
+	class DrawNode;
+	class Label;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CPerformanceOverlay
+// Classes Inherited	: Node
+// Purpose				: To show testers the costs of the level on the device without a profiler: update and physics times,
+//						: the shapes and the active entities of every pool, the draw calls, the last stage transition and
+//						: reset durations and a rolling graph of the frame times
+// Notes				: Add it to the scene above the game layers and call Toggle() from a debug key. The physics time is
+//						: only measured if the scene steps its physics world through CLevelManager::StepPhysics()
+//-----------------------------------------------------------------------------------------------------------------------------
+class CPerformanceOverlay : public cocos2d::Node
+{
+
+private:
+
+	// Level whose costs are shown
+	const CLevelManager* m_pcLevelManager;
+
+	// Text of the counters
+	cocos2d::Label* m_pcLabel;
+
+	// Frame time graph
+	cocos2d::DrawNode* m_pcGraph;
+
+	// Frame times in milliseconds, used as a ring buffer
+	std::vector<float> m_afFrameTimes;
+
+	// Index of the next frame time to write
+	int m_iNextFrameTime;
+
+	// Frames left before the text is refreshed, the graph is redrawn every frame
+	int m_iFramesBeforeRefresh;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: RefreshText()
+	// Purpose			: Write the latest stats of the level in the label
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void RefreshText();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: DrawGraph()
+	// Purpose			: Draw one bar per stored frame time, with lines at the 60 and 30 frames per second budgets
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void DrawGraph();
+
+public:
+
+	// Amount of frames shown by the graph
+	static const int k_iGraphFrames = 120;
+
+	// Amount of frames between two refreshes of the text
+	static const int k_iRefreshFrames = 10;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: create()
+	// Parameters		: pcLevelManager	- Level whose costs are shown
+	// Purpose			: Create a hidden overlay, the usual cocos2d-x factory
+	// Returns			: An autoreleased overlay, nullptr on failure
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CPerformanceOverlay* create( const CLevelManager* pcLevelManager );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: init()
+	// Parameters		: pcLevelManager	- Level whose costs are shown
+	// Purpose			: Create the label and the graph
+	// Returns			: False if the node could not be initialised
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool init( const CLevelManager* pcLevelManager );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: update()
+	// Parameters		: fDeltaTime		- Time passed since the last frame
+	// Purpose			: Store the frame time, redraw the graph and refresh the text when it is due
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void update( float fDeltaTime ) override;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Toggle()
+	// Purpose			: Show or hide the overlay, a hidden overlay is not updated
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Toggle();
+
+protected:
+
+	CPerformanceOverlay();
+};
+
+#endif // !PERFORMANCEOVERLAY_H
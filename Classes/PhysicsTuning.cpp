@@ -0,0 +1,116 @@
+#include "PhysicsTuning.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <chipmunk/chipmunk.h>
+#include <cocos/math/CCGeometry.h>
+#include <cocos/physics/CCPhysicsBody.h>
+
+#include "ShapePool.h"
+
+namespace PhysicsTuning
+{
+	// Below this amount of shapes the tree's queries are cheap enough whatever the level looks like
+	static const int k_iMinShapesForHash = 256;
+
+	// Largest standard deviation of the shape sizes, relative to their mean, for which a single cell size fits the level
+	static const float k_fMaxSizeVariation = 1.0f;
+
+	// Cells per shape in the hash, Chipmunk advises about ten to keep the buckets short
+	static const int k_iCellsPerShape = 10;
+	static const int k_iMinHashCells = 1000;
+
+	// Solver iterations, at most Chipmunk's default, one more than the least for every few dynamic shapes and for every
+	// many environment shapes they may touch
+	static const int k_iMinIterations = 5;
+	static const int k_iMaxIterations = 10;
+	static const int k_iDynamicShapesPerIteration = 8;
+	static const int k_iStaticShapesPerIteration = 64;
+
+	SShapeStats::SShapeStats()
+		: iShapes( 0 )
+		, fSumSize( 0.0f )
+		, fSumSquaredSize( 0.0f )
+		, fMaxSize( 0.0f )
+	{}
+
+	void SShapeStats::AddBox( const cocos2d::Size& rcSize )
+	{
+		const float fSize = std::max( rcSize.width, rcSize.height );
+
+		iShapes++;
+		fSumSize += fSize;
+		fSumSquaredSize += fSize * fSize;
+		fMaxSize = std::max( fMaxSize, fSize );
+	}
+
+	float SShapeStats::GetMeanSize() const
+	{
+		return ( iShapes > 0 ) ? fSumSize / iShapes : 0.0f;
+	}
+
+	float SShapeStats::GetSizeDeviation() const
+	{
+		if( iShapes <= 0 )
+		{
+			return 0.0f;
+		}
+
+		const float fMean = GetMeanSize();
+		return sqrtf( std::max( 0.0f, fSumSquaredSize / iShapes - fMean * fMean ) );
+	}
+
+	SSettings Derive( const SShapeStats& rsStaticShapes, const int iDynamicShapes )
+	{
+		SSettings sSettings;
+
+		const float fMean = rsStaticShapes.GetMeanSize();
+		const float fDeviation = rsStaticShapes.GetSizeDeviation();
+		const int iShapes = rsStaticShapes.iShapes + iDynamicShapes;
+
+		// A hash only pays off with many shapes of similar size, a long shape would be added to every cell it covers
+		sSettings.bUseSpatialHash = ( iShapes >= k_iMinShapesForHash ) && ( fMean > 0.0f )
+			&& ( fDeviation <= fMean * k_fMaxSizeVariation );
+
+		// Cells fit most shapes so that each one is added to a few cells only
+		sSettings.fCellSize = fMean + fDeviation;
+		sSettings.iHashCells = std::max( k_iMinHashCells, iShapes * k_iCellsPerShape );
+
+		sSettings.iIterations = std::min( k_iMaxIterations, k_iMinIterations + iDynamicShapes / k_iDynamicShapesPerIteration
+			+ rsStaticShapes.iShapes / k_iStaticShapesPerIteration );
+
+		return sSettings;
+	}
+
+	bool Apply( const SSettings& rsSettings, cocos2d::PhysicsBody* pcContainer )
+	{
+		// Neither the world nor a static body expose the space, the shapes of the container know it once it is added
+		cpSpace* pSpace = nullptr;
+
+		for( cocos2d::PhysicsShape* pcShape : pcContainer->getShapes() )
+		{
+			const CResizableBoxShape* pcBox = dynamic_cast<CResizableBoxShape*>( pcShape );
+
+			if( nullptr != pcBox )
+			{
+				pSpace = pcBox->GetSpace();
+				break;
+			}
+		}
+
+		if( nullptr == pSpace )
+		{
+			return false;
+		}
+
+		if( rsSettings.bUseSpatialHash )
+		{
+			cpSpaceUseSpatialHash( pSpace, rsSettings.fCellSize, rsSettings.iHashCells );
+		}
+
+		cpSpaceSetIterations( pSpace, rsSettings.iIterations );
+
+		return true;
+	}
+}
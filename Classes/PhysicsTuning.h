@@ -0,0 +1,77 @@
+#ifndef PHYSICSTUNING_H
+#define PHYSICSTUNING_H
+
+namespace cocos2d
+{
+	class PhysicsBody;
+	class Size;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Namespace Name		: PhysicsTuning
+// Purpose				: To pick the broadphase and the solver iterations of a level's physics world from the shapes the level
+//						: creates, instead of running every level with Chipmunk's defaults. A level whose static shapes
+//						: are many and of similar size is indexed by a spatial hash with cells fitting those shapes, other
+//						: levels keep the bounding box tree. Levels with few shapes, and so few contacts, solve them with
+//						: fewer iterations than Chipmunk's default of 10
+// Notes				: The settings are applied to the Chipmunk space once the level's bodies are in the world
+//-----------------------------------------------------------------------------------------------------------------------------
+namespace PhysicsTuning
+{
+	// Size distribution of the shapes of a level, gathered as they are created
+	struct SShapeStats
+	{
+		int		iShapes;
+		// Sum and sum of the squares of the longest side of every shape, in points
+		float	fSumSize;
+		float	fSumSquaredSize;
+		// Longest side of the biggest shape
+		float	fMaxSize;
+
+		SShapeStats();
+
+		//-----------------------------------------------------------------------------------------------------------------------------
+		// Function Name	: AddBox()
+		// Parameters		: rcSize			- Size of the box shape
+		//-----------------------------------------------------------------------------------------------------------------------------
+		void AddBox( const cocos2d::Size& rcSize );
+
+		//-----------------------------------------------------------------------------------------------------------------------------
+		// Function Name	: Getters
+		// Purpose			: Mean and standard deviation of the longest side of the shapes, 0 without shapes
+		//-----------------------------------------------------------------------------------------------------------------------------
+		float GetMeanSize() const;
+		float GetSizeDeviation() const;
+	};
+
+	// Broadphase and solver settings of a physics world
+	struct SSettings
+	{
+		// Spatial hash instead of the default bounding box tree
+		bool	bUseSpatialHash;
+		// Side of a cell and amount of cells of the spatial hash
+		float	fCellSize;
+		int		iHashCells;
+		// Iterations of the contact solver
+		int		iIterations;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Derive()
+	// Parameters		: rsStaticShapes	- Shapes of the level's environment
+	//					: iDynamicShapes	- Shapes of the other bodies in the world
+	// Returns			: The settings fitting the level
+	//-----------------------------------------------------------------------------------------------------------------------------
+	SSettings Derive( const SShapeStats& rsStaticShapes, const int iDynamicShapes );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Apply()
+	// Parameters		: rsSettings		- Settings to use
+	//					: pcContainer		- Static body holding the level's environment shapes
+	// Purpose			: Switch the space of the container's shapes to the settings' broadphase and solver iterations
+	// Returns			: False if the container is not in a physics world yet, the space cannot be reached before
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Apply( const SSettings& rsSettings, cocos2d::PhysicsBody* pcContainer );
+}
+
+#endif // !PHYSICSTUNING_H
@@ -3,6 +3,8 @@
 
 
 #include "Collider.h"
+#include "CollisionMatrix.h"
+#include "ShapePool.h"
 #include "SpriteObject.h"
 
 #include <CCValue.h>
@@ -24,10 +26,12 @@ protected:
 
 	// Collider of the platform
 	cocos2d::PhysicsBody* m_pcCollider;
-	// Shape of the platform collider
-	cocos2d::PhysicsShapeBox* m_pcBoxShape;
+	// Shape of the platform collider, resized when the platform is initialised again
+	CResizableBoxShape* m_pcBoxShape;
 	// Platform can be triggered or not
 	bool m_bCanBeTriggered;
+	// Category of the platform's shapes in the collision matrix
+	CollisionMatrix::ECategory m_eCollisionCategory;
 
 public:
 
@@ -65,11 +69,27 @@ public:
 	//-----------------------------------------------------------------------------------------------------------------------------
 	void SetID( const int iID );
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: SetCollisionCategory()
+	// Parameters		: eCategory			- Category of the platform in the collision matrix
+	// Purpose			: Store the category used for the shapes created later and apply its bitmasks to the existing ones
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetCollisionCategory( const CollisionMatrix::ECategory eCategory );
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function name	: Reset()
 	// Purpose			: Empty method, it has to be defined by children classes
 	//-----------------------------------------------------------------------------------------------------------------------------
 	virtual void Reset();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: VSimulate()
+	// Parameters		: fDeltaTime		- Time since the last frame
+	// Purpose			: Empty method, children classes compute their state for the frame here. It runs on the job system
+	//					: alongside the other platforms, so it only touches the platform's own members and calls no
+	//					: cocos2d-x method, VUpdate() applies the result to the node and the body afterwards
+	//-----------------------------------------------------------------------------------------------------------------------------
+	virtual void VSimulate( float fDeltaTime );
 };
 
 #endif // !PLATFORMBASE_H
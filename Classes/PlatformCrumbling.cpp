@@ -1,93 +1,127 @@
-#include "PlatformCrumbling.h"
-
-#include "cocos/2d/CCActionInterval.h"
-#include "cocos/2d/CCActionInstant.h"
-
-#include "Settings.h"
-#include "TextureManager.h"
-
-using cocos2d::Vec2;
-using cocos2d::ValueMap;
-
-
-CPlatformCrumbling::CPlatformCrumbling( CTextureManager& rcTextureManager, const int iID )
-	: CPlatformBase( iID )
-	, v2StartingPos( Vec2::ZERO )
-{
-	// Initialise the platform's sprite
-	CreateSprite( rcTextureManager.GetTexture( EGameTextures::Platform ), false );
-}
-
-CPlatformCrumbling::~CPlatformCrumbling() {}
-
-void CPlatformCrumbling::Initialise( const ValueMap& rcObjectValues )
-{
-	// Call base class initialisation
-	CPlatformBase::Initialise( rcObjectValues );
-
-	// Store the values from the paramters
-	float fHeight = rcObjectValues.at( "height" ).asFloat();
-	float fWidth = rcObjectValues.at( "width" ).asFloat();
-
-	// Rescale the size of the platform to match the one specified by the object's values
-	setScaleX( fWidth / getContentSize().width );
-	setScaleY( fHeight / getContentSize().height );
-
-	// Create a physics shape if not preset
-	if( nullptr == m_pcCollider->getShape( 0 ) )
-	{
-		// Create physics shape of the platform size 
-		m_pcBoxShape = cocos2d::PhysicsShapeBox::create( getContentSize(), cocos2d::PhysicsMaterial( 1.0, 0.0, 1.0 ),
-			getContentSize() * 0.5f );
-		m_pcCollider->addShape( m_pcBoxShape, false );
-
-		// Set shape to collide with player
-		m_pcBoxShape->setCategoryBitmask( PLATFORM_BITMASK_CATEGORY );
-		m_pcBoxShape->setCollisionBitmask( PLATFORM_BITMASK_COLLIDER );
-		m_pcBoxShape->setContactTestBitmask( PLATFORM_BITMASK_CONTACT );
-	}
-
-	// Store the starting position
-	v2StartingPos = getPosition();
-
-	// Reset the platform for precaution
-	Reset();
-}
-
-void CPlatformCrumbling::VCollisionResponse()
-{
-
-	// Activate the response once until platform get re-initialised
-	if( m_bCanBeTriggered )
-	{
-		// Move the platform down half of its height in 1 second
-		cocos2d::MoveBy* pcMoveBy = cocos2d::MoveBy::create( 1.0f, Vec2( 0, -m_pcBoxShape->getSize().height * 0.25f ) );
-		// Fade out the platform's sprite over 1 second
-		cocos2d::FadeOut* pcFadeOut = cocos2d::FadeOut::create( 1.0f );
-		// Disable collider, 
-		cocos2d::CallFunc* pcDisable = cocos2d::CallFunc::create( [&]() { m_pcCollider->setEnabled( false ); } );
-		// Move and fade simultaneously
-		cocos2d::Spawn* pcSpawn = cocos2d::Spawn::createWithTwoActions( pcMoveBy, pcFadeOut );
-		// Perform spawn first then disable
-		cocos2d::Sequence* pcSequence = cocos2d::Sequence::create( pcSpawn, pcDisable, nullptr );
-		runAction( pcSequence );
-		// Cannot be triggered again
-		m_bCanBeTriggered = false;
-
-	}
-
-}
-
-void CPlatformCrumbling::Reset()
-{
-	this->stopAllActions();
-
-	// Set position to the one specified originally in initialisation
-	setPosition( v2StartingPos );
-	// Platform can be triggered again
-	m_bCanBeTriggered = true;
-	// Enable the collider
-	m_pcCollider->setEnabled( true );
-	// Set opacity to max to make che platform visible
-	setOpacity( 255 );
-}
+#include "PlatformCrumbling.h"
+
+#include <algorithm>
+
+#include "Settings.h"
+#include "TextureManager.h"
+
+using cocos2d::Vec2;
+using cocos2d::ValueMap;
+
+constexpr float CPlatformCrumbling::k_fCrumbleDuration;
+
+CPlatformCrumbling::CPlatformCrumbling( CTextureManager& rcTextureManager, const int iID )
+	: CPlatformBase( iID )
+	, v2StartingPos( Vec2::ZERO )
+	, m_fCrumbleDepth( 0.0f )
+	, m_fCrumbleTime( 0.0f )
+	, m_fCrumbleProgress( 0.0f )
+	, m_bIsCrumbling( false )
+{
+	// Initialise the platform's sprite
+	CreateSprite( rcTextureManager.GetTexture( EGameTextures::Platform ), false );
+}
+
+CPlatformCrumbling::~CPlatformCrumbling() {}
+
+void CPlatformCrumbling::Initialise( const ValueMap& rcObjectValues )
+{
+	// Call base class initialisation
+	CPlatformBase::Initialise( rcObjectValues );
+
+	// Store the values from the paramters
+	float fHeight = rcObjectValues.at( "height" ).asFloat();
+	float fWidth = rcObjectValues.at( "width" ).asFloat();
+
+	// Rescale the size of the platform to match the one specified by the object's values
+	setScaleX( fWidth / getContentSize().width );
+	setScaleY( fHeight / getContentSize().height );
+
+	// Create a physics shape if not preset
+	if( nullptr == m_pcCollider->getShape( 0 ) )
+	{
+		// Create physics shape of the platform size 
+		m_pcBoxShape = CResizableBoxShape::create( getContentSize(), cocos2d::PhysicsMaterial( 1.0, 0.0, 1.0 ),
+			getContentSize() * 0.5f );
+		m_pcCollider->addShape( m_pcBoxShape, false );
+
+		// Set shape to collide with player
+		CollisionMatrix::ApplyFilter( m_pcBoxShape, m_eCollisionCategory );
+	}
+	else
+	{
+		// The pooled platform keeps its shape from the previous stage, fit it to the platform again
+		m_pcBoxShape->Resize( getContentSize(), getContentSize() * 0.5f );
+	}
+
+	// Store the starting position
+	v2StartingPos = getPosition();
+
+	// Reset the platform for precaution
+	Reset();
+}
+
+void CPlatformCrumbling::VCollisionResponse()
+{
+
+	// Activate the response once until platform get re-initialised
+	if( m_bCanBeTriggered )
+	{
+		// Move the platform down a quarter of its height while fading it out, VSimulate() and VUpdate() do the rest
+		m_fCrumbleDepth = m_pcBoxShape->getSize().height * 0.25f;
+		m_fCrumbleTime = 0.0f;
+		m_fCrumbleProgress = 0.0f;
+		m_bIsCrumbling = true;
+		// Cannot be triggered again
+		m_bCanBeTriggered = false;
+
+	}
+
+}
+
+void CPlatformCrumbling::VSimulate( float fDeltaTime )
+{
+	if( !m_bIsCrumbling )
+	{
+		return;
+	}
+
+	m_fCrumbleTime = std::min( m_fCrumbleTime + fDeltaTime, k_fCrumbleDuration );
+	m_fCrumbleProgress = m_fCrumbleTime / k_fCrumbleDuration;
+}
+
+void CPlatformCrumbling::VUpdate( float )
+{
+	if( !m_bIsCrumbling )
+	{
+		return;
+	}
+
+	// Move and fade simultaneously
+	setPosition( v2StartingPos.x, v2StartingPos.y - ( m_fCrumbleDepth * m_fCrumbleProgress ) );
+	setOpacity( static_cast<GLubyte>( 255.0f * ( 1.0f - m_fCrumbleProgress ) ) );
+
+	// Disable the collider once the platform has disappeared
+	if( m_fCrumbleProgress >= 1.0f )
+	{
+		m_pcCollider->setEnabled( false );
+		m_bIsCrumbling = false;
+	}
+}
+
+void CPlatformCrumbling::Reset()
+{
+	// Stop crumbling
+	m_bIsCrumbling = false;
+	m_fCrumbleTime = 0.0f;
+	m_fCrumbleProgress = 0.0f;
+
+	// Set position to the one specified originally in initialisation
+	setPosition( v2StartingPos );
+	// Platform can be triggered again
+	m_bCanBeTriggered = true;
+	// Enable the collider
+	m_pcCollider->setEnabled( true );
+	// Set opacity to max to make che platform visible
+	setOpacity( 255 );
+}
@@ -18,6 +18,18 @@ private:
 	// Starting position in the room in case the platform needs to be regenerated
 	cocos2d::Vec2 v2StartingPos;
 
+	// Seconds the platform takes to lower and fade out once triggered
+	static constexpr float k_fCrumbleDuration = 1.0f;
+
+	// Distance the platform lowers while crumbling, taken from the shape when triggered
+	float m_fCrumbleDepth;
+	// Seconds since the platform was triggered
+	float m_fCrumbleTime;
+	// Part of the crumble done, computed by VSimulate() and applied by VUpdate()
+	float m_fCrumbleProgress;
+	// The platform is lowering and fading out
+	bool m_bIsCrumbling;
+
 public:
 
 	//-----------------------------------------------------------------------------------------------------------------------------
@@ -45,10 +57,24 @@ public:
 
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function name	: VCollisionResponse()
-	// Purpose			: Lowers the platform and disable its collider after 1 second
+	// Purpose			: Starts lowering the platform, its collider is disabled after 1 second
 	//-----------------------------------------------------------------------------------------------------------------------------
 	void VCollisionResponse() override;
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: VSimulate()
+	// Parameters		: fDeltaTime		- Time since the last frame
+	// Purpose			: Advance the crumble timer and compute how far the platform has lowered and faded
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void VSimulate( float fDeltaTime ) override;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function name	: VUpdate()
+	// Parameters		: fDeltaTime		- Time since the last frame
+	// Purpose			: Move and fade the sprite as computed by VSimulate(), disable the collider once the crumble is done
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void VUpdate( float fDeltaTime ) override;
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function name	: Reset()
 	// Purpose			: This function will reset the platform to its original position and state
@@ -1,174 +1,273 @@
-#include "Port.h"
-
-#include <AudioEngine.h>
-#include <CCEventCustom.h>
-#include <CCEventDispatcher.h>
-
-#include "TextureManager.h"
-#include "Settings.h"
-
-using cocos2d::Vec2;
-using cocos2d::PhysicsShapeBox;
-
-CPort::CPort( CTextureManager& rcTextureManager, const int iID )
-	: m_pcCollider( nullptr )
-	, m_pcTextureManager( rcTextureManager )
-	, m_IsFilling( false )
-	, m_IsPlaced( false )
-	, m_fLoadingTimeInSeconds( 2.0 )
-	, m_iAudioID( 0 )
-	, m_pcStandingZone( nullptr )
-{
-
-	// Initialise the port's sprite using the texture manager
-	CreateSprite( m_pcTextureManager.GetTexture( EGameTextures::Port ), true, 1, 2 );
-
-	// Create an empty sprite for the standing zone 
-	m_pcStandingZone = new CSpriteObject();
-
-	// Create port collider
-	m_pcCollider = cocos2d::PhysicsBody::create();
-	m_pcCollider->setDynamic( false );
-	addComponent( m_pcCollider );
-
-	// Setting the name of the platform with its ID, used for collision management
-	m_pcCollider->setName( "Port " + std::to_string( iID ) );
-
-	// Create a loading bar that will be used as visual timer for port placement
-	m_pcLoadingBar = cocos2d::ui::LoadingBar::create( "MP_Meter2.png" );
-	m_pcLoadingBar->setScale( 0.06f );
-	// Set bar's filling direction from left to right
-	m_pcLoadingBar->setDirection( cocos2d::ui::LoadingBar::Direction::LEFT );
-	// Position the bar a bit higher than the port sprite
-	m_pcLoadingBar->setPosition( Vec2( 0.0f, getContentSize().height ) );
-	m_pcLoadingBar->setAnchorPoint( Vec2( 0.25f, 0 ) );
-
-	setVisible( false );
-
-	addChild( m_pcLoadingBar );
-}
-
-CPort::~CPort() {}
-
-void CPort::Initialise( const cocos2d::Value& rcTiledObject )
-{
-	const cocos2d::ValueMap& rcObjectValues = rcTiledObject.asValueMap();
-
-	CCASSERT( !rcObjectValues.empty(), "No values in the tiled object" );
-
-	if( m_pcCollider->getShape( 0 ) == nullptr )
-	{
-		// Copy the tiled object's size to a variable
-		Vec2 cObjectSize = Vec2( rcObjectValues.at( "width" ).asFloat(), rcObjectValues.at( "height" ).asFloat() );
-
-		// Storing a negative offset on the y axis
-		Vec2 cColliderOffsetFromSprite = Vec2( 0.0f, -16.0f );
-		// Create physics shape of the object size placed lower than the port itself
-		PhysicsShapeBox* pcBoxShape = PhysicsShapeBox::create( cocos2d::Size( cObjectSize ), 
-			cocos2d::PhysicsMaterial( 1.0, 0.0, 1.0 ), cColliderOffsetFromSprite );
-		m_pcCollider->addShape( pcBoxShape, false );
-
-		pcBoxShape->setCategoryBitmask( TRIGGER_BITMASK_CATEGORY );
-		pcBoxShape->setCollisionBitmask( TRIGGER_BITMASK_COLLIDER );
-		pcBoxShape->setContactTestBitmask( TRIGGER_BITMASK_CONTACT );
-
-		// Create a sprite for the standing zone
-		m_pcStandingZone->CreateSprite( m_pcTextureManager.GetTexture( EGameTextures::PortStandingZone ), false );
-		// Making the standing zone's sprite a bit transparent
-		m_pcStandingZone->setOpacity( 170 );
-		// Scale it to the size of the actual trigger physics shape and place it at the same position
-		m_pcStandingZone->setScaleX( cObjectSize.x / m_pcStandingZone->getContentSize().width );
-		m_pcStandingZone->setScaleY( 1.0f / 16.0 );
-		m_pcStandingZone->setPosition( -Vec2( getContentSize().width * getScaleX() * 0.10f, 10.0f ) );
-
-		addChild( m_pcStandingZone );
-
-	}
-
-	// Position the port in the coordinates given by the tiled object
-	float fOffsetCorrectionX = rcObjectValues.at( "x" ).asFloat();
-	float fOffsetCorrectionY = rcObjectValues.at( "y" ).asFloat() + rcObjectValues.at( "height" ).asFloat() * 0.5f;
-	setPosition( fOffsetCorrectionX, fOffsetCorrectionY );
-
-	Reset();
-}
-
-
-void CPort::VTriggerResponse()
-{
-	// If the port is placed do nothing
-	if( !m_IsPlaced )
-	{
-		// If the port is not placed and the loading bar is not filling
-		if( !m_IsFilling )
-		{
-			if( Audio::k_iAudioEnabled )
-			{
-				m_iAudioID = cocos2d::AudioEngine::play2d( "/Audio/turbolift_05.ogg", false, 0.9f );
-			}
-
-			// Schedule the filling function to fill the bar over x amount of seconds
-			this->schedule( [=]( float delta ){
-
-				// Retrieve and update the loading bar percentage
-				float percent = m_pcLoadingBar->getPercent();
-				percent++;
-				m_pcLoadingBar->setPercent( percent );
-				
-				// If the bar is fully filled
-				if( percent >= 100.0f )
-				{
-					// Bar is now placed
-					m_IsPlaced = !m_IsPlaced;
-
-					// Create and send an event to acknowledge the activation
-					cocos2d::EventCustom portActivated( "Port_Activated" );
-					_eventDispatcher->dispatchEvent( &portActivated );
-
-					// Create and send an event to acknowledge the usage of chip
-					cocos2d::EventCustom chipUsed( "Chip_Used" );
-					_eventDispatcher->dispatchEvent( &chipUsed );
-
-					// Set the animation state of the port to on | Nikodem Hamrol
-					SetAnimationState( GetSpriteFrameHeight(), false, 0.0f, 1 );
-
-					// Unschedule the filling function
-					this->unschedule( "updateLoadingBar" );
-
-					// Deactivate the loading bar and standing zone if the port has been placed
-					m_pcLoadingBar->setVisible( false );
-					m_pcStandingZone->setVisible( false );
-				}
-			}, m_fLoadingTimeInSeconds * 0.01f, "updateLoadingBar" );
-
-			// Bar is currently filling by this point
-			m_IsFilling = !m_IsFilling;
-		}
-		// If the port is filling (at this point it means the player stepped out trigger collider
-		else
-		{
-			cocos2d::AudioEngine::stop( m_iAudioID );
-			// Unschedule the filling function
-			this->unschedule( "updateLoadingBar" );
-			// Reset set percentage to 0
-			m_pcLoadingBar->setPercent( 0.0 );
-			// The bar is not filling anymore
-			m_IsFilling = !m_IsFilling;
-		}
-	}
-
-}
-
-void CPort::Reset()
-{
-	// Set the class members to default values
-	m_IsPlaced = false;
-	m_IsFilling = false;
-	m_pcLoadingBar->setPercent( 0.0f );
-	m_pcLoadingBar->setVisible( true );
-	m_pcStandingZone->setVisible( true );
-	setVisible( true );
-	// Set the state state of the port to on | Nikodem Hamrol
-	SetAnimationState( 0, false, 0.0f, 2 );
-}
-
+#include "Port.h"
+
+#include <algorithm>
+
+#include <CCEventCustom.h>
+#include <CCEventDispatcher.h>
+
+#include "TextureManager.h"
+#include "Settings.h"
+
+using cocos2d::Vec2;
+
+CPort::CPort( CTextureManager& rcTextureManager, const int iID )
+	: m_cTriggerOffset( 0.0f, -16.0f )
+	, m_pcAudioService( nullptr )
+	, m_pcTextureManager( rcTextureManager )
+	, m_IsFilling( false )
+	, m_IsPlaced( false )
+	, m_fLoadingTimeInSeconds( 2.0 )
+	, m_fFillingTimeInSeconds( 0.0f )
+	, m_iAudioID( 0 )
+	, m_pcStandingZone( nullptr )
+	, m_bIsStandingZoneCreated( false )
+	, m_pcAnimator( nullptr )
+	, m_iAnimation( -1 )
+{
+
+	// Initialise the port's sprite using the texture manager
+	CreateSprite( m_pcTextureManager.GetTexture( EGameTextures::Port ), true, 1, 2 );
+
+	// Create an empty sprite for the standing zone 
+	m_pcStandingZone = new CSpriteObject();
+
+	// Setting the name of the port with its ID, used for debugging
+	setName( "Port " + std::to_string( iID ) );
+
+	// Create a loading bar that will be used as visual timer for port placement
+	m_pcLoadingBar = cocos2d::ui::LoadingBar::create( "MP_Meter2.png" );
+	m_pcLoadingBar->setScale( 0.06f );
+	// Set bar's filling direction from left to right
+	m_pcLoadingBar->setDirection( cocos2d::ui::LoadingBar::Direction::LEFT );
+	// Position the bar a bit higher than the port sprite
+	m_pcLoadingBar->setPosition( Vec2( 0.0f, getContentSize().height ) );
+	m_pcLoadingBar->setAnchorPoint( Vec2( 0.25f, 0 ) );
+
+	setVisible( false );
+
+	addChild( m_pcLoadingBar );
+}
+
+CPort::~CPort()
+{
+	// Leave the level's animator so that it never steps a deleted sprite
+	SetAnimator( nullptr );
+}
+
+void CPort::Initialise( const cocos2d::Value& rcTiledObject )
+{
+	const cocos2d::ValueMap& rcObjectValues = rcTiledObject.asValueMap();
+
+	CCASSERT( !rcObjectValues.empty(), "No values in the tiled object" );
+
+	// Copy the tiled object's size, used as the size of the trigger volume
+	m_cTriggerSize = cocos2d::Size( rcObjectValues.at( "width" ).asFloat(), rcObjectValues.at( "height" ).asFloat() );
+
+	if( !m_bIsStandingZoneCreated )
+	{
+		// Create a sprite for the standing zone
+		m_pcStandingZone->CreateSprite( m_pcTextureManager.GetTexture( EGameTextures::PortStandingZone ), false );
+		// Making the standing zone's sprite a bit transparent
+		m_pcStandingZone->setOpacity( 170 );
+		m_pcStandingZone->setScaleY( 1.0f / 16.0 );
+		m_pcStandingZone->setPosition( -Vec2( getContentSize().width * getScaleX() * 0.10f, 10.0f ) );
+
+		addChild( m_pcStandingZone );
+
+		m_bIsStandingZoneCreated = true;
+	}
+
+	// Scale the standing zone to the width of the trigger volume, it can change between stages
+	m_pcStandingZone->setScaleX( m_cTriggerSize.width / m_pcStandingZone->getContentSize().width );
+
+	// Position the port in the coordinates given by the tiled object
+	float fOffsetCorrectionX = rcObjectValues.at( "x" ).asFloat();
+	float fOffsetCorrectionY = rcObjectValues.at( "y" ).asFloat() + rcObjectValues.at( "height" ).asFloat() * 0.5f;
+	setPosition( fOffsetCorrectionX, fOffsetCorrectionY );
+
+	Reset();
+}
+
+void CPort::StartFilling()
+{
+	// If the port is placed or already filling do nothing
+	if( m_IsPlaced || m_IsFilling )
+	{
+		return;
+	}
+
+	if( Audio::k_iAudioEnabled && nullptr != m_pcAudioService )
+	{
+		m_iAudioID = m_pcAudioService->VPlay2D( "/Audio/turbolift_05.ogg", false, 0.9f );
+	}
+
+	// The bar is filled by VUpdate() over x amount of seconds
+	m_fFillingTimeInSeconds = 0.0f;
+
+	// Bar is currently filling by this point
+	m_IsFilling = true;
+}
+
+void CPort::Place( const bool bUseChip )
+{
+	// Port is now placed
+	m_IsPlaced = true;
+	m_IsFilling = false;
+
+	// Create and send an event to acknowledge the activation
+	cocos2d::EventCustom portActivated( "Port_Activated" );
+	_eventDispatcher->dispatchEvent( &portActivated );
+
+	if( bUseChip )
+	{
+		// Create and send an event to acknowledge the usage of chip
+		cocos2d::EventCustom chipUsed( "Chip_Used" );
+		_eventDispatcher->dispatchEvent( &chipUsed );
+	}
+
+	// Set the animation state of the port to on | Nikodem Hamrol
+	SetAnimation( GetSpriteFrameHeight(), false, 0.0f, 1 );
+
+	// Deactivate the loading bar and standing zone if the port has been placed
+	m_pcLoadingBar->setVisible( false );
+	m_pcStandingZone->setVisible( false );
+}
+
+void CPort::StopFilling()
+{
+	// Only a port still filling has something to stop
+	if( m_IsPlaced || !m_IsFilling )
+	{
+		return;
+	}
+
+	if( nullptr != m_pcAudioService )
+	{
+		m_pcAudioService->VStop( m_iAudioID );
+	}
+
+	// Reset set percentage to 0
+	m_pcLoadingBar->setPercent( 0.0 );
+	// The bar is not filling anymore
+	m_IsFilling = false;
+}
+
+void CPort::VUpdate( float fDeltaTime )
+{
+	if( !m_IsFilling )
+	{
+		return;
+	}
+
+	// Update the loading bar percentage
+	m_fFillingTimeInSeconds += fDeltaTime;
+	m_pcLoadingBar->setPercent( std::min( 100.0f, 100.0f * m_fFillingTimeInSeconds / m_fLoadingTimeInSeconds ) );
+
+	// If the bar is fully filled
+	if( m_fFillingTimeInSeconds >= m_fLoadingTimeInSeconds )
+	{
+		Place( true );
+	}
+}
+
+void CPort::VTriggerResponse()
+{
+	if( m_IsFilling )
+	{
+		StopFilling();
+	}
+	else
+	{
+		StartFilling();
+	}
+}
+
+void CPort::OnTriggerEvent( const CTriggerGrid::EEvent eEvent )
+{
+	// The filling keeps going while the player stays in the zone, so stay events are ignored
+	if( CTriggerGrid::EEvent::Enter == eEvent )
+	{
+		StartFilling();
+	}
+	else if( CTriggerGrid::EEvent::Exit == eEvent )
+	{
+		StopFilling();
+	}
+}
+
+void CPort::RestorePlaced()
+{
+	if( !m_IsPlaced )
+	{
+		// The chip has already been spent when the port was placed before saving
+		Place( false );
+	}
+}
+
+bool CPort::IsPlaced() const
+{
+	return m_IsPlaced;
+}
+
+void CPort::SetAudioService( CAudioService* pcAudioService )
+{
+	m_pcAudioService = pcAudioService;
+}
+
+void CPort::SetAnimator( CSpriteAnimator* pcAnimator )
+{
+	if( pcAnimator == m_pcAnimator )
+	{
+		return;
+	}
+
+	// Leave the previous animator, which hands the handle to the next sprite registered
+	if( nullptr != m_pcAnimator )
+	{
+		m_pcAnimator->Unregister( m_iAnimation );
+		m_iAnimation = -1;
+	}
+
+	m_pcAnimator = pcAnimator;
+
+	if( nullptr != m_pcAnimator )
+	{
+		m_iAnimation = m_pcAnimator->Register( this );
+	}
+}
+
+void CPort::SetAnimation( const float fRowY, const bool bLoop, const float fFrameTime, const int iFrames )
+{
+	if( nullptr != m_pcAnimator )
+	{
+		m_pcAnimator->SetState( m_iAnimation, fRowY, bLoop, fFrameTime, iFrames );
+	}
+	else
+	{
+		SetAnimationState( fRowY, bLoop, fFrameTime, iFrames );
+	}
+}
+
+cocos2d::Rect CPort::GetTriggerVolume() const
+{
+	// The volume is centred a bit lower than the port's sprite
+	const Vec2 cCentre = getPosition() + m_cTriggerOffset;
+
+	return cocos2d::Rect( cCentre.x - m_cTriggerSize.width * 0.5f, cCentre.y - m_cTriggerSize.height * 0.5f,
+		m_cTriggerSize.width, m_cTriggerSize.height );
+}
+
+void CPort::Reset()
+{
+	// Set the class members to default values
+	m_IsPlaced = false;
+	m_IsFilling = false;
+	m_fFillingTimeInSeconds = 0.0f;
+	m_pcLoadingBar->setPercent( 0.0f );
+	m_pcLoadingBar->setVisible( true );
+	m_pcStandingZone->setVisible( true );
+	setVisible( true );
+	// Set the state state of the port to on | Nikodem Hamrol
+	SetAnimation( 0.0f, false, 0.0f, 2 );
+}
+
@@ -3,7 +3,10 @@
 
 
 #include "Collider.h"
+#include "LevelContext.h"
+#include "SpriteAnimator.h"
 #include "SpriteObject.h"
+#include "TriggerGrid.h"
 
 #include "CCValue.h"
 #include <ui/CocosGUI.h>
@@ -14,6 +17,7 @@ class CTextureManager;
 // Class Name			: CPort
 // Classes Inherited	: CSpriteObject, CCollider
 // Purpose				: To handle the a port in the level. It can be activated on collision and "placed" if the player has "chip"
+// Notes				: The standing zone is not a physics sensor, its volume is registered in the level's trigger grid
 //-----------------------------------------------------------------------------------------------------------------------------
 class CPort 
 	: public CSpriteObject
@@ -21,8 +25,12 @@ class CPort
 {
 
 private:
-	// Pointer to port collider 
-	cocos2d::PhysicsBody* m_pcCollider;
+	// Size of the trigger volume, taken from the tiled object
+	cocos2d::Size m_cTriggerSize;
+	// Offset of the trigger volume's center from the port's position
+	cocos2d::Vec2 m_cTriggerOffset;
+	// Service used to play the port's sounds, set by the level manager
+	CAudioService* m_pcAudioService;
 	// Pointer to texture manager
 	CTextureManager& m_pcTextureManager;
 	// Pointer to loading bar
@@ -34,45 +42,127 @@ private:
 	bool m_IsPlaced;
 	// Time required to fill the loading bar
 	float m_fLoadingTimeInSeconds;
+	// Time the loading bar has been filling for
+	float m_fFillingTimeInSeconds;
 
 	int m_iAudioID;
 	// Pointer to the standing zone object
 	CSpriteObject* m_pcStandingZone;
+	// True once the standing zone's sprite has been created
+	bool m_bIsStandingZoneCreated;
+	// Animator of the level stepping the port's frames, nullptr to let the sprite animate itself
+	CSpriteAnimator* m_pcAnimator;
+	// Handle of the port's animation in the animator
+	int m_iAnimation;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: StartFilling()
+	// Purpose			: Start filling the loading bar if the port is not placed yet. When the bar is full the port is placed
+	//					: and an event is sent to the Exit Door to acknowledge the placement success
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void StartFilling();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: StopFilling()
+	// Purpose			: Stop filling the loading bar and empty it, if the port is not placed yet
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void StopFilling();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Place()
+	// Parameters		: bUseChip			- True to send the event consuming the player's chip
+	// Purpose			: Switch the port on, hide its loading bar and standing zone and tell the Exit Door it is placed
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Place( const bool bUseChip );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetAnimation()
+	// Parameters		: fRowY				- Top of the row in the port's sprite sheet
+	//					: bLoop				- True to loop the row's frames
+	//					: fFrameTime		- Seconds each frame is shown
+	//					: iFrames			- Amount of frames in the row
+	// Purpose			: Change the port's animation through the level's animator, or through the sprite without one
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetAnimation( const float fRowY, const bool bLoop, const float fFrameTime, const int iFrames );
 
 public:
 
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Constructor Name	: CPort()
-	// Purpose			: Create a port with its basic elements so texture, empty collider and the loading bar used during port 
-	//					: placement. Collider name is set to "Port + iiD)
+	// Purpose			: Create a port with its basic elements so texture and the loading bar used during port placement
 	// Parameters		: rcTextureManager	- The texture manager used to set the texture
 	//					: iID				- The unique ID used to identify this port during the game
-	// Notes			: Collision trigger is positioned a bit lower than the sprite itself
+	// Notes			: Trigger volume is positioned a bit lower than the sprite itself
 	//-----------------------------------------------------------------------------------------------------------------------------
 	CPort(  CTextureManager& rcTextureManager, const int iID );
 	
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Destructor Name	: ~CPort()
-	// Purpose			: Free memory used by the class
+	// Purpose			: Unregister the port from the level's animator
 	//-----------------------------------------------------------------------------------------------------------------------------
 	~CPort();
 
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: Initialise()
 	// Parameters		: rcTiledObject		- The tilemap object from where the position/dimensions are taken
-	// Purpose			: Position the port based on the given object values and resets it to original values. If the collider is
-	//					: empty creates a physics shape based and initialise standing zone
+	// Purpose			: Position the port based on the given object values, size its trigger volume and resets it to original
+	//					: values. The standing zone's sprite is created on the first initialisation
 	//-----------------------------------------------------------------------------------------------------------------------------
 	void Initialise( const cocos2d::Value& rcTiledObject );
 
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: VTriggerResponse()
-	// Purpose			: Handle the activation and placement of the port. When collision box is triggered, the loading bar will 
-	//					: fill as long as the stands in it. On bar's completition it sends an event to the Exit Door to acknowledge 
-	//					: the placement success
+	// Purpose			: Handle the activation and placement of the port. Every call toggles the filling of the loading bar, so
+	//					: the bar fills as long as the player stands between two calls
 	//-----------------------------------------------------------------------------------------------------------------------------
 	void VTriggerResponse() override;
 
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: VUpdate()
+	// Parameters		: fDeltaTime		- Time since the last frame
+	// Purpose			: Fill the loading bar while the port is filling and place the port once the bar is full
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void VUpdate( float fDeltaTime ) override;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: OnTriggerEvent()
+	// Parameters		: eEvent			- Event sent by the trigger grid
+	// Purpose			: Start filling the loading bar when the player enters the standing zone and stop when the player exits
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void OnTriggerEvent( const CTriggerGrid::EEvent eEvent );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTriggerVolume()
+	// Purpose			: Compute the standing zone's volume in the coordinates of the port's parent
+	// Returns			: The volume to register in the trigger grid
+	//-----------------------------------------------------------------------------------------------------------------------------
+	cocos2d::Rect GetTriggerVolume() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetAudioService()
+	// Parameters		: pcAudioService	- Service of the level's context used to play the port's sounds
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetAudioService( CAudioService* pcAudioService );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetAnimator()
+	// Parameters		: pcAnimator		- Animator of the level, the port's sprite is registered in it. nullptr
+	//										  unregisters it, the sprite then animates itself
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetAnimator( CSpriteAnimator* pcAnimator );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: RestorePlaced()
+	// Purpose			: Place the port straight away when loading a save, without consuming a chip
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void RestorePlaced();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: IsPlaced()
+	// Returns			: True if the port has been placed
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsPlaced() const;
+
 	//-----------------------------------------------------------------------------------------------------------------------------
 	// Function Name	: Reset()
 	// Purpose			: Reset the port to default values
@@ -0,0 +1,173 @@
+#include "RenderStateBuffer.h"
+
+#include <algorithm>
+
+#include <cocos/2d/CCNode.h>
+#include <cocos/2d/CCSprite.h>
+#include <cocos/base/ccMacros.h>
+
+CRenderStateBuffer::CRenderStateBuffer()
+	: m_iBackBuffer( 0 )
+	, m_iLastApplied( 0 )
+{}
+
+int CRenderStateBuffer::AddNode( cocos2d::Node* pcNode )
+{
+	CCASSERT( nullptr != pcNode, "Bound node is null" );
+
+	int iSlot = static_cast<int>( m_apcNodes.size() );
+
+	if( !m_aiFreeSlots.empty() )
+	{
+		iSlot = m_aiFreeSlots.back();
+		m_aiFreeSlots.pop_back();
+		m_apcNodes[ iSlot ] = pcNode;
+	}
+	else
+	{
+		m_apcNodes.push_back( pcNode );
+
+		SNodeState sState = {};
+
+		for( SBuffer& rsBuffer : m_asBuffers )
+		{
+			rsBuffer.asStates.push_back( sState );
+
+			// Every node is written at most once per buffer, so the simulation never grows the list
+			rsBuffer.aiWritten.reserve( m_apcNodes.size() );
+		}
+	}
+
+	return iSlot;
+}
+
+void CRenderStateBuffer::RemoveNode( const int iSlot )
+{
+	CCASSERT( iSlot >= 0 && iSlot < static_cast<int>( m_apcNodes.size() ) && nullptr != m_apcNodes[ iSlot ], "Unknown node" );
+
+	for( SBuffer& rsBuffer : m_asBuffers )
+	{
+		if( 0 != rsBuffer.asStates[ iSlot ].uiFields )
+		{
+			rsBuffer.asStates[ iSlot ].uiFields = 0;
+			rsBuffer.aiWritten.erase( std::find( rsBuffer.aiWritten.begin(), rsBuffer.aiWritten.end(), iSlot ) );
+		}
+	}
+
+	m_apcNodes[ iSlot ] = nullptr;
+	m_aiFreeSlots.push_back( iSlot );
+}
+
+CRenderStateBuffer::SNodeState& CRenderStateBuffer::Write( const int iSlot, const EField eField )
+{
+	CCASSERT( iSlot >= 0 && iSlot < static_cast<int>( m_apcNodes.size() ), "Unknown node" );
+
+	SBuffer& rsBuffer = m_asBuffers[ m_iBackBuffer ];
+	SNodeState& rsState = rsBuffer.asStates[ iSlot ];
+
+	if( 0 == rsState.uiFields )
+	{
+		rsBuffer.aiWritten.push_back( iSlot );
+	}
+
+	rsState.uiFields |= eField;
+
+	return rsState;
+}
+
+void CRenderStateBuffer::SetPosition( const int iSlot, const cocos2d::Vec2& rcPosition )
+{
+	Write( iSlot, Position ).cPosition = rcPosition;
+}
+
+void CRenderStateBuffer::SetRotation( const int iSlot, const float fRotation )
+{
+	Write( iSlot, Rotation ).fRotation = fRotation;
+}
+
+void CRenderStateBuffer::SetScale( const int iSlot, const cocos2d::Vec2& rcScale )
+{
+	Write( iSlot, Scale ).cScale = rcScale;
+}
+
+void CRenderStateBuffer::SetOpacity( const int iSlot, const uint8_t uiOpacity )
+{
+	Write( iSlot, Opacity ).uiOpacity = uiOpacity;
+}
+
+void CRenderStateBuffer::SetVisible( const int iSlot, const bool bIsVisible )
+{
+	Write( iSlot, Visibility ).bIsVisible = bIsVisible;
+}
+
+void CRenderStateBuffer::SetTextureRect( const int iSlot, const cocos2d::Rect& rcTextureRect )
+{
+	Write( iSlot, TextureRect ).cTextureRect = rcTextureRect;
+}
+
+void CRenderStateBuffer::Clear( SBuffer& rsBuffer )
+{
+	for( const int iSlot : rsBuffer.aiWritten )
+	{
+		rsBuffer.asStates[ iSlot ].uiFields = 0;
+	}
+
+	rsBuffer.aiWritten.clear();
+}
+
+void CRenderStateBuffer::Publish()
+{
+	m_iBackBuffer = 1 - m_iBackBuffer;
+
+	// The new back buffer has been applied already
+	Clear( m_asBuffers[ m_iBackBuffer ] );
+}
+
+int CRenderStateBuffer::Apply()
+{
+	const SBuffer& rsBuffer = m_asBuffers[ 1 - m_iBackBuffer ];
+
+	for( const int iSlot : rsBuffer.aiWritten )
+	{
+		const SNodeState& rsState = rsBuffer.asStates[ iSlot ];
+		cocos2d::Node* pcNode = m_apcNodes[ iSlot ];
+
+		if( 0 != ( rsState.uiFields & Position ) )
+		{
+			pcNode->setPosition( rsState.cPosition );
+		}
+
+		if( 0 != ( rsState.uiFields & Rotation ) )
+		{
+			pcNode->setRotation( rsState.fRotation );
+		}
+
+		if( 0 != ( rsState.uiFields & Scale ) )
+		{
+			pcNode->setScale( rsState.cScale.x, rsState.cScale.y );
+		}
+
+		if( 0 != ( rsState.uiFields & Opacity ) )
+		{
+			pcNode->setOpacity( rsState.uiOpacity );
+		}
+
+		if( 0 != ( rsState.uiFields & Visibility ) )
+		{
+			pcNode->setVisible( rsState.bIsVisible );
+		}
+
+		if( 0 != ( rsState.uiFields & TextureRect ) )
+		{
+			static_cast<cocos2d::Sprite*>( pcNode )->setTextureRect( rsState.cTextureRect );
+		}
+	}
+
+	m_iLastApplied = static_cast<int>( rsBuffer.aiWritten.size() );
+
+	return m_iLastApplied;
+}
+
+int CRenderStateBuffer::GetNodeCount() const	{ return static_cast<int>( m_apcNodes.size() - m_aiFreeSlots.size() ); }
+
+int CRenderStateBuffer::GetLastApplied() const	{ return m_iLastApplied; }
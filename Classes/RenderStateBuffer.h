@@ -0,0 +1,142 @@
+#ifndef RENDERSTATEBUFFER_H
+#define RENDERSTATEBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <cocos/math/CCGeometry.h>
+
+namespace cocos2d
+{
+	class Node;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CRenderStateBuffer
+// Purpose				: To hand the render state computed by the simulation thread to the thread rendering the scene. The
+//						: simulation writes the transforms, opacity, visibility and animation frames of the nodes it changes
+//						: in the back buffer while the render thread applies the front buffer, written by the previous
+//						: simulation, to the nodes. Publish() swaps the buffers once both threads are done with them
+// Notes				: Only the fields written since the last swap are applied, later writes of a field in the same
+//						: buffer replace the earlier ones. The nodes are bound and unbound by the render thread while no
+//						: simulation runs, they are not retained. Texture rects are only written for nodes that are sprites
+// Example				: const int iSlot = cBuffer.AddNode( pcSprite ); ... cBuffer.SetTextureRect( iSlot, cFrame );
+//						: cBuffer.Publish(); cBuffer.Apply();
+//-----------------------------------------------------------------------------------------------------------------------------
+class CRenderStateBuffer
+{
+
+public:
+
+	// Fields of a node's render state, combined in the mask of the written fields
+	enum EField : uint8_t
+	{
+		Position		= 1 << 0,
+		Rotation		= 1 << 1,
+		Scale			= 1 << 2,
+		Opacity			= 1 << 3,
+		Visibility		= 1 << 4,
+		TextureRect		= 1 << 5
+	};
+
+private:
+
+	// Render state of a node, only the fields in the mask are meaningful
+	struct SNodeState
+	{
+		uint8_t			uiFields;
+		uint8_t			uiOpacity;
+		bool			bIsVisible;
+		float			fRotation;
+		cocos2d::Vec2	cPosition;
+		cocos2d::Vec2	cScale;
+		cocos2d::Rect	cTextureRect;
+	};
+
+	// States indexed by the nodes' slots, and the slots written since the buffer was last cleared
+	struct SBuffer
+	{
+		std::vector<SNodeState>	asStates;
+		std::vector<int>		aiWritten;
+	};
+
+	// Bound nodes indexed by their slot, nullptr for a free slot
+	std::vector<cocos2d::Node*> m_apcNodes;
+	std::vector<int> m_aiFreeSlots;
+
+	SBuffer m_asBuffers[ 2 ];
+
+	// Buffer written by the simulation, the other one is applied
+	int m_iBackBuffer;
+
+	// Nodes changed by the last Apply()
+	int m_iLastApplied;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Write()
+	// Parameters		: iSlot				- Slot of the node
+	//					: eField			- Field about to be written
+	// Returns			: The state of the node in the back buffer, with the field marked as written
+	//-----------------------------------------------------------------------------------------------------------------------------
+	SNodeState& Write( const int iSlot, const EField eField );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Clear()
+	// Parameters		: rsBuffer			- Buffer to clear
+	// Purpose			: Unmark the written fields of the buffer's nodes
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static void Clear( SBuffer& rsBuffer );
+
+public:
+
+	CRenderStateBuffer();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddNode()
+	// Parameters		: pcNode			- Node whose render state is written by the simulation
+	// Purpose			: Bind the node to a slot, reserving room so that writing the state never allocates
+	// Returns			: The slot of the node
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int AddNode( cocos2d::Node* pcNode );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: RemoveNode()
+	// Parameters		: iSlot				- Slot returned by AddNode()
+	// Purpose			: Unbind the node and drop the state written for it in both buffers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void RemoveNode( const int iSlot );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Setters
+	// Parameters		: iSlot				- Slot of the node
+	// Purpose			: Write a field of the node's state in the back buffer, called by the simulation
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetPosition( const int iSlot, const cocos2d::Vec2& rcPosition );
+	void SetRotation( const int iSlot, const float fRotation );
+	void SetScale( const int iSlot, const cocos2d::Vec2& rcScale );
+	void SetOpacity( const int iSlot, const uint8_t uiOpacity );
+	void SetVisible( const int iSlot, const bool bIsVisible );
+	void SetTextureRect( const int iSlot, const cocos2d::Rect& rcTextureRect );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Publish()
+	// Purpose			: Swap the buffers, the state written by the simulation becomes the one applied and the applied one
+	//					: is cleared for the next simulation. Called while neither thread uses the buffers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Publish();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Apply()
+	// Purpose			: Set the written fields of the front buffer on their nodes, called by the render thread
+	// Returns			: The amount of nodes changed
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int Apply();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Getters
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetNodeCount() const;
+	int GetLastApplied() const;
+};
+
+#endif // !RENDERSTATEBUFFER_H
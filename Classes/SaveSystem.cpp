@@ -0,0 +1,253 @@
+#include "SaveSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cocos/base/ccMacros.h>
+
+// Magic number at the start of every save
+static const uint8_t k_auiMagic[] = { 'I', 'R', 'S', 'V' };
+
+// Size of an encoded record: magic, version, padding, four fields and the checksum
+static const size_t k_uiRecordSize = 4 + 2 + 2 + 4 * 4 + 4;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: ComputeCRC32()
+// Parameters		: puiData			- Data to check
+//					: uiSize			- Amount of bytes
+// Purpose			: Standard CRC-32 (polynomial 0xEDB88320), bitwise as the records are only a few bytes long
+// Returns			: The checksum of the data
+//-----------------------------------------------------------------------------------------------------------------------------
+static uint32_t ComputeCRC32( const uint8_t* puiData, const size_t uiSize )
+{
+	uint32_t uiCRC = 0xFFFFFFFFu;
+
+	for( size_t i = 0; i < uiSize; i++ )
+	{
+		uiCRC ^= puiData[ i ];
+
+		for( int iBit = 0; iBit < 8; iBit++ )
+		{
+			uiCRC = ( uiCRC >> 1 ) ^ ( 0xEDB88320u & ( 0u - ( uiCRC & 1u ) ) );
+		}
+	}
+
+	return ~uiCRC;
+}
+
+static void PutUInt16( std::vector<uint8_t>& rauiData, const uint16_t uiValue )
+{
+	rauiData.push_back( static_cast<uint8_t>( uiValue ) );
+	rauiData.push_back( static_cast<uint8_t>( uiValue >> 8 ) );
+}
+
+static void PutUInt32( std::vector<uint8_t>& rauiData, const uint32_t uiValue )
+{
+	for( int iShift = 0; iShift < 32; iShift += 8 )
+	{
+		rauiData.push_back( static_cast<uint8_t>( uiValue >> iShift ) );
+	}
+}
+
+static uint16_t GetUInt16( const uint8_t* puiData )
+{
+	return static_cast<uint16_t>( puiData[ 0 ] | ( puiData[ 1 ] << 8 ) );
+}
+
+static uint32_t GetUInt32( const uint8_t* puiData )
+{
+	return static_cast<uint32_t>( puiData[ 0 ] ) | ( static_cast<uint32_t>( puiData[ 1 ] ) << 8 )
+		| ( static_cast<uint32_t>( puiData[ 2 ] ) << 16 ) | ( static_cast<uint32_t>( puiData[ 3 ] ) << 24 );
+}
+
+CSaveSystem::CSaveSystem()
+	: m_bHasPending( false )
+	, m_bIsWriting( false )
+	, m_bStop( false )
+{}
+
+CSaveSystem::~CSaveSystem()
+{
+	Stop();
+}
+
+void CSaveSystem::Start( const std::string& rsPath )
+{
+	Stop();
+
+	m_sPath = rsPath;
+	m_sTemporaryPath = rsPath + ".tmp";
+	m_bStop = false;
+
+	m_cWriter = std::thread( &CSaveSystem::WriterLoop, this );
+}
+
+void CSaveSystem::Stop()
+{
+	if( !m_cWriter.joinable() )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> cLock( m_cMutex );
+		m_bStop = true;
+	}
+
+	m_cCondition.notify_all();
+	m_cWriter.join();
+}
+
+bool CSaveSystem::IsStarted() const
+{
+	return m_cWriter.joinable();
+}
+
+void CSaveSystem::Save( const SRecord& rsRecord )
+{
+	if( !IsStarted() )
+	{
+		return;
+	}
+
+	std::vector<uint8_t> auiData;
+	Encode( rsRecord, auiData );
+
+	{
+		// A record still waiting is replaced, the newest progress is the only one worth writing
+		std::lock_guard<std::mutex> cLock( m_cMutex );
+		m_auiPending.swap( auiData );
+		m_bHasPending = true;
+	}
+
+	m_cCondition.notify_all();
+}
+
+void CSaveSystem::Flush()
+{
+	std::unique_lock<std::mutex> cLock( m_cMutex );
+	m_cCondition.wait( cLock, [this]() { return !m_bHasPending && !m_bIsWriting; } );
+}
+
+void CSaveSystem::WriterLoop()
+{
+	std::vector<uint8_t> auiData;
+	std::unique_lock<std::mutex> cLock( m_cMutex );
+
+	while( true )
+	{
+		m_cCondition.wait( cLock, [this]() { return m_bHasPending || m_bStop; } );
+
+		if( !m_bHasPending )
+		{
+			// Stopped with nothing left to write
+			return;
+		}
+
+		auiData.swap( m_auiPending );
+		m_bHasPending = false;
+		m_bIsWriting = true;
+
+		// The file is written without holding the lock so Save() never waits on the disk
+		cLock.unlock();
+
+		if( !WriteFile( auiData ) )
+		{
+			CCLOG( "Save system: failed to write %s", m_sPath.c_str() );
+		}
+
+		cLock.lock();
+		m_bIsWriting = false;
+		m_cCondition.notify_all();
+	}
+}
+
+bool CSaveSystem::WriteFile( const std::vector<uint8_t>& rauiData ) const
+{
+	FILE* pFile = fopen( m_sTemporaryPath.c_str(), "wb" );
+
+	if( nullptr == pFile )
+	{
+		return false;
+	}
+
+	bool bIsWritten = fwrite( rauiData.data(), 1, rauiData.size(), pFile ) == rauiData.size() && 0 == fflush( pFile );
+
+	// Make sure the data is on disk before the rename makes it the save
+#ifdef _WIN32
+	bIsWritten = bIsWritten && 0 == _commit( _fileno( pFile ) );
+#else
+	bIsWritten = bIsWritten && 0 == fsync( fileno( pFile ) );
+#endif
+
+	bIsWritten = ( 0 == fclose( pFile ) ) && bIsWritten;
+
+	if( !bIsWritten )
+	{
+		remove( m_sTemporaryPath.c_str() );
+		return false;
+	}
+
+#ifdef _WIN32
+	return 0 != MoveFileExA( m_sTemporaryPath.c_str(), m_sPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+#else
+	return 0 == rename( m_sTemporaryPath.c_str(), m_sPath.c_str() );
+#endif
+}
+
+bool CSaveSystem::Load( SRecord& rsRecord ) const
+{
+	FILE* pFile = fopen( m_sPath.c_str(), "rb" );
+
+	if( nullptr == pFile )
+	{
+		return false;
+	}
+
+	// Read one byte more than a record to reject longer files
+	std::vector<uint8_t> auiData( k_uiRecordSize + 1 );
+	auiData.resize( fread( auiData.data(), 1, auiData.size(), pFile ) );
+	fclose( pFile );
+
+	return Decode( auiData, rsRecord );
+}
+
+void CSaveSystem::Encode( const SRecord& rsRecord, std::vector<uint8_t>& rauiData )
+{
+	rauiData.clear();
+	rauiData.reserve( k_uiRecordSize );
+
+	rauiData.insert( rauiData.end(), k_auiMagic, k_auiMagic + sizeof( k_auiMagic ) );
+	PutUInt16( rauiData, k_uiVersion );
+	PutUInt16( rauiData, 0 );
+	PutUInt32( rauiData, static_cast<uint32_t>( rsRecord.iLevel ) );
+	PutUInt32( rauiData, static_cast<uint32_t>( rsRecord.iStage ) );
+	PutUInt32( rauiData, rsRecord.uiCollectedPickups );
+	PutUInt32( rauiData, rsRecord.uiPlacedPorts );
+	PutUInt32( rauiData, ComputeCRC32( rauiData.data(), rauiData.size() ) );
+}
+
+bool CSaveSystem::Decode( const std::vector<uint8_t>& rauiData, SRecord& rsRecord )
+{
+	if( rauiData.size() != k_uiRecordSize
+		|| !std::equal( k_auiMagic, k_auiMagic + sizeof( k_auiMagic ), rauiData.begin() )
+		|| GetUInt16( &rauiData[ 4 ] ) != k_uiVersion
+		|| GetUInt32( &rauiData[ k_uiRecordSize - 4 ] ) != ComputeCRC32( rauiData.data(), k_uiRecordSize - 4 ) )
+	{
+		return false;
+	}
+
+	rsRecord.iLevel = static_cast<int32_t>( GetUInt32( &rauiData[ 8 ] ) );
+	rsRecord.iStage = static_cast<int32_t>( GetUInt32( &rauiData[ 12 ] ) );
+	rsRecord.uiCollectedPickups = GetUInt32( &rauiData[ 16 ] );
+	rsRecord.uiPlacedPorts = GetUInt32( &rauiData[ 20 ] );
+
+	return true;
+}
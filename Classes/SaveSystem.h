@@ -0,0 +1,146 @@
+#ifndef SAVESYSTEM_H
+#define SAVESYSTEM_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CSaveSystem
+// Purpose				: To persist the player's progress without stalling a frame. Saving only encodes a small binary record
+//						: and hands it to a background thread, which writes it to a temporary file, flushes it to disk and
+//						: renames it over the previous save, so a crash at any point leaves either the old or the new save
+// Notes				: Records saved faster than they are written replace each other, only the latest one is written
+//-----------------------------------------------------------------------------------------------------------------------------
+class CSaveSystem
+{
+
+public:
+
+	// Version of the binary layout, increased whenever the record changes
+	static const uint16_t k_uiVersion = 1;
+
+	// Progress of the player
+	struct SRecord
+	{
+		// Level and stage to load
+		int32_t			iLevel;
+		int32_t			iStage;
+		// One bit per pickup of the pickups manager, set if collected
+		uint32_t		uiCollectedPickups;
+		// One bit per port of the stage, set if placed
+		uint32_t		uiPlacedPorts;
+	};
+
+private:
+
+	// Path of the save and of the temporary file written before the rename
+	std::string m_sPath;
+	std::string m_sTemporaryPath;
+
+	// Thread writing the records
+	std::thread m_cWriter;
+
+	// Protects the members below, shared with the writer
+	std::mutex m_cMutex;
+	std::condition_variable m_cCondition;
+
+	// Encoded record waiting to be written
+	std::vector<uint8_t> m_auiPending;
+	bool m_bHasPending;
+
+	// True while the writer is writing a record
+	bool m_bIsWriting;
+
+	// True when the writer has to write the pending record and stop
+	bool m_bStop;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: WriterLoop()
+	// Purpose			: Body of the writer thread, wait for records and write them until stopped
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void WriterLoop();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: WriteFile()
+	// Parameters		: rauiData			- Encoded record
+	// Purpose			: Write the record to the temporary file, flush it to disk and atomically replace the save with it
+	// Returns			: True if the save has been replaced
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool WriteFile( const std::vector<uint8_t>& rauiData ) const;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CSaveSystem()
+	// Purpose			: Create a stopped save system, nothing is written until Start() is called
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CSaveSystem();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Destructor name	: ~CSaveSystem()
+	// Purpose			: Write the pending record and stop the writer
+	//-----------------------------------------------------------------------------------------------------------------------------
+	~CSaveSystem();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Start()
+	// Parameters		: rsPath			- Path of the save file
+	// Purpose			: Start the writer thread
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Start( const std::string& rsPath );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Stop()
+	// Purpose			: Write the pending record and join the writer thread
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Stop();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: IsStarted()
+	// Returns			: True if records can be saved
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool IsStarted() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Save()
+	// Parameters		: rsRecord			- Progress to save
+	// Purpose			: Encode the record and queue it for the writer, returns straight away
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Save( const SRecord& rsRecord );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Flush()
+	// Purpose			: Wait until every queued record has been written
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Flush();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Load()
+	// Parameters		: rsRecord			- Filled with the saved progress
+	// Purpose			: Read the save and validate its header, version and checksum
+	// Returns			: False if there is no save or it is not valid
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Load( SRecord& rsRecord ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Encode()
+	// Parameters		: rsRecord			- Progress to encode
+	//					: rauiData			- Filled with the binary record
+	// Purpose			: Write the record in little endian after a magic number and the version, followed by its CRC-32
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static void Encode( const SRecord& rsRecord, std::vector<uint8_t>& rauiData );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Decode()
+	// Parameters		: rauiData			- Binary record
+	//					: rsRecord			- Filled with the decoded progress
+	// Returns			: False if the data is not a valid record of the current version
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static bool Decode( const std::vector<uint8_t>& rauiData, SRecord& rsRecord );
+};
+
+#endif // !SAVESYSTEM_H
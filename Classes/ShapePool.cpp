@@ -0,0 +1,118 @@
+#include "ShapePool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+#include <chipmunk/chipmunk.h>
+#include <chipmunk/chipmunk_unsafe.h>
+#include <cocos/base/ccMacros.h>
+#include <cocos/physics/CCPhysicsBody.h>
+
+CResizableBoxShape* CResizableBoxShape::create( const cocos2d::Size& rcSize, const cocos2d::PhysicsMaterial& rcMaterial,
+	const cocos2d::Vec2& rcOffset )
+{
+	CResizableBoxShape* pcShape = new ( std::nothrow ) CResizableBoxShape();
+
+	if( nullptr != pcShape && pcShape->init( rcSize, rcMaterial, rcOffset ) )
+	{
+		pcShape->autorelease();
+		return pcShape;
+	}
+
+	CC_SAFE_DELETE( pcShape );
+	return nullptr;
+}
+
+void CResizableBoxShape::Resize( const cocos2d::Size& rcSize, const cocos2d::Vec2& rcOffset )
+{
+	const cpFloat fHalfWidth = rcSize.width * 0.5f;
+	const cpFloat fHalfHeight = rcSize.height * 0.5f;
+
+	// Same corners as PhysicsShapeBox::init(), with the scale the body applied to the shape
+	cpVect asVerts[ 4 ] =
+	{
+		{ ( rcOffset.x - fHalfWidth ) * _scaleX, ( rcOffset.y - fHalfHeight ) * _scaleY },
+		{ ( rcOffset.x - fHalfWidth ) * _scaleX, ( rcOffset.y + fHalfHeight ) * _scaleY },
+		{ ( rcOffset.x + fHalfWidth ) * _scaleX, ( rcOffset.y + fHalfHeight ) * _scaleY },
+		{ ( rcOffset.x + fHalfWidth ) * _scaleX, ( rcOffset.y - fHalfHeight ) * _scaleY }
+	};
+
+	// A mirroring scale flips the winding, Chipmunk expects the corners counterclockwise
+	if( _scaleX * _scaleY < 0.0f )
+	{
+		std::reverse( asVerts, asVerts + 4 );
+	}
+
+	cpShape* pcShape = _cpShapes.front();
+	cpPolyShapeSetVerts( pcShape, 4, asVerts, cpTransformIdentity );
+
+	_area = std::fabs( rcSize.width * _scaleX * rcSize.height * _scaleY );
+
+	cpSpace* pcSpace = cpShapeGetSpace( pcShape );
+
+	if( nullptr != pcSpace )
+	{
+		cpSpaceReindexShape( pcSpace, pcShape );
+	}
+}
+
+cpSpace* CResizableBoxShape::GetSpace() const
+{
+	return cpShapeGetSpace( _cpShapes.front() );
+}
+
+CShapePool::CShapePool()
+	: m_iCreatedBoxes( 0 )
+{}
+
+CShapePool::~CShapePool()
+{
+	for( CResizableBoxShape* pcBox : m_apcFreeBoxes )
+	{
+		pcBox->release();
+	}
+}
+
+CResizableBoxShape* CShapePool::AcquireBox( const cocos2d::Size& rcSize, const cocos2d::PhysicsMaterial& rcMaterial,
+	const cocos2d::Vec2& rcOffset )
+{
+	if( m_apcFreeBoxes.empty() )
+	{
+		m_iCreatedBoxes++;
+		return CResizableBoxShape::create( rcSize, rcMaterial, rcOffset );
+	}
+
+	CResizableBoxShape* pcBox = m_apcFreeBoxes.back();
+	m_apcFreeBoxes.pop_back();
+
+	// Resized before the material so that the density gives the mass of the new area
+	pcBox->Resize( rcSize, rcOffset );
+	pcBox->setMaterial( rcMaterial );
+
+	// The pool's reference is handed to the autorelease pool, like a box just created
+	pcBox->autorelease();
+
+	return pcBox;
+}
+
+void CShapePool::ReleaseShapes( cocos2d::PhysicsBody* pcBody )
+{
+	for( cocos2d::PhysicsShape* pcShape : pcBody->getShapes() )
+	{
+		CResizableBoxShape* pcBox = dynamic_cast<CResizableBoxShape*>( pcShape );
+
+		// Retained before the body drops its reference
+		if( nullptr != pcBox )
+		{
+			pcBox->retain();
+			m_apcFreeBoxes.push_back( pcBox );
+		}
+	}
+
+	pcBody->removeAllShapes();
+}
+
+int CShapePool::GetFreeCount() const	{ return static_cast<int>( m_apcFreeBoxes.size() ); }
+
+int CShapePool::GetCreatedCount() const	{ return m_iCreatedBoxes; }
@@ -0,0 +1,115 @@
+#ifndef SHAPEPOOL_H
+#define SHAPEPOOL_H
+
+#include <vector>
+
+#include <cocos/physics/CCPhysicsShape.h>
+
+struct cpSpace;
+
+namespace cocos2d
+{
+	class PhysicsBody;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CResizableBoxShape
+// Classes Inherited	: PhysicsShapeBox
+// Purpose				: To create a box shape whose size and offset can be changed after its creation, so that a shape can
+//						: be kept by a pooled entity or a shape pool and fitted to the next object instead of being replaced
+// Notes				: Resizing moves the corners of the Chipmunk polygon in place, which never allocates for a box, and
+//						: updates the shape's area. The mass and the moment given to the body are left as they are, the boxes
+//						: of the game are added to their bodies without them
+//-----------------------------------------------------------------------------------------------------------------------------
+class CResizableBoxShape : public cocos2d::PhysicsShapeBox
+{
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: create()
+	// Parameters		: rcSize			- Size of the box
+	//					: rcMaterial		- Material of the shape
+	//					: rcOffset			- Offset of the box's centre from the body's
+	// Returns			: A new autoreleased box, nullptr if it could not be created
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static CResizableBoxShape* create( const cocos2d::Size& rcSize, const cocos2d::PhysicsMaterial& rcMaterial,
+		const cocos2d::Vec2& rcOffset );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Resize()
+	// Parameters		: rcSize			- New size of the box
+	//					: rcOffset			- New offset of the box's centre from the body's
+	// Purpose			: Fit the box to a new size and offset, keeping the scale the body gave it. A box already in a
+	//					: space is reindexed so that static bodies collide with its new bounds straight away
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Resize( const cocos2d::Size& rcSize, const cocos2d::Vec2& rcOffset );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetSpace()
+	// Returns			: The Chipmunk space the box is in, nullptr before its body is added to a physics world. Unlike a
+	//					: static body, the shapes of every body are added to the space
+	//-----------------------------------------------------------------------------------------------------------------------------
+	cpSpace* GetSpace() const;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CShapePool
+// Purpose				: To keep the box shapes of a body that is emptied, e.g. the environment's body when a new stage is
+//						: loaded, and hand them out again resized for the next stage's objects. Once the biggest stage has
+//						: been loaded, switching stages creates and destroys no physics shape
+// Notes				: The free boxes are retained by the pool and released with it. A box handed out keeps the tag and
+//						: the collision filter it had, callers set both
+// Example				: cPool.ReleaseShapes( pcBody ); pcBody->addShape( cPool.AcquireBox( cSize, cMaterial, cOffset ), false );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CShapePool
+{
+
+private:
+
+	// Boxes waiting to be handed out
+	std::vector<CResizableBoxShape*> m_apcFreeBoxes;
+
+	// Boxes created because none was free
+	int m_iCreatedBoxes;
+
+	// Non copyable, the pool retains its boxes
+	CShapePool( const CShapePool& ) = delete;
+	CShapePool& operator=( const CShapePool& ) = delete;
+
+public:
+
+	CShapePool();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Destructor name	: ~CShapePool()
+	// Purpose			: Release the free boxes
+	//-----------------------------------------------------------------------------------------------------------------------------
+	~CShapePool();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AcquireBox()
+	// Parameters		: rcSize			- Size of the box
+	//					: rcMaterial		- Material of the shape
+	//					: rcOffset			- Offset of the box's centre from the body's
+	// Purpose			: Resize a free box, or create one if none is left
+	// Returns			: An autoreleased box, not attached to any body
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CResizableBoxShape* AcquireBox( const cocos2d::Size& rcSize, const cocos2d::PhysicsMaterial& rcMaterial,
+		const cocos2d::Vec2& rcOffset );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ReleaseShapes()
+	// Parameters		: pcBody			- Body to empty
+	// Purpose			: Remove all the shapes of the body, keeping its resizable boxes for the next calls of AcquireBox()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ReleaseShapes( cocos2d::PhysicsBody* pcBody );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Getters
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetFreeCount() const;
+	int GetCreatedCount() const;
+};
+
+#endif // !SHAPEPOOL_H
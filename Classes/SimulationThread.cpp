@@ -0,0 +1,84 @@
+#include "SimulationThread.h"
+
+#include <chrono>
+
+#include <cocos/base/ccMacros.h>
+
+CSimulationThread::CSimulationThread()
+	: m_bIsRunning( false )
+	, m_bStop( false )
+	, m_fLastFrameMs( 0.0f )
+{
+	m_cThread = std::thread( &CSimulationThread::ThreadLoop, this );
+}
+
+CSimulationThread::~CSimulationThread()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> cLock( m_cMutex );
+		m_bStop = true;
+	}
+
+	m_cCondition.notify_all();
+	m_cThread.join();
+}
+
+void CSimulationThread::Start( const std::function<void()>& fnFrame )
+{
+	{
+		std::lock_guard<std::mutex> cLock( m_cMutex );
+
+		CCASSERT( !m_bIsRunning, "The previous frame has not been waited for" );
+
+		m_fnFrame = fnFrame;
+		m_bIsRunning = true;
+	}
+
+	m_cCondition.notify_all();
+}
+
+float CSimulationThread::Wait()
+{
+	const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> cLock( m_cMutex );
+	m_cCondition.wait( cLock, [this]() { return !m_bIsRunning; } );
+
+	return std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - cStart ).count();
+}
+
+float CSimulationThread::GetLastFrameMs() const	{ return m_fLastFrameMs; }
+
+void CSimulationThread::ThreadLoop()
+{
+	std::unique_lock<std::mutex> cLock( m_cMutex );
+
+	while( true )
+	{
+		m_cCondition.wait( cLock, [this]() { return m_bStop || m_fnFrame; } );
+
+		if( m_bStop )
+		{
+			return;
+		}
+
+		std::function<void()> fnFrame;
+		fnFrame.swap( m_fnFrame );
+
+		// The frame runs unlocked, Wait() only looks at the running flag
+		cLock.unlock();
+
+		const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+		fnFrame();
+		const float fFrameMs = std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - cStart ).count();
+
+		cLock.lock();
+		m_fLastFrameMs = fFrameMs;
+		m_bIsRunning = false;
+
+		// Both the waiting caller and a destructor may be waiting on the condition
+		m_cCondition.notify_all();
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CSimulationThread
+// Purpose				: To run a frame's simulation on its own thread while the calling thread renders the previous frame.
+//						: Start() hands the frame to the thread and returns straight away, Wait() blocks until it is done,
+//						: so the simulation of frame N+1 overlaps the rendering of frame N on machines with a spare core
+// Notes				: One frame runs at a time. Like the jobs of CJobSystem, the frame must not call cocos2d-x and the
+//						: caller must leave the data it works on alone between Start() and Wait()
+// Example				: cThread.Start( fnSimulate ); ... render ... cThread.Wait(); apply the results
+//-----------------------------------------------------------------------------------------------------------------------------
+class CSimulationThread
+{
+
+private:
+
+	std::thread m_cThread;
+
+	// Hands the frames to the thread and signals their end
+	std::mutex m_cMutex;
+	std::condition_variable m_cCondition;
+
+	// Frame to run, empty once the thread has taken it
+	std::function<void()> m_fnFrame;
+
+	// True from Start() to the end of the frame
+	bool m_bIsRunning;
+	bool m_bStop;
+
+	// Time the thread spent on the last frame, in milliseconds
+	float m_fLastFrameMs;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ThreadLoop()
+	// Purpose			: Body of the thread, run the frames as they are started until stopped
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ThreadLoop();
+
+	// Non copyable, the thread points to the object
+	CSimulationThread( const CSimulationThread& ) = delete;
+	CSimulationThread& operator=( const CSimulationThread& ) = delete;
+
+public:
+
+	CSimulationThread();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Destructor name	: ~CSimulationThread()
+	// Purpose			: Wait for the running frame, then stop and join the thread
+	//-----------------------------------------------------------------------------------------------------------------------------
+	~CSimulationThread();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Start()
+	// Parameters		: fnFrame			- Work of the frame, small enough for std::function to store without allocating
+	// Purpose			: Run the frame on the thread, the previous one must have been waited for
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Start( const std::function<void()>& fnFrame );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Wait()
+	// Purpose			: Block until the started frame is done, returns straight away if none is running
+	// Returns			: The time spent waiting, in milliseconds
+	//-----------------------------------------------------------------------------------------------------------------------------
+	float Wait();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetLastFrameMs()
+	// Returns			: The time the thread spent on the last frame waited for, in milliseconds
+	//-----------------------------------------------------------------------------------------------------------------------------
+	float GetLastFrameMs() const;
+};
+
+#endif // !SIMULATIONTHREAD_H
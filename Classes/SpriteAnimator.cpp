@@ -0,0 +1,198 @@
+#include "SpriteAnimator.h"
+
+#include "RenderStateBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <cocos/2d/CCSprite.h>
+#include <cocos/base/ccMacros.h>
+
+// Next frame time of the animations that never change frame
+static const float k_fNever = std::numeric_limits<float>::infinity();
+
+// Seconds after which the clock is moved back, a clock counting the whole session would lose the precision of the frame times
+static const float k_fClockPeriod = 60.0f;
+
+CSpriteAnimator::CSpriteAnimator()
+	: m_fTime( 0.0f )
+	, m_iLastChanges( 0 )
+	, m_pcRenderState( nullptr )
+{}
+
+int CSpriteAnimator::Register( cocos2d::Sprite* pcSprite )
+{
+	CCASSERT( nullptr != pcSprite, "Animated sprite is null" );
+
+	const int iIndex = static_cast<int>( m_apcSprites.size() );
+
+	m_apcSprites.push_back( pcSprite );
+	m_acFirstFrames.push_back( pcSprite->getTextureRect() );
+	m_aiFrameCounts.push_back( 1 );
+	m_afFrameTimes.push_back( 0.0f );
+	m_abLoops.push_back( false );
+	m_aiFrames.push_back( 0 );
+	m_afNextFrameTimes.push_back( k_fNever );
+	m_aiRenderSlots.push_back( ( nullptr != m_pcRenderState ) ? m_pcRenderState->AddNode( pcSprite ) : -1 );
+
+	// Reuse the handle of a removed animation if there is one
+	int iHandle = static_cast<int>( m_aiHandleToIndex.size() );
+
+	if( !m_aiFreeHandles.empty() )
+	{
+		iHandle = m_aiFreeHandles.back();
+		m_aiFreeHandles.pop_back();
+		m_aiHandleToIndex[ iHandle ] = iIndex;
+	}
+	else
+	{
+		m_aiHandleToIndex.push_back( iIndex );
+	}
+
+	m_aiIndexToHandle.push_back( iHandle );
+
+	return iHandle;
+}
+
+void CSpriteAnimator::Unregister( const int iHandle )
+{
+	CCASSERT( iHandle >= 0 && iHandle < static_cast<int>( m_aiHandleToIndex.size() ), "Unknown animation" );
+
+	const int iIndex = m_aiHandleToIndex[ iHandle ];
+	const int iLast = static_cast<int>( m_apcSprites.size() ) - 1;
+
+	if( nullptr != m_pcRenderState )
+	{
+		m_pcRenderState->RemoveNode( m_aiRenderSlots[ iIndex ] );
+	}
+
+	// Move the last animation in the removed one's place, so the arrays stay dense
+	m_apcSprites[ iIndex ] = m_apcSprites[ iLast ];
+	m_acFirstFrames[ iIndex ] = m_acFirstFrames[ iLast ];
+	m_aiFrameCounts[ iIndex ] = m_aiFrameCounts[ iLast ];
+	m_afFrameTimes[ iIndex ] = m_afFrameTimes[ iLast ];
+	m_abLoops[ iIndex ] = m_abLoops[ iLast ];
+	m_aiFrames[ iIndex ] = m_aiFrames[ iLast ];
+	m_afNextFrameTimes[ iIndex ] = m_afNextFrameTimes[ iLast ];
+	m_aiRenderSlots[ iIndex ] = m_aiRenderSlots[ iLast ];
+
+	const int iMovedHandle = m_aiIndexToHandle[ iLast ];
+	m_aiIndexToHandle[ iIndex ] = iMovedHandle;
+	m_aiHandleToIndex[ iMovedHandle ] = iIndex;
+
+	m_apcSprites.pop_back();
+	m_acFirstFrames.pop_back();
+	m_aiFrameCounts.pop_back();
+	m_afFrameTimes.pop_back();
+	m_abLoops.pop_back();
+	m_aiFrames.pop_back();
+	m_afNextFrameTimes.pop_back();
+	m_aiRenderSlots.pop_back();
+	m_aiIndexToHandle.pop_back();
+
+	m_aiHandleToIndex[ iHandle ] = -1;
+	m_aiFreeHandles.push_back( iHandle );
+}
+
+void CSpriteAnimator::SetState( const int iHandle, const float fRowY, const bool bLoop, const float fFrameTime, const int iFrames )
+{
+	CCASSERT( iHandle >= 0 && iHandle < static_cast<int>( m_aiHandleToIndex.size() ), "Unknown animation" );
+
+	const int iIndex = m_aiHandleToIndex[ iHandle ];
+
+	CCASSERT( iIndex >= 0, "Animation unregistered" );
+
+	m_acFirstFrames[ iIndex ].origin.y = fRowY;
+	m_aiFrameCounts[ iIndex ] = std::max( 1, iFrames );
+	m_afFrameTimes[ iIndex ] = fFrameTime;
+	m_abLoops[ iIndex ] = bLoop;
+	m_aiFrames[ iIndex ] = 0;
+
+	// A single frame or a frame time of 0 never changes
+	m_afNextFrameTimes[ iIndex ] = ( fFrameTime > 0.0f && m_aiFrameCounts[ iIndex ] > 1 ) ? m_fTime + fFrameTime : k_fNever;
+
+	ShowFrame( iIndex );
+}
+
+void CSpriteAnimator::SetRenderState( CRenderStateBuffer* pcRenderState )
+{
+	for( int i = 0; i < static_cast<int>( m_apcSprites.size() ); i++ )
+	{
+		if( nullptr != m_pcRenderState )
+		{
+			m_pcRenderState->RemoveNode( m_aiRenderSlots[ i ] );
+		}
+
+		m_aiRenderSlots[ i ] = ( nullptr != pcRenderState ) ? pcRenderState->AddNode( m_apcSprites[ i ] ) : -1;
+	}
+
+	m_pcRenderState = pcRenderState;
+}
+
+void CSpriteAnimator::Step( const float fDeltaTime )
+{
+	m_fTime += fDeltaTime;
+	m_iLastChanges = 0;
+
+	const int iAnimations = static_cast<int>( m_afNextFrameTimes.size() );
+
+	// Move the clock and the next frame times back together, the animations that never change stay at infinity
+	if( m_fTime >= k_fClockPeriod )
+	{
+		m_fTime -= k_fClockPeriod;
+
+		for( int i = 0; i < iAnimations; i++ )
+		{
+			m_afNextFrameTimes[ i ] -= k_fClockPeriod;
+		}
+	}
+
+	for( int i = 0; i < iAnimations; i++ )
+	{
+		// Most animations are static or between two frames, this is the only work they cost
+		if( m_afNextFrameTimes[ i ] > m_fTime )
+		{
+			continue;
+		}
+
+		// Frames skipped by a long frame are not shown
+		const int iElapsedFrames = 1 + static_cast<int>( ( m_fTime - m_afNextFrameTimes[ i ] ) / m_afFrameTimes[ i ] );
+		int iFrame = m_aiFrames[ i ] + iElapsedFrames;
+
+		if( iFrame >= m_aiFrameCounts[ i ] )
+		{
+			iFrame = m_abLoops[ i ] ? iFrame % m_aiFrameCounts[ i ] : m_aiFrameCounts[ i ] - 1;
+		}
+
+		const bool bIsLastFrame = !m_abLoops[ i ] && ( m_aiFrameCounts[ i ] - 1 == iFrame );
+		m_afNextFrameTimes[ i ] = bIsLastFrame ? k_fNever : m_afNextFrameTimes[ i ] + iElapsedFrames * m_afFrameTimes[ i ];
+
+		if( iFrame != m_aiFrames[ i ] )
+		{
+			m_aiFrames[ i ] = iFrame;
+			ShowFrame( i );
+		}
+	}
+}
+
+void CSpriteAnimator::ShowFrame( const int iIndex )
+{
+	cocos2d::Rect cFrame = m_acFirstFrames[ iIndex ];
+	cFrame.origin.x += cFrame.size.width * m_aiFrames[ iIndex ];
+
+	if( nullptr != m_pcRenderState )
+	{
+		m_pcRenderState->SetTextureRect( m_aiRenderSlots[ iIndex ], cFrame );
+	}
+	else
+	{
+		m_apcSprites[ iIndex ]->setTextureRect( cFrame );
+	}
+
+	m_iLastChanges++;
+}
+
+int CSpriteAnimator::GetAnimationCount() const	{ return static_cast<int>( m_apcSprites.size() ); }
+
+int CSpriteAnimator::GetLastChanges() const		{ return m_iLastChanges; }
@@ -0,0 +1,121 @@
+#ifndef SPRITEANIMATOR_H
+#define SPRITEANIMATOR_H
+
+#include <vector>
+
+#include <cocos/math/CCGeometry.h>
+
+namespace cocos2d
+{
+	class Sprite;
+}
+
+class CRenderStateBuffer;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CSpriteAnimator
+// Purpose				: To animate the sprite sheets of every registered sprite from one place. The state of the animations
+//						: is kept in parallel arrays, one entry per sprite: its row in the sheet, frame count, frame time,
+//						: loop flag, shown frame and the time of its next frame. Step() advances the clock once per frame
+//						: and only sets the texture rect of the sprites whose frame changes, so a static sprite costs one
+//						: comparison and the rects touched follow the amount of frame changes, not of sprites
+// Notes				: Frames of a row are laid left to right, each one the size of the sprite's texture rect when it was
+//						: registered. Handles stay valid until the sprite is unregistered. Given a render state buffer, the
+//						: frames are written in it instead of the sprites, so that Step() can run on the simulation thread
+// Example				: const int iAnimation = cAnimator.Register( pcPort );
+//						: cAnimator.SetState( iAnimation, 0.0f, true, 0.1f, 4 ); cAnimator.Step( fDeltaTime );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CSpriteAnimator
+{
+
+private:
+
+	// Animated sprites and their frames, indexed by the dense position of the animation
+	std::vector<cocos2d::Sprite*>	m_apcSprites;
+	std::vector<cocos2d::Rect>		m_acFirstFrames;
+
+	// State of the animations
+	std::vector<int>	m_aiFrameCounts;
+	std::vector<float>	m_afFrameTimes;
+	std::vector<bool>	m_abLoops;
+	std::vector<int>	m_aiFrames;
+	std::vector<float>	m_afNextFrameTimes;
+
+	// Dense position of every handle and handle of every dense position, removals move the last animation in the hole
+	std::vector<int>	m_aiHandleToIndex;
+	std::vector<int>	m_aiIndexToHandle;
+	std::vector<int>	m_aiFreeHandles;
+
+	// Clock of the animations, moved back by a fixed period from time to time so that it stays small
+	float m_fTime;
+
+	// Texture rects set by the last Step()
+	int m_iLastChanges;
+
+	// Buffer the frames are written to instead of the sprites, nullptr to set them straight away
+	CRenderStateBuffer* m_pcRenderState;
+
+	// Slot of every sprite in the render state buffer, indexed by the dense position of the animation
+	std::vector<int> m_aiRenderSlots;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ShowFrame()
+	// Parameters		: iIndex			- Dense position of the animation
+	// Purpose			: Set the sprite's texture rect to the animation's current frame
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ShowFrame( const int iIndex );
+
+public:
+
+	CSpriteAnimator();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Register()
+	// Parameters		: pcSprite			- Sprite to animate, its texture rect is the first frame of the first row
+	// Purpose			: Add a static animation of the sprite showing its current frame
+	// Returns			: The handle of the animation
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int Register( cocos2d::Sprite* pcSprite );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Unregister()
+	// Parameters		: iHandle			- Handle returned by Register()
+	// Purpose			: Stop animating the sprite, its frame is left as it is
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Unregister( const int iHandle );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetState()
+	// Parameters		: iHandle			- Handle returned by Register()
+	//					: fRowY				- Top of the row in the sprite sheet, in the units of the sprite's texture rect
+	//					: bLoop				- True to start again after the last frame, false to stay on it
+	//					: fFrameTime		- Seconds each frame is shown, 0 shows the first frame only
+	//					: iFrames			- Amount of frames in the row
+	// Purpose			: Start the animation of a row from its first frame, shown straight away. Same arguments as
+	//					: CSpriteObject::SetAnimationState()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetState( const int iHandle, const float fRowY, const bool bLoop, const float fFrameTime, const int iFrames );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetRenderState()
+	// Parameters		: pcRenderState		- Buffer the frames are written to, nullptr to set them on the sprites
+	// Purpose			: Bind every animated sprite to the buffer, and unbind them from the previous one. The caller applies
+	//					: the frames still held by the previous buffer before switching
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetRenderState( CRenderStateBuffer* pcRenderState );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Step()
+	// Parameters		: fDeltaTime		- Time since the last frame
+	// Purpose			: Advance every animation and show the frames that changed, or write them in the render state buffer
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Step( const float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Getters
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetAnimationCount() const;
+	int GetLastChanges() const;
+};
+
+#endif // !SPRITEANIMATOR_H
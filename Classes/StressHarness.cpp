@@ -0,0 +1,254 @@
+#include "StressHarness.h"
+
+#include "AllocationTracker.h"
+#include "LevelContext.h"
+#include "LevelManager.h"
+#include "LoadingScreen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <CCDirector.h>
+#include <cocos/2d/CCScene.h>
+#include <cocos/base/ccMacros.h>
+#include <cocos/physics/CCPhysicsWorld.h>
+#include <cocos/platform/CCFileUtils.h>
+
+// Fixed step of the simulated frames
+static const float k_fFrameTime = 1.0f / 60.0f;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: GrowthExponent()
+// Parameters		: fCost				- Cost of a run
+//					: fFirstCost		- Same cost in the first run
+//					: fObjectRatio		- Objects of the run divided by the objects of the first run
+// Returns			: The exponent of the amount of objects the cost follows, 0 if either run measured nothing
+//-----------------------------------------------------------------------------------------------------------------------------
+static float GrowthExponent( const float fCost, const float fFirstCost, const float fObjectRatio )
+{
+	if( fCost <= 0.0f || fFirstCost <= 0.0f || fObjectRatio <= 1.0f )
+	{
+		return 0.0f;
+	}
+
+	return logf( fCost / fFirstCost ) / logf( fObjectRatio );
+}
+
+CStressHarness::CStressHarness( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD )
+	: m_pcTextureManager( pcTextureManager )
+	, m_pcPickupsManager( pcPickupsManager )
+	, m_pcHUD( pcHUD )
+	, m_bRequireNoAllocations( false )
+	, m_bIsPipelined( false )
+{}
+
+bool CStressHarness::Run( const CStressLevel::SSettings& rsSettings, const std::string& rsMapFile, const int iFramesPerStage )
+{
+	SResult sResult = {};
+	sResult.iStages = std::max( 1, rsSettings.iStages );
+
+	if( !CStressLevel::Write( rsSettings, rsMapFile, &sResult.iObjects ) )
+	{
+		return false;
+	}
+
+	// The level runs on its own systems, its scene only holds the physics world stepped below. Its camera would see what
+	// the game's does
+	const cocos2d::Director* pcDirector = cocos2d::Director::getInstance();
+	CLevelContext* pcContext = CLevelContext::CreateIsolated( 1.0f,
+		cocos2d::Rect( pcDirector->getVisibleOrigin(), pcDirector->getVisibleSize() ) );
+
+	cocos2d::Scene* pcScene = cocos2d::Scene::createWithPhysics();
+	pcScene->retain();
+	pcContext->ApplyTo( pcScene );
+
+	cocos2d::PhysicsWorld* pcPhysicsWorld = pcScene->getPhysicsWorld();
+	pcPhysicsWorld->setAutoStep( false );
+
+	{
+		CLevelManager cLevelManager;
+
+		// Initialised in slices like the loading screen does, the longest slice is the worst frame the player would see
+		const std::chrono::steady_clock::time_point cStart = std::chrono::steady_clock::now();
+		cLevelManager.BeginInitialise( m_pcTextureManager, m_pcPickupsManager, m_pcHUD, pcContext, rsMapFile );
+
+		while( !cLevelManager.ContinueInitialise( CLoadingScreen::k_fDefaultBudgetMs ) )
+		{
+		}
+
+		sResult.fInitialiseMs = std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - cStart ).count();
+		sResult.fLongestInitialiseSliceMs = cLevelManager.GetLongestInitialiseSliceMs();
+
+		// Entering the scene adds the bodies to the physics world, as running it from the Director would
+		pcScene->addChild( cLevelManager.GetCurrentLevel() );
+		pcScene->onEnter();
+		cLevelManager.TunePhysics( pcPhysicsWorld );
+		cLevelManager.SetPipelined( m_bIsPipelined );
+
+		const cocos2d::Size cTileSize = cLevelManager.GetCurrentLevel()->getTileSize();
+		const float fStageWidth = rsSettings.iStageColumns * cTileSize.width;
+
+		// Camera's view in the map's coordinates, following the player
+		const cocos2d::Size cVisibleSize = pcContext->GetVisibleRect().size;
+		const cocos2d::Size cViewSize( cVisibleSize.width / cLevelManager.GetCurrentLevel()->getScaleX(),
+			cVisibleSize.height / cLevelManager.GetCurrentLevel()->getScaleY() );
+		const int iFrames = std::max( 1, iFramesPerStage );
+
+		CLevelManager::SLevelStats sStats;
+		CInputLatencyTracker& rcLatency = cLevelManager.GetInputLatency();
+
+		// Every allocation of the played frames is counted, the stage transitions allow their own
+		AllocationTracker::Reset();
+		AllocationTracker::TrackThisThread( true );
+
+		for( int iStage = 0; iStage < sResult.iStages; iStage++ )
+		{
+			cLevelManager.LoadNewStage( iStage );
+
+			cLevelManager.GetStats( sStats );
+			sResult.fStageTransitionMs += sStats.fStageTransitionMs;
+			sResult.fMaxStageTransitionMs = std::max( sResult.fMaxStageTransitionMs, sStats.fStageTransitionMs );
+
+			for( int iFrame = 0; iFrame < iFrames; iFrame++ )
+			{
+				// Player walking along the floor from one end of the stage to the other
+				const float fPlayerX = ( iStage + static_cast<float>( iFrame ) / iFrames ) * fStageWidth;
+				const cocos2d::Rect cPlayerBounds( fPlayerX, cTileSize.height, cTileSize.width, cTileSize.height * 2.0f );
+
+				// Synthetic input arriving before the update on even frames and after it on odd ones, which waits a frame
+				const bool bInputBeforeUpdate = ( 0 == iFrame % 2 );
+
+				if( bInputBeforeUpdate )
+				{
+					rcLatency.OnInput();
+				}
+
+				pcContext->Step( k_fFrameTime );
+				cLevelManager.UpdateTriggers( cPlayerBounds, k_fFrameTime );
+				cLevelManager.Update( k_fFrameTime );
+				cLevelManager.UpdateEnemies( cocos2d::Rect( cPlayerBounds.getMidX() - cViewSize.width * 0.5f,
+					cPlayerBounds.getMidY() - cViewSize.height * 0.5f, cViewSize.width, cViewSize.height ), k_fFrameTime );
+				cLevelManager.StepPhysics( pcPhysicsWorld, k_fFrameTime );
+				cLevelManager.BeginSimulation( k_fFrameTime );
+
+				if( !bInputBeforeUpdate )
+				{
+					rcLatency.OnInput();
+				}
+
+				// Nothing is drawn, the frame is done once its physics are stepped
+				rcLatency.OnFramePresented();
+				AllocationTracker::EndFrame();
+
+				cLevelManager.GetStats( sStats );
+				sResult.fUpdateMs += sStats.fUpdateMs;
+				sResult.fEnemiesMs += sStats.fEnemiesMs;
+				sResult.fPhysicsMs += sStats.fPhysicsMs;
+				sResult.fSimulationMs += sStats.fSimulationMs;
+				sResult.fSimulationWaitMs += sStats.fSimulationWaitMs;
+				sResult.iEnvironmentShapes = sStats.iEnvironmentShapes;
+				sResult.iMaxEntityShapes = std::max( sResult.iMaxEntityShapes, sStats.iEntityShapes );
+			}
+		}
+
+		AllocationTracker::TrackThisThread( false );
+
+		AllocationTracker::SReport sAllocations;
+		AllocationTracker::GetReport( sAllocations );
+		sResult.iPlayAllocations = sAllocations.iAllocations;
+		sResult.iFramesWithAllocations = sAllocations.iFramesWithAllocations;
+
+		if( sResult.iPlayAllocations > 0 )
+		{
+			AllocationTracker::LogCallSites( 10 );
+		}
+
+		sResult.fStageTransitionMs /= sResult.iStages;
+		sResult.fUpdateMs /= sResult.iStages * iFrames;
+		sResult.fEnemiesMs /= sResult.iStages * iFrames;
+		sResult.fPhysicsMs /= sResult.iStages * iFrames;
+		sResult.fSimulationMs /= sResult.iStages * iFrames;
+		sResult.fSimulationWaitMs /= sResult.iStages * iFrames;
+
+		rcLatency.GetReport( sResult.sLatency );
+
+		pcScene->onExit();
+	}
+
+	// The map's nodes unregister from the context's dispatcher when they are released, so the context goes last
+	pcScene->release();
+	CC_SAFE_DELETE( pcContext );
+
+	m_asResults.push_back( sResult );
+
+	return !m_bRequireNoAllocations || 0 == sResult.iPlayAllocations;
+}
+
+void CStressHarness::SetAllocationFreeRequired( const bool bIsRequired )
+{
+	m_bRequireNoAllocations = bIsRequired;
+}
+
+void CStressHarness::SetPipelined( const bool bIsPipelined )
+{
+	m_bIsPipelined = bIsPipelined;
+}
+
+bool CStressHarness::RunScaling( const CStressLevel::SSettings& rsSettings, std::initializer_list<int> aiFactors,
+	const int iFramesPerStage )
+{
+	const std::string sWritablePath = cocos2d::FileUtils::getInstance()->getWritablePath();
+	bool bHasSucceeded = true;
+
+	for( const int iFactor : aiFactors )
+	{
+		bHasSucceeded &= Run( rsSettings.Scaled( iFactor ), sWritablePath + "StressLevel" + std::to_string( iFactor ) + ".tmx",
+			iFramesPerStage );
+	}
+
+	return bHasSucceeded;
+}
+
+void CStressHarness::Report() const
+{
+	if( m_asResults.empty() )
+	{
+		return;
+	}
+
+	const SResult& rsFirst = m_asResults.front();
+
+	CCLOG( "Stress | stages | objects | init ms | stage ms (max) | update ms | physics ms | env shapes | entity shapes" );
+
+	for( const SResult& rsResult : m_asResults )
+	{
+		const float fObjectRatio = static_cast<float>( rsResult.iObjects ) / std::max( 1, rsFirst.iObjects );
+
+		CCLOG( "Stress | %6d | %7d | %7.2f | %6.2f (%6.2f) | %9.3f | %10.3f | %10d | %13d",
+			rsResult.iStages, rsResult.iObjects, rsResult.fInitialiseMs, rsResult.fStageTransitionMs,
+			rsResult.fMaxStageTransitionMs, rsResult.fUpdateMs, rsResult.fPhysicsMs, rsResult.iEnvironmentShapes,
+			rsResult.iMaxEntityShapes );
+
+		CCLOG( "Stress | growth x%.1f objects: init %.2f, stage %.2f, update %.2f, physics %.2f", fObjectRatio,
+			GrowthExponent( rsResult.fInitialiseMs, rsFirst.fInitialiseMs, fObjectRatio ),
+			GrowthExponent( rsResult.fStageTransitionMs, rsFirst.fStageTransitionMs, fObjectRatio ),
+			GrowthExponent( rsResult.fUpdateMs, rsFirst.fUpdateMs, fObjectRatio ),
+			GrowthExponent( rsResult.fPhysicsMs, rsFirst.fPhysicsMs, fObjectRatio ) );
+
+		CCLOG( "Stress | initialisation frame of %.2f ms at most, budget %.2f ms", rsResult.fLongestInitialiseSliceMs,
+			CLoadingScreen::k_fDefaultBudgetMs );
+
+		CCLOG( "Stress | enemies update %.3f ms", rsResult.fEnemiesMs );
+
+		CCLOG( "Stress | simulation thread %.3f ms, update waited %.3f ms", rsResult.fSimulationMs, rsResult.fSimulationWaitMs );
+
+		CCLOG( "Stress | %d allocations during play in %d frames", rsResult.iPlayAllocations, rsResult.iFramesWithAllocations );
+
+		CCLOG( "Stress | input to frame p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms",
+			rsResult.sLatency.sInputToPresent.fP50Ms, rsResult.sLatency.sInputToPresent.fP90Ms,
+			rsResult.sLatency.sInputToPresent.fP99Ms, rsResult.sLatency.sInputToPresent.fMaxMs );
+	}
+}
+
+const std::vector<CStressHarness::SResult>& CStressHarness::GetResults() const { return m_asResults; }
@@ -0,0 +1,133 @@
+#ifndef STRESSHARNESS_H
+#define STRESSHARNESS_H
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "InputLatency.h"
+#include "StressLevel.h"
+
+class CHUD;
+class CPickupsManager;
+class CTextureManager;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CStressHarness
+// Purpose				: To play stress levels without rendering and measure how the level scales. Every run writes a level
+//						: with CStressLevel, initialises it on an isolated context, then loads each stage in turn and
+//						: plays it for a fixed amount of frames, with a player box walking across the stage through the
+//						: trigger grid and a synthetic input every frame. The report compares every run with the first one
+// Notes				: Runs block until done, start them from a debug key or a command line switch rather than during
+//						: play. The managers given are shared by the runs, like they are by the game's levels
+// Example				: CStressHarness cHarness( pcTextureManager, pcPickupsManager, pcHUD );
+//						: cHarness.RunScaling( CStressLevel::SSettings(), { 1, 10, 100 }, 120 ); cHarness.Report();
+//-----------------------------------------------------------------------------------------------------------------------------
+class CStressHarness
+{
+
+public:
+
+	// Costs measured by a run, the per frame costs are averaged over every frame of every stage
+	struct SResult
+	{
+		int		iStages;
+		int		iObjects;
+		// Time spent initialising the level and longest slice of the initialisation, in milliseconds
+		float	fInitialiseMs;
+		float	fLongestInitialiseSliceMs;
+		// Average and longest stage transition, in milliseconds
+		float	fStageTransitionMs;
+		float	fMaxStageTransitionMs;
+		// Average update, enemies update and physics step, in milliseconds
+		float	fUpdateMs;
+		float	fEnemiesMs;
+		float	fPhysicsMs;
+		// Average time of the simulation thread and time the update waited for it, 0 unless the level is pipelined
+		float	fSimulationMs;
+		float	fSimulationWaitMs;
+		// Shapes of the environment's body, and the most shapes of the active entities seen in a stage
+		int		iEnvironmentShapes;
+		int		iMaxEntityShapes;
+		// Latency of the synthetic input, from its arrival to the end of the frame's physics step
+		CInputLatencyTracker::SReport	sLatency;
+		// Heap allocations made by the played frames outside the stage transitions, 0 if the build does not track them
+		int		iPlayAllocations;
+		int		iFramesWithAllocations;
+	};
+
+private:
+
+	CTextureManager* m_pcTextureManager;
+	CPickupsManager* m_pcPickupsManager;
+	CHUD* m_pcHUD;
+
+	// Results of the runs, in the order they were made
+	std::vector<SResult> m_asResults;
+
+	// True if a run fails when a played frame allocates
+	bool m_bRequireNoAllocations;
+
+	// True if the levels simulate on the simulation thread, see CLevelManager::SetPipelined()
+	bool m_bIsPipelined;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CStressHarness()
+	// Parameters		: pcTextureManager	- The texture manager of the game
+	//					: pcPickupsManager	- The pickup manager of the game
+	//					: pcHUD				- The HUD passed to the checkpoints
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CStressHarness( CTextureManager* pcTextureManager, CPickupsManager* pcPickupsManager, CHUD* pcHUD );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Run()
+	// Parameters		: rsSettings		- Size and content of the level
+	//					: rsMapFile			- Path the level is written to
+	//					: iFramesPerStage	- Frames played in every stage
+	// Purpose			: Write the level, play all its stages and store the result
+	// Returns			: False if the level could not be written, or if a played frame allocated while allocation free
+	//					: frames are required
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool Run( const CStressLevel::SSettings& rsSettings, const std::string& rsMapFile, const int iFramesPerStage );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetAllocationFreeRequired()
+	// Parameters		: bIsRequired		- True to fail the runs whose played frames allocate, e.g. in an automated run
+	// Notes			: Allocations are only tracked by builds with ALLOCATION_TRACKING, see AllocationTracker
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetAllocationFreeRequired( const bool bIsRequired );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: SetPipelined()
+	// Parameters		: bIsPipelined		- True to play the next runs with the simulation on its own thread
+	// Notes			: Nothing is rendered, so the simulation overlaps the end of the frame only, not a draw
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void SetPipelined( const bool bIsPipelined );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: RunScaling()
+	// Parameters		: rsSettings		- Settings of the smallest level
+	//					: aiFactors			- Multipliers of the amount of objects, one run each
+	//					: iFramesPerStage	- Frames played in every stage
+	// Purpose			: Run the same level at every scale, the levels are written in the writable path
+	// Returns			: False if any run failed
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool RunScaling( const CStressLevel::SSettings& rsSettings, std::initializer_list<int> aiFactors, const int iFramesPerStage );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Report()
+	// Purpose			: Log a row per run with its costs, and how fast each cost grows compared to the amount of objects
+	//					: since the first run: 1 is linear, 0 is constant
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Report() const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetResults()
+	// Returns			: The results of the runs, in the order they were made
+	//-----------------------------------------------------------------------------------------------------------------------------
+	const std::vector<SResult>& GetResults() const;
+};
+
+#endif // !STRESSHARNESS_H
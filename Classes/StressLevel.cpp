@@ -0,0 +1,335 @@
+#include "StressLevel.h"
+
+#include "EntityRegistry.h"
+#include "Settings.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include <cocos/base/ccMacros.h>
+#include <cocos/platform/CCFileUtils.h>
+
+// Smallest stage holding the fixed objects of a stage: bounds, checkpoint, ports and exit door
+static const int k_iMinStageColumns = 16;
+static const int k_iMinStageRows = 12;
+
+// Size of the platforms in tiles, every platform of a type shares the collider of the type's first platform
+static const int k_iPlatformColumns = 3;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CTmxWriter
+// Purpose				: To append the object groups of the stress level to its TMX document. Objects are given in tiles
+//						: from the bottom left of the map, like the map's nodes, and written in pixels from the top left
+//						: like Tiled does
+//-----------------------------------------------------------------------------------------------------------------------------
+class CTmxWriter
+{
+
+private:
+
+	std::string m_sDocument;
+	int m_iTileSize;
+	int m_iMapRows;
+	int m_iNextID;
+
+public:
+
+	CTmxWriter( const int iTileSize, const int iMapRows )
+		: m_iTileSize( iTileSize )
+		, m_iMapRows( iMapRows )
+		, m_iNextID( 1 )
+	{}
+
+	void BeginGroup( const std::string& rsName )
+	{
+		m_sDocument += " <objectgroup name=\"" + rsName + "\">\n";
+	}
+
+	void EndGroup()
+	{
+		m_sDocument += " </objectgroup>\n";
+	}
+
+	void AddObject( const int iColumn, const int iRow, const int iColumns, const int iRows, const std::string& rsName = "",
+		const std::string& rsType = "" )
+	{
+		char szObject[ 256 ];
+		snprintf( szObject, sizeof( szObject ), "  <object id=\"%d\"%s%s%s%s%s%s x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"/>\n",
+			m_iNextID++,
+			rsName.empty() ? "" : " name=\"", rsName.c_str(), rsName.empty() ? "" : "\"",
+			rsType.empty() ? "" : " type=\"", rsType.c_str(), rsType.empty() ? "" : "\"",
+			iColumn * m_iTileSize, ( m_iMapRows - iRow - iRows ) * m_iTileSize, iColumns * m_iTileSize, iRows * m_iTileSize );
+
+		m_sDocument += szObject;
+	}
+
+	const std::string& GetDocument() const	{ return m_sDocument; }
+
+	int GetObjectCount() const				{ return m_iNextID - 1; }
+
+	int GetNextID() const					{ return m_iNextID; }
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: RandomInRange()
+// Parameters		: rcRandom			- Generator of the level
+//					: iMin				- Smallest value
+//					: iMax				- Biggest value, the smallest one is returned if it is lower
+// Returns			: A random value in the range
+//-----------------------------------------------------------------------------------------------------------------------------
+static int RandomInRange( std::mt19937& rcRandom, const int iMin, const int iMax )
+{
+	return ( iMax <= iMin ) ? iMin : std::uniform_int_distribution<int>( iMin, iMax )( rcRandom );
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Function Name	: WriteStageEntities()
+// Parameters		: rcWriter			- Writer of the document
+//					: rcRandom			- Generator of the level
+//					: iStage			- ID of the stage, -1 for the pre-initialisation stage
+//					: iFirstColumn		- First column of the stage's room
+//					: rsSettings		- Size and content of the level
+// Purpose			: Write the "Platforms N", "Pickups N", "Ports N" and "Enemies N" groups of the stage. The
+//					: pre-initialisation stage gets one object of each kind, which sets up the colliders of the pools
+//-----------------------------------------------------------------------------------------------------------------------------
+static void WriteStageEntities( CTmxWriter& rcWriter, std::mt19937& rcRandom, const int iStage, const int iFirstColumn,
+	const CStressLevel::SSettings& rsSettings )
+{
+	const bool bIsPreInitialisation = ( -1 == iStage );
+	const std::string sStage = std::to_string( iStage );
+	const int iColumns = rsSettings.iStageColumns;
+	const int iRows = rsSettings.iStageRows;
+
+	// Platforms are shared between the types, a type whose pool is full gets no more platforms
+	rcWriter.BeginGroup( "Platforms " + sStage );
+
+	int aiPlatforms[ EntityRegistry::k_iNumOfPlatformTypes ] = {};
+	const int iPlatforms = bIsPreInitialisation ? EntityRegistry::k_iNumOfPlatformTypes : rsSettings.iPlatforms;
+
+	for( int i = 0; i < iPlatforms; i++ )
+	{
+		const int iType = i % EntityRegistry::k_iNumOfPlatformTypes;
+		const EntityRegistry::SPlatformType& rsType = EntityRegistry::k_asPlatformTypes[ iType ];
+
+		if( aiPlatforms[ iType ] < rsType.iPoolSize )
+		{
+			rcWriter.AddObject( RandomInRange( rcRandom, iFirstColumn + 2, iFirstColumn + iColumns - k_iPlatformColumns - 2 ),
+				RandomInRange( rcRandom, 3, iRows - 4 ), k_iPlatformColumns, 1, "", rsType.pszTypeName );
+			aiPlatforms[ iType ]++;
+		}
+	}
+
+	rcWriter.EndGroup();
+
+	// At least one port per stage, each one activated by a key pickup
+	const int iPorts = bIsPreInitialisation ? 1 : std::max( 1, std::min( rsSettings.iPorts, Ports::k_iMaxAmountOfPorts ) );
+
+	rcWriter.BeginGroup( "Pickups " + sStage );
+
+	for( int i = 0; i < iPorts; i++ )
+	{
+		rcWriter.AddObject( iFirstColumn + ( i + 1 ) * iColumns / ( iPorts + 1 ), iRows / 2, 1, 1, "", rsSettings.sKeyPickupType );
+	}
+
+	rcWriter.EndGroup();
+
+	rcWriter.BeginGroup( "Ports " + sStage );
+
+	for( int i = 0; i < iPorts; i++ )
+	{
+		rcWriter.AddObject( iFirstColumn + ( i + 1 ) * iColumns / ( iPorts + 1 ), 1, 2, 2 );
+	}
+
+	rcWriter.EndGroup();
+
+	const int iEnemies = bIsPreInitialisation ? 1 : std::min( rsSettings.iEnemies, Enemies::k_iMaxAmountOfEnemies );
+
+	// A stage without enemies has no enemy group, like in the shipped maps
+	if( iEnemies > 0 )
+	{
+		rcWriter.BeginGroup( "Enemies " + sStage );
+
+		for( int i = 0; i < iEnemies; i++ )
+		{
+			rcWriter.AddObject( RandomInRange( rcRandom, iFirstColumn + 2, iFirstColumn + iColumns - 3 ), 1, 1, 1 );
+		}
+
+		rcWriter.EndGroup();
+	}
+}
+
+CStressLevel::SSettings::SSettings()
+	: iStages( 6 )
+	, iStageColumns( 60 )
+	, iStageRows( 34 )
+	, iTileSize( 32 )
+	, iFloorSegments( 3 )
+	, iWalls( 4 )
+	, iObstacles( 3 )
+	, iClimbables( 2 )
+	, iPlatforms( 6 )
+	, iPorts( 2 )
+	, iEnemies( 3 )
+	, sKeyPickupType( "Chip" )
+	, uiSeed( 1 )
+{}
+
+CStressLevel::SSettings CStressLevel::SSettings::Scaled( const int iFactor ) const
+{
+	const int iScale = std::max( 1, iFactor );
+
+	SSettings sScaled = *this;
+	sScaled.iStages = iStages * iScale;
+
+	// Every group of a stage gets denser too, the entities stop growing once their pools are full
+	sScaled.iWalls = iWalls * iScale;
+	sScaled.iObstacles = iObstacles * iScale;
+	sScaled.iClimbables = iClimbables * iScale;
+	sScaled.iPlatforms = iPlatforms * iScale;
+	sScaled.iPorts = iPorts * iScale;
+	sScaled.iEnemies = iEnemies * iScale;
+	return sScaled;
+}
+
+std::string CStressLevel::Generate( const SSettings& rsSettings, int* piObjects )
+{
+	SSettings sSettings = rsSettings;
+	sSettings.iStages = std::max( 1, sSettings.iStages );
+	sSettings.iStageColumns = std::max( k_iMinStageColumns, sSettings.iStageColumns );
+	sSettings.iStageRows = std::max( k_iMinStageRows, sSettings.iStageRows );
+	sSettings.iFloorSegments = std::max( 1, sSettings.iFloorSegments );
+
+	const int iMapColumns = sSettings.iStages * sSettings.iStageColumns;
+	const int iMapRows = sSettings.iStageRows;
+	const int iColumns = sSettings.iStageColumns;
+	const int iRows = sSettings.iStageRows;
+
+	CTmxWriter cWriter( sSettings.iTileSize, iMapRows );
+	std::mt19937 cRandom( sSettings.uiSeed );
+
+	// Environment groups, every one of them is expected to hold objects
+	for( const EntityRegistry::SEnvironmentGroup& rsGroup : EntityRegistry::k_asEnvironmentGroups )
+	{
+		const std::string sGroup = rsGroup.pszGroupName;
+
+		cWriter.BeginGroup( sGroup );
+
+		for( int iStage = 0; iStage < sSettings.iStages; iStage++ )
+		{
+			const int iFirstColumn = iStage * iColumns;
+
+			if( "Stage Bounds" == sGroup )
+			{
+				// Ceiling of every stage and the two ends of the map
+				cWriter.AddObject( iFirstColumn, iRows - 1, iColumns, 1 );
+
+				if( 0 == iStage )
+				{
+					cWriter.AddObject( 0, 0, 1, iRows );
+				}
+
+				if( sSettings.iStages - 1 == iStage )
+				{
+					cWriter.AddObject( iMapColumns - 1, 0, 1, iRows );
+				}
+			}
+			else if( "Floor" == sGroup )
+			{
+				// Segments split by one tile gaps, the last one reaches the end of the stage
+				const int iSegmentColumns = std::max( 2, iColumns / sSettings.iFloorSegments );
+
+				for( int iColumn = 0; iColumn < iColumns; iColumn += iSegmentColumns )
+				{
+					const int iSegmentEnd = std::min( iColumns, iColumn + iSegmentColumns );
+					const int iGap = ( iSegmentEnd == iColumns ) ? 0 : 1;
+					cWriter.AddObject( iFirstColumn + iColumn, 0, iSegmentEnd - iColumn - iGap, 1 );
+				}
+			}
+			else if( "Walls" == sGroup )
+			{
+				for( int i = 0; i < std::max( 1, sSettings.iWalls ); i++ )
+				{
+					cWriter.AddObject( RandomInRange( cRandom, iFirstColumn + 2, iFirstColumn + iColumns - 3 ),
+						RandomInRange( cRandom, 2, iRows - 5 ), 1, 3 );
+				}
+			}
+			else if( "Obstacles" == sGroup )
+			{
+				for( int i = 0; i < std::max( 1, sSettings.iObstacles ); i++ )
+				{
+					cWriter.AddObject( RandomInRange( cRandom, iFirstColumn + 2, iFirstColumn + iColumns - 3 ), 1, 1, 1 );
+				}
+			}
+			else
+			{
+				// Climbable walls and any group registered later
+				for( int i = 0; i < std::max( 1, sSettings.iClimbables ); i++ )
+				{
+					cWriter.AddObject( RandomInRange( cRandom, iFirstColumn + 2, iFirstColumn + iColumns - 3 ), 1, 1, 4 );
+				}
+			}
+		}
+
+		cWriter.EndGroup();
+	}
+
+	// The pre-initialisation stage lies in the first room, its objects are never claimed
+	WriteStageEntities( cWriter, cRandom, -1, 0, sSettings );
+
+	for( int iStage = 0; iStage < sSettings.iStages; iStage++ )
+	{
+		WriteStageEntities( cWriter, cRandom, iStage, iStage * iColumns, sSettings );
+	}
+
+	cWriter.BeginGroup( "Checkpoints" );
+
+	for( int iStage = 0; iStage < sSettings.iStages; iStage++ )
+	{
+		cWriter.AddObject( iStage * iColumns + 1, 1, 1, 2, "Checkpoint" + std::to_string( iStage ) );
+	}
+
+	cWriter.EndGroup();
+
+	cWriter.BeginGroup( "ExitDoors" );
+
+	for( int iStage = -1; iStage < sSettings.iStages; iStage++ )
+	{
+		cWriter.AddObject( std::max( 0, iStage ) * iColumns + iColumns - 3, 1, 2, 3, "ExitDoor " + std::to_string( iStage ) );
+	}
+
+	cWriter.EndGroup();
+
+	if( nullptr != piObjects )
+	{
+		*piObjects = cWriter.GetObjectCount();
+	}
+
+	char szMap[ 256 ];
+	snprintf( szMap, sizeof( szMap ), "<map version=\"1.0\" orientation=\"orthogonal\" renderorder=\"right-down\" "
+		"width=\"%d\" height=\"%d\" tilewidth=\"%d\" tileheight=\"%d\" nextobjectid=\"%d\">\n",
+		iMapColumns, iMapRows, sSettings.iTileSize, sSettings.iTileSize, cWriter.GetNextID() );
+
+	return std::string( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" ) + szMap + cWriter.GetDocument() + "</map>\n";
+}
+
+bool CStressLevel::Write( const SSettings& rsSettings, const std::string& rsMapFile, int* piObjects )
+{
+	int iObjects = 0;
+	const std::string sDocument = Generate( rsSettings, &iObjects );
+
+	if( !cocos2d::FileUtils::getInstance()->writeStringToFile( sDocument, rsMapFile ) )
+	{
+		CCLOG( "Stress level: could not write %s", rsMapFile.c_str() );
+		return false;
+	}
+
+	CCLOG( "Stress level: %d stages, %d objects written to %s", std::max( 1, rsSettings.iStages ), iObjects, rsMapFile.c_str() );
+
+	if( nullptr != piObjects )
+	{
+		*piObjects = iObjects;
+	}
+
+	return true;
+}
@@ -0,0 +1,77 @@
+#ifndef STRESSLEVEL_H
+#define STRESSLEVEL_H
+
+#include <string>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CStressLevel
+// Purpose				: To write Tiled maps far bigger than the shipped levels, used to measure how the level's loading,
+//						: stage transitions, update and physics scale with the amount of objects. The map has every group
+//						: the level manager reads: the environment groups of the entity registry, "Platforms N",
+//						: "Pickups N", "Ports N" and "Enemies N" for every stage and for the pre-initialisation stage,
+//						: "Checkpoints" and "ExitDoors". Stages are rooms laid side by side, filled at random from a seed
+// Notes				: The map has no tile layer, only objects. The entities of a stage are capped to their pool sizes in
+//						: Settings.h, so bigger levels get more stages or a denser environment
+// Example				: CStressLevel::SSettings sSettings; sSettings.iStages = 100;
+//						: CStressLevel::Write( sSettings, sWritablePath + "Stress100.tmx" );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CStressLevel
+{
+
+public:
+
+	// Size and content of the generated level, the counts are per stage
+	struct SSettings
+	{
+		// Amount of stages and size of a stage in tiles
+		int				iStages;
+		int				iStageColumns;
+		int				iStageRows;
+		// Size of a tile in pixels
+		int				iTileSize;
+		// Environment objects
+		int				iFloorSegments;
+		int				iWalls;
+		int				iObstacles;
+		int				iClimbables;
+		// Entities, capped to their pool sizes, platforms are shared between the registered platform types
+		int				iPlatforms;
+		int				iPorts;
+		int				iEnemies;
+		// Type of the pickups collected to activate the ports, one per port
+		std::string		sKeyPickupType;
+		// Seed of the random placement, the same settings always give the same map
+		unsigned int	uiSeed;
+
+		// Settings of a level about the size of a shipped one
+		SSettings();
+
+		//-----------------------------------------------------------------------------------------------------------------------------
+		// Function Name	: Scaled()
+		// Parameters		: iFactor			- Multiplier of the amount of objects
+		// Purpose			: Multiply the amount of stages and the objects of every group of a stage. The entities are
+		//					: capped to their pool sizes by Generate()
+		// Returns			: The scaled settings
+		//-----------------------------------------------------------------------------------------------------------------------------
+		SSettings Scaled( const int iFactor ) const;
+	};
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Generate()
+	// Parameters		: rsSettings		- Size and content of the level
+	//					: piObjects			- Set to the amount of objects in the map if not nullptr
+	// Returns			: The TMX document of the level
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static std::string Generate( const SSettings& rsSettings, int* piObjects = nullptr );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Write()
+	// Parameters		: rsSettings		- Size and content of the level
+	//					: rsMapFile			- Path of the TMX file to write
+	//					: piObjects			- Set to the amount of objects in the map if not nullptr
+	// Returns			: False if the file could not be written
+	//-----------------------------------------------------------------------------------------------------------------------------
+	static bool Write( const SSettings& rsSettings, const std::string& rsMapFile, int* piObjects = nullptr );
+};
+
+#endif // !STRESSLEVEL_H
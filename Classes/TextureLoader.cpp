@@ -0,0 +1,223 @@
+#include "TextureLoader.h"
+
+#include "DecodedImageCache.h"
+
+#include <algorithm>
+
+#include <cocos/base/ccMacros.h>
+#include <cocos/2d/CCTMXXMLParser.h>
+#include <cocos/platform/CCFileUtils.h>
+#include <cocos/platform/CCImage.h>
+#include <cocos/renderer/CCTextureCache.h>
+
+typedef std::chrono::steady_clock TClock;
+
+CTextureLoader::CTextureLoader( cocos2d::TextureCache* pcTextureCache, const CDecodedImageCache* pcDecodedImages )
+	: m_pcTextureCache( pcTextureCache )
+	, m_pcDecodedImages( pcDecodedImages )
+	, m_iNextDecode( 0 )
+	, m_iCachedImages( 0 )
+	, m_iNextUpload( 0 )
+	, m_iLoadedTextures( 0 )
+	, m_fUploadMs( 0.0f )
+{
+	CCASSERT( nullptr != m_pcTextureCache, "Texture cache is null" );
+}
+
+CTextureLoader::~CTextureLoader()
+{
+	StopWorkers();
+
+	// Images of a load left unfinished, the uploaded ones have already been released
+	for( int iIndex = m_iNextUpload; iIndex < static_cast<int>( m_apcImages.size() ); iIndex++ )
+	{
+		CC_SAFE_RELEASE( m_apcImages[ iIndex ] );
+	}
+}
+
+void CTextureLoader::AddFile( const std::string& rsFile )
+{
+	if( std::find( m_asFiles.begin(), m_asFiles.end(), rsFile ) == m_asFiles.end() )
+	{
+		m_asFiles.push_back( rsFile );
+	}
+}
+
+void CTextureLoader::AddTilesets( const std::string& rsMapFile )
+{
+	// Only the map's XML is parsed, no texture is created
+	cocos2d::TMXMapInfo* pcMapInfo = cocos2d::TMXMapInfo::create( rsMapFile );
+
+	CCASSERT( nullptr != pcMapInfo, rsMapFile.c_str() );
+
+	for( cocos2d::TMXTilesetInfo* pcTileset : pcMapInfo->getTilesets() )
+	{
+		// The parser already resolved the image's path relative to the map
+		AddFile( pcTileset->_sourceImage );
+	}
+}
+
+void CTextureLoader::BeginLoad( const bool bUseWorkerThreads )
+{
+	CCASSERT( m_acWorkers.empty() && m_iNextUpload >= static_cast<int>( m_asFullPaths.size() ), "Texture loading already running" );
+
+	m_cLoadStart = TClock::now();
+	m_fUploadMs = 0.0f;
+
+	// Resolve the paths on this thread, the file utilities' path cache is not thread safe
+	m_asFullPaths.clear();
+
+	for( const std::string& rsFile : m_asFiles )
+	{
+		const std::string sFullPath = cocos2d::FileUtils::getInstance()->fullPathForFilename( rsFile );
+
+		if( !sFullPath.empty() && nullptr == m_pcTextureCache->getTextureForKey( sFullPath ) )
+		{
+			m_asFullPaths.push_back( sFullPath );
+		}
+	}
+
+	const int iAmountOfImages = static_cast<int>( m_asFullPaths.size() );
+
+	m_apcImages.assign( iAmountOfImages, nullptr );
+	m_abDecoded.reset( new std::atomic<bool>[ iAmountOfImages ] );
+
+	for( int iIndex = 0; iIndex < iAmountOfImages; iIndex++ )
+	{
+		m_abDecoded[ iIndex ] = false;
+	}
+
+	m_iNextDecode = 0;
+	m_iCachedImages = 0;
+	m_iNextUpload = 0;
+	m_iLoadedTextures = 0;
+
+	const int iAmountOfThreads = bUseWorkerThreads
+		? std::min( iAmountOfImages, std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) ) ) : 0;
+
+	// Every worker takes the next image not decoded yet until there are none left
+	for( int i = 0; i < iAmountOfThreads; i++ )
+	{
+		m_acWorkers.emplace_back( [this, iAmountOfImages]()
+		{
+			for( int iIndex = m_iNextDecode++; iIndex < iAmountOfImages; iIndex = m_iNextDecode++ )
+			{
+				DecodeImage( iIndex );
+			}
+		} );
+	}
+}
+
+bool CTextureLoader::ContinueLoad( const int iMaxUploads )
+{
+	const int iAmountOfImages = static_cast<int>( m_asFullPaths.size() );
+	const TClock::time_point cStart = TClock::now();
+
+	// Upload on this thread, keyed by full path so later requests of the same file hit the cache
+	for( int iUploads = 0; iUploads < iMaxUploads && m_iNextUpload < iAmountOfImages; iUploads++ )
+	{
+		if( m_acWorkers.empty() )
+		{
+			DecodeImage( m_iNextUpload );
+		}
+		else if( !m_abDecoded[ m_iNextUpload ].load( std::memory_order_acquire ) )
+		{
+			// Still decoding, the next call polls it again
+			break;
+		}
+
+		cocos2d::Image* pcImage = m_apcImages[ m_iNextUpload ];
+
+		if( nullptr == pcImage )
+		{
+			CCLOG( "Texture loader: failed to decode %s", m_asFullPaths[ m_iNextUpload ].c_str() );
+		}
+		else
+		{
+			if( nullptr != m_pcTextureCache->addImage( pcImage, m_asFullPaths[ m_iNextUpload ] ) )
+			{
+				m_iLoadedTextures++;
+			}
+
+			pcImage->release();
+		}
+
+		m_iNextUpload++;
+	}
+
+	m_fUploadMs += std::chrono::duration<float, std::milli>( TClock::now() - cStart ).count();
+
+	if( m_iNextUpload < iAmountOfImages )
+	{
+		return false;
+	}
+
+	CCLOG( "Texture loader: %d textures, %d from the decoded image cache, loaded in %.2f ms on %d threads, uploads took %.2f ms",
+		m_iLoadedTextures, m_iCachedImages.load(),
+		std::chrono::duration<float, std::milli>( TClock::now() - m_cLoadStart ).count(),
+		std::max( static_cast<int>( m_acWorkers.size() ), 1 ), m_fUploadMs );
+
+	StopWorkers();
+
+	return true;
+}
+
+int CTextureLoader::GetLoadedCount() const	{ return m_iLoadedTextures; }
+
+void CTextureLoader::DecodeImage( const int iIndex )
+{
+	cocos2d::Image* pcImage = new cocos2d::Image();
+	bool bIsDecoded = false;
+
+	if( nullptr == m_pcDecodedImages )
+	{
+		bIsDecoded = pcImage->initWithImageFile( m_asFullPaths[ iIndex ] );
+	}
+	else
+	{
+		// The file is read once, hashed to find its pixels in the cache and only decoded if they are not there
+		const cocos2d::Data cSource = cocos2d::FileUtils::getInstance()->getDataFromFile( m_asFullPaths[ iIndex ] );
+		const size_t uiSourceSize = static_cast<size_t>( cSource.getSize() );
+		const uint64_t uiSourceHash = CDecodedImageCache::HashContent( cSource.getBytes(), uiSourceSize );
+
+		if( cSource.isNull() )
+		{
+			bIsDecoded = false;
+		}
+		else if( m_pcDecodedImages->Load( uiSourceHash, uiSourceSize, pcImage ) )
+		{
+			bIsDecoded = true;
+			m_iCachedImages++;
+		}
+		else if( pcImage->initWithImageData( cSource.getBytes(), cSource.getSize() ) )
+		{
+			bIsDecoded = true;
+			m_pcDecodedImages->Store( uiSourceHash, uiSourceSize, pcImage );
+		}
+	}
+
+	if( bIsDecoded )
+	{
+		m_apcImages[ iIndex ] = pcImage;
+	}
+	else
+	{
+		pcImage->release();
+	}
+
+	// Published after the image, the uploading thread reads it once it sees the flag
+	m_abDecoded[ iIndex ].store( true, std::memory_order_release );
+}
+
+void CTextureLoader::StopWorkers()
+{
+	// The workers take no new image once the next one is past the end
+	m_iNextDecode = static_cast<int>( m_asFullPaths.size() );
+
+	for( std::thread& rcWorker : m_acWorkers )
+	{
+		rcWorker.join();
+	}
+
+	m_acWorkers.clear();
+}
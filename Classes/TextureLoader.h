@@ -0,0 +1,138 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CDecodedImageCache;
+
+namespace cocos2d
+{
+	class Image;
+	class TextureCache;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CTextureLoader
+// Purpose				: To preload the textures of a level before its entities are built. Every listed image is decoded on
+//						: worker threads, then only the GPU uploads happen on the main thread, so the following texture
+//						: requests of the map and of the entities are served from the texture cache. The loading is resumable:
+//						: BeginLoad() starts the decoding, each ContinueLoad() uploads a few of the images decoded meanwhile
+// Notes				: Textures already in the cache are skipped, so the loader can be run again on the next level. Given a
+//						: decoded image cache, the images decoded by an earlier launch are read from it instead
+// Example				: cLoader.AddTilesets( sMapFile ); cLoader.BeginLoad( true ); while( !cLoader.ContinueLoad( 2 ) ) { ... }
+//-----------------------------------------------------------------------------------------------------------------------------
+class CTextureLoader
+{
+
+private:
+
+	// Files to load as given by the callers
+	std::vector<std::string> m_asFiles;
+
+	// Texture cache receiving the uploaded textures
+	cocos2d::TextureCache* m_pcTextureCache;
+
+	// Pixels decoded by the earlier launches, nullptr to always decode
+	const CDecodedImageCache* m_pcDecodedImages;
+
+	// Files of the running load not in the cache yet, resolved to their full paths
+	std::vector<std::string> m_asFullPaths;
+
+	// Decoded image of every file, nullptr if it could not be decoded, and whether its decoding is done
+	std::vector<cocos2d::Image*> m_apcImages;
+	std::unique_ptr<std::atomic<bool>[]> m_abDecoded;
+
+	// Next image taken by a worker, images read from the decoded image cache
+	std::atomic<int> m_iNextDecode;
+	std::atomic<int> m_iCachedImages;
+
+	// Threads decoding the images, none to decode them on the thread calling ContinueLoad()
+	std::vector<std::thread> m_acWorkers;
+
+	// Next image to upload and textures added to the cache by the running load
+	int m_iNextUpload;
+	int m_iLoadedTextures;
+
+	// Start of the running load and time spent uploading, for the log
+	std::chrono::steady_clock::time_point m_cLoadStart;
+	float m_fUploadMs;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: DecodeImage()
+	// Parameters		: iIndex			- Index of the file in the running load
+	// Purpose			: Decode one image, the same work done by the texture cache's own asynchronous loading thread, then
+	//					: mark it as decoded. Called by the workers or by the thread calling ContinueLoad()
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void DecodeImage( const int iIndex );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: StopWorkers()
+	// Purpose			: Let the workers finish the image they are decoding and join them
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void StopWorkers();
+
+	// Non copyable, the workers point to the loader
+	CTextureLoader( const CTextureLoader& ) = delete;
+	CTextureLoader& operator=( const CTextureLoader& ) = delete;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CTextureLoader()
+	// Parameters		: pcTextureCache	- Texture cache receiving the uploaded textures
+	//					: pcDecodedImages	- Pixels decoded by the earlier launches, filled with the images decoded now
+	//-----------------------------------------------------------------------------------------------------------------------------
+	explicit CTextureLoader( cocos2d::TextureCache* pcTextureCache, const CDecodedImageCache* pcDecodedImages = nullptr );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Destructor name	: ~CTextureLoader()
+	// Purpose			: Stop the decoding of a load left unfinished and release the images not uploaded
+	//-----------------------------------------------------------------------------------------------------------------------------
+	~CTextureLoader();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddFile()
+	// Parameters		: rsFile			- Image file to load, as passed to the texture cache
+	// Purpose			: Add an image to the ones loaded by BeginLoad(), duplicates are ignored
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void AddFile( const std::string& rsFile );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddTilesets()
+	// Parameters		: rsMapFile			- Tiled map file
+	// Purpose			: Parse the map without creating it and add the images of all its tilesets
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void AddTilesets( const std::string& rsMapFile );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: BeginLoad()
+	// Parameters		: bUseWorkerThreads	- True to decode the images in parallel on worker threads, false to decode them
+	//										  in ContinueLoad() on the calling thread, used to compare the startup times
+	// Purpose			: Start loading every added image not in the cache yet and return straight away
+	// Notes			: Must be called from the thread owning the GL context
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BeginLoad( const bool bUseWorkerThreads );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ContinueLoad()
+	// Parameters		: iMaxUploads		- Most textures uploaded by this call
+	// Purpose			: Upload the images decoded since the last call, in the order they were added, up to the given amount.
+	//					: Once every image is uploaded the workers are joined and the load is logged
+	// Returns			: True once the load is done, false while images are left to decode or to upload
+	// Notes			: Must be called from the thread owning the GL context
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool ContinueLoad( const int iMaxUploads );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetLoadedCount()
+	// Returns			: The amount of textures added to the cache by the running or last load
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetLoadedCount() const;
+};
+
+#endif // !TEXTURELOADER_H
@@ -0,0 +1,178 @@
+#include "TriggerGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <cocos/base/ccMacros.h>
+
+using cocos2d::Rect;
+
+CTriggerGrid::CTriggerGrid()
+	: m_fCellSize( 1.0f )
+	, m_iColumns( 0 )
+	, m_iRows( 0 )
+	, m_uiQuery( 0 )
+{}
+
+void CTriggerGrid::Initialise( const Rect& rcBounds, const float fCellSize )
+{
+	CCASSERT( fCellSize > 0.0f, "Trigger grid cell size must be positive" );
+
+	m_cBounds = rcBounds;
+	m_fCellSize = fCellSize;
+
+	// Enough cells to cover the whole area, the last row and column can be partially outside it
+	m_iColumns = std::max( 1, static_cast<int>( std::ceil( rcBounds.size.width / fCellSize ) ) );
+	m_iRows = std::max( 1, static_cast<int>( std::ceil( rcBounds.size.height / fCellSize ) ) );
+
+	m_aaiCells.clear();
+	m_aaiCells.resize( m_iColumns * m_iRows );
+
+	Clear();
+}
+
+void CTriggerGrid::Clear()
+{
+	m_asTriggers.clear();
+	m_aiInside.clear();
+	m_aiInsideNow.clear();
+
+	for( std::vector<int>& raiCell : m_aaiCells )
+	{
+		raiCell.clear();
+	}
+}
+
+bool CTriggerGrid::GetCellRange( const Rect& rcArea, int& riMinColumn, int& riMinRow, int& riMaxColumn, int& riMaxRow ) const
+{
+	// Position of the area relative to the grid origin, in cells
+	riMinColumn = static_cast<int>( std::floor( ( rcArea.getMinX() - m_cBounds.getMinX() ) / m_fCellSize ) );
+	riMinRow = static_cast<int>( std::floor( ( rcArea.getMinY() - m_cBounds.getMinY() ) / m_fCellSize ) );
+	riMaxColumn = static_cast<int>( std::floor( ( rcArea.getMaxX() - m_cBounds.getMinX() ) / m_fCellSize ) );
+	riMaxRow = static_cast<int>( std::floor( ( rcArea.getMaxY() - m_cBounds.getMinY() ) / m_fCellSize ) );
+
+	if( riMaxColumn < 0 || riMaxRow < 0 || riMinColumn >= m_iColumns || riMinRow >= m_iRows )
+	{
+		return false;
+	}
+
+	riMinColumn = std::max( riMinColumn, 0 );
+	riMinRow = std::max( riMinRow, 0 );
+	riMaxColumn = std::min( riMaxColumn, m_iColumns - 1 );
+	riMaxRow = std::min( riMaxRow, m_iRows - 1 );
+
+	return true;
+}
+
+int CTriggerGrid::AddTrigger( const Rect& rcVolume, const TriggerCallback& rfnCallback )
+{
+	CCASSERT( m_iColumns > 0, "Trigger grid not initialised" );
+
+	const int iID = m_asTriggers.size();
+
+	STrigger sTrigger;
+	sTrigger.cVolume = rcVolume;
+	sTrigger.fnCallback = rfnCallback;
+	sTrigger.bIsInside = false;
+	sTrigger.uiLastQuery = m_uiQuery;
+	m_asTriggers.push_back( sTrigger );
+
+	// The player can be inside every trigger at once, so the lists of the queries never grow during play
+	m_aiInside.reserve( m_asTriggers.size() );
+	m_aiInsideNow.reserve( m_asTriggers.size() );
+
+	int iMinColumn, iMinRow, iMaxColumn, iMaxRow;
+	const bool bIsInsideGrid = GetCellRange( rcVolume, iMinColumn, iMinRow, iMaxColumn, iMaxRow );
+
+	CCASSERT( bIsInsideGrid, "Trigger outside of the grid" );
+
+	// Store the trigger in every cell its volume overlaps
+	if( bIsInsideGrid )
+	{
+		for( int iRow = iMinRow; iRow <= iMaxRow; iRow++ )
+		{
+			for( int iColumn = iMinColumn; iColumn <= iMaxColumn; iColumn++ )
+			{
+				m_aaiCells[ iRow * m_iColumns + iColumn ].push_back( iID );
+			}
+		}
+	}
+
+	return iID;
+}
+
+void CTriggerGrid::ResetStates()
+{
+	for( const int iID : m_aiInside )
+	{
+		m_asTriggers[ iID ].bIsInside = false;
+	}
+
+	m_aiInside.clear();
+}
+
+void CTriggerGrid::Update( const Rect& rcPlayerBounds, const float fDeltaTime )
+{
+	m_uiQuery++;
+	m_aiInsideNow.clear();
+
+	int iMinColumn, iMinRow, iMaxColumn, iMaxRow;
+
+	if( GetCellRange( rcPlayerBounds, iMinColumn, iMinRow, iMaxColumn, iMaxRow ) )
+	{
+		for( int iRow = iMinRow; iRow <= iMaxRow; iRow++ )
+		{
+			for( int iColumn = iMinColumn; iColumn <= iMaxColumn; iColumn++ )
+			{
+				for( const int iID : m_aaiCells[ iRow * m_iColumns + iColumn ] )
+				{
+					STrigger& rsTrigger = m_asTriggers[ iID ];
+
+					// Already tested through another cell in this query
+					if( rsTrigger.uiLastQuery == m_uiQuery )
+					{
+						continue;
+					}
+
+					rsTrigger.uiLastQuery = m_uiQuery;
+
+					if( !rsTrigger.cVolume.intersectsRect( rcPlayerBounds ) )
+					{
+						continue;
+					}
+
+					m_aiInsideNow.push_back( iID );
+
+					if( rsTrigger.bIsInside )
+					{
+						rsTrigger.fnCallback( EEvent::Stay, fDeltaTime );
+					}
+					else
+					{
+						rsTrigger.bIsInside = true;
+						rsTrigger.fnCallback( EEvent::Enter, fDeltaTime );
+					}
+				}
+			}
+		}
+	}
+
+	// Every trigger the player was inside and that has not been found in this query has been left
+	for( const int iID : m_aiInside )
+	{
+		STrigger& rsTrigger = m_asTriggers[ iID ];
+
+		if( std::find( m_aiInsideNow.begin(), m_aiInsideNow.end(), iID ) == m_aiInsideNow.end() )
+		{
+			rsTrigger.bIsInside = false;
+			rsTrigger.fnCallback( EEvent::Exit, fDeltaTime );
+		}
+	}
+
+	m_aiInside.swap( m_aiInsideNow );
+}
+
+int CTriggerGrid::GetAmountOfTriggers() const
+{
+	return m_asTriggers.size();
+}
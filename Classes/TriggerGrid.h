@@ -0,0 +1,139 @@
+#ifndef TRIGGERGRID_H
+#define TRIGGERGRID_H
+
+#include <functional>
+#include <vector>
+
+#include <cocos/math/CCGeometry.h>
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CTriggerGrid
+// Purpose				: To detect when the player enters, stays in or exits trigger volumes without using physics sensors.
+//						: The axis aligned volumes of the current stage are bucketed in a uniform grid which is queried once per
+//						: tick with the player's bounds, so only the volumes sharing a cell with the player are tested
+// Notes				: Callbacks are called in a deterministic order and must not add or remove triggers
+//-----------------------------------------------------------------------------------------------------------------------------
+class CTriggerGrid
+{
+
+public:
+
+	// Events a trigger can receive
+	enum class EEvent
+	{
+		Enter,
+		Stay,
+		Exit
+	};
+
+	// Function called on every event of a trigger
+	typedef std::function<void( const EEvent eEvent, const float fDeltaTime )> TriggerCallback;
+
+private:
+
+	// A trigger volume and its state
+	struct STrigger
+	{
+		// Volume of the trigger in map space
+		cocos2d::Rect		cVolume;
+		// Function called on the trigger's events
+		TriggerCallback		fnCallback;
+		// True if the player was inside the volume on the last query
+		bool				bIsInside;
+		// Last query that tested the trigger, avoids testing twice a trigger spanning many cells
+		unsigned int		uiLastQuery;
+	};
+
+	// Area covered by the grid in map space
+	cocos2d::Rect m_cBounds;
+
+	// Size of a square cell
+	float m_fCellSize;
+
+	// Amount of cells along the x and y axis
+	int m_iColumns;
+	int m_iRows;
+
+	// Triggers of the current stage, indexed by the ID returned by AddTrigger()
+	std::vector<STrigger> m_asTriggers;
+
+	// IDs of the triggers overlapping each cell, row by row
+	std::vector<std::vector<int>> m_aaiCells;
+
+	// IDs of the triggers the player was inside on the last query
+	std::vector<int> m_aiInside;
+
+	// IDs of the triggers the player is inside in the current query, swapped with m_aiInside
+	std::vector<int> m_aiInsideNow;
+
+	// Counter of the queries done
+	unsigned int m_uiQuery;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetCellRange()
+	// Parameters		: rcArea			- Area in map space
+	//					: riMinColumn		- First column overlapped by the area
+	//					: riMinRow			- First row overlapped by the area
+	//					: riMaxColumn		- Last column overlapped by the area
+	//					: riMaxRow			- Last row overlapped by the area
+	// Purpose			: Find the cells overlapped by the area, clamped to the grid
+	// Returns			: False if the area is completely outside the grid
+	//-----------------------------------------------------------------------------------------------------------------------------
+	bool GetCellRange( const cocos2d::Rect& rcArea, int& riMinColumn, int& riMinRow, int& riMaxColumn, int& riMaxRow ) const;
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CTriggerGrid()
+	// Purpose			: Create an empty grid with no cells
+	//-----------------------------------------------------------------------------------------------------------------------------
+	CTriggerGrid();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Initialise()
+	// Parameters		: rcBounds			- Area covered by the grid in map space
+	//					: fCellSize			- Size of a square cell
+	// Purpose			: Allocate the cells of the grid and remove all the triggers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Initialise( const cocos2d::Rect& rcBounds, const float fCellSize );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Clear()
+	// Purpose			: Remove all the triggers without sending exit events, used when a new stage is loaded
+	// Notes			: The cells keep their memory so that the next stage does not allocate
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Clear();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: AddTrigger()
+	// Parameters		: rcVolume			- Volume of the trigger in map space
+	//					: rfnCallback		- Function called on the trigger's events
+	// Purpose			: Add a trigger to all the cells its volume overlaps
+	// Returns			: The ID of the trigger
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int AddTrigger( const cocos2d::Rect& rcVolume, const TriggerCallback& rfnCallback );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ResetStates()
+	// Purpose			: Forget which triggers the player is inside without sending events, used when the stage is reset so
+	//					: that a player still inside a volume receives a new enter event
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void ResetStates();
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Update()
+	// Parameters		: rcPlayerBounds	- Bounds of the player in map space
+	//					: fDeltaTime		- Time passed since the last update, passed to the callbacks
+	// Purpose			: Test the player's bounds against the triggers of the cells it overlaps and send the enter and stay
+	//					: events, then send the exit events of the triggers the player left
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Update( const cocos2d::Rect& rcPlayerBounds, const float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetAmountOfTriggers()
+	// Returns			: The amount of triggers in the grid
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetAmountOfTriggers() const;
+};
+
+#endif // !TRIGGERGRID_H
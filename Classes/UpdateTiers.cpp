@@ -0,0 +1,143 @@
+#include "UpdateTiers.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <cocos/2d/CCNode.h>
+#include <cocos/base/ccMacros.h>
+#include <cocos/physics/CCPhysicsBody.h>
+
+using cocos2d::Vec2;
+
+CUpdateTiers::SSettings::SSettings()
+	: fFullMargin( 64.0f )
+	, fReducedMargin( 640.0f )
+	, fHysteresis( 32.0f )
+	, iReducedInterval( 4 )
+{}
+
+CUpdateTiers::CUpdateTiers( const SSettings& rsSettings )
+	: m_sSettings( rsSettings )
+	, m_uiFrame( 0 )
+	, m_aiTierCounts()
+{
+	CCASSERT( m_sSettings.fFullMargin <= m_sSettings.fReducedMargin, "Reduced tier closer than the full tier" );
+	CCASSERT( m_sSettings.iReducedInterval > 0, "Reduced tier never updated" );
+}
+
+void CUpdateTiers::Reset( const int iEntities )
+{
+	for( SEntity& rsEntity : m_asEntities )
+	{
+		if( ETier::Frozen == rsEntity.eTier )
+		{
+			Thaw( rsEntity );
+		}
+	}
+
+	SEntity sEntity;
+	sEntity.pcNode = nullptr;
+	sEntity.eTier = ETier::Full;
+	sEntity.fPendingTime = 0.0f;
+
+	m_asEntities.assign( iEntities, sEntity );
+	m_uiFrame = 0;
+}
+
+void CUpdateTiers::BeginFrame( const cocos2d::Rect& rcView )
+{
+	m_cView = rcView;
+	m_uiFrame++;
+	std::fill( std::begin( m_aiTierCounts ), std::end( m_aiTierCounts ), 0 );
+}
+
+float CUpdateTiers::Schedule( const int iEntity, cocos2d::Node* pcNode, const float fDeltaTime )
+{
+	CCASSERT( iEntity >= 0 && iEntity < static_cast<int>( m_asEntities.size() ), "Entity not reset" );
+
+	SEntity& rsEntity = m_asEntities[ iEntity ];
+	rsEntity.pcNode = pcNode;
+
+	const ETier eTier = ChooseTier( rsEntity, pcNode->getPosition() );
+	m_aiTierCounts[ static_cast<int>( eTier ) ]++;
+
+	if( eTier != rsEntity.eTier )
+	{
+		if( ETier::Frozen == rsEntity.eTier )
+		{
+			Thaw( rsEntity );
+		}
+		else if( ETier::Frozen == eTier )
+		{
+			Freeze( rsEntity );
+		}
+
+		rsEntity.eTier = eTier;
+	}
+
+	if( ETier::Frozen == eTier )
+	{
+		return 0.0f;
+	}
+
+	// Entities promoted to the full tier get the time they skipped in the reduced one
+	rsEntity.fPendingTime += fDeltaTime;
+
+	// Entities of the reduced tier are spread over the frames of the interval by their index
+	if( ETier::Reduced == eTier && 0 != ( m_uiFrame + iEntity ) % m_sSettings.iReducedInterval )
+	{
+		return 0.0f;
+	}
+
+	const float fUpdateTime = rsEntity.fPendingTime;
+	rsEntity.fPendingTime = 0.0f;
+
+	return fUpdateTime;
+}
+
+CUpdateTiers::ETier CUpdateTiers::ChooseTier( const SEntity& rsEntity, const Vec2& rcPosition ) const
+{
+	// Distance from the view along the axis the entity is farthest on, 0 inside the view
+	const float fDistanceX = std::max( 0.0f, std::max( m_cView.getMinX() - rcPosition.x, rcPosition.x - m_cView.getMaxX() ) );
+	const float fDistanceY = std::max( 0.0f, std::max( m_cView.getMinY() - rcPosition.y, rcPosition.y - m_cView.getMaxY() ) );
+	const float fDistance = std::max( fDistanceX, fDistanceY );
+
+	const float fFullMargin = m_sSettings.fFullMargin + ( ( ETier::Full == rsEntity.eTier ) ? m_sSettings.fHysteresis : 0.0f );
+	const float fReducedMargin = m_sSettings.fReducedMargin + ( ( ETier::Frozen != rsEntity.eTier ) ? m_sSettings.fHysteresis : 0.0f );
+
+	return ( fDistance <= fFullMargin ) ? ETier::Full
+		: ( fDistance <= fReducedMargin ) ? ETier::Reduced : ETier::Frozen;
+}
+
+void CUpdateTiers::Freeze( SEntity& rsEntity )
+{
+	// Actions and scheduled updates of the entity stop with it
+	rsEntity.pcNode->pause();
+	rsEntity.fPendingTime = 0.0f;
+
+	cocos2d::PhysicsBody* pcBody = rsEntity.pcNode->getPhysicsBody();
+
+	if( nullptr != pcBody )
+	{
+		rsEntity.cFrozenVelocity = pcBody->getVelocity();
+		pcBody->setEnabled( false );
+	}
+}
+
+void CUpdateTiers::Thaw( SEntity& rsEntity )
+{
+	rsEntity.pcNode->resume();
+
+	cocos2d::PhysicsBody* pcBody = rsEntity.pcNode->getPhysicsBody();
+
+	if( nullptr != pcBody )
+	{
+		pcBody->setEnabled( true );
+		pcBody->setVelocity( rsEntity.cFrozenVelocity );
+	}
+}
+
+int CUpdateTiers::GetTierCount( const ETier eTier ) const
+{
+	return m_aiTierCounts[ static_cast<int>( eTier ) ];
+}
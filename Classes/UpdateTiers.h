@@ -0,0 +1,150 @@
+#ifndef UPDATETIERS_H
+#define UPDATETIERS_H
+
+#include <vector>
+
+#include <cocos/math/CCGeometry.h>
+
+namespace cocos2d
+{
+	class Node;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Class Name			: CUpdateTiers
+// Purpose				: To spend the update time of a stage's entities where the player can see them. Every frame each entity
+//						: is given a tier from its distance to the camera's view: entities on screen or about to enter it are
+//						: updated every frame, the ones nearby but off screen every few frames with the time they skipped,
+//						: and the far ones are frozen: their node is paused and their physics body taken out of the world
+// Notes				: Only off screen entities are slowed down or frozen, and a frozen entity thaws before it can be seen,
+//						: so no tier change shows. The tiers only grow back past a small hysteresis to avoid flickering
+//						: between two tiers. Frozen entities lose the time they spent frozen rather than catching up
+// Example				: cTiers.Reset( iEnemies ); ... cTiers.BeginFrame( rcView );
+//						: const float fTime = cTiers.Schedule( i, pcEnemy, fDeltaTime ); if( fTime > 0.0f ) pcEnemy->VUpdate( fTime );
+//-----------------------------------------------------------------------------------------------------------------------------
+class CUpdateTiers
+{
+
+public:
+
+	// How often an entity is updated
+	enum class ETier : int
+	{
+		Full,
+		Reduced,
+		Frozen
+	};
+
+	static const int k_iNumOfTiers = 3;
+
+	// Distances of the tiers, in the view's coordinates
+	struct SSettings
+	{
+		// Distance from the view up to which entities are updated every frame, enough for an entity to come in view
+		float	fFullMargin;
+		// Distance from the view up to which entities are updated every few frames, farther ones are frozen
+		float	fReducedMargin;
+		// Extra distance an entity must move away before it drops to a slower tier
+		float	fHysteresis;
+		// Frames between two updates of the reduced tier
+		int		iReducedInterval;
+
+		//-----------------------------------------------------------------------------------------------------------------------------
+		// Constructor name	: SSettings()
+		// Purpose			: Set the tiers used by the enemies
+		//-----------------------------------------------------------------------------------------------------------------------------
+		SSettings();
+	};
+
+private:
+
+	// State of an entity
+	struct SEntity
+	{
+		// Node of the entity when it was last scheduled, thawed by Reset() if it is frozen
+		cocos2d::Node*	pcNode;
+		ETier			eTier;
+		// Time not given to the entity yet while in the reduced tier
+		float			fPendingTime;
+		// Velocity of the body when it was frozen, given back when it thaws
+		cocos2d::Vec2	cFrozenVelocity;
+	};
+
+	SSettings m_sSettings;
+
+	// States indexed by the entities' index
+	std::vector<SEntity> m_asEntities;
+
+	// Camera's view of the current frame
+	cocos2d::Rect m_cView;
+
+	// Frames begun since the last reset, staggers the reduced updates
+	unsigned int m_uiFrame;
+
+	// Entities scheduled in each tier during the current frame
+	int m_aiTierCounts[ k_iNumOfTiers ];
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: ChooseTier()
+	// Parameters		: rsEntity			- State of the entity
+	//					: rcPosition		- Position of the entity
+	// Returns			: The tier of the entity for the current frame
+	//-----------------------------------------------------------------------------------------------------------------------------
+	ETier ChooseTier( const SEntity& rsEntity, const cocos2d::Vec2& rcPosition ) const;
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Freeze()
+	// Parameters		: rsEntity			- State of the entity
+	// Purpose			: Pause the entity's node and take its body out of the physics world
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Freeze( SEntity& rsEntity );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Thaw()
+	// Parameters		: rsEntity			- State of the entity
+	// Purpose			: Resume the entity's node and put its body back in the world with the velocity it had
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Thaw( SEntity& rsEntity );
+
+public:
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Constructor name	: CUpdateTiers()
+	// Parameters		: rsSettings		- Distances of the tiers
+	//-----------------------------------------------------------------------------------------------------------------------------
+	explicit CUpdateTiers( const SSettings& rsSettings = SSettings() );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Reset()
+	// Parameters		: iEntities			- Amount of entities scheduled
+	// Purpose			: Thaw every frozen entity and start them all in the full tier, called before a stage claims its
+	//					: entities so that the pools find the bodies as they left them
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void Reset( const int iEntities );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: BeginFrame()
+	// Parameters		: rcView			- Part of the map seen by the camera, in the coordinates of the entities' parent
+	// Purpose			: Start scheduling a new frame
+	//-----------------------------------------------------------------------------------------------------------------------------
+	void BeginFrame( const cocos2d::Rect& rcView );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: Schedule()
+	// Parameters		: iEntity			- Index of the entity, below the amount given to Reset()
+	//					: pcNode			- Node of the entity
+	//					: fDeltaTime		- Time passed since the last frame
+	// Purpose			: Move the entity to its tier for this frame, freezing or thawing it if needed
+	// Returns			: The time to update the entity with, 0 if it is not updated this frame
+	//-----------------------------------------------------------------------------------------------------------------------------
+	float Schedule( const int iEntity, cocos2d::Node* pcNode, const float fDeltaTime );
+
+	//-----------------------------------------------------------------------------------------------------------------------------
+	// Function Name	: GetTierCount()
+	// Parameters		: eTier				- Tier to count
+	// Returns			: The entities scheduled in the tier during the current frame
+	//-----------------------------------------------------------------------------------------------------------------------------
+	int GetTierCount( const ETier eTier ) const;
+};
+
+#endif // !UPDATETIERS_H